@@ -71,7 +71,14 @@ extern "C" void app_main(void)
          * Warmup time. If the sensor is always powered,
          * we can set it to 0 to save time on the first boot
          */
-        .warmup_time_ms   = 0
+        .warmup_time_ms   = 0,
+
+        /**
+         * Try to clear a stuck ECHO pin twice before reporting ECHO_STUCK.
+         * Add power_cycle_us and pass a power-enable GPIO to UsSensor to
+         * also toggle the sensor supply.
+         */
+        .stuck_recovery_attempts = 2
     };
 
     /**
@@ -147,7 +154,8 @@ extern "C" void app_main(void)
                     ESP_LOGW(TAG, "Error: Insufficient samples for a reliable calculation.");
                     break;
                 case UsResult::ECHO_STUCK:
-                    ESP_LOGE(TAG, "CRITICAL ERROR: ECHO pin stuck HIGH! Power-cycle suggested.");
+                    ESP_LOGE(TAG, "CRITICAL ERROR: ECHO pin stuck HIGH after %lu recovery attempts! Power-cycle suggested.",
+                             static_cast<unsigned long>(us_cfg.stuck_recovery_attempts));
                     break;
                 case UsResult::HW_FAULT:
                     ESP_LOGE(TAG, "CRITICAL ERROR: Hardware fault in GPIO driver.");
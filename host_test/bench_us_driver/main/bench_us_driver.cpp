@@ -0,0 +1,296 @@
+// components/ultrasonic_sensor/host_test/bench_us_driver/main/bench_us_driver.cpp
+//
+// Benchmarks of UsDriver::ping_once.
+//
+// 1. UsConfig::fast_ping on and off. The HAL is a fake: a virtual clock and
+//    an ECHO line that rises on the first poll after the trigger and falls on
+//    the next one, so a ping costs only its fixed sequence of HAL calls. Every
+//    HAL call is counted, and each GPIO call can be given a busy-wait cost to
+//    stand in for the real GPIO driver.
+// 2. UsConfig::echo_wait policies on a simulated scheduler. Every poll costs
+//    1 us of the measuring task, a yield hands YIELD_US to another task and a
+//    sleep hands over whole ticks. The target wanders and sometimes jumps. The
+//    report gives the distance error and the share of the ping the measuring
+//    task kept the CPU.
+//
+// Environment (app_main has no argv):
+//   US_BENCH_PINGS=n          Pings per fast_ping mode (default 200000).
+//   US_BENCH_GPIO_COST_NS=ns  Busy-wait per GPIO call (default 0).
+//   US_BENCH_POLICY_PINGS=n   Pings per echo_wait policy (default 2000).
+//
+// Exits non-zero if the fast path reads differently or does not save HAL
+// calls, or if a relaxed policy does not give CPU time back.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "mock_hal_freertos.hpp"
+#include "mock_hal_gpio.hpp"
+#include "mock_hal_sys_rom.hpp"
+#include "mock_hal_timer.hpp"
+#include "us_driver.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using ::testing::_;
+using ::testing::NiceMock;
+
+static constexpr gpio_num_t TRIG_PIN = GPIO_NUM_4;
+static constexpr gpio_num_t ECHO_PIN = GPIO_NUM_5;
+static constexpr int64_t US_PER_TIMER_READ = 580; // two reads of echo: ~20 cm
+
+struct FakeHal
+{
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+
+    int64_t now_us = 0;
+    int echo_phase = 0; // 0: idle LOW, 1: HIGH on next poll, 2: LOW on next poll
+    uint64_t gpio_calls = 0;
+    uint64_t hal_calls = 0;
+    uint64_t gpio_cost_ns = 0;
+
+    FakeHal()
+    {
+        ON_CALL(gpio, set_direction(_, _)).WillByDefault([this](gpio_num_t, gpio_mode_t) {
+            gpio_call();
+            return ESP_OK;
+        });
+        ON_CALL(gpio, set_level(_, _)).WillByDefault([this](gpio_num_t pin, uint32_t level) {
+            gpio_call();
+            if (pin == TRIG_PIN && level == 0)
+                echo_phase = 1;
+            return ESP_OK;
+        });
+        ON_CALL(gpio, get_level(_)).WillByDefault([this](gpio_num_t) {
+            gpio_call();
+            if (echo_phase == 1) {
+                echo_phase = 2;
+                return 1;
+            }
+            echo_phase = 0;
+            return 0;
+        });
+        ON_CALL(timer, get_time_us()).WillByDefault([this]() {
+            hal_calls++;
+            now_us += US_PER_TIMER_READ;
+            return now_us;
+        });
+        ON_CALL(sys_rom, delay_us(_)).WillByDefault([this](uint32_t us) {
+            hal_calls++;
+            now_us += us;
+        });
+    }
+
+    void gpio_call()
+    {
+        gpio_calls++;
+        hal_calls++;
+        if (gpio_cost_ns == 0)
+            return;
+        auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(gpio_cost_ns);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+};
+
+struct ModeResult
+{
+    double ns_per_ping;
+    double hal_calls_per_ping;
+    double gpio_calls_per_ping;
+    UsDriverStats stats;
+    Reading last;
+    uint64_t failed;
+};
+
+static ModeResult run_mode(bool fast_ping, uint64_t pings, uint64_t gpio_cost_ns)
+{
+    FakeHal hal;
+    hal.gpio_cost_ns = gpio_cost_ns;
+    UsDriver driver(hal.gpio, hal.timer, hal.sys_rom, TRIG_PIN, ECHO_PIN);
+
+    UsConfig cfg;
+    cfg.fast_ping = fast_ping;
+
+    ModeResult r{};
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < pings; i++) {
+        r.last = driver.ping_once(cfg);
+        if (r.last.result != UsResult::OK)
+            r.failed++;
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    r.ns_per_ping = static_cast<double>(ns) / pings;
+    r.hal_calls_per_ping = static_cast<double>(hal.hal_calls) / pings;
+    r.gpio_calls_per_ping = static_cast<double>(hal.gpio_calls) / pings;
+    r.stats = driver.stats();
+    return r;
+}
+
+static void print_mode(const char *name, const ModeResult &r)
+{
+    printf("%-6s %9.1f ns/ping  %5.2f HAL calls/ping (%5.2f GPIO)  full=%" PRIu32 " fast=%" PRIu32 "\n", name,
+           r.ns_per_ping, r.hal_calls_per_ping, r.gpio_calls_per_ping, r.stats.full_preps, r.stats.fast_preps);
+}
+
+struct SchedulerSim
+{
+    static constexpr int64_t YIELD_US = 100; // another task's slice after a yield
+    static constexpr int64_t TICK_US = 1000000 / configTICK_RATE_HZ;
+    static constexpr int64_t RISE_DELAY_US = 450;
+
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+
+    int64_t now_us = 0;
+    int64_t given_us = 0; // handed to other tasks
+    int64_t trigger_us = -1;
+    int64_t width_us = 0;
+
+    SchedulerSim()
+    {
+        ON_CALL(timer, get_time_us()).WillByDefault([this]() { return ++now_us; });
+        ON_CALL(sys_rom, delay_us(_)).WillByDefault([this](uint32_t us) { now_us += us; });
+        ON_CALL(freertos, task_delay(_)).WillByDefault([this](TickType_t ticks) {
+            // A sleep wakes on a tick boundary, at most `ticks` ticks later
+            int64_t wake = (ticks == 0) ? now_us + YIELD_US : (now_us / TICK_US + ticks) * TICK_US;
+            given_us += wake - now_us;
+            now_us = wake;
+        });
+        ON_CALL(gpio, set_level(_, _)).WillByDefault([this](gpio_num_t pin, uint32_t level) {
+            if (pin == TRIG_PIN && level == 0)
+                trigger_us = now_us;
+            return ESP_OK;
+        });
+        ON_CALL(gpio, get_level(_)).WillByDefault([this](gpio_num_t) {
+            int64_t rise = trigger_us + RISE_DELAY_US;
+            return (trigger_us >= 0 && now_us >= rise && now_us < rise + width_us) ? 1 : 0;
+        });
+    }
+};
+
+struct PolicyResult
+{
+    double mean_err_cm;
+    double p99_err_cm;
+    double max_err_cm;
+    double cpu_share;
+    UsDriverStats stats;
+};
+
+static PolicyResult run_policy(EchoWait policy, uint64_t pings)
+{
+    SchedulerSim sim;
+    UsDriver driver(sim.gpio, sim.timer, sim.sys_rom, TRIG_PIN, ECHO_PIN, {.freertos_hal = &sim.freertos});
+    UsConfig cfg;
+    cfg.echo_wait = policy;
+    cfg.max_distance_cm = 400.0f;
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> step(0.0f, 0.5f);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    float cm = 150.0f;
+
+    std::vector<double> errors;
+    int64_t busy_us = 0;
+    int64_t total_us = 0;
+    for (uint64_t i = 0; i < pings; i++) {
+        // Slow drift, and a jump to a new target on 2% of the pings
+        cm = (uniform(rng) < 0.02f) ? 20.0f + 330.0f * uniform(rng) : std::clamp(cm + step(rng), 20.0f, 350.0f);
+        sim.width_us = std::lround(2.0f * cm / UsDriver::SOUND_SPEED_CM_PER_US);
+        sim.trigger_us = -1;
+
+        int64_t start = sim.now_us;
+        int64_t given = sim.given_us;
+        Reading r = driver.ping_once(cfg);
+        total_us += sim.now_us - start;
+        busy_us += (sim.now_us - start) - (sim.given_us - given);
+
+        if (is_success(r.result))
+            errors.push_back(std::fabs(r.cm - cm));
+    }
+
+    PolicyResult out{};
+    std::sort(errors.begin(), errors.end());
+    if (!errors.empty()) {
+        double sum = 0.0;
+        for (double e : errors) sum += e;
+        out.mean_err_cm = sum / errors.size();
+        out.p99_err_cm = errors[errors.size() * 99 / 100];
+        out.max_err_cm = errors.back();
+    }
+    out.cpu_share = total_us ? static_cast<double>(busy_us) / total_us : 0.0;
+    out.stats = driver.stats();
+    return out;
+}
+
+static void print_policy(const char *name, const PolicyResult &r)
+{
+    printf("%-10s  error mean %6.3f cm  p99 %6.3f cm  max %6.2f cm  CPU held %5.1f%%  yields %" PRIu32
+           "  sleeps %" PRIu32 "  late %" PRIu32 "\n",
+           name, r.mean_err_cm, r.p99_err_cm, r.max_err_cm, 100.0 * r.cpu_share, r.stats.wait_yields,
+           r.stats.wait_sleeps, r.stats.late_edges);
+}
+
+extern "C" void app_main(void)
+{
+    const char *pings_env = getenv("US_BENCH_PINGS");
+    const char *cost_env = getenv("US_BENCH_GPIO_COST_NS");
+    uint64_t pings = pings_env ? strtoull(pings_env, nullptr, 10) : 200000;
+    uint64_t gpio_cost_ns = cost_env ? strtoull(cost_env, nullptr, 10) : 0;
+    if (pings == 0)
+        pings = 1;
+
+    printf("Pings per mode: %" PRIu64 ", GPIO call cost: %" PRIu64 " ns\n", pings, gpio_cost_ns);
+
+    ModeResult full = run_mode(false, pings, gpio_cost_ns);
+    ModeResult fast = run_mode(true, pings, gpio_cost_ns);
+    print_mode("full", full);
+    print_mode("fast", fast);
+    printf("Speedup: %.2fx, HAL calls saved: %.1f%%\n", full.ns_per_ping / fast.ns_per_ping,
+           100.0 * (1.0 - fast.hal_calls_per_ping / full.hal_calls_per_ping));
+
+    if (full.failed != 0 || fast.failed != 0 || full.last != fast.last) {
+        fprintf(stderr, "Fast path changed the readings (failed: full=%" PRIu64 " fast=%" PRIu64 ")\n", full.failed,
+                fast.failed);
+        exit(1);
+    }
+    if (fast.stats.full_preps != 1 || fast.hal_calls_per_ping >= full.hal_calls_per_ping) {
+        fprintf(stderr, "Fast path did not skip the clear sequence\n");
+        exit(1);
+    }
+
+    const char *policy_env = getenv("US_BENCH_POLICY_PINGS");
+    uint64_t policy_pings = policy_env ? strtoull(policy_env, nullptr, 10) : 2000;
+    if (policy_pings == 0)
+        policy_pings = 1;
+
+    printf("\nEcho wait policies, %" PRIu64 " pings each (yield slice %" PRId64 " us, tick %" PRId64 " us):\n",
+           policy_pings, SchedulerSim::YIELD_US, SchedulerSim::TICK_US);
+    PolicyResult spin = run_policy(EchoWait::SPIN, policy_pings);
+    PolicyResult yield = run_policy(EchoWait::SPIN_YIELD, policy_pings);
+    PolicyResult sleep = run_policy(EchoWait::SPIN_SLEEP, policy_pings);
+    print_policy("SPIN", spin);
+    print_policy("SPIN_YIELD", yield);
+    print_policy("SPIN_SLEEP", sleep);
+
+    if (yield.cpu_share >= spin.cpu_share || sleep.cpu_share >= spin.cpu_share) {
+        fprintf(stderr, "Relaxed echo wait policies did not give CPU time back\n");
+        exit(1);
+    }
+    exit(0);
+}
@@ -0,0 +1,312 @@
+// components/ultrasonic_sensor/host_test/bench_us_shared_hal/main/bench_us_shared_hal.cpp
+//
+// Stress benchmark of UsSensor instances sharing one set of HAL objects.
+//
+// N sensors run read_distance() bursts on N std::threads, once with a single
+// shared set of HAL fakes and once with one set per sensor. The fakes run on
+// the host's steady clock: delay_us() busy-waits, task_delay() sleeps, and
+// each sensor's ECHO pin is high from ECHO_RISE_US after its trigger for the
+// round trip to its own target. Nothing in the fakes locks, like the
+// ESP-IDF calls behind the production HALs, so any serialisation would come
+// from the driver or from the HAL dispatch itself.
+//
+// For each N the report gives the aggregate ping rate, the echo width error
+// of every ping (timing distortion from polling threads being preempted) and
+// the largest number of threads seen inside HAL calls at the same time.
+// The gmock dispatch in front of the fakes adds a per-call cost the real HALs
+// do not have, so absolute rates are a floor; the shared/separate ratio is
+// the result.
+//
+// Environment (app_main has no argv):
+//   US_BENCH_MAX_SENSORS=n  Largest N, doubled from 1 (default 8, at most 8).
+//   US_BENCH_BURSTS=n       Bursts per sensor and N (default 40).
+//   US_BENCH_ECHO_WAIT=p    UsConfig::echo_wait: spin, yield or sleep (default spin).
+//
+// Exits non-zero if, while there are no more sensors than hardware threads,
+// a ping fails or a sensor reads another sensor's target. Beyond that the
+// polling threads compete for CPU time and errors are expected; they are
+// reported, not checked.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+#include "i_us_recorder.hpp"
+#include "mock_hal_freertos.hpp"
+#include "mock_hal_gpio.hpp"
+#include "mock_hal_sys_rom.hpp"
+#include "mock_hal_timer.hpp"
+#include "us_driver.hpp"
+#include "us_sensor.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using ::testing::_;
+using ::testing::NiceMock;
+
+static constexpr int MAX_SENSORS = 8;
+static constexpr int PIN_COUNT = 2 * MAX_SENSORS + 2;
+static constexpr int64_t ECHO_RISE_US = 100;
+static constexpr uint8_t PINGS_PER_BURST = 5;
+static constexpr uint16_t PING_INTERVAL_MS = 10;
+static constexpr float TARGET_SPACING_CM = 6.0f;
+
+// Sensor k uses TRIG = 2k + 2 and ECHO = 2k + 3
+static gpio_num_t trig_pin(int k) { return static_cast<gpio_num_t>(2 * k + 2); }
+static gpio_num_t echo_pin(int k) { return static_cast<gpio_num_t>(2 * k + 3); }
+static float target_cm(int k) { return 30.0f + TARGET_SPACING_CM * k; }
+static int64_t width_us(int k) { return std::lround(2.0f * target_cm(k) / UsDriver::SOUND_SPEED_CM_PER_US); }
+
+static int64_t host_us()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/** One set of HAL fakes. Per-pin state only, in atomics, so sensors can share it. */
+struct HalSet
+{
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+
+    std::atomic<bool> trig_high[PIN_COUNT];
+    std::atomic<int64_t> trig_fall_us[PIN_COUNT];
+    std::atomic<int> inside{0};
+    std::atomic<int> max_inside{0};
+
+    HalSet()
+    {
+        for (int p = 0; p < PIN_COUNT; p++) {
+            trig_high[p] = false;
+            trig_fall_us[p] = -1;
+        }
+
+        ON_CALL(gpio, set_level(_, _)).WillByDefault([this](gpio_num_t pin, uint32_t level) {
+            Enter e(*this);
+            int p = static_cast<int>(pin);
+            if (p % 2 == 0) { // TRIG pins are even
+                if (level != 0)
+                    trig_high[p] = true;
+                else if (trig_high[p].exchange(false))
+                    trig_fall_us[p] = host_us();
+            }
+            return ESP_OK;
+        });
+        ON_CALL(gpio, get_level(_)).WillByDefault([this](gpio_num_t pin) {
+            Enter e(*this);
+            int p = static_cast<int>(pin);
+            int k = (p - 3) / 2;
+            int64_t fall = trig_fall_us[p - 1].load();
+            if (fall < 0)
+                return 0;
+            int64_t now = host_us();
+            return (now >= fall + ECHO_RISE_US && now < fall + ECHO_RISE_US + width_us(k)) ? 1 : 0;
+        });
+        ON_CALL(gpio, set_direction(_, _)).WillByDefault([this](gpio_num_t, gpio_mode_t) {
+            Enter e(*this);
+            return ESP_OK;
+        });
+        ON_CALL(timer, get_time_us()).WillByDefault([this]() {
+            Enter e(*this);
+            return host_us();
+        });
+        ON_CALL(sys_rom, delay_us(_)).WillByDefault([this](uint32_t us) {
+            Enter e(*this);
+            int64_t until = host_us() + us;
+            while (host_us() < until) {
+            }
+        });
+        ON_CALL(freertos, task_delay(_)).WillByDefault([](TickType_t ticks) {
+            if (ticks == 0)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(ticks * 1000000LL / configTICK_RATE_HZ));
+        });
+    }
+
+    /** Tracks how many threads are inside a HAL call at the same time. */
+    struct Enter
+    {
+        explicit Enter(HalSet &h) : hal(h)
+        {
+            int now = ++hal.inside;
+            int seen = hal.max_inside.load();
+            while (now > seen && !hal.max_inside.compare_exchange_weak(seen, now)) {
+            }
+        }
+        ~Enter() { --hal.inside; }
+        HalSet &hal;
+    };
+};
+
+/** Collects the echo width error of every ping of one sensor. */
+class EchoErrors : public IUsRecorder
+{
+public:
+    explicit EchoErrors(int k) : k_(k) {}
+
+    void record(const TraceRecord &rec) override
+    {
+        if (rec.result != static_cast<uint8_t>(UsResult::OK)) {
+            failed++;
+            return;
+        }
+        errors_cm.push_back(std::fabs(static_cast<float>(rec.echo_us) - static_cast<float>(width_us(k_))) *
+                            UsDriver::SOUND_SPEED_CM_PER_US / 2.0f);
+    }
+
+    std::vector<float> errors_cm;
+    uint64_t failed = 0;
+
+private:
+    int k_;
+};
+
+struct RunResult
+{
+    double pings_per_s;
+    double mean_err_cm;
+    double p99_err_cm;
+    double max_err_cm;
+    int max_inside;
+    uint64_t failed;
+    int wrong_target; // sensors whose median reading is closer to another target
+};
+
+static RunResult run(int n, bool shared, uint64_t bursts, EchoWait echo_wait)
+{
+    std::vector<std::unique_ptr<HalSet>> hals;
+    for (int k = 0; k < (shared ? 1 : n); k++) {
+        hals.push_back(std::make_unique<HalSet>());
+    }
+
+    UsConfig cfg;
+    cfg.ping_interval_ms = PING_INTERVAL_MS;
+    cfg.warmup_time_ms = 0;
+    cfg.echo_wait = echo_wait;
+
+    std::vector<std::unique_ptr<UsSensor>> sensors;
+    std::vector<std::unique_ptr<EchoErrors>> errors;
+    for (int k = 0; k < n; k++) {
+        HalSet &h = *hals[shared ? 0 : k];
+        sensors.push_back(
+            std::make_unique<UsSensor>(h.gpio, h.timer, h.sys_rom, h.freertos, trig_pin(k), echo_pin(k), cfg));
+        errors.push_back(std::make_unique<EchoErrors>(k));
+        sensors.back()->set_recorder(errors.back().get());
+        sensors.back()->init();
+    }
+
+    std::vector<std::vector<float>> readings(n);
+    std::atomic<int> ready{0};
+    std::vector<std::thread> threads;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k = 0; k < n; k++) {
+        threads.emplace_back([&, k]() {
+            ready++;
+            while (ready.load() < n) {
+                std::this_thread::yield();
+            }
+            for (uint64_t b = 0; b < bursts; b++) {
+                Reading r = sensors[k]->read_distance(PINGS_PER_BURST);
+                if (is_success(r.result))
+                    readings[k].push_back(r.cm);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    RunResult out{};
+    std::vector<float> all;
+    for (int k = 0; k < n; k++) {
+        all.insert(all.end(), errors[k]->errors_cm.begin(), errors[k]->errors_cm.end());
+        out.failed += errors[k]->failed;
+
+        auto &r = readings[k];
+        if (r.empty()) {
+            out.wrong_target++;
+            continue;
+        }
+        std::nth_element(r.begin(), r.begin() + r.size() / 2, r.end());
+        if (std::fabs(r[r.size() / 2] - target_cm(k)) >= TARGET_SPACING_CM / 2.0f)
+            out.wrong_target++;
+    }
+    for (auto &h : hals) {
+        out.max_inside = std::max(out.max_inside, h->max_inside.load());
+    }
+
+    std::sort(all.begin(), all.end());
+    if (!all.empty()) {
+        double sum = 0.0;
+        for (float e : all) sum += e;
+        out.mean_err_cm = sum / all.size();
+        out.p99_err_cm = all[all.size() * 99 / 100];
+        out.max_err_cm = all.back();
+    }
+    out.pings_per_s = static_cast<double>(all.size() + out.failed) / seconds;
+    return out;
+}
+
+static void print_run(int n, const char *mode, const RunResult &r)
+{
+    printf("%2d  %-8s %8.0f pings/s  %6.0f per sensor  error mean %5.2f cm  p99 %5.2f cm  max %6.2f cm"
+           "  in HAL at once %d  failed %" PRIu64 "\n",
+           n, mode, r.pings_per_s, r.pings_per_s / n, r.mean_err_cm, r.p99_err_cm, r.max_err_cm, r.max_inside,
+           r.failed);
+}
+
+extern "C" void app_main(void)
+{
+    const char *sensors_env = getenv("US_BENCH_MAX_SENSORS");
+    const char *bursts_env = getenv("US_BENCH_BURSTS");
+    const char *wait_env = getenv("US_BENCH_ECHO_WAIT");
+    int max_sensors = sensors_env ? atoi(sensors_env) : MAX_SENSORS;
+    uint64_t bursts = bursts_env ? strtoull(bursts_env, nullptr, 10) : 40;
+    max_sensors = std::clamp(max_sensors, 1, MAX_SENSORS);
+    if (bursts == 0)
+        bursts = 1;
+
+    EchoWait echo_wait = EchoWait::SPIN;
+    const char *wait_name = "spin";
+    if (wait_env != nullptr && strcmp(wait_env, "yield") == 0) {
+        echo_wait = EchoWait::SPIN_YIELD;
+        wait_name = "yield";
+    } else if (wait_env != nullptr && strcmp(wait_env, "sleep") == 0) {
+        echo_wait = EchoWait::SPIN_SLEEP;
+        wait_name = "sleep";
+    }
+
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    printf("%" PRIu64 " bursts of %u pings per sensor, %u ms between pings, echo wait %s, %d hardware threads\n",
+           bursts, PINGS_PER_BURST, PING_INTERVAL_MS, wait_name, cores);
+
+    bool ok = true;
+    for (int n = 1; n <= max_sensors; n *= 2) {
+        RunResult separate = run(n, false, bursts, echo_wait);
+        RunResult shared = run(n, true, bursts, echo_wait);
+        print_run(n, "separate", separate);
+        print_run(n, "shared", shared);
+        printf("    shared/separate throughput %.2f\n", shared.pings_per_s / separate.pings_per_s);
+
+        if (n <= cores && (separate.failed != 0 || shared.failed != 0 || separate.wrong_target != 0 || shared.wrong_target != 0)) {
+            fprintf(stderr, "N=%d: failed pings or readings of the wrong target\n", n);
+            ok = false;
+        }
+    }
+    exit(ok ? 0 : 1);
+}
@@ -0,0 +1,359 @@
+// components/ultrasonic_sensor/host_test/fuzz_us_processor/main/fuzz_us_processor.cpp
+//
+// Fuzzing harness for UsProcessor::process (and, through the filter choice,
+// reduce_median / reduce_dominant_cluster).
+//
+// Modes (selected by environment variables, as app_main has no argv):
+//   - default            Built-in mutation loop; tracks the slowest input.
+//   - US_FUZZ_STDIN=1    Run a single input read from stdin (AFL/AFL++ mode).
+//   - US_FUZZ_INPUT=path Run a single input file (crash reproduction).
+// LLVMFuzzerTestOneInput is also exported for libFuzzer builds.
+//
+// Input layout (missing bytes read as zero):
+//   [0]      total_pings passed to process() (may exceed MAX_PINGS)
+//   [1]      bit 0: filter (0 = MEDIAN, 1 = DOMINANT_CLUSTER)
+//   [2..5]   max_dev_cm (raw float bits)
+//   [6..]    per ping: 1 byte UsResult (mod 8) + 4 bytes cm (raw float bits)
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "us_processor.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+
+static constexpr size_t HEADER_BYTES = 6;
+static constexpr size_t PING_BYTES = 5;
+static constexpr size_t MAX_INPUT_PINGS = 255;
+static constexpr size_t MAX_INPUT = HEADER_BYTES + PING_BYTES * MAX_INPUT_PINGS;
+static constexpr int TIMING_RUNS = 3;
+
+/** Cycle counter of the host CPU, or nanoseconds where none is available. */
+static inline uint64_t read_cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+static const char *CYCLE_UNIT =
+#if defined(__x86_64__) || defined(__i386__)
+    "cycles";
+#else
+    "ns";
+#endif
+
+struct DecodedInput
+{
+    uint8_t total_pings;
+    UsConfig cfg;
+    Reading pings[MAX_INPUT_PINGS + 1];
+};
+
+static float read_float(const uint8_t *p)
+{
+    float f;
+    memcpy(&f, p, sizeof(f));
+    return f;
+}
+
+static void decode(const uint8_t *data, size_t size, DecodedInput &in)
+{
+    uint8_t buf[MAX_INPUT] = {};
+    memcpy(buf, data, std::min(size, MAX_INPUT));
+
+    in.total_pings = buf[0];
+    in.cfg = UsConfig{};
+    in.cfg.filter = (buf[1] & 1) ? Filter::DOMINANT_CLUSTER : Filter::MEDIAN;
+    in.cfg.max_dev_cm = read_float(&buf[2]);
+
+    for (size_t i = 0; i < MAX_INPUT_PINGS; i++) {
+        const uint8_t *p = &buf[HEADER_BYTES + i * PING_BYTES];
+        in.pings[i].result = static_cast<UsResult>(p[0] % 8);
+        in.pings[i].cm = read_float(p + 1);
+    }
+}
+
+static void fail(const char *what, const DecodedInput &in, const Reading &out)
+{
+    fprintf(stderr, "INVARIANT VIOLATED: %s (total_pings=%u filter=%d max_dev=%g -> result=%d cm=%g)\n", what,
+            in.total_pings, static_cast<int>(in.cfg.filter), in.cfg.max_dev_cm, static_cast<int>(out.result), out.cm);
+    abort();
+}
+
+/** Checks the output of process() against properties that must hold for any input. */
+static void check(const DecodedInput &in, const Reading &out)
+{
+    if (static_cast<int>(out.result) < 0 || out.result > UsResult::HW_FAULT)
+        fail("result outside UsResult", in, out);
+    if (out.result == UsResult::ECHO_STUCK || out.result == UsResult::HW_FAULT)
+        fail("processor reported a hardware failure", in, out);
+
+    if (!is_success(out.result)) {
+        if (out.cm != 0.0f)
+            fail("failed result carries a distance", in, out);
+        return;
+    }
+
+    if (!std::isfinite(out.cm))
+        fail("successful result is not finite", in, out);
+
+    // The filtered distance must lie within the valid samples actually considered
+    size_t considered = std::min<size_t>(in.total_pings, IUsProcessor::MAX_PINGS);
+    float lo = INFINITY;
+    float hi = -INFINITY;
+    for (size_t i = 0; i < considered; i++) {
+        if (is_success(in.pings[i].result) && std::isfinite(in.pings[i].cm)) {
+            lo = std::min(lo, in.pings[i].cm);
+            hi = std::max(hi, in.pings[i].cm);
+        }
+    }
+    // Allow for float rounding of the cluster average
+    float tol = std::max(std::fabs(lo), std::fabs(hi)) * 1e-6f;
+    if (out.cm < lo - tol || out.cm > hi + tol)
+        fail("distance outside the valid samples", in, out);
+}
+
+/** Runs one input; returns the fastest of TIMING_RUNS calls. */
+static uint64_t run_one(const uint8_t *data, size_t size, UsResult *result_out = nullptr)
+{
+    static DecodedInput in;
+    decode(data, size, in);
+
+    UsProcessor processor;
+    uint64_t best = UINT64_MAX;
+    Reading out = {};
+    for (int r = 0; r < TIMING_RUNS; r++) {
+        uint64_t t0 = read_cycles();
+        out = processor.process(in.pings, in.total_pings, in.cfg);
+        uint64_t t1 = read_cycles();
+        best = std::min(best, t1 - t0);
+    }
+
+    check(in, out);
+    if (result_out)
+        *result_out = out.result;
+    return best;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    run_one(data, size);
+    return 0;
+}
+
+// =================================================================
+// Built-in mutation loop
+// =================================================================
+
+using Input = std::vector<uint8_t>;
+
+static Input make_input(uint8_t total, bool cluster, float max_dev, const std::vector<Reading> &pings)
+{
+    Input in(HEADER_BYTES + PING_BYTES * pings.size());
+    in[0] = total;
+    in[1] = cluster ? 1 : 0;
+    memcpy(&in[2], &max_dev, sizeof(max_dev));
+    for (size_t i = 0; i < pings.size(); i++) {
+        in[HEADER_BYTES + i * PING_BYTES] = static_cast<uint8_t>(pings[i].result);
+        memcpy(&in[HEADER_BYTES + i * PING_BYTES + 1], &pings[i].cm, sizeof(float));
+    }
+    return in;
+}
+
+static std::vector<Input> seed_corpus()
+{
+    std::vector<Input> seeds;
+    const uint8_t max = IUsProcessor::MAX_PINGS;
+
+    for (bool cluster : {false, true}) {
+        seeds.push_back(make_input(max, cluster, 15.0f, std::vector<Reading>(max, {UsResult::OK, 50.0f})));
+        seeds.push_back(make_input(max, cluster, 0.0f, std::vector<Reading>(max, {UsResult::OK, 123.4f})));
+        seeds.push_back(make_input(255, cluster, 15.0f, std::vector<Reading>(255, {UsResult::OK, 50.0f})));
+        seeds.push_back(make_input(7, cluster, 15.0f, std::vector<Reading>(7, {UsResult::OK, NAN})));
+        seeds.push_back(make_input(5, cluster, NAN, {{UsResult::OK, 1.0f}, {UsResult::OK, INFINITY}}));
+        seeds.push_back(make_input(max, cluster, 1e9f, std::vector<Reading>(max, {UsResult::TIMEOUT, 0.0f})));
+
+        std::vector<Reading> spread;
+        for (uint8_t i = 0; i < max; i++) spread.push_back({UsResult::OK, 10.0f + 4.9f * i});
+        seeds.push_back(make_input(max, cluster, 1e9f, spread));
+    }
+    return seeds;
+}
+
+static void mutate(Input &in, std::mt19937 &rng)
+{
+    if (in.size() < HEADER_BYTES)
+        in.resize(HEADER_BYTES);
+
+    std::uniform_int_distribution<int> op(0, 6);
+    std::uniform_int_distribution<size_t> byte(0, in.size() - 1);
+    size_t pings = (in.size() - HEADER_BYTES) / PING_BYTES;
+    std::uniform_int_distribution<size_t> ping(0, pings ? pings - 1 : 0);
+
+    static const float special[] = {NAN, INFINITY, -INFINITY, 0.0f, -0.0f, 1e-45f, 3.4e38f, -1.0f, 10.0f, 200.0f};
+
+    switch (op(rng)) {
+    case 0: // flip a bit
+        in[byte(rng)] ^= static_cast<uint8_t>(1u << (rng() % 8));
+        break;
+    case 1: // random byte
+        in[byte(rng)] = static_cast<uint8_t>(rng());
+        break;
+    case 2: // new ping count
+        in[0] = static_cast<uint8_t>(rng());
+        break;
+    case 3: // special float into a ping
+        if (pings) {
+            float f = special[rng() % (sizeof(special) / sizeof(special[0]))];
+            memcpy(&in[HEADER_BYTES + ping(rng) * PING_BYTES + 1], &f, sizeof(f));
+        }
+        break;
+    case 4: // nudge a ping distance
+        if (pings) {
+            size_t at = HEADER_BYTES + ping(rng) * PING_BYTES + 1;
+            float f;
+            memcpy(&f, &in[at], sizeof(f));
+            f += std::uniform_real_distribution<float>(-10.0f, 10.0f)(rng);
+            memcpy(&in[at], &f, sizeof(f));
+        }
+        break;
+    case 5: // append a ping
+        if (pings < MAX_INPUT_PINGS) {
+            for (size_t i = 0; i < PING_BYTES; i++) in.push_back(static_cast<uint8_t>(rng()));
+            in[in.size() - PING_BYTES] %= 8;
+        }
+        break;
+    default: // duplicate a ping over another
+        if (pings > 1) {
+            size_t a = HEADER_BYTES + ping(rng) * PING_BYTES;
+            size_t b = HEADER_BYTES + ping(rng) * PING_BYTES;
+            memcpy(&in[b], &in[a], PING_BYTES);
+        }
+        break;
+    }
+}
+
+static bool read_file(FILE *f, Input &out)
+{
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    return !ferror(f);
+}
+
+static void run_single(FILE *f)
+{
+    Input in;
+    if (!read_file(f, in)) {
+        fprintf(stderr, "Cannot read input\n");
+        exit(2);
+    }
+    uint64_t c = run_one(in.data(), in.size());
+    printf("OK: %" PRIu64 " %s\n", c, CYCLE_UNIT);
+}
+
+static void run_loop()
+{
+    const char *it_env = getenv("US_FUZZ_ITERATIONS");
+    const char *seed_env = getenv("US_FUZZ_SEED");
+    uint64_t iterations = it_env ? strtoull(it_env, nullptr, 10) : 1000000;
+    std::mt19937 rng(seed_env ? static_cast<unsigned>(strtoul(seed_env, nullptr, 10)) : 1);
+
+    std::vector<Input> corpus = seed_corpus();
+    Input slowest;
+    uint64_t slowest_cycles = 0;
+    uint64_t total_cycles = 0;
+    uint64_t results[8] = {};
+
+    for (const Input &s : corpus) {
+        uint64_t c = run_one(s.data(), s.size());
+        if (c > slowest_cycles) {
+            slowest_cycles = c;
+            slowest = s;
+        }
+    }
+
+    for (uint64_t i = 0; i < iterations; i++) {
+        // Bias mutations towards the slowest input to climb towards the worst case
+        Input in = (rng() % 4 == 0) ? slowest : corpus[rng() % corpus.size()];
+        int rounds = 1 + static_cast<int>(rng() % 4);
+        for (int r = 0; r < rounds; r++) mutate(in, rng);
+
+        UsResult result;
+        uint64_t c = run_one(in.data(), in.size(), &result);
+        total_cycles += c;
+        results[static_cast<int>(result)]++;
+
+        if (c > slowest_cycles) {
+            slowest_cycles = c;
+            slowest = in;
+        }
+        if (results[static_cast<int>(result)] == 1 && corpus.size() < 1024) {
+            corpus.push_back(in); // first input reaching this outcome
+        }
+    }
+
+    printf("Iterations: %" PRIu64 "\n", iterations);
+    printf("Mean: %.1f %s/call, worst: %" PRIu64 " %s/call\n",
+           iterations ? static_cast<double>(total_cycles) / iterations : 0.0, CYCLE_UNIT, slowest_cycles, CYCLE_UNIT);
+    printf("Outcomes:");
+    for (int r = 0; r < 8; r++) printf(" %d=%" PRIu64, r, results[r]);
+    printf("\n");
+
+    DecodedInput d;
+    decode(slowest.data(), slowest.size(), d);
+    printf("Slowest input: total_pings=%u filter=%s max_dev=%g\n", d.total_pings,
+           d.cfg.filter == Filter::MEDIAN ? "MEDIAN" : "DOMINANT_CLUSTER", d.cfg.max_dev_cm);
+
+    const char *out_path = getenv("US_FUZZ_SLOWEST_OUT");
+    if (out_path != nullptr) {
+        FILE *f = fopen(out_path, "wb");
+        if (f == nullptr || fwrite(slowest.data(), 1, slowest.size(), f) != slowest.size()) {
+            fprintf(stderr, "Cannot write %s\n", out_path);
+            exit(1);
+        }
+        fclose(f);
+        printf("Slowest input written to %s\n", out_path);
+    }
+}
+
+extern "C" void app_main(void)
+{
+    const char *input = getenv("US_FUZZ_INPUT");
+    if (input != nullptr) {
+        FILE *f = fopen(input, "rb");
+        if (f == nullptr) {
+            fprintf(stderr, "Cannot open %s\n", input);
+            exit(2);
+        }
+        run_single(f);
+        fclose(f);
+        exit(0);
+    }
+
+    const char *use_stdin = getenv("US_FUZZ_STDIN");
+    if (use_stdin != nullptr && strcmp(use_stdin, "1") == 0) {
+        run_single(stdin);
+        exit(0);
+    }
+
+    run_loop();
+    exit(0);
+}
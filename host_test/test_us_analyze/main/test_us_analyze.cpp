@@ -0,0 +1,222 @@
+// components/ultrasonic_sensor/host_test/test_us_analyze/main/test_us_analyze.cpp
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "analyze.hpp"
+#include "us_trace.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using namespace us_analyze;
+
+// =================================================================
+// Trace files
+// =================================================================
+
+/** Echo width of a target at @p cm. */
+static uint32_t echo_of(float cm)
+{
+    return static_cast<uint32_t>(std::lround(cm / (SOUND_SPEED_CM_PER_US / 2.0f)));
+}
+
+/** Append a burst of @p pings pings with the given result, all echoing @p cm. */
+static void add_burst(std::vector<TraceRecord> &records, uint8_t pings, UsResult result, float cm)
+{
+    for (uint8_t i = 0; i < pings; i++) {
+        TraceRecord rec{};
+        rec.timestamp_us = static_cast<int64_t>(records.size()) * 70000;
+        rec.echo_us = (result == UsResult::OK) ? echo_of(cm) + i : 0;
+        rec.result = static_cast<uint8_t>(result);
+        rec.ping_index = i;
+        rec.ping_count = pings;
+        records.push_back(rec);
+    }
+}
+
+/** Write a trace file, optionally followed by the first half of one more record. */
+static std::string write_trace(const char *name, uint32_t sensor_id, const std::vector<TraceRecord> &records,
+                               bool truncated_tail = false)
+{
+    const std::string path = ::testing::TempDir() + name;
+    FILE *f = fopen(path.c_str(), "wb");
+    EXPECT_NE(f, nullptr);
+    const TraceHeader header = make_trace_header(UsConfig{}, sensor_id);
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(records.data(), sizeof(TraceRecord), records.size(), f);
+    if (truncated_tail) {
+        const TraceRecord partial{};
+        fwrite(&partial, sizeof(partial) / 2, 1, f);
+    }
+    fclose(f);
+    return path;
+}
+
+class UsAnalyzeTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // Sensor 7, first file: five 3-ping bursts at 100 cm, the middle one silent
+        std::vector<TraceRecord> a;
+        for (int i = 0; i < 5; i++) add_burst(a, 3, (i == 2) ? UsResult::TIMEOUT : UsResult::OK, 100.0f);
+        ASSERT_EQ(ESP_OK, trace_a_.open(write_trace("us_analyze_a.trace", 7, a, true).c_str()));
+
+        // Sensor 7, second file: two 4-ping bursts at 100 cm
+        std::vector<TraceRecord> b;
+        for (int i = 0; i < 2; i++) add_burst(b, 4, UsResult::OK, 100.0f);
+        ASSERT_EQ(ESP_OK, trace_b_.open(write_trace("us_analyze_b.trace", 7, b).c_str()));
+
+        // Sensor 9: one 2-ping burst at 30 cm
+        std::vector<TraceRecord> c;
+        add_burst(c, 2, UsResult::OK, 30.0f);
+        ASSERT_EQ(ESP_OK, trace_c_.open(write_trace("us_analyze_c.trace", 9, c).c_str()));
+
+        // Candidate: nothing beyond 50 cm is in range
+        overrides_ = {NAN, NAN, 50.0f, -1, 0};
+    }
+
+    static size_t index(UsResult r) { return static_cast<size_t>(r); }
+
+    MappedTrace trace_a_;
+    MappedTrace trace_b_;
+    MappedTrace trace_c_;
+    Overrides overrides_;
+};
+
+// =================================================================
+// MappedTrace
+// =================================================================
+
+TEST_F(UsAnalyzeTest, TruncatedRecordIgnored)
+{
+    EXPECT_EQ(trace_a_.count(), 15u);
+    EXPECT_EQ(trace_a_.sensor_id(), 7u);
+    EXPECT_EQ(trace_a_.records()[14].ping_index, 2);
+    EXPECT_EQ(ESP_ERR_INVALID_STATE, trace_a_.open("unused"));
+}
+
+TEST_F(UsAnalyzeTest, ReleaseKeepsRecordsReadable)
+{
+    const std::vector<TraceRecord> before(trace_a_.records(), trace_a_.records() + trace_a_.count());
+    trace_a_.release(0, trace_a_.count());
+    trace_a_.release(5, 5);
+    trace_a_.release(10, 3);
+    trace_a_.release(0, 1000); // clamped to the file
+
+    for (size_t i = 0; i < before.size(); i++) {
+        EXPECT_EQ(before[i].echo_us, trace_a_.records()[i].echo_us);
+        EXPECT_EQ(before[i].ping_index, trace_a_.records()[i].ping_index);
+    }
+
+    trace_a_.close();
+    trace_a_.release(0, 15); // unmapped: no-op
+    EXPECT_EQ(trace_a_.count(), 0u);
+}
+
+// =================================================================
+// Chunking
+// =================================================================
+
+TEST_F(UsAnalyzeTest, ChunksStartOnBurstBoundaries)
+{
+    // 4-record chunks cut the second 3-ping burst; the cut moves to its end
+    std::vector<Chunk> chunks;
+    plan_chunks(trace_a_, 4, chunks);
+    ASSERT_EQ(chunks.size(), 3u);
+    EXPECT_EQ(chunks[0].first, 0u);
+    EXPECT_EQ(chunks[0].last, 6u);
+    EXPECT_EQ(chunks[1].first, 6u);
+    EXPECT_EQ(chunks[1].last, 12u);
+    EXPECT_EQ(chunks[2].first, 12u);
+    EXPECT_EQ(chunks[2].last, 15u);
+
+    // Any chunk size gives the same bursts as one chunk over the whole file
+    const Summary whole = analyze_chunk({&trace_a_, 0, trace_a_.count()}, overrides_);
+    EXPECT_EQ(whole.bursts, 5u);
+    for (size_t size = 0; size <= 16; size++) {
+        std::vector<Chunk> split;
+        plan_chunks(trace_a_, size, split);
+        Summary sum;
+        for (const Chunk &c : split) {
+            EXPECT_EQ(trace_a_.records()[c.first].ping_index, 0) << "chunk size " << size;
+            sum.merge(analyze_chunk(c, overrides_));
+        }
+        EXPECT_EQ(sum.bursts, whole.bursts) << "chunk size " << size;
+        EXPECT_EQ(sum.pings, 15u) << "chunk size " << size;
+        EXPECT_EQ(sum.changed(), whole.changed()) << "chunk size " << size;
+    }
+}
+
+// =================================================================
+// Reprocessing
+// =================================================================
+
+TEST_F(UsAnalyzeTest, ChunkCountsTransitions)
+{
+    const Summary s = analyze_chunk({&trace_a_, 0, trace_a_.count()}, overrides_);
+    const size_t ok = index(UsResult::OK);
+    const size_t oor = index(UsResult::OUT_OF_RANGE);
+    const size_t timeout = index(UsResult::TIMEOUT);
+
+    EXPECT_EQ(s.sensor_id, 7u);
+    EXPECT_EQ(s.baseline[ok], 4u);
+    EXPECT_EQ(s.baseline[timeout], 1u);
+    EXPECT_EQ(s.candidate[oor], 4u);
+    EXPECT_EQ(s.candidate[timeout], 1u);
+    EXPECT_EQ(s.transitions[ok][oor], 4u);
+    EXPECT_EQ(s.transitions[timeout][timeout], 1u);
+    EXPECT_EQ(s.changed(), 4u);
+    EXPECT_EQ(s.both_success, 0u);
+    EXPECT_DOUBLE_EQ(s.success_rate(s.baseline), 0.8);
+    EXPECT_DOUBLE_EQ(s.success_rate(s.candidate), 0.0);
+}
+
+TEST_F(UsAnalyzeTest, MergesPerSensorAcrossFiles)
+{
+    std::vector<Chunk> chunks;
+    plan_chunks(trace_a_, 4, chunks);
+    plan_chunks(trace_b_, 3, chunks);
+    plan_chunks(trace_c_, 1, chunks);
+
+    const std::vector<Summary> sensors = analyze(chunks, overrides_, 3);
+    ASSERT_EQ(sensors.size(), 2u);
+
+    const Summary &s7 = sensors[0];
+    EXPECT_EQ(s7.sensor_id, 7u);
+    EXPECT_EQ(s7.bursts, 7u);
+    EXPECT_EQ(s7.pings, 23u);
+    EXPECT_EQ(s7.transitions[index(UsResult::OK)][index(UsResult::OUT_OF_RANGE)], 6u);
+    EXPECT_EQ(s7.transitions[index(UsResult::TIMEOUT)][index(UsResult::TIMEOUT)], 1u);
+    EXPECT_EQ(s7.changed(), 6u);
+
+    // In range under both configurations: unchanged and unshifted
+    const Summary &s9 = sensors[1];
+    EXPECT_EQ(s9.sensor_id, 9u);
+    EXPECT_EQ(s9.bursts, 1u);
+    EXPECT_EQ(s9.transitions[index(UsResult::OK)][index(UsResult::OK)], 1u);
+    EXPECT_EQ(s9.both_success, 1u);
+    EXPECT_EQ(s9.changed(), 0u);
+    EXPECT_NEAR(s9.mean_shift_cm(), 0.0, 1e-6);
+
+    // Thread count does not change the totals
+    const std::vector<Summary> serial = analyze(chunks, overrides_, 1);
+    ASSERT_EQ(serial.size(), 2u);
+    EXPECT_EQ(serial[0].bursts, s7.bursts);
+    EXPECT_EQ(serial[0].changed(), s7.changed());
+}
+
+TEST_F(UsAnalyzeTest, PingCountOverrideUsesFirstPings)
+{
+    Overrides first_ping{NAN, NAN, NAN, -1, 1};
+    const Summary s = analyze_chunk({&trace_b_, 0, trace_b_.count()}, first_ping);
+    EXPECT_EQ(s.bursts, 2u);
+    EXPECT_EQ(s.pings, 8u); // every recorded ping is read
+    EXPECT_EQ(s.both_success, 2u);
+    EXPECT_GT(s.mean_shift_cm(), 0.0); // one ping instead of four moves the distance
+}
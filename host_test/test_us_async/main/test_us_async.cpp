@@ -0,0 +1,409 @@
+// components/ultrasonic_sensor/host_test/test_us_async/main/test_us_async.cpp
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp_err.h"
+
+#include "mock_hal_freertos.hpp"
+#include "mock_hal_gpio.hpp"
+#include "mock_hal_sys_rom.hpp"
+#include "mock_hal_timer.hpp"
+#include "us_driver.hpp"
+#include "us_executor.hpp"
+#include "us_jitter.hpp"
+#include "us_processor.hpp"
+#include "us_sensor.hpp"
+#include "us_task.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using ::testing::_;
+using ::testing::Field;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+/**
+ * Simulated time shared by the executor and every driver. It only moves when
+ * someone waits (delay_us, task_delay), plus an optional cost per timer read.
+ */
+struct VirtualClock
+{
+    int64_t now = 0;
+    int64_t cost_per_read_us = 0;
+    uint32_t task_delays = 0;
+    uint32_t busy_waits = 0;
+
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+
+    VirtualClock()
+    {
+        ON_CALL(timer, get_time_us()).WillByDefault([this]() {
+            now += cost_per_read_us;
+            return now;
+        });
+        ON_CALL(sys_rom, delay_us(_)).WillByDefault([this](uint32_t us) {
+            busy_waits++;
+            now += us;
+        });
+        ON_CALL(freertos, task_delay(_)).WillByDefault([this](TickType_t ticks) {
+            task_delays++;
+            now += static_cast<int64_t>(ticks) * 1000000 / configTICK_RATE_HZ;
+        });
+    }
+};
+
+// =================================================================
+// UsTask / UsExecutor
+// =================================================================
+
+static UsTask<int> add(int a, int b)
+{
+    co_return a + b;
+}
+
+static UsTask<int> add_twice(int a, int b, int c)
+{
+    int x = co_await add(a, b);
+    int y = co_await add(x, c);
+    co_return y;
+}
+
+TEST(UsExecutorTest, NestedTasksReturnValues)
+{
+    VirtualClock clock;
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos);
+    EXPECT_EQ(6, exec.block_on(add_twice(1, 2, 3)));
+}
+
+static UsTask<void> sleeper(UsExecutor &exec, uint32_t us, int id, std::vector<int> &order)
+{
+    co_await exec.sleep_us(us);
+    order.push_back(id);
+}
+
+TEST(UsExecutorTest, SleepersWakeInDeadlineOrder)
+{
+    VirtualClock clock;
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos);
+    std::vector<int> order;
+
+    exec.spawn(sleeper(exec, 3000, 0, order));
+    exec.spawn(sleeper(exec, 1000, 1, order));
+    exec.spawn(sleeper(exec, 2500, 2, order));
+    exec.spawn(sleeper(exec, 1000, 3, order)); // same deadline as 1: FIFO
+    EXPECT_EQ(4u, exec.active());
+    exec.run();
+
+    EXPECT_EQ((std::vector<int>{1, 3, 2, 0}), order);
+    EXPECT_EQ(0u, exec.active());
+    EXPECT_GE(clock.now, 3000);
+    EXPECT_LT(clock.now, 3100);
+
+    // Whole ticks are slept with task_delay, the sub-tick rest with delay_us
+    EXPECT_GT(clock.task_delays, 0u);
+    EXPECT_GT(clock.busy_waits, 0u);
+}
+
+static UsTask<void> ping_pong(UsExecutor &exec, char name, int rounds, std::string &log)
+{
+    for (int i = 0; i < rounds; i++) {
+        log += name;
+        co_await exec.yield();
+    }
+}
+
+TEST(UsExecutorTest, YieldInterleavesReadyTasks)
+{
+    VirtualClock clock;
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos);
+    std::string log;
+
+    exec.spawn(ping_pong(exec, 'a', 3, log));
+    exec.spawn(ping_pong(exec, 'b', 3, log));
+    exec.run();
+
+    EXPECT_EQ("ababab", log);
+    EXPECT_EQ(0u, clock.task_delays + clock.busy_waits);
+}
+
+struct DestroyCounter
+{
+    int &destroyed;
+    ~DestroyCounter() { destroyed++; }
+};
+
+static UsTask<void> waits_forever(UsExecutor &exec, int &destroyed)
+{
+    DestroyCounter guard{destroyed};
+    co_await exec.sleep_us(1000000);
+    co_await exec.sleep_us(1000000);
+}
+
+static UsTask<void> awaits_child(UsExecutor &exec, int &destroyed)
+{
+    DestroyCounter guard{destroyed};
+    co_await waits_forever(exec, destroyed);
+}
+
+TEST(UsExecutorTest, DestroyingExecutorReleasesPendingTasks)
+{
+    VirtualClock clock;
+    int destroyed = 0;
+    {
+        UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos);
+        exec.spawn(awaits_child(exec, destroyed));
+        exec.run_once();
+        EXPECT_EQ(0, destroyed);
+    }
+    EXPECT_EQ(2, destroyed);
+}
+
+// =================================================================
+// Simulated sensors
+// =================================================================
+
+/** One sensor on its own GPIO fake, answering from the virtual clock. */
+struct SimSensor
+{
+    static constexpr gpio_num_t TRIG = GPIO_NUM_4;
+    static constexpr gpio_num_t ECHO = GPIO_NUM_5;
+    static constexpr int64_t BURST_DELAY_US = 100;
+
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    float target_cm = 0.0f;
+    bool echo_returns = true;
+    int64_t trigger_us = -1;
+    std::shared_ptr<UsDriver> driver;
+    std::unique_ptr<UsSensor> sensor;
+
+    SimSensor(VirtualClock &clock, float cm, const UsConfig &cfg)
+        : target_cm(cm)
+    {
+        ON_CALL(gpio, set_level(_, _)).WillByDefault([this, &clock](gpio_num_t pin, uint32_t level) {
+            if (pin == TRIG && level == 0)
+                trigger_us = clock.now;
+            return ESP_OK;
+        });
+        ON_CALL(gpio, get_level(ECHO)).WillByDefault([this, &clock](gpio_num_t) {
+            if (trigger_us < 0 || !echo_returns)
+                return 0;
+            int64_t rise = trigger_us + BURST_DELAY_US;
+            int64_t fall = rise + std::lround(2.0f * target_cm / UsDriver::SOUND_SPEED_CM_PER_US);
+            return (clock.now >= rise && clock.now < fall) ? 1 : 0;
+        });
+
+        driver = std::make_shared<UsDriver>(gpio, clock.timer, clock.sys_rom, TRIG, ECHO);
+        sensor = std::make_unique<UsSensor>(cfg, driver, std::make_shared<UsProcessor>(), clock.freertos,
+                                            clock.timer);
+    }
+};
+
+TEST(UsAsyncDriverTest, AwaitedPingMatchesBlockingPing)
+{
+    VirtualClock clock;
+    clock.cost_per_read_us = 1; // blocking polls need time to pass
+    UsConfig cfg;
+    SimSensor sim(clock, 123.0f, cfg);
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos);
+
+    Reading blocking = sim.driver->ping_once(cfg);
+    Reading awaited = exec.block_on(sim.driver->ping(exec, cfg));
+
+    ASSERT_EQ(UsResult::OK, blocking.result);
+    ASSERT_EQ(UsResult::OK, awaited.result);
+    EXPECT_NEAR(blocking.cm, awaited.cm, 0.1f);
+    EXPECT_NEAR(123.0f, awaited.cm, 0.5f);
+    EXPECT_EQ(sim.driver->last_echo_us(), static_cast<uint32_t>(std::lround(awaited.cm * 2.0f / UsDriver::SOUND_SPEED_CM_PER_US)));
+}
+
+static UsTask<void> ping_into(UsExecutor &exec, UsDriver &driver, const UsConfig &cfg, Reading &out)
+{
+    out = co_await driver.ping(exec, cfg);
+}
+
+static UsTask<void> tick_until_triggered(UsExecutor &exec, const SimSensor &sim, int &ticks)
+{
+    while (sim.trigger_us < 0) {
+        ticks++;
+        co_await exec.sleep_us(100);
+    }
+}
+
+TEST(UsAsyncDriverTest, JitterAndPulseDoNotBlockOtherTasks)
+{
+    VirtualClock clock;
+    UsConfig cfg;
+    cfg.trigger_jitter_us = 5000;
+    cfg.jitter_seed = 42;
+    SimSensor sim(clock, 50.0f, cfg);
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos, 10);
+    const int64_t jitter_us = UsJitter(cfg.jitter_seed).next_delay_us(cfg.trigger_jitter_us);
+
+    Reading r;
+    int ticks = 0;
+    exec.spawn(ping_into(exec, *sim.driver, cfg, r));
+    exec.spawn(tick_until_triggered(exec, sim, ticks));
+    exec.run();
+
+    EXPECT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(50.0f, r.cm, 0.5f);
+    EXPECT_GE(sim.trigger_us, jitter_us + cfg.ping_duration_us);
+    EXPECT_LT(sim.trigger_us, jitter_us + cfg.ping_duration_us + 50);
+    EXPECT_GE(ticks, static_cast<int>(jitter_us / 100));
+}
+
+TEST(UsAsyncDriverTest, MissingEchoTimesOut)
+{
+    VirtualClock clock;
+    UsConfig cfg;
+    SimSensor sim(clock, 50.0f, cfg);
+    sim.echo_returns = false;
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos, 100);
+
+    Reading r = exec.block_on(sim.driver->ping(exec, cfg));
+    EXPECT_EQ(UsResult::TIMEOUT, r.result);
+    EXPECT_GE(clock.now, static_cast<int64_t>(cfg.timeout_us));
+    EXPECT_LT(clock.now, static_cast<int64_t>(cfg.timeout_us) + 1000);
+}
+
+class BlockingOnlyDriver : public IUsDriver
+{
+public:
+    MOCK_METHOD(esp_err_t, init, (), (override));
+    MOCK_METHOD(esp_err_t, deinit, (), (override));
+    MOCK_METHOD(Reading, ping_once, (const UsConfig &cfg), (override));
+};
+
+TEST(UsAsyncDriverTest, DefaultPingFallsBackToPingOnce)
+{
+    VirtualClock clock;
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos);
+    BlockingOnlyDriver driver;
+    EXPECT_CALL(driver, ping_once(_)).WillOnce(Return(Reading{UsResult::OK, 77.0f}));
+
+    Reading r = exec.block_on(driver.ping(exec, UsConfig{}));
+    EXPECT_EQ((Reading{UsResult::OK, 77.0f}), r);
+
+    // The compiled overload forwards to the same path with its source configuration
+    UsConfig cfg;
+    cfg.timeout_us = 12345;
+    const UsCompiledConfig cc(cfg);
+    EXPECT_CALL(driver, ping_once(Field(&UsConfig::timeout_us, 12345)))
+        .WillOnce(Return(Reading{UsResult::OK, 78.0f}));
+    EXPECT_EQ((Reading{UsResult::OK, 78.0f}), exec.block_on(driver.ping(exec, cc)));
+}
+
+static UsTask<void> measure_into(UsExecutor &exec, UsSensor &sensor, uint8_t pings, Reading &out)
+{
+    out = co_await sensor.measure(exec, pings);
+}
+
+/** Driver with only the compiled asynchronous path; records which configuration it was handed. */
+class CompiledPingDriver : public IUsDriver
+{
+public:
+    esp_err_t init() override { return ESP_OK; }
+    esp_err_t deinit() override { return ESP_OK; }
+    Reading ping_once(const UsConfig &cfg) override
+    {
+        uncompiled_pings++;
+        return {UsResult::OK, 50.0f};
+    }
+    UsTask<Reading> ping(UsExecutor &exec, const UsCompiledConfig &cc) override
+    {
+        seen = &cc;
+        co_await exec.yield();
+        co_return Reading{UsResult::OK, 50.0f};
+    }
+    using IUsDriver::ping;
+
+    const UsCompiledConfig *seen = nullptr;
+    int uncompiled_pings = 0;
+};
+
+TEST(UsAsyncSensorTest, MeasurePassesCompiledConfig)
+{
+    VirtualClock clock;
+    UsConfig cfg;
+    cfg.ping_interval_ms = 0;
+    auto driver = std::make_shared<CompiledPingDriver>();
+    UsSensor sensor(cfg, driver, std::make_shared<UsProcessor>(), clock.freertos);
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos);
+
+    Reading r = exec.block_on(sensor.measure(exec, 3));
+    EXPECT_EQ(UsResult::OK, r.result);
+    EXPECT_EQ(&sensor.compiled_config(), driver->seen);
+    EXPECT_EQ(0, driver->uncompiled_pings);
+}
+
+TEST(UsAsyncSensorTest, MeasurePublishesAndOverlapsSensors)
+{
+    VirtualClock clock;
+    UsConfig cfg;
+    cfg.ping_interval_ms = 20;
+    SimSensor near(clock, 40.0f, cfg);
+    SimSensor far(clock, 180.0f, cfg);
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos, 10);
+
+    Reading r_near;
+    Reading r_far;
+    exec.spawn(measure_into(exec, *near.sensor, 5, r_near));
+    exec.spawn(measure_into(exec, *far.sensor, 5, r_far));
+    exec.run();
+
+    EXPECT_EQ(UsResult::OK, r_near.result);
+    EXPECT_NEAR(40.0f, r_near.cm, 0.5f);
+    EXPECT_EQ(UsResult::OK, r_far.result);
+    EXPECT_NEAR(180.0f, r_far.cm, 0.5f);
+    EXPECT_EQ(r_far, far.sensor->get_latest(1000).reading);
+
+    // Both bursts ran side by side: about one burst of the far sensor, not the sum
+    const int64_t one_far_burst = 5 * 10600 + 4 * 20000;
+    EXPECT_LT(clock.now, one_far_burst + 5000);
+    EXPECT_GT(exec.resumptions(), 10u);
+}
+
+TEST(UsAsyncSensorTest, ThousandsOfSensorsOnOneThread)
+{
+    constexpr size_t SENSORS = 2000;
+    VirtualClock clock;
+    UsConfig cfg;
+    cfg.ping_interval_ms = 10;
+    cfg.max_distance_cm = 300.0f;
+    UsExecutor exec(clock.timer, clock.sys_rom, clock.freertos, 25);
+
+    std::vector<std::unique_ptr<SimSensor>> sims;
+    std::vector<Reading> results(SENSORS);
+    for (size_t k = 0; k < SENSORS; k++) {
+        float cm = 20.0f + static_cast<float>(k % 250);
+        sims.push_back(std::make_unique<SimSensor>(clock, cm, cfg));
+        exec.spawn(measure_into(exec, *sims.back()->sensor, 3, results[k]));
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    exec.run();
+    auto wall_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+
+    size_t correct = 0;
+    for (size_t k = 0; k < SENSORS; k++) {
+        if (results[k].result == UsResult::OK && std::fabs(results[k].cm - sims[k]->target_cm) < 1.0f)
+            correct++;
+    }
+    EXPECT_EQ(SENSORS, correct);
+
+    // Every sensor finished within the time of a single burst of the farthest target
+    const int64_t longest_burst = 3 * (100 + 2 * 269 * 29 + 100) + 2 * 10000;
+    EXPECT_LT(clock.now, longest_burst + 5000);
+    printf("%zu sensors: %llu resumptions, %lld ms wall time\n", SENSORS,
+           static_cast<unsigned long long>(exec.resumptions()), static_cast<long long>(wall_ms));
+}
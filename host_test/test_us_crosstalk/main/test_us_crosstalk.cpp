@@ -0,0 +1,274 @@
+// components/ultrasonic_sensor/host_test/test_us_crosstalk/main/test_us_crosstalk.cpp
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "esp_err.h"
+
+#include "mock_hal_freertos.hpp"
+#include "mock_hal_gpio.hpp"
+#include "mock_hal_sys_rom.hpp"
+#include "mock_hal_timer.hpp"
+#include "us_driver.hpp"
+#include "us_jitter.hpp"
+#include "us_processor.hpp"
+#include "us_sensor.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using ::testing::_;
+using ::testing::NiceMock;
+
+// =================================================================
+// UsJitter
+// =================================================================
+
+TEST(UsJitterTest, SameSeedSameSequence)
+{
+    UsJitter a(1234);
+    UsJitter b(1234);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(a.next_delay_us(5000), b.next_delay_us(5000));
+    }
+}
+
+TEST(UsJitterTest, DifferentSeedsDiverge)
+{
+    UsJitter a(1);
+    UsJitter b(2);
+    int equal = 0;
+    for (int i = 0; i < 100; i++) {
+        equal += (a.next_delay_us(5000) == b.next_delay_us(5000)) ? 1 : 0;
+    }
+    EXPECT_LT(equal, 5);
+}
+
+TEST(UsJitterTest, DelaysStayInRangeAndSpread)
+{
+    UsJitter jitter(0); // zero seed must still produce a sequence
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+    for (int i = 0; i < 1000; i++) {
+        uint32_t d = jitter.next_delay_us(2000);
+        ASSERT_LE(d, 2000u);
+        lo = std::min(lo, d);
+        hi = std::max(hi, d);
+    }
+    EXPECT_LT(lo, 100u);
+    EXPECT_GT(hi, 1900u);
+    EXPECT_EQ(jitter.next_delay_us(0), 0u);
+}
+
+// =================================================================
+// Acoustic simulation: N sensors firing concurrently in one space
+// =================================================================
+
+/**
+ * Every sensor runs the real UsSensor / UsDriver / UsProcessor on HAL fakes
+ * with its own simulated clock. All sensors fire in the same slots of
+ * SLOT_US, so their bursts overlap in time. ECHO falls at the first arrival
+ * after the burst was sent: the sensor's own echo, or the burst of another
+ * sensor travelling along a crosstalk path. The other sensors' trigger times
+ * are predicted from their jitter seeds, the same way their drivers draw them.
+ */
+class AcousticSpace
+{
+public:
+    static constexpr int64_t SLOT_US = 50000;     // firing period shared by all sensors
+    static constexpr int64_t POLL_US = 5;         // simulated cost of one timer read
+    static constexpr int64_t BURST_DELAY_US = 10; // trigger to ECHO rising edge
+    static constexpr uint8_t PINGS = 9;
+
+    struct Sensor
+    {
+        UsConfig cfg;
+        float true_cm = 0.0f;
+        std::vector<int64_t> trigger_offset_us; // predicted, per slot
+
+        NiceMock<idf_hals::MockGpioHAL> gpio;
+        NiceMock<idf_hals::MockTimerHAL> timer;
+        NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+        NiceMock<idf_hals::MockHalFreertos> freertos;
+        std::unique_ptr<UsSensor> sensor;
+
+        int64_t now_us = 0;
+        int64_t slot = 0;
+        int64_t trigger_us = -1; // falling edge of TRIG in the current slot
+        int mismatched_triggers = 0;
+    };
+
+    AcousticSpace(const std::vector<float> &true_cm, const std::vector<std::vector<float>> &path_cm,
+                  float crosstalk_probability, uint16_t jitter_us, size_t bursts)
+        : path_cm_(path_cm)
+        , crosstalk_probability_(crosstalk_probability)
+    {
+        for (size_t k = 0; k < true_cm.size(); k++) {
+            auto s = std::make_unique<Sensor>();
+            s->true_cm = true_cm[k];
+            s->cfg.ping_interval_ms = SLOT_US / 1000;
+            s->cfg.max_distance_cm = 400.0f;
+            s->cfg.trigger_jitter_us = jitter_us;
+            s->cfg.jitter_seed = 0xC0FFEE + 7919 * static_cast<uint32_t>(k);
+
+            UsJitter predictor(s->cfg.jitter_seed);
+            for (size_t i = 0; i < bursts * PINGS; i++) {
+                int64_t jitter = (jitter_us > 0) ? predictor.next_delay_us(jitter_us) : 0;
+                s->trigger_offset_us.push_back(jitter + s->cfg.ping_duration_us);
+            }
+
+            wire(*s, k);
+            sensors_.push_back(std::move(s));
+        }
+    }
+
+    /** Runs one concurrent burst on every sensor and returns the readings. */
+    std::vector<Reading> burst(size_t b)
+    {
+        std::vector<Reading> readings;
+        for (auto &s : sensors_) {
+            s->slot = static_cast<int64_t>(b) * PINGS;
+            s->now_us = s->slot * SLOT_US;
+            s->trigger_us = -1;
+            readings.push_back(s->sensor->read_distance(PINGS));
+        }
+        return readings;
+    }
+
+    const Sensor &sensor(size_t k) const { return *sensors_[k]; }
+    size_t size() const { return sensors_.size(); }
+
+private:
+    void wire(Sensor &s, size_t k)
+    {
+        const gpio_num_t trig = GPIO_NUM_4;
+        const gpio_num_t echo = GPIO_NUM_5;
+
+        ON_CALL(s.timer, get_time_us()).WillByDefault([&s]() {
+            s.now_us += POLL_US;
+            return s.now_us;
+        });
+        ON_CALL(s.sys_rom, delay_us(_)).WillByDefault([&s](uint32_t us) { s.now_us += us; });
+        ON_CALL(s.freertos, task_delay(_)).WillByDefault([&s](TickType_t) {
+            // Next ping starts at the next shared slot
+            s.slot++;
+            s.now_us = s.slot * SLOT_US;
+            s.trigger_us = -1;
+        });
+        ON_CALL(s.gpio, set_level(_, _)).WillByDefault([&s, trig](gpio_num_t pin, uint32_t level) {
+            if (pin == trig && level == 0 && s.now_us > s.slot * SLOT_US) {
+                s.trigger_us = s.now_us;
+                if (s.trigger_us != s.slot * SLOT_US + s.trigger_offset_us[s.slot])
+                    s.mismatched_triggers++;
+            }
+            return ESP_OK;
+        });
+        ON_CALL(s.gpio, get_level(echo)).WillByDefault([this, &s, k](gpio_num_t) {
+            if (s.trigger_us < 0)
+                return 0;
+            int64_t rise = s.trigger_us + BURST_DELAY_US;
+            return (s.now_us >= rise && s.now_us < echo_fall_us(s, k, rise)) ? 1 : 0;
+        });
+
+        auto driver = std::make_shared<UsDriver>(s.gpio, s.timer, s.sys_rom, trig, echo);
+        s.sensor = std::make_unique<UsSensor>(s.cfg, driver, std::make_shared<UsProcessor>(), s.freertos);
+    }
+
+    int64_t echo_fall_us(const Sensor &s, size_t k, int64_t rise) const
+    {
+        int64_t fall = s.trigger_us + tof_us(2.0f * s.true_cm);
+
+        for (size_t j = 0; j < sensors_.size(); j++) {
+            if (j == k || !crosstalk_heard(k, j, s.slot))
+                continue;
+            const Sensor &other = *sensors_[j];
+            int64_t arrival = s.slot * SLOT_US + other.trigger_offset_us[s.slot] + tof_us(path_cm_[k][j]);
+            if (arrival > rise && arrival < fall)
+                fall = arrival;
+        }
+        return fall;
+    }
+
+    static int64_t tof_us(float path_cm) { return std::lround(path_cm / UsDriver::SOUND_SPEED_CM_PER_US); }
+
+    // Deterministic per (listener, source, slot): whether the neighbour's burst is loud enough
+    bool crosstalk_heard(size_t k, size_t j, int64_t slot) const
+    {
+        uint64_t x = (static_cast<uint64_t>(slot) << 16) ^ (k << 8) ^ j;
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return static_cast<float>(x >> 40) / static_cast<float>(1ULL << 24) < crosstalk_probability_;
+    }
+
+    std::vector<std::unique_ptr<Sensor>> sensors_;
+    std::vector<std::vector<float>> path_cm_;
+    float crosstalk_probability_;
+};
+
+struct SimOutcome
+{
+    std::vector<int> correct; // per sensor: successful readings within tolerance
+    std::vector<int> wrong;   // per sensor: successful readings outside tolerance
+};
+
+static SimOutcome run_simulation(uint16_t jitter_us, size_t bursts)
+{
+    // Three sensors; one-way crosstalk paths between each pair of transducers
+    const std::vector<float> true_cm = {150.0f, 120.0f, 170.0f};
+    const std::vector<std::vector<float>> path_cm = {
+        {0.0f, 110.0f, 160.0f},
+        {110.0f, 0.0f, 90.0f},
+        {160.0f, 90.0f, 0.0f},
+    };
+
+    AcousticSpace space(true_cm, path_cm, 0.25f, jitter_us, bursts);
+    SimOutcome out{std::vector<int>(true_cm.size(), 0), std::vector<int>(true_cm.size(), 0)};
+
+    for (size_t b = 0; b < bursts; b++) {
+        auto readings = space.burst(b);
+        for (size_t k = 0; k < readings.size(); k++) {
+            if (!is_success(readings[k].result))
+                continue;
+            if (std::fabs(readings[k].cm - true_cm[k]) <= 3.0f)
+                out.correct[k]++;
+            else
+                out.wrong[k]++;
+        }
+    }
+
+    for (size_t k = 0; k < space.size(); k++) {
+        EXPECT_EQ(space.sensor(k).mismatched_triggers, 0) << "driver jitter diverged from prediction, sensor " << k;
+    }
+    return out;
+}
+
+TEST(UsCrosstalkSimulation, AlignedConcurrentFiringIsUnreliable)
+{
+    // Baseline: no jitter. Crosstalk lands at the same apparent distance on every
+    // ping, so bursts mix two consistent targets and fail (or report the ghost).
+    constexpr size_t BURSTS = 40;
+    SimOutcome out = run_simulation(0, BURSTS);
+
+    for (size_t k = 0; k < out.correct.size(); k++) {
+        EXPECT_LT(out.correct[k], static_cast<int>(BURSTS / 4)) << "sensor " << k;
+    }
+}
+
+TEST(UsCrosstalkSimulation, JitteredConcurrentFiringRejectsCrosstalk)
+{
+    // With jitter, crosstalk scatters over the listening window and is rejected
+    // by the processor; every sensor measures its own target at the full rate.
+    constexpr size_t BURSTS = 40;
+    SimOutcome out = run_simulation(6000, BURSTS);
+
+    for (size_t k = 0; k < out.correct.size(); k++) {
+        EXPECT_GE(out.correct[k], static_cast<int>(BURSTS * 3 / 4)) << "sensor " << k;
+        EXPECT_EQ(out.wrong[k], 0) << "sensor " << k;
+    }
+}
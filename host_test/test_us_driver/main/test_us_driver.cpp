@@ -6,22 +6,40 @@
 
 #include <cmath>
 #include <cstdint>
+#include <initializer_list>
+#include <utility>
 
 #include "esp_err.h"
 
+#include "mock_hal_freertos.hpp"
 #include "mock_hal_gpio.hpp"
 #include "mock_hal_timer.hpp"
 #include "mock_hal_sys_rom.hpp"
 #include "us_driver.hpp"
+#include "us_jitter.hpp"
+#include "us_multi_driver.hpp"
 #include "us_types.hpp"
 
 using namespace ultrasonic;
 using ::testing::_;
 using ::testing::DoAll;
 using ::testing::InSequence;
+using ::testing::NiceMock;
 using ::testing::Return;
 using ::testing::SetArgReferee;
 
+class MockUsCycleCounter : public IUsCycleCounter
+{
+public:
+    MOCK_METHOD(uint32_t, cycles, (), (override));
+};
+
+class MockUsGpioBulk : public IUsGpioBulk
+{
+public:
+    MOCK_METHOD(uint64_t, read_inputs, (), (override));
+};
+
 class UsDriverTest : public ::testing::Test
 {
 protected:
@@ -115,6 +133,16 @@ protected:
         EXPECT_CALL(timer_hal, get_time_us()).WillOnce(Return(echo_start_us + pulse_duration_us));
     }
 
+    void ExpectEchoWindow(int64_t window_start_us, std::initializer_list<std::pair<int, int64_t>> samples)
+    {
+        // Window start timestamp, then one (level, timestamp) pair per poll
+        EXPECT_CALL(timer_hal, get_time_us()).WillOnce(Return(window_start_us));
+        for (const auto &[level, time_us] : samples) {
+            EXPECT_CALL(gpio_hal, get_level(ECHO_PIN)).WillOnce(Return(level));
+            EXPECT_CALL(timer_hal, get_time_us()).WillOnce(Return(time_us));
+        }
+    }
+
     void PrepareTrigger()
     {
         ExpectPingPrepare();
@@ -430,6 +458,741 @@ TEST_F(UsDriverTest, Ping_PinStuckHigh)
     EXPECT_EQ(UsResult::ECHO_STUCK, result.result);
 }
 
+// ==================================================================
+// ECHO_STUCK recovery
+// ==================================================================
+
+TEST_F(UsDriverTest, Ping_PinStuckHigh_RecoveryDisabledCountsEvent)
+{
+    InSequence s;
+
+    ExpectPingPrepare();
+    ExpectStuckCheck(true);
+
+    EXPECT_EQ(driver->ping_once(default_cfg_).result, UsResult::ECHO_STUCK);
+    EXPECT_EQ(driver->stats().stuck_events, 1u);
+    EXPECT_EQ(driver->stats().stuck_recoveries, 0u);
+}
+
+TEST_F(UsDriverTest, StuckRecoveredByDischarge)
+{
+    default_cfg_.stuck_recovery_attempts = 2;
+    default_cfg_.stuck_settle_us = 300;
+
+    InSequence s;
+
+    ExpectPingPrepare();
+    ExpectStuckCheck(true);
+
+    // a. Discharge ECHO and re-check
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_OUTPUT)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(ECHO_PIN, 0)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(sys_rom_hal, delay_us(300)).WillOnce(Return());
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_INPUT)).WillOnce(Return(ESP_OK));
+    ExpectStuckCheck(false);
+
+    // The ping then continues normally
+    ExpectTriggerPulse(20);
+    ExpectRisingEdge(1000);
+    ExpectDistanceMeasurement(20.0f);
+
+    auto result = driver->ping_once(default_cfg_);
+    EXPECT_EQ(result.result, UsResult::OK);
+    EXPECT_NEAR(result.cm, 20.0f, 0.5f);
+    EXPECT_EQ(driver->stats().stuck_events, 1u);
+    EXPECT_EQ(driver->stats().stuck_recoveries, 1u);
+    EXPECT_EQ(driver->stats().power_cycles, 0u);
+}
+
+TEST_F(UsDriverTest, StuckRecoveredByRetrigger)
+{
+    default_cfg_.stuck_recovery_attempts = 1;
+    default_cfg_.stuck_settle_us = 300;
+
+    InSequence s;
+
+    ExpectPingPrepare();
+    ExpectStuckCheck(true);
+
+    // a. Discharge does not help
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_OUTPUT)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(ECHO_PIN, 0)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(sys_rom_hal, delay_us(300)).WillOnce(Return());
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_INPUT)).WillOnce(Return(ESP_OK));
+    ExpectStuckCheck(true);
+
+    // b. Retrigger, ECHO drops, settle
+    ExpectTriggerPulse(20);
+    ExpectEchoMeasurement(5000, 400);
+    EXPECT_CALL(sys_rom_hal, delay_us(300)).WillOnce(Return());
+    ExpectStuckCheck(false);
+
+    ExpectTriggerPulse(20);
+    ExpectRisingEdge(1000);
+    ExpectDistanceMeasurement(20.0f);
+
+    EXPECT_EQ(driver->ping_once(default_cfg_).result, UsResult::OK);
+    EXPECT_EQ(driver->stats().stuck_recoveries, 1u);
+}
+
+TEST_F(UsDriverTest, StuckRecoveredByPowerCycle)
+{
+    const gpio_num_t POWER_PIN = GPIO_NUM_6;
+    UsDriver powered(gpio_hal, timer_hal, sys_rom_hal, TRIG_PIN, ECHO_PIN, {.power_pin = POWER_PIN, .power_on_level = 0});
+
+    default_cfg_.stuck_recovery_attempts = 1;
+    default_cfg_.stuck_settle_us = 300;
+    default_cfg_.power_cycle_us = 50000;
+
+    InSequence s;
+
+    ExpectPingPrepare();
+    ExpectStuckCheck(true);
+
+    // a. Discharge does not help
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_OUTPUT)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(ECHO_PIN, 0)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(sys_rom_hal, delay_us(300)).WillOnce(Return());
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_INPUT)).WillOnce(Return(ESP_OK));
+    ExpectStuckCheck(true);
+
+    // b. Retrigger does not help either: ECHO never drops
+    ExpectTriggerPulse(20);
+    EXPECT_CALL(timer_hal, get_time_us()).WillOnce(Return(0));
+    EXPECT_CALL(gpio_hal, get_level(ECHO_PIN)).WillOnce(Return(1));
+    EXPECT_CALL(timer_hal, get_time_us()).WillOnce(Return(50000));
+    EXPECT_CALL(sys_rom_hal, delay_us(300)).WillOnce(Return());
+    ExpectStuckCheck(true);
+
+    // c. Power off (active-low enable), boot, discharge
+    EXPECT_CALL(gpio_hal, set_level(POWER_PIN, 1)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(sys_rom_hal, delay_us(50000)).WillOnce(Return());
+    EXPECT_CALL(gpio_hal, set_level(POWER_PIN, 0)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(sys_rom_hal, delay_us(50000)).WillOnce(Return());
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_OUTPUT)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(ECHO_PIN, 0)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(sys_rom_hal, delay_us(300)).WillOnce(Return());
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_INPUT)).WillOnce(Return(ESP_OK));
+    ExpectStuckCheck(false);
+
+    ExpectTriggerPulse(20);
+    ExpectRisingEdge(1000);
+    ExpectDistanceMeasurement(20.0f);
+
+    EXPECT_EQ(powered.ping_once(default_cfg_).result, UsResult::OK);
+    EXPECT_EQ(powered.stats().stuck_recoveries, 1u);
+    EXPECT_EQ(powered.stats().power_cycles, 1u);
+}
+
+TEST_F(UsDriverTest, StuckRecoveryExhausted)
+{
+    default_cfg_.stuck_recovery_attempts = 3;
+
+    // ECHO never drops; every wait times out
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, _)).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(_, _)).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, get_level(ECHO_PIN)).WillRepeatedly(Return(1));
+    EXPECT_CALL(sys_rom_hal, delay_us(_)).WillRepeatedly(Return());
+    int64_t now_us = 0;
+    EXPECT_CALL(timer_hal, get_time_us()).WillRepeatedly([&now_us]() { return now_us += 20000; });
+
+    EXPECT_EQ(driver->ping_once(default_cfg_).result, UsResult::ECHO_STUCK);
+    EXPECT_EQ(driver->stats().stuck_events, 1u);
+    EXPECT_EQ(driver->stats().stuck_recoveries, 0u);
+    EXPECT_EQ(driver->stats().power_cycles, 0u); // no power pin wired
+}
+
+TEST_F(UsDriverTest, StuckRecoveryHalFailureIsHwFault)
+{
+    default_cfg_.stuck_recovery_attempts = 1;
+
+    InSequence s;
+
+    ExpectPingPrepare();
+    ExpectStuckCheck(true);
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_OUTPUT)).WillOnce(Return(ESP_FAIL));
+
+    EXPECT_EQ(driver->ping_once(default_cfg_).result, UsResult::HW_FAULT);
+}
+
+TEST_F(UsDriverTest, InitConfiguresPowerPin)
+{
+    const gpio_num_t POWER_PIN = GPIO_NUM_6;
+    UsDriver powered(gpio_hal, timer_hal, sys_rom_hal, TRIG_PIN, ECHO_PIN, {.power_pin = POWER_PIN});
+
+    EXPECT_CALL(gpio_hal, reset_pin(_)).Times(3).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, config(_)).Times(3).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(_, 0)).Times(2).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_direction(ECHO_PIN, GPIO_MODE_OUTPUT)).WillOnce(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(POWER_PIN, 1)).WillOnce(Return(ESP_OK));
+
+    EXPECT_EQ(ESP_OK, powered.init());
+}
+
+TEST_F(UsDriverTest, DeinitPowersSensorDown)
+{
+    const gpio_num_t POWER_PIN = GPIO_NUM_6;
+    UsDriver high_side(gpio_hal, timer_hal, sys_rom_hal, TRIG_PIN, ECHO_PIN, {.power_pin = POWER_PIN, .power_on_level = 0});
+    UsDriver low_side(gpio_hal, timer_hal, sys_rom_hal, TRIG_PIN, ECHO_PIN, {.power_pin = POWER_PIN});
+
+    {
+        InSequence s;
+        EXPECT_CALL(gpio_hal, set_level(TRIG_PIN, 0)).WillOnce(Return(ESP_OK));
+        EXPECT_CALL(gpio_hal, reset_pin(TRIG_PIN)).WillOnce(Return(ESP_OK));
+        EXPECT_CALL(gpio_hal, set_level(ECHO_PIN, 0)).WillOnce(Return(ESP_OK));
+        EXPECT_CALL(gpio_hal, reset_pin(ECHO_PIN)).WillOnce(Return(ESP_OK));
+        EXPECT_CALL(gpio_hal, set_level(POWER_PIN, 1)).WillOnce(Return(ESP_OK));
+        EXPECT_CALL(gpio_hal, reset_pin(POWER_PIN)).WillOnce(Return(ESP_OK));
+    }
+    EXPECT_EQ(ESP_OK, high_side.deinit());
+
+    EXPECT_CALL(gpio_hal, set_level(_, 0)).Times(3).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, reset_pin(_)).Times(3).WillRepeatedly(Return(ESP_OK));
+    EXPECT_EQ(ESP_OK, low_side.deinit());
+
+    // A power pin that cannot be driven fails deinit and is not released
+    EXPECT_CALL(gpio_hal, set_level(_, 0)).Times(2).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, reset_pin(_)).Times(2).WillRepeatedly(Return(ESP_OK));
+    EXPECT_CALL(gpio_hal, set_level(POWER_PIN, 1)).WillOnce(Return(ESP_FAIL));
+    EXPECT_EQ(ESP_FAIL, high_side.deinit());
+}
+
+TEST_F(UsDriverTest, TriggerJitterDelaysTrigger)
+{
+    default_cfg_.trigger_jitter_us = 3000;
+    default_cfg_.jitter_seed = 42;
+
+    UsJitter expected(42);
+
+    InSequence s;
+
+    PrepareTrigger();
+    EXPECT_CALL(sys_rom_hal, delay_us(expected.next_delay_us(3000))).WillOnce(Return());
+    ExpectTriggerPulse(20);
+    ExpectRisingEdge(1000);
+    ExpectDistanceMeasurement(20.0f);
+    EXPECT_EQ(driver->ping_once(default_cfg_).result, UsResult::OK);
+
+    // The sequence continues on the next ping
+    PrepareTrigger();
+    EXPECT_CALL(sys_rom_hal, delay_us(expected.next_delay_us(3000))).WillOnce(Return());
+    ExpectTriggerPulse(20);
+    ExpectRisingEdge(1000);
+    ExpectDistanceMeasurement(20.0f);
+    EXPECT_EQ(driver->ping_once(default_cfg_).result, UsResult::OK);
+}
+
+// ==================================================================
+// Multi-echo capture
+// ==================================================================
+
+TEST_F(UsDriverTest, FastPingSkipsClearAfterCleanPing)
+{
+    default_cfg_.fast_ping = true;
+
+    // First ping after construction always runs the clear sequence
+    {
+        InSequence s;
+        ExpectSuccessfulPing();
+    }
+    EXPECT_EQ(UsResult::OK, driver->ping_once(default_cfg_).result);
+    ::testing::Mock::VerifyAndClearExpectations(&gpio_hal);
+
+    // ECHO ended LOW, so the second ping goes straight to the stuck check
+    {
+        InSequence s;
+        EXPECT_CALL(gpio_hal, set_direction(_, _)).Times(0);
+        EXPECT_CALL(gpio_hal, set_level(ECHO_PIN, _)).Times(0);
+        ExpectStuckCheck(false);
+        ExpectTriggerPulse(20);
+        ExpectRisingEdge(1000);
+        ExpectEchoMeasurement(1010, 1000);
+    }
+    EXPECT_EQ(UsResult::OK, driver->ping_once(default_cfg_).result);
+
+    EXPECT_EQ(driver->stats().full_preps, 1u);
+    EXPECT_EQ(driver->stats().fast_preps, 1u);
+}
+
+TEST_F(UsDriverTest, FastPingClearsAgainAfterTimeout)
+{
+    default_cfg_.fast_ping = true;
+
+    InSequence s;
+
+    ExpectSuccessfulPing();
+
+    // Fast ping whose echo never ends
+    ExpectStuckCheck(false);
+    ExpectTriggerPulse(20);
+    ExpectRisingEdge(1000);
+    ExpectEchoMeasurement(1010, 0, 0, true);
+
+    EXPECT_EQ(UsResult::OK, driver->ping_once(default_cfg_).result);
+    EXPECT_EQ(UsResult::TIMEOUT, driver->ping_once(default_cfg_).result);
+    ::testing::Mock::VerifyAndClearExpectations(&gpio_hal);
+    ::testing::Mock::VerifyAndClearExpectations(&timer_hal);
+
+    // The timed-out ping may have left ECHO HIGH: full sequence again
+    ExpectSuccessfulPing();
+    EXPECT_EQ(UsResult::OK, driver->ping_once(default_cfg_).result);
+
+    EXPECT_EQ(driver->stats().full_preps, 2u);
+    EXPECT_EQ(driver->stats().fast_preps, 1u);
+}
+
+TEST_F(UsDriverTest, FastPingDisabledAlwaysClears)
+{
+    InSequence s;
+
+    ExpectSuccessfulPing();
+    ExpectSuccessfulPing();
+
+    EXPECT_EQ(UsResult::OK, driver->ping_once(default_cfg_).result);
+    EXPECT_EQ(UsResult::OK, driver->ping_once(default_cfg_).result);
+
+    EXPECT_EQ(driver->stats().full_preps, 2u);
+    EXPECT_EQ(driver->stats().fast_preps, 0u);
+}
+
+/**
+ * Virtual 240 MHz CPU: time only moves on waits and counter reads. ECHO rises
+ * 100 us after the trigger and stays HIGH for echo_width_us.
+ */
+struct CycleClock
+{
+    static constexpr uint32_t CYCLES_PER_US = 240;
+    static constexpr uint32_t CYCLES_PER_READ = 24; // 0.1 us per counter read
+
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<MockUsCycleCounter> counter;
+
+    uint32_t cycles = 0; // wraps like the hardware counter
+    uint64_t elapsed = 0;
+    int64_t trigger_at = -1;
+    float echo_width_us = 1000.5f;
+    bool echo_returns = true;
+
+    CycleClock()
+    {
+        ON_CALL(counter, cycles()).WillByDefault([this]() {
+            advance(CYCLES_PER_READ);
+            return cycles;
+        });
+        ON_CALL(timer, get_time_us()).WillByDefault([this]() { return static_cast<int64_t>(elapsed / CYCLES_PER_US); });
+        ON_CALL(sys_rom, delay_us(_)).WillByDefault([this](uint32_t us) { advance(uint64_t{us} * CYCLES_PER_US); });
+        ON_CALL(gpio, set_level(_, _)).WillByDefault([this](gpio_num_t pin, uint32_t level) {
+            if (pin == GPIO_NUM_4 && level == 0)
+                trigger_at = static_cast<int64_t>(elapsed);
+            return ESP_OK;
+        });
+        ON_CALL(gpio, get_level(GPIO_NUM_5)).WillByDefault([this](gpio_num_t) {
+            if (trigger_at < 0 || !echo_returns)
+                return 0;
+            double rise = static_cast<double>(trigger_at) + 100.0 * CYCLES_PER_US;
+            double fall = rise + static_cast<double>(echo_width_us) * CYCLES_PER_US;
+            double now = static_cast<double>(elapsed);
+            return (now >= rise && now < fall) ? 1 : 0;
+        });
+    }
+
+    void advance(uint64_t n)
+    {
+        elapsed += n;
+        cycles += static_cast<uint32_t>(n);
+    }
+};
+
+TEST(UsDriverCycleTest, InitCalibratesCounter)
+{
+    CycleClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.cycle_counter = &clock.counter});
+
+    EXPECT_CALL(clock.sys_rom, delay_us(UsDriver::CYCLE_CALIBRATION_US)).Times(1);
+    ASSERT_EQ(ESP_OK, driver.init());
+    EXPECT_NEAR(static_cast<float>(CycleClock::CYCLES_PER_US), driver.cycles_per_us(), 0.5f);
+}
+
+TEST(UsDriverCycleTest, EchoTimedWithSubMicrosecondResolution)
+{
+    CycleClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.cycle_counter = &clock.counter});
+    ASSERT_EQ(ESP_OK, driver.init());
+
+    // The polling loops only read the counter
+    EXPECT_CALL(clock.timer, get_time_us()).Times(0);
+
+    UsConfig cfg;
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(1000.5f * UsDriver::SOUND_SPEED_CM_PER_US / 2.0f, r.cm, 0.005f);
+    EXPECT_NEAR(1000.5f, static_cast<float>(driver.last_echo_us()), 0.6f);
+}
+
+TEST(UsDriverCycleTest, CounterWrapDuringEcho)
+{
+    CycleClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.cycle_counter = &clock.counter});
+    ASSERT_EQ(ESP_OK, driver.init());
+
+    // Wraps about 600 us into the echo
+    clock.cycles = UINT32_MAX - 700u * CycleClock::CYCLES_PER_US;
+    Reading r = driver.ping_once(UsConfig{});
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(1000.5f * UsDriver::SOUND_SPEED_CM_PER_US / 2.0f, r.cm, 0.005f);
+}
+
+TEST(UsDriverCycleTest, TimeoutCountedInCycles)
+{
+    CycleClock clock;
+    clock.echo_returns = false;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.cycle_counter = &clock.counter});
+    ASSERT_EQ(ESP_OK, driver.init());
+
+    UsConfig cfg;
+    uint64_t before = clock.elapsed;
+    EXPECT_EQ(UsResult::TIMEOUT, driver.ping_once(cfg).result);
+    uint64_t waited_us = (clock.elapsed - before) / CycleClock::CYCLES_PER_US;
+    EXPECT_GE(waited_us, cfg.timeout_us);
+    EXPECT_LT(waited_us, cfg.timeout_us + 100);
+}
+
+TEST(UsDriverCycleTest, StalledCounterFallsBackToTimer)
+{
+    CycleClock clock;
+    ON_CALL(clock.counter, cycles()).WillByDefault(Return(1234u));
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.cycle_counter = &clock.counter});
+
+    ASSERT_EQ(ESP_OK, driver.init());
+    EXPECT_EQ(0.0f, driver.cycles_per_us());
+    EXPECT_EQ(ESP_ERR_INVALID_STATE, driver.calibrate_cycle_counter());
+
+    // Timer path: every poll reads the timer (advance the clock per read so the echo is seen)
+    int64_t now_us = 0;
+    ON_CALL(clock.timer, get_time_us()).WillByDefault([&]() {
+        clock.advance(CycleClock::CYCLES_PER_US);
+        return ++now_us;
+    });
+    EXPECT_CALL(clock.counter, cycles()).Times(0);
+    Reading r = driver.ping_once(UsConfig{});
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(1000.5f * UsDriver::SOUND_SPEED_CM_PER_US / 2.0f, r.cm, 0.05f);
+}
+
+/**
+ * Virtual clock for the echo wait policies: 1 us per timer read. A yield lets
+ * another task run for YIELD_US, a sleep lasts whole ticks. ECHO rises 150 us
+ * after the trigger and stays HIGH for echo_width_us.
+ */
+struct SchedulerClock
+{
+    static constexpr int64_t YIELD_US = 50;
+    static constexpr int64_t TICK_US = 1000000 / configTICK_RATE_HZ;
+
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+
+    int64_t now = 0;
+    int64_t trigger_at = -1;
+    int64_t echo_width_us = 5000;
+    int64_t yield_us = YIELD_US;
+    int64_t slept_ticks = 0;
+
+    SchedulerClock()
+    {
+        ON_CALL(timer, get_time_us()).WillByDefault([this]() { return ++now; });
+        ON_CALL(sys_rom, delay_us(_)).WillByDefault([this](uint32_t us) { now += us; });
+        ON_CALL(freertos, task_delay(_)).WillByDefault([this](TickType_t ticks) {
+            slept_ticks += ticks;
+            now += (ticks == 0) ? yield_us : static_cast<int64_t>(ticks) * TICK_US;
+        });
+        ON_CALL(gpio, set_level(_, _)).WillByDefault([this](gpio_num_t pin, uint32_t level) {
+            if (pin == GPIO_NUM_4 && level == 0)
+                trigger_at = now;
+            return ESP_OK;
+        });
+        ON_CALL(gpio, get_level(GPIO_NUM_5)).WillByDefault([this](gpio_num_t) {
+            if (trigger_at < 0)
+                return 0;
+            int64_t rise = trigger_at + 150;
+            return (now >= rise && now < rise + echo_width_us) ? 1 : 0;
+        });
+    }
+
+    float true_cm() const { return echo_width_us * UsDriver::SOUND_SPEED_CM_PER_US / 2.0f; }
+};
+
+TEST(UsDriverWaitTest, SpinNeverYields)
+{
+    SchedulerClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.freertos_hal = &clock.freertos});
+    EXPECT_CALL(clock.freertos, task_delay(_)).Times(0);
+
+    UsConfig cfg;
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(clock.true_cm(), r.cm, 0.05f);
+    EXPECT_EQ(driver.stats().wait_yields, 0u);
+}
+
+TEST(UsDriverWaitTest, PolicyIgnoredWithoutFreertosHal)
+{
+    SchedulerClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5);
+    EXPECT_CALL(clock.freertos, task_delay(_)).Times(0);
+
+    UsConfig cfg;
+    cfg.echo_wait = EchoWait::SPIN_SLEEP;
+    EXPECT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+    EXPECT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+}
+
+TEST(UsDriverWaitTest, SpinYieldSpinsAroundPredictedEdge)
+{
+    SchedulerClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.freertos_hal = &clock.freertos});
+    UsConfig cfg;
+    cfg.echo_wait = EchoWait::SPIN_YIELD;
+
+    // No prediction yet: the falling edge may be seen up to one yield late
+    Reading first = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, first.result);
+    EXPECT_NEAR(clock.true_cm(), first.cm, SchedulerClock::YIELD_US * UsDriver::SOUND_SPEED_CM_PER_US);
+    EXPECT_GT(driver.stats().wait_yields, 0u);
+    EXPECT_EQ(driver.stats().wait_sleeps, 0u);
+
+    // Predicted from the first echo: spun across the edge
+    Reading second = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, second.result);
+    EXPECT_NEAR(clock.true_cm(), second.cm, 0.05f);
+    EXPECT_EQ(clock.slept_ticks, 0);
+}
+
+TEST(UsDriverWaitTest, SpinSleepSleepsUntilPredictedEdge)
+{
+    SchedulerClock clock;
+    clock.echo_width_us = 10000;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.freertos_hal = &clock.freertos});
+    UsConfig cfg;
+    cfg.echo_wait = EchoWait::SPIN_SLEEP;
+
+    // Without a prediction a whole tick could swallow the edge: yield only
+    ASSERT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+    EXPECT_EQ(driver.stats().wait_sleeps, 0u);
+
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(clock.true_cm(), r.cm, 0.05f);
+    EXPECT_GT(driver.stats().wait_sleeps, 0u);
+
+    // Slept most of the echo: up to the spin guard before the predicted edge
+    const int64_t sleepable_us = clock.echo_width_us - cfg.spin_guard_us - cfg.spin_window_us;
+    EXPECT_GE(clock.slept_ticks * SchedulerClock::TICK_US, sleepable_us - 2 * SchedulerClock::TICK_US);
+    EXPECT_LE(clock.slept_ticks * SchedulerClock::TICK_US, sleepable_us);
+}
+
+TEST(UsDriverWaitTest, SpinSleepRecoversWhenTargetMovesCloser)
+{
+    SchedulerClock clock;
+    clock.echo_width_us = 10000;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.freertos_hal = &clock.freertos});
+    UsConfig cfg;
+    cfg.echo_wait = EchoWait::SPIN_SLEEP;
+    ASSERT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+
+    // The target jumped closer: the edge falls inside a sleep and the ping is rejected
+    clock.echo_width_us = 4000;
+    Reading late = driver.ping_once(cfg);
+    EXPECT_EQ(UsResult::HIGH_VARIANCE, late.result);
+    EXPECT_EQ(driver.stats().late_edges, 1u);
+    EXPECT_EQ(driver.last_echo_us(), 0u);
+
+    // The late echo is not used as a prediction; one ping without sleeping relearns it
+    driver.ping_once(cfg);
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(clock.true_cm(), r.cm, 0.05f);
+}
+
+TEST(UsDriverWaitTest, EdgeAfterLongYieldRejected)
+{
+    SchedulerClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.freertos_hal = &clock.freertos});
+    UsConfig cfg;
+    cfg.echo_wait = EchoWait::SPIN_YIELD;
+
+    // Another ready task holds the CPU for a whole time slice on every yield
+    clock.yield_us = SchedulerClock::TICK_US;
+    EXPECT_EQ(UsResult::HIGH_VARIANCE, driver.ping_once(cfg).result);
+    EXPECT_EQ(driver.stats().late_edges, 1u);
+
+    // Short yields keep the edge within MAX_EDGE_GAP_US
+    clock.yield_us = UsDriver::MAX_EDGE_GAP_US / 2;
+    clock.now += 60000;
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(clock.true_cm(), r.cm, UsDriver::MAX_EDGE_GAP_US * UsDriver::SOUND_SPEED_CM_PER_US / 2.0f);
+    EXPECT_EQ(driver.stats().late_edges, 1u);
+}
+
+TEST(UsDriverGateTest, LostTargetDeclaredAtGateEnd)
+{
+    SchedulerClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5);
+    UsConfig cfg;
+    cfg.max_distance_cm = 400.0f;
+    cfg.track_gate_cm = 10.0f; // 583 us of echo
+    ASSERT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+
+    // The target left; the far wall answers at 20 ms. Given up at the gate end instead
+    clock.now += 60000; // ping interval: the clock model stretches a pulse still in progress
+    clock.echo_width_us = 20000;
+    const int64_t start = clock.now;
+    EXPECT_EQ(UsResult::TIMEOUT, driver.ping_once(cfg).result);
+    EXPECT_LT(clock.now - start, 5000 + 583 + 300);
+    EXPECT_EQ(driver.stats().gate_losses, 1u);
+    const int64_t abandoned_end = clock.trigger_at + 150 + clock.echo_width_us;
+
+    // The next ping lets the abandoned pulse run out, then reacquires without a gate
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(clock.true_cm(), r.cm, 0.05f);
+    EXPECT_GT(clock.trigger_at, abandoned_end);
+    EXPECT_EQ(driver.stats().stuck_events, 0u);
+}
+
+TEST(UsDriverGateTest, EchoBeforeGateRejected)
+{
+    SchedulerClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5);
+    UsConfig cfg;
+    cfg.track_gate_cm = 10.0f;
+    ASSERT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+
+    // A nearer reflector far outside the gate is not taken for the target
+    clock.now += 60000;
+    clock.echo_width_us = 2000;
+    EXPECT_EQ(UsResult::OUT_OF_RANGE, driver.ping_once(cfg).result);
+    EXPECT_EQ(driver.stats().gate_rejects, 1u);
+    EXPECT_NEAR(driver.last_echo_us(), 2000u, 5u);
+
+    // If it persists, the next ping is ungated and follows it
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(clock.true_cm(), r.cm, 0.05f);
+
+    // Movement within the gate is tracked
+    clock.now += 60000;
+    clock.echo_width_us = 2400;
+    EXPECT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+    EXPECT_EQ(driver.stats().gate_rejects, 1u);
+    EXPECT_EQ(driver.stats().gate_losses, 0u);
+}
+
+TEST(UsDriverGateTest, InitDropsTrack)
+{
+    SchedulerClock clock;
+    UsDriver driver(clock.gpio, clock.timer, clock.sys_rom, GPIO_NUM_4, GPIO_NUM_5);
+    UsConfig cfg;
+    cfg.track_gate_cm = 10.0f;
+    ASSERT_EQ(UsResult::OK, driver.ping_once(cfg).result);
+
+    // A re-initialised sensor may face another target; the old echo must not gate it
+    ASSERT_EQ(ESP_OK, driver.deinit());
+    ASSERT_EQ(ESP_OK, driver.init());
+    clock.now += 60000;
+    clock.echo_width_us = 2000;
+    Reading r = driver.ping_once(cfg);
+    ASSERT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(clock.true_cm(), r.cm, 0.05f);
+    EXPECT_EQ(driver.stats().gate_rejects, 0u);
+}
+
+TEST_F(UsDriverTest, CaptureTwoEchoes)
+{
+    default_cfg_.max_echoes = 2;
+
+    InSequence s;
+
+    PrepareTrigger();
+    ExpectTriggerPulse(20);
+    ExpectEchoWindow(1000, {{0, 1010}, {1, 1100}, {1, 1500}, {0, 1700}, {0, 2000}, {1, 5000}, {0, 6000}});
+
+    EchoCapture capture;
+    EXPECT_EQ(driver->capture_echoes(default_cfg_, capture), UsResult::OK);
+    ASSERT_EQ(capture.count, 2);
+    EXPECT_EQ(capture.pulses[0].start_us, 100u);
+    EXPECT_EQ(capture.pulses[0].width_us, 600u);
+    EXPECT_NEAR(capture.pulses[0].cm, 600 * UsDriver::SOUND_SPEED_CM_PER_US / 2.0f, 0.01f);
+    EXPECT_EQ(capture.pulses[1].start_us, 4000u);
+    EXPECT_EQ(capture.pulses[1].width_us, 1000u);
+    EXPECT_EQ(driver->last_echo_us(), 600u);
+}
+
+TEST_F(UsDriverTest, CaptureZeroEchoesClampedToOne)
+{
+    // Rejected by validation; a driver called directly still keeps one pulse
+    default_cfg_.max_echoes = 0;
+
+    InSequence s;
+
+    PrepareTrigger();
+    ExpectTriggerPulse(20);
+    ExpectEchoWindow(1000, {{0, 1010}, {1, 1100}, {1, 1500}, {0, 1700}});
+
+    EchoCapture capture;
+    EXPECT_EQ(driver->capture_echoes(default_cfg_, capture), UsResult::OK);
+    ASSERT_EQ(capture.count, 1);
+    EXPECT_EQ(capture.pulses[0].width_us, 600u);
+    EXPECT_EQ(UsCompiledConfig(default_cfg_).max_echoes, 1);
+}
+
+TEST_F(UsDriverTest, CaptureDropsPulseOpenAtWindowEnd)
+{
+    default_cfg_.max_echoes = EchoCapture::MAX_ECHOES;
+
+    InSequence s;
+
+    PrepareTrigger();
+    ExpectTriggerPulse(20);
+    ExpectEchoWindow(0, {{1, 100}, {0, 300}, {1, 2000}, {1, 40000}});
+
+    EchoCapture capture;
+    EXPECT_EQ(driver->capture_echoes(default_cfg_, capture), UsResult::OK);
+    ASSERT_EQ(capture.count, 1);
+    EXPECT_EQ(capture.pulses[0].start_us, 100u);
+    EXPECT_EQ(capture.pulses[0].width_us, 200u);
+}
+
+TEST_F(UsDriverTest, CaptureNoEchoIsTimeout)
+{
+    InSequence s;
+
+    PrepareTrigger();
+    ExpectTriggerPulse(20);
+    ExpectEchoWindow(0, {{0, 10}, {0, 40000}});
+
+    EchoCapture capture;
+    EXPECT_EQ(driver->capture_echoes(default_cfg_, capture), UsResult::TIMEOUT);
+    EXPECT_EQ(capture.count, 0);
+}
+
+TEST_F(UsDriverTest, CaptureEchoStuck)
+{
+    InSequence s;
+
+    ExpectPingPrepare();
+    ExpectStuckCheck(true);
+
+    EchoCapture capture;
+    EXPECT_EQ(driver->capture_echoes(default_cfg_, capture), UsResult::ECHO_STUCK);
+    EXPECT_EQ(capture.count, 0);
+}
+
 TEST_F(UsDriverTest, Ping_TriggerFail)
 {
     InSequence s;
@@ -485,3 +1248,143 @@ TEST_F(UsDriverTest, NoPingInterval)
     EXPECT_EQ(result.result, UsResult::OK);
     EXPECT_NEAR(result.cm, 20.0f, 0.5f);
 }
+
+// =================================================================
+// UsMultiDriver
+// =================================================================
+
+/**
+ * Sensors on TRIG 4 + 2k / ECHO 5 + 2k, each raising ECHO 150 us after its
+ * own trigger for its own echo width, on a clock that advances 1 us per
+ * timer read.
+ */
+struct MultiClock
+{
+    static constexpr size_t N = 3;
+
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<MockUsGpioBulk> bulk;
+
+    UsChannelPins pins[N];
+    int64_t echo_width_us[N] = {3000, 6000, 10000};
+    int64_t trigger_at[N] = {-1, -1, -1};
+    uint64_t stuck = 0;
+    int64_t now = 0;
+
+    MultiClock()
+    {
+        for (size_t k = 0; k < N; k++) {
+            pins[k] = {static_cast<gpio_num_t>(4 + 2 * k), static_cast<gpio_num_t>(5 + 2 * k)};
+        }
+        ON_CALL(timer, get_time_us()).WillByDefault([this]() { return ++now; });
+        ON_CALL(sys_rom, delay_us(_)).WillByDefault([this](uint32_t us) { now += us; });
+        ON_CALL(gpio, set_level(_, _)).WillByDefault([this](gpio_num_t pin, uint32_t level) {
+            for (size_t k = 0; k < N; k++) {
+                if (pin == pins[k].trig_pin && level == 0)
+                    trigger_at[k] = now;
+            }
+            return ESP_OK;
+        });
+        ON_CALL(bulk, read_inputs()).WillByDefault([this]() {
+            uint64_t levels = stuck;
+            for (size_t k = 0; k < N; k++) {
+                const int64_t rise = trigger_at[k] + 150;
+                if (trigger_at[k] >= 0 && now >= rise && now < rise + echo_width_us[k])
+                    levels |= 1ULL << pins[k].echo_pin;
+            }
+            return levels;
+        });
+    }
+
+    float true_cm(size_t k) const { return echo_width_us[k] * SOUND_SPEED_CM_PER_US / 2.0f; }
+};
+
+TEST(UsMultiDriverTest, MeasuresAllChannelsInOnePing)
+{
+    MultiClock clock;
+    UsMultiDriver driver(clock.gpio, clock.timer, clock.sys_rom, clock.bulk, clock.pins, MultiClock::N);
+    ASSERT_EQ(ESP_OK, driver.init());
+    EXPECT_CALL(clock.gpio, get_level(_)).Times(0);
+
+    UsConfig cfg;
+    cfg.max_distance_cm = 400.0f;
+    Reading r[MultiClock::N];
+    const int64_t start = clock.now;
+    driver.ping_all(cfg, r);
+
+    for (size_t k = 0; k < MultiClock::N; k++) {
+        ASSERT_EQ(UsResult::OK, r[k].result) << "channel " << k;
+        EXPECT_NEAR(clock.true_cm(k), r[k].cm, 0.05f);
+        EXPECT_NEAR(driver.last_echo_us(k), clock.echo_width_us[k], 2);
+    }
+    // The longest echo, not the sum of the three
+    EXPECT_LT(clock.now - start, 10000 + 500);
+}
+
+TEST(UsMultiDriverTest, ChannelsEndIndependently)
+{
+    MultiClock clock;
+    clock.echo_width_us[1] = 40000; // nothing within timeout_us
+    clock.echo_width_us[2] = 500;   // below min_distance_cm
+    clock.stuck = 1ULL << clock.pins[0].echo_pin;
+    UsMultiDriver driver(clock.gpio, clock.timer, clock.sys_rom, clock.bulk, clock.pins, MultiClock::N);
+    ASSERT_EQ(ESP_OK, driver.init());
+
+    // The stuck channel is not triggered
+    EXPECT_CALL(clock.gpio, set_level(_, _)).Times(::testing::AnyNumber());
+    EXPECT_CALL(clock.gpio, set_level(clock.pins[0].trig_pin, _)).Times(0);
+
+    UsConfig cfg;
+    cfg.min_distance_cm = 10.0f;
+    Reading r[MultiClock::N];
+    driver.ping_all(cfg, r);
+
+    EXPECT_EQ(UsResult::ECHO_STUCK, r[0].result);
+    EXPECT_EQ(UsResult::TIMEOUT, r[1].result);
+    EXPECT_EQ(UsResult::OUT_OF_RANGE, r[2].result);
+    EXPECT_EQ(driver.last_echo_us(0), 0u);
+    EXPECT_EQ(driver.last_echo_us(1), 0u);
+    EXPECT_NEAR(driver.last_echo_us(2), 500u, 2u);
+}
+
+TEST(UsMultiDriverTest, TriggerFaultOnlyAffectsItsChannel)
+{
+    MultiClock clock;
+    ON_CALL(clock.gpio, set_level(clock.pins[1].trig_pin, 1)).WillByDefault(Return(ESP_FAIL));
+    UsMultiDriver driver(clock.gpio, clock.timer, clock.sys_rom, clock.bulk, clock.pins, MultiClock::N);
+    ASSERT_EQ(ESP_OK, driver.init());
+
+    Reading r[MultiClock::N];
+    driver.ping_all(UsConfig{}, r);
+
+    EXPECT_EQ(UsResult::OK, r[0].result);
+    EXPECT_EQ(UsResult::HW_FAULT, r[1].result);
+    EXPECT_EQ(UsResult::OK, r[2].result);
+}
+
+TEST(UsMultiDriverTest, InitRejectsBadChannelLists)
+{
+    MultiClock clock;
+    auto init = [&](const UsChannelPins *pins, size_t count) {
+        UsMultiDriver driver(clock.gpio, clock.timer, clock.sys_rom, clock.bulk, pins, count);
+        return driver.init();
+    };
+
+    UsChannelPins many[UsMultiDriver::MAX_CHANNELS + 1];
+    for (size_t k = 0; k <= UsMultiDriver::MAX_CHANNELS; k++) {
+        many[k] = {static_cast<gpio_num_t>(2 * k), static_cast<gpio_num_t>(2 * k + 1)};
+    }
+    EXPECT_EQ(ESP_OK, init(many, UsMultiDriver::MAX_CHANNELS));
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, init(many, UsMultiDriver::MAX_CHANNELS + 1));
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, init(many, 0));
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, init(nullptr, 1));
+
+    const UsChannelPins shared_echo[] = {{GPIO_NUM_4, GPIO_NUM_5}, {GPIO_NUM_6, GPIO_NUM_5}};
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, init(shared_echo, 2));
+    const UsChannelPins unconnected[] = {{GPIO_NUM_4, GPIO_NUM_NC}};
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, init(unconnected, 1));
+    const UsChannelPins beyond_register[] = {{GPIO_NUM_4, static_cast<gpio_num_t>(64)}};
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, init(beyond_register, 1));
+}
@@ -0,0 +1,292 @@
+// components/ultrasonic_sensor/host_test/test_us_fusion/main/test_us_fusion.cpp
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "esp_err.h"
+
+#include "mock_hal_freertos.hpp"
+#include "us_fusion.hpp"
+#include "us_processor.hpp"
+#include "us_sensor.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using ::testing::NiceMock;
+
+// =================================================================
+// Fake sensors
+// =================================================================
+
+/**
+ * Driver of a sensor looking at a surface: every ping reads the true
+ * distance plus gaussian noise. A failing unit reads a fixed offset (another
+ * surface, a fouled transducer) or stops answering.
+ */
+class NoisyDriver : public IUsDriver
+{
+public:
+    NoisyDriver(float &true_cm, uint32_t seed)
+        : true_cm_(true_cm)
+        , rng_(seed)
+    {
+    }
+
+    esp_err_t init() override { return ESP_OK; }
+    esp_err_t deinit() override { return ESP_OK; }
+
+    Reading ping_once(const UsConfig &cfg) override
+    {
+        if (silent)
+            return {UsResult::TIMEOUT, 0.0f};
+        return {UsResult::OK, true_cm_ + offset_cm + noise_(rng_)};
+    }
+
+    float offset_cm = 0.0f;
+    bool silent = false;
+
+private:
+    float &true_cm_;
+    std::mt19937 rng_;
+    std::normal_distribution<float> noise_{0.0f, 1.0f};
+};
+
+class UsFusionTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        cfg_.ping_interval_ms = 0;
+        for (uint32_t i = 0; i < 3; i++) {
+            drivers_.push_back(std::make_shared<NoisyDriver>(true_cm_, 100 + i));
+            sensors_.push_back(
+                std::make_unique<UsSensor>(cfg_, drivers_.back(), std::make_shared<UsProcessor>(), freertos_));
+        }
+    }
+
+    /** Fusion over the first @p n sensors. */
+    UsFusion make_fusion(size_t n, const UsFusionConfig &fcfg = UsFusionConfig{})
+    {
+        UsFusion fusion(fcfg);
+        for (size_t i = 0; i < n; i++) {
+            EXPECT_EQ(ESP_OK, fusion.add_sensor(sensors_[i].get()));
+        }
+        return fusion;
+    }
+
+    UsConfig cfg_;
+    float true_cm_ = 120.0f;
+    NiceMock<idf_hals::MockHalFreertos> freertos_;
+    std::vector<std::shared_ptr<NoisyDriver>> drivers_;
+    std::vector<std::unique_ptr<UsSensor>> sensors_;
+};
+
+static MeasurementInfo burst(UsResult result, float cm, uint8_t samples)
+{
+    MeasurementInfo info;
+    info.reading = {result, cm};
+    info.filter_samples = samples;
+    return info;
+}
+
+// =================================================================
+// Voting
+// =================================================================
+
+TEST_F(UsFusionTest, HealthySensorsAgree)
+{
+    UsFusion fusion = make_fusion(3);
+    FusedReading f = fusion.read_distance();
+
+    ASSERT_EQ(UsResult::OK, f.reading.result);
+    EXPECT_NEAR(true_cm_, f.reading.cm, 2.0f);
+    EXPECT_EQ(f.sensors, 3);
+    EXPECT_EQ(f.agreeing, 3);
+    EXPECT_EQ(f.samples, 9);
+    EXPECT_EQ(f.disagree_mask, 0);
+    EXPECT_EQ(f.faulty_mask, 0);
+    EXPECT_LE(f.spread_cm, UsFusionConfig{}.agree_cm);
+}
+
+TEST_F(UsFusionTest, OutvotedUnitFlaggedThenRecovers)
+{
+    UsFusion fusion = make_fusion(3);
+    drivers_[1]->offset_cm = 25.0f;
+
+    for (int round = 1; round <= 3; round++) {
+        FusedReading f = fusion.read_distance();
+        ASSERT_EQ(UsResult::OK, f.reading.result);
+        EXPECT_NEAR(true_cm_, f.reading.cm, 2.0f); // the odd one out does not pull the result
+        EXPECT_EQ(f.agreeing, 2);
+        EXPECT_EQ(f.disagree_mask, 0b010);
+        EXPECT_EQ(f.faulty_mask, (round == 3) ? 0b010 : 0);
+    }
+
+    drivers_[1]->offset_cm = 0.0f;
+    FusedReading f = fusion.read_distance();
+    EXPECT_EQ(f.disagree_mask, 0);
+    EXPECT_EQ(f.faulty_mask, 0);
+}
+
+TEST_F(UsFusionTest, SilentUnitStrikesWhileQuorumHolds)
+{
+    UsFusionConfig fcfg;
+    fcfg.fault_after = 2;
+    UsFusion fusion = make_fusion(3, fcfg);
+    drivers_[2]->silent = true;
+
+    FusedReading f = fusion.read_distance();
+    ASSERT_EQ(UsResult::OK, f.reading.result);
+    EXPECT_EQ(f.sensors, 2);
+    EXPECT_EQ(f.failed_mask, 0b100);
+    EXPECT_EQ(f.faulty_mask, 0);
+
+    EXPECT_EQ(fusion.read_distance().faulty_mask, 0b100);
+    fusion.reset_faults();
+    EXPECT_EQ(fusion.faulty_mask(), 0);
+}
+
+TEST_F(UsFusionTest, TwoSensorsDisagreeing)
+{
+    UsFusion fusion = make_fusion(2);
+    drivers_[0]->offset_cm = -30.0f;
+
+    // Neither can be trusted over the other, and neither earns a strike
+    FusedReading f = fusion.read_distance();
+    EXPECT_EQ(UsResult::HIGH_VARIANCE, f.reading.result);
+    EXPECT_EQ(f.sensors, 2);
+    EXPECT_EQ(f.agreeing, 1);
+    EXPECT_NE(f.disagree_mask, 0);
+    for (int i = 0; i < 5; i++) fusion.read_distance();
+    EXPECT_EQ(fusion.faulty_mask(), 0);
+}
+
+TEST_F(UsFusionTest, BelowQuorumIsWeak)
+{
+    UsFusion fusion = make_fusion(3);
+    drivers_[0]->silent = true;
+    drivers_[1]->silent = true;
+
+    FusedReading f = fusion.read_distance();
+    EXPECT_EQ(UsResult::WEAK_SIGNAL, f.reading.result);
+    EXPECT_NEAR(true_cm_, f.reading.cm, 2.0f);
+    EXPECT_EQ(f.agreeing, 1);
+    EXPECT_EQ(f.failed_mask, 0b011);
+
+    // The working sensor is enough to blame the silent ones
+    fusion.read_distance();
+    EXPECT_EQ(fusion.read_distance().faulty_mask, 0b011);
+}
+
+TEST_F(UsFusionTest, SilentUnitOfPairFlagged)
+{
+    UsFusion fusion = make_fusion(2);
+    drivers_[1]->silent = true;
+
+    for (int round = 1; round <= 3; round++) {
+        FusedReading f = fusion.read_distance();
+        EXPECT_EQ(UsResult::WEAK_SIGNAL, f.reading.result);
+        EXPECT_EQ(f.failed_mask, 0b10);
+        EXPECT_EQ(f.faulty_mask, (round == 3) ? 0b10 : 0);
+    }
+
+    // Back in agreement, it clears
+    drivers_[1]->silent = false;
+    FusedReading f = fusion.read_distance();
+    EXPECT_EQ(UsResult::OK, f.reading.result);
+    EXPECT_EQ(f.faulty_mask, 0);
+
+    // When every sensor fails nobody is blamed
+    drivers_[0]->silent = true;
+    drivers_[1]->silent = true;
+    for (int i = 0; i < 5; i++) fusion.read_distance();
+    EXPECT_EQ(fusion.faulty_mask(), 0);
+}
+
+// =================================================================
+// combine()
+// =================================================================
+
+TEST(UsFusionCombineTest, WeightsFollowKeptPings)
+{
+    UsFusionConfig fcfg;
+    fcfg.agree_cm = 5.0f;
+    UsFusion fusion(fcfg);
+
+    // The 5-ping burst outweighs the 1-ping one inside the consensus
+    const MeasurementInfo bursts[] = {burst(UsResult::OK, 100.0f, 5), burst(UsResult::OK, 104.0f, 1),
+                                      burst(UsResult::OK, 160.0f, 5)};
+    FusedReading f = fusion.combine(bursts, 3);
+    ASSERT_EQ(UsResult::OK, f.reading.result);
+    EXPECT_NEAR(f.reading.cm, (5 * 100.0f + 104.0f) / 6, 1e-3f);
+    EXPECT_EQ(f.samples, 6);
+    EXPECT_EQ(f.disagree_mask, 0b100);
+    EXPECT_NEAR(f.spread_cm, 104.0f - f.reading.cm, 1e-3f);
+
+    // A WEAK_SIGNAL burst votes with half its pings
+    const MeasurementInfo weak[] = {burst(UsResult::WEAK_SIGNAL, 100.0f, 4), burst(UsResult::OK, 102.0f, 2)};
+    EXPECT_NEAR(fusion.combine(weak, 2).reading.cm, 101.0f, 1e-3f);
+}
+
+TEST(UsFusionCombineTest, AllFailedReportsCommonFailure)
+{
+    UsFusion fusion;
+    const MeasurementInfo bursts[] = {burst(UsResult::TIMEOUT, 0.0f, 0), burst(UsResult::ECHO_STUCK, 0.0f, 0),
+                                      burst(UsResult::TIMEOUT, 0.0f, 0)};
+    FusedReading f = fusion.combine(bursts, 3);
+    EXPECT_EQ(UsResult::TIMEOUT, f.reading.result);
+    EXPECT_EQ(f.sensors, 0);
+    EXPECT_EQ(f.failed_mask, 0b111);
+
+    EXPECT_EQ(UsResult::INSUFFICIENT_SAMPLES, fusion.combine(bursts, 0).reading.result);
+    EXPECT_EQ(UsResult::INSUFFICIENT_SAMPLES, fusion.read_distance().reading.result);
+}
+
+TEST_F(UsFusionTest, AddSensorChecks)
+{
+    UsFusion fusion;
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, fusion.add_sensor(nullptr));
+    EXPECT_EQ(ESP_OK, fusion.add_sensor(sensors_[0].get()));
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, fusion.add_sensor(sensors_[0].get()));
+    EXPECT_EQ(ESP_OK, fusion.add_sensor(sensors_[1].get()));
+    EXPECT_EQ(ESP_OK, fusion.add_sensor(sensors_[2].get()));
+
+    UsSensor extra(cfg_, drivers_[0], std::make_shared<UsProcessor>(), freertos_);
+    EXPECT_EQ(ESP_OK, fusion.add_sensor(&extra));
+    UsSensor too_many(cfg_, drivers_[0], std::make_shared<UsProcessor>(), freertos_);
+    EXPECT_EQ(ESP_ERR_NO_MEM, fusion.add_sensor(&too_many));
+    EXPECT_EQ(fusion.sensor_count(), UsFusion::MAX_SENSORS);
+}
+
+// =================================================================
+// Confidence per ping
+// =================================================================
+
+TEST_F(UsFusionTest, ShortFusedBurstsMatchLongSingleBurst)
+{
+    constexpr int ROUNDS = 400;
+    UsFusion fusion = make_fusion(3); // 3 pings per sensor
+
+    double single_sq = 0.0;
+    double fused_sq = 0.0;
+    for (int i = 0; i < ROUNDS; i++) {
+        Reading single = sensors_[0]->read_distance(7);
+        FusedReading fused = fusion.read_distance();
+        ASSERT_EQ(UsResult::OK, single.result);
+        ASSERT_EQ(UsResult::OK, fused.reading.result);
+        single_sq += std::pow(single.cm - true_cm_, 2);
+        fused_sq += std::pow(fused.reading.cm - true_cm_, 2);
+    }
+    const double single_rms = std::sqrt(single_sq / ROUNDS);
+    const double fused_rms = std::sqrt(fused_sq / ROUNDS);
+
+    // Three pings per sensor are at least as precise as seven on one sensor
+    EXPECT_LT(fused_rms, single_rms);
+    EXPECT_EQ(fusion.faulty_mask(), 0);
+}
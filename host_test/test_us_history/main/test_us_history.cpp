@@ -0,0 +1,286 @@
+// components/ultrasonic_sensor/host_test/test_us_history/main/test_us_history.cpp
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "esp_err.h"
+
+#include "us_history.hpp"
+#include "us_history_file.hpp"
+#include "us_packed_reading.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+
+/**
+ * Readings as a sensor produces them: one burst every ~100 ms with some
+ * scheduling jitter, a target drifting slowly, and an occasional timeout.
+ */
+static std::vector<HistorySample> make_series(size_t n, int64_t start_us = 1000000)
+{
+    std::vector<HistorySample> out;
+    uint32_t x = 12345;
+    auto rnd = [&x]() {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return x;
+    };
+
+    int64_t t = start_us;
+    float cm = 120.0f;
+    for (size_t i = 0; i < n; i++) {
+        t += 100000 + static_cast<int64_t>(rnd() % 2001) - 1000;
+        // Echo widths are whole microseconds, so distances move in steps of ~0.017 cm
+        cm += static_cast<float>(static_cast<int>(rnd() % 5) - 2) * 0.01715f;
+        Reading r = (rnd() % 50 == 0) ? Reading{UsResult::TIMEOUT, 0.0f} : Reading{UsResult::OK, cm};
+        out.push_back({t, PackedReading::pack(r)});
+    }
+    return out;
+}
+
+static void append_all(UsHistory &history, const std::vector<HistorySample> &samples)
+{
+    for (const auto &s : samples) {
+        ASSERT_EQ(ESP_OK, history.append(s.timestamp_us, s.reading.unpack()));
+    }
+}
+
+static bool same(const HistorySample &a, const HistorySample &b)
+{
+    return a.timestamp_us == b.timestamp_us && a.reading == b.reading;
+}
+
+TEST(UsHistoryTest, InitValidatesGeometry)
+{
+    UsHistoryRamStorage small(UsHistory::MIN_BLOCK_SIZE - 1, 8);
+    UsHistory a(small);
+    EXPECT_EQ(ESP_ERR_INVALID_SIZE, a.init());
+    EXPECT_EQ(ESP_ERR_INVALID_STATE, a.append(0, {UsResult::OK, 1.0f}));
+
+    UsHistoryRamStorage single(256, 1);
+    UsHistory b(single);
+    EXPECT_EQ(ESP_ERR_INVALID_SIZE, b.init());
+
+    UsHistoryRamStorage ok(256, 2);
+    UsHistory c(ok);
+    EXPECT_EQ(ESP_OK, c.init());
+    EXPECT_EQ(0u, c.stats().retained);
+    EXPECT_EQ(0.0f, c.compression_ratio());
+}
+
+TEST(UsHistoryTest, RoundTripIsLossless)
+{
+    UsHistoryRamStorage storage(256, 64);
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+
+    auto series = make_series(1500);
+    append_all(history, series);
+
+    std::vector<HistorySample> out(series.size() + 10);
+    size_t n = history.query(INT64_MIN, INT64_MAX, out.data(), out.size());
+    ASSERT_EQ(series.size(), n);
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_TRUE(same(series[i], out[i])) << i;
+    }
+    EXPECT_EQ(series.size(), history.stats().appended);
+    EXPECT_EQ(series.size(), history.stats().retained);
+}
+
+TEST(UsHistoryTest, CompressesTypicalSeries)
+{
+    UsHistoryRamStorage storage(512, 64);
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+    append_all(history, make_series(4000));
+
+    // Raw samples take 16 bytes
+    EXPECT_GT(history.compression_ratio(), 3.0f);
+    EXPECT_LT(history.bytes_per_sample(), 5.0f);
+
+    UsHistoryStats s = history.stats();
+    EXPECT_NEAR(history.bytes_per_sample(), static_cast<float>(s.stored_bytes) / s.retained, 1e-3f);
+}
+
+TEST(UsHistoryTest, OutOfOrderSampleRejected)
+{
+    UsHistoryRamStorage storage(256, 4);
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+
+    EXPECT_EQ(ESP_OK, history.append(1000, {UsResult::OK, 10.0f}));
+    EXPECT_EQ(ESP_OK, history.append(1000, {UsResult::OK, 11.0f})); // equal timestamps are fine
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, history.append(999, {UsResult::OK, 12.0f}));
+    EXPECT_EQ(1u, history.stats().dropped);
+    EXPECT_EQ(2u, history.stats().retained);
+}
+
+TEST(UsHistoryTest, RingKeepsNewestSamples)
+{
+    UsHistoryRamStorage storage(128, 4);
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+
+    auto series = make_series(2000);
+    append_all(history, series);
+
+    UsHistoryStats s = history.stats();
+    EXPECT_EQ(2000u, s.appended);
+    ASSERT_LT(s.retained, 2000u);
+    ASSERT_GT(s.retained, 0u);
+    EXPECT_LE(s.stored_bytes, 4u * 128u);
+
+    // What is left is exactly the newest part of the series
+    std::vector<HistorySample> out(series.size());
+    size_t n = history.query(INT64_MIN, INT64_MAX, out.data(), out.size());
+    ASSERT_EQ(s.retained, n);
+    size_t first = series.size() - n;
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_TRUE(same(series[first + i], out[i])) << i;
+    }
+}
+
+TEST(UsHistoryTest, RangeQueryDecodesOnlyTouchedBlocks)
+{
+    UsHistoryRamStorage storage(256, 128);
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+
+    auto series = make_series(5000);
+    append_all(history, series);
+    UsHistoryStats before = history.stats();
+    ASSERT_GT(before.blocks_written, 50u);
+
+    // Ten samples from the middle of the history
+    const int64_t from = series[2500].timestamp_us;
+    const int64_t to = series[2509].timestamp_us;
+    std::vector<HistorySample> out(100);
+    size_t n = history.query(from, to, out.data(), out.size());
+
+    ASSERT_EQ(10u, n);
+    for (size_t i = 0; i < n; i++) {
+        EXPECT_TRUE(same(series[2500 + i], out[i])) << i;
+    }
+    EXPECT_LE(history.stats().blocks_decoded - before.blocks_decoded, 2u);
+
+    // A bounded output stops the query early
+    n = history.query(INT64_MIN, INT64_MAX, out.data(), 3);
+    EXPECT_EQ(3u, n);
+    EXPECT_TRUE(same(series[0], out[0]));
+
+    // Empty and inverted ranges
+    EXPECT_EQ(0u, history.query(0, series[0].timestamp_us - 1, out.data(), out.size()));
+    EXPECT_EQ(0u, history.query(to, from, out.data(), out.size()));
+}
+
+TEST(UsHistoryTest, CorruptBlockIsSkipped)
+{
+    UsHistoryRamStorage storage(256, 16);
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+
+    auto series = make_series(600);
+    append_all(history, series);
+
+    // Wipe the header of block 2
+    uint8_t zeros[sizeof(HistoryBlockHeader)] = {};
+    ASSERT_EQ(ESP_OK, storage.write(2, zeros, sizeof(zeros)));
+
+    std::vector<HistorySample> out(series.size());
+    size_t n = history.query(INT64_MIN, INT64_MAX, out.data(), out.size());
+    EXPECT_LT(n, series.size());
+    EXPECT_GT(n, series.size() / 2);
+    for (size_t i = 1; i < n; i++) {
+        EXPECT_LT(out[i - 1].timestamp_us, out[i].timestamp_us);
+    }
+}
+
+TEST(UsHistoryTest, ActsAsReadingSink)
+{
+    UsHistoryRamStorage storage(256, 4);
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+
+    IUsReadingSink &sink = history;
+    TimedReading r;
+    r.reading = {UsResult::OK, 33.3f};
+    r.timestamp_us = 42;
+    r.stale = false;
+    sink.on_reading(r);
+
+    HistorySample out[2];
+    ASSERT_EQ(1u, history.query(0, 100, out, 2));
+    EXPECT_EQ(42, out[0].timestamp_us);
+    EXPECT_EQ(PackedReading::pack(r.reading), out[0].reading);
+}
+
+class UsHistoryFileTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        path_ = ::testing::TempDir() + "us_history_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+        std::remove(path_.c_str());
+    }
+
+    void TearDown() override { std::remove(path_.c_str()); }
+
+    std::string path_;
+};
+
+TEST_F(UsHistoryFileTest, OpenValidatesArguments)
+{
+    UsHistoryFileStorage storage;
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, storage.open(path_.c_str(), 0, 4));
+    ASSERT_EQ(ESP_OK, storage.open(path_.c_str(), 256, 4));
+    EXPECT_EQ(ESP_ERR_INVALID_STATE, storage.open(path_.c_str(), 256, 4));
+    EXPECT_EQ(256u, storage.block_size());
+    EXPECT_EQ(4u, storage.block_count());
+
+    uint8_t buf[8];
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, storage.read(4, 0, buf, sizeof(buf)));
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, storage.read(0, 250, buf, sizeof(buf)));
+    EXPECT_EQ(ESP_OK, storage.read(3, 248, buf, sizeof(buf)));
+
+    UsHistoryFileStorage missing_dir;
+    EXPECT_EQ(ESP_FAIL, missing_dir.open("/nonexistent_dir/history.bin", 256, 4));
+}
+
+TEST_F(UsHistoryFileTest, HistorySurvivesRestart)
+{
+    auto series = make_series(3000);
+    const size_t half = series.size() / 2;
+
+    {
+        UsHistoryFileStorage storage;
+        ASSERT_EQ(ESP_OK, storage.open(path_.c_str(), 256, 64));
+        UsHistory history(storage);
+        ASSERT_EQ(ESP_OK, history.init());
+        append_all(history, std::vector<HistorySample>(series.begin(), series.begin() + half));
+        ASSERT_EQ(ESP_OK, history.flush());
+    }
+
+    // Reopen: the history resumes, including the partially filled block
+    UsHistoryFileStorage storage;
+    ASSERT_EQ(ESP_OK, storage.open(path_.c_str(), 256, 64));
+    UsHistory history(storage);
+    ASSERT_EQ(ESP_OK, history.init());
+    EXPECT_EQ(half, history.stats().retained);
+
+    append_all(history, std::vector<HistorySample>(series.begin() + half, series.end()));
+
+    std::vector<HistorySample> out(series.size());
+    size_t n = history.query(INT64_MIN, INT64_MAX, out.data(), out.size());
+    ASSERT_EQ(history.stats().retained, n);
+    size_t first = series.size() - n;
+    for (size_t i = 0; i < n; i++) {
+        ASSERT_TRUE(same(series[first + i], out[i])) << i;
+    }
+}
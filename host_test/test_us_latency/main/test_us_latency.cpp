@@ -0,0 +1,251 @@
+// components/ultrasonic_sensor/host_test/test_us_latency/main/test_us_latency.cpp
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "us_latency.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+
+using Hist = UsLatencyHistogram;
+
+// Deterministic heavy-tailed latencies: mostly one ping time, a tail of timeouts
+class Rng
+{
+public:
+    explicit Rng(uint32_t seed) : x_(seed) {}
+    uint32_t next()
+    {
+        x_ ^= x_ << 13;
+        x_ ^= x_ >> 17;
+        x_ ^= x_ << 5;
+        return x_;
+    }
+    uint32_t latency()
+    {
+        uint32_t r = next();
+        if (r % 100 < 3)
+            return 60000 + next() % 400000; // timed-out bursts
+        return 1500 + next() % 30000;
+    }
+
+private:
+    uint32_t x_;
+};
+
+static uint32_t exact_quantile(std::vector<uint32_t> v, double q)
+{
+    std::sort(v.begin(), v.end());
+    size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(q * v.size())));
+    return v[rank - 1];
+}
+
+// =================================================================
+// Bucket layout
+// =================================================================
+
+TEST(UsLatencyHistogramTest, BucketsTileTheRange)
+{
+    EXPECT_EQ(Hist::BUCKETS, 384u);
+    EXPECT_EQ(Hist::bucket_low(0), 0u);
+    for (size_t i = 0; i + 1 < Hist::BUCKETS; i++) {
+        ASSERT_EQ(Hist::bucket_high(i) + 1, Hist::bucket_low(i + 1)) << i;
+        ASSERT_EQ(Hist::bucket_of(Hist::bucket_low(i)), i);
+        ASSERT_EQ(Hist::bucket_of(Hist::bucket_high(i)), i);
+        // Width at most 1/SUB_COUNT of the lower bound beyond the exact range
+        uint32_t width = Hist::bucket_high(i) - Hist::bucket_low(i) + 1;
+        if (i >= Hist::SUB_COUNT)
+            ASSERT_LE(width * Hist::SUB_COUNT, Hist::bucket_low(i)) << i;
+        else
+            ASSERT_EQ(width, 1u);
+    }
+    EXPECT_EQ(Hist::bucket_low(Hist::BUCKETS - 1), (Hist::SUB_COUNT * 2 - 1) << (Hist::MAX_EXPONENT - Hist::SUB_BITS - 1));
+    EXPECT_EQ(Hist::bucket_of(UINT32_MAX), Hist::BUCKETS - 1);
+    EXPECT_EQ(Hist::bucket_of(1u << Hist::MAX_EXPONENT), Hist::BUCKETS - 1);
+}
+
+// =================================================================
+// Recording and percentiles
+// =================================================================
+
+TEST(UsLatencyHistogramTest, EmptyHistogram)
+{
+    Hist h;
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+    EXPECT_EQ(h.mean(), 0.0);
+    EXPECT_EQ(h.percentile(0.5), 0u);
+}
+
+TEST(UsLatencyHistogramTest, SmallValuesAreExact)
+{
+    Hist h;
+    for (uint32_t v = 1; v <= 10; v++) {
+        h.record(v);
+    }
+    EXPECT_EQ(h.count(), 10u);
+    EXPECT_EQ(h.min(), 1u);
+    EXPECT_EQ(h.max(), 10u);
+    EXPECT_DOUBLE_EQ(h.mean(), 5.5);
+    EXPECT_EQ(h.percentile(0.5), 5u);
+    EXPECT_EQ(h.percentile(0.9), 9u);
+    EXPECT_EQ(h.percentile(0.0), 1u);
+    EXPECT_EQ(h.percentile(1.0), 10u);
+}
+
+TEST(UsLatencyHistogramTest, PercentilesWithinOneBucket)
+{
+    Rng rng(42);
+    Hist h;
+    std::vector<uint32_t> all;
+    for (int i = 0; i < 100000; i++) {
+        uint32_t v = rng.latency();
+        h.record(v);
+        all.push_back(v);
+    }
+
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        uint32_t exact = exact_quantile(all, q);
+        uint32_t est = h.percentile(q);
+        EXPECT_GE(est, exact) << q;
+        EXPECT_LE(est - exact, exact / Hist::SUB_COUNT) << q; // <= 6.25%
+    }
+    EXPECT_EQ(h.percentile(1.0), *std::max_element(all.begin(), all.end()));
+    // Timeouts dominate the tail while barely moving the median
+    EXPECT_LT(h.percentile(0.5), 20000u);
+    EXPECT_GT(h.percentile(0.99), 60000u);
+}
+
+TEST(UsLatencyHistogramTest, HugeValuesClampToLastBucket)
+{
+    Hist h;
+    h.record(UINT32_MAX);
+    h.record(1u << 30);
+    EXPECT_EQ(h.bucket_count(Hist::BUCKETS - 1), 2u);
+    EXPECT_EQ(h.max(), UINT32_MAX);
+    EXPECT_EQ(h.percentile(0.5), UINT32_MAX); // clamped bucket high, within [min, max]
+}
+
+// =================================================================
+// Merge and serialization
+// =================================================================
+
+TEST(UsLatencyHistogramTest, MergeEqualsCombinedRecording)
+{
+    Rng rng(7);
+    Hist a, b, both;
+    for (int i = 0; i < 5000; i++) {
+        uint32_t v = rng.latency();
+        ((i % 3 == 0) ? a : b).record(v);
+        both.record(v);
+    }
+    a.merge(b);
+    EXPECT_EQ(a.count(), both.count());
+    EXPECT_EQ(a.min(), both.min());
+    EXPECT_EQ(a.max(), both.max());
+    EXPECT_DOUBLE_EQ(a.mean(), both.mean());
+    for (size_t i = 0; i < Hist::BUCKETS; i++) {
+        ASSERT_EQ(a.bucket_count(i), both.bucket_count(i));
+    }
+
+    Hist empty;
+    a.merge(empty);
+    EXPECT_EQ(a.min(), both.min());
+}
+
+TEST(UsLatencyHistogramTest, EncodeDecodeRoundTrip)
+{
+    Rng rng(99);
+    Hist h;
+    for (int i = 0; i < 20000; i++) {
+        h.record(rng.latency());
+    }
+
+    std::vector<uint8_t> buf(Hist::MAX_ENCODED_BYTES);
+    size_t len = h.encode(buf.data(), buf.size());
+    ASSERT_GT(len, 0u);
+    EXPECT_LT(len, 600u); // sparse: only the occupied buckets
+    EXPECT_EQ(h.encode(buf.data(), len - 1), 0u);
+
+    Hist out;
+    ASSERT_EQ(out.decode(buf.data(), len), ESP_OK);
+    EXPECT_EQ(out.count(), h.count());
+    EXPECT_EQ(out.min(), h.min());
+    EXPECT_EQ(out.max(), h.max());
+    EXPECT_DOUBLE_EQ(out.mean(), h.mean());
+    for (size_t i = 0; i < Hist::BUCKETS; i++) {
+        ASSERT_EQ(out.bucket_count(i), h.bucket_count(i));
+    }
+
+    Hist empty;
+    len = empty.encode(buf.data(), buf.size());
+    ASSERT_EQ(out.decode(buf.data(), len), ESP_OK);
+    EXPECT_EQ(out.count(), 0u);
+    EXPECT_EQ(out.min(), 0u);
+}
+
+TEST(UsLatencyHistogramTest, DecodeRejectsBadInput)
+{
+    Hist h;
+    h.record(1000);
+    h.record(2000);
+    std::vector<uint8_t> buf(Hist::MAX_ENCODED_BYTES);
+    size_t len = h.encode(buf.data(), buf.size());
+
+    Hist out;
+    out.record(5);
+    for (size_t n = 0; n < len; n++) {
+        EXPECT_EQ(out.decode(buf.data(), n), ESP_ERR_INVALID_SIZE) << n;
+    }
+    buf[len] = 0;
+    EXPECT_EQ(out.decode(buf.data(), len + 1), ESP_ERR_INVALID_SIZE); // trailing bytes
+
+    std::vector<uint8_t> other = buf;
+    other[2] = Hist::SUB_BITS + 1;
+    EXPECT_EQ(out.decode(other.data(), len), ESP_ERR_INVALID_VERSION);
+
+    EXPECT_EQ(out.count(), 1u); // unchanged by failed decodes
+}
+
+// =================================================================
+// UsLatencyStats
+// =================================================================
+
+TEST(UsLatencyStatsTest, SplitsByResultAndMerges)
+{
+    auto node_a = std::make_unique<UsLatencyStats>();
+    auto node_b = std::make_unique<UsLatencyStats>();
+    node_a->record_read(UsResult::OK, 150000);
+    node_a->record_read(UsResult::TIMEOUT, 400000);
+    node_a->record_ping(UsResult::OK, 3000);
+    node_b->record_read(UsResult::OK, 160000);
+    node_b->record_ping(UsResult::TIMEOUT, 60000);
+
+    node_a->merge(*node_b);
+    node_a->merge(*node_a); // no-op
+
+    Hist h;
+    node_a->read(UsResult::OK, h);
+    EXPECT_EQ(h.count(), 2u);
+    EXPECT_EQ(h.max(), 160000u);
+    node_a->read(UsResult::TIMEOUT, h);
+    EXPECT_EQ(h.count(), 1u);
+    node_a->reads(h);
+    EXPECT_EQ(h.count(), 3u);
+    EXPECT_EQ(h.max(), 400000u);
+    node_a->pings(h);
+    EXPECT_EQ(h.count(), 2u);
+    node_a->ping(static_cast<UsResult>(US_RESULT_COUNT), h);
+    EXPECT_EQ(h.count(), 0u);
+
+    node_a->reset();
+    node_a->reads(h);
+    EXPECT_EQ(h.count(), 0u);
+}
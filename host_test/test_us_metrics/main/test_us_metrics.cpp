@@ -0,0 +1,205 @@
+// components/ultrasonic_sensor/host_test/test_us_metrics/main/test_us_metrics.cpp
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "us_metrics.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+
+static size_t idx(UsResult r) { return static_cast<size_t>(r); }
+
+static std::string to_json(const UsMetrics &m)
+{
+    size_t len = metrics_to_json(m, nullptr, 0);
+    std::string out(len, '\0');
+    EXPECT_EQ(metrics_to_json(m, out.data(), len + 1), len);
+    return out;
+}
+
+static std::string to_prometheus(const UsMetrics &m, const char *sensor)
+{
+    size_t len = metrics_to_prometheus(m, sensor, nullptr, 0);
+    std::string out(len, '\0');
+    EXPECT_EQ(metrics_to_prometheus(m, sensor, out.data(), len + 1), len);
+    return out;
+}
+
+// =================================================================
+// UsMetricsCounters
+// =================================================================
+
+TEST(UsMetricsTest, CountsPingsBurstsAndRatios)
+{
+    UsMetricsCounters counters;
+
+    // 3 of 4 pings valid -> bucket (0.7, 0.8]
+    Reading a[] = {{UsResult::OK, 10.0f}, {UsResult::TIMEOUT, 0.0f}, {UsResult::OK, 10.1f}, {UsResult::OK, 9.9f}};
+    counters.add_burst(a, 4, {UsResult::OK, 10.0f});
+
+    // No valid ping -> bucket 0
+    Reading b[] = {{UsResult::TIMEOUT, 0.0f}, {UsResult::OUT_OF_RANGE, 0.0f}};
+    counters.add_burst(b, 2, {UsResult::TIMEOUT, 0.0f});
+
+    // All valid -> last bucket
+    Reading c[] = {{UsResult::OK, 50.0f}};
+    counters.add_burst(c, 1, {UsResult::OK, 50.0f});
+
+    // Deadline too short for one ping: counted as a burst, not in the ratio
+    counters.add_burst(nullptr, 0, {UsResult::INSUFFICIENT_SAMPLES, 0.0f});
+
+    UsMetrics m = counters.snapshot();
+    EXPECT_EQ(m.ping_results[idx(UsResult::OK)], 4u);
+    EXPECT_EQ(m.ping_results[idx(UsResult::TIMEOUT)], 2u);
+    EXPECT_EQ(m.ping_results[idx(UsResult::OUT_OF_RANGE)], 1u);
+    EXPECT_EQ(m.pings(), 7u);
+
+    EXPECT_EQ(m.burst_results[idx(UsResult::OK)], 2u);
+    EXPECT_EQ(m.burst_results[idx(UsResult::TIMEOUT)], 1u);
+    EXPECT_EQ(m.burst_results[idx(UsResult::INSUFFICIENT_SAMPLES)], 1u);
+    EXPECT_EQ(m.bursts(), 4u);
+
+    EXPECT_EQ(m.valid_ratio[0], 1u);
+    EXPECT_EQ(m.valid_ratio[7], 1u);
+    EXPECT_EQ(m.valid_ratio[9], 1u);
+    EXPECT_EQ(m.valid_ratio_sum_ppm, 1750000u);
+    EXPECT_FLOAT_EQ(m.mean_valid_ratio(), 4.0f / 7.0f);
+
+    EXPECT_EQ(m.pings_per_burst[0], 1u);
+    EXPECT_EQ(m.pings_per_burst[1], 1u);
+    EXPECT_EQ(m.pings_per_burst[2], 1u);
+    EXPECT_EQ(m.pings_per_burst[4], 1u);
+}
+
+TEST(UsMetricsTest, RatioBucketEdges)
+{
+    // Bucket i holds (i/10, (i+1)/10]: exactly 50% belongs to bucket 4
+    for (uint8_t count = 1; count <= IUsProcessor::MAX_PINGS; count++) {
+        for (uint8_t valid = 1; valid <= count; valid++) {
+            UsMetricsCounters counters;
+            std::vector<Reading> pings(count, {UsResult::TIMEOUT, 0.0f});
+            for (uint8_t i = 0; i < valid; i++) {
+                pings[i] = {UsResult::OK, 1.0f};
+            }
+            counters.add_burst(pings.data(), count, {UsResult::OK, 1.0f});
+
+            UsMetrics m = counters.snapshot();
+            double ratio = static_cast<double>(valid) / count;
+            for (size_t b = 0; b < VALID_RATIO_BUCKETS; b++) {
+                bool inside = ratio > b / 10.0 + 1e-9 && ratio <= (b + 1) / 10.0 + 1e-9;
+                EXPECT_EQ(m.valid_ratio[b], inside ? 1u : 0u) << int(valid) << "/" << int(count) << " bucket " << b;
+            }
+        }
+    }
+}
+
+TEST(UsMetricsTest, ResetZeroesEverything)
+{
+    UsMetricsCounters counters;
+    Reading a[] = {{UsResult::OK, 10.0f}, {UsResult::HW_FAULT, 0.0f}};
+    counters.add_burst(a, 2, {UsResult::HW_FAULT, 0.0f});
+    counters.reset();
+
+    UsMetrics m = counters.snapshot();
+    UsMetrics zero;
+    EXPECT_EQ(std::memcmp(&m, &zero, sizeof(m)), 0);
+}
+
+// =================================================================
+// Serialization
+// =================================================================
+
+TEST(UsMetricsTest, ResultNames)
+{
+    EXPECT_STREQ(result_name(UsResult::OK), "ok");
+    EXPECT_STREQ(result_name(UsResult::INSUFFICIENT_SAMPLES), "insufficient_samples");
+    EXPECT_STREQ(result_name(UsResult::HW_FAULT), "hw_fault");
+    EXPECT_STREQ(result_name(static_cast<UsResult>(US_RESULT_COUNT)), "unknown");
+}
+
+TEST(UsMetricsTest, JsonLayout)
+{
+    UsMetricsCounters counters;
+    Reading a[] = {{UsResult::OK, 10.0f}, {UsResult::TIMEOUT, 0.0f}};
+    counters.add_burst(a, 2, {UsResult::OK, 10.0f});
+
+    std::string json = to_json(counters.snapshot());
+    EXPECT_EQ(json, "{\"pings\":{\"ok\":1,\"weak_signal\":0,\"timeout\":1,\"out_of_range\":0,\"high_variance\":0,"
+                    "\"insufficient_samples\":0,\"echo_stuck\":0,\"hw_fault\":0},"
+                    "\"bursts\":{\"ok\":1,\"weak_signal\":0,\"timeout\":0,\"out_of_range\":0,\"high_variance\":0,"
+                    "\"insufficient_samples\":0,\"echo_stuck\":0,\"hw_fault\":0},"
+                    "\"valid_ratio\":[0,0,0,0,1,0,0,0,0,0],\"valid_ratio_sum\":0.500000,"
+                    "\"pings_per_burst\":[0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0],\"mean_valid_ratio\":0.5000}");
+}
+
+TEST(UsMetricsTest, PrometheusCountersAndHistograms)
+{
+    UsMetricsCounters counters;
+    Reading a[] = {{UsResult::OK, 10.0f}, {UsResult::OK, 10.0f}, {UsResult::TIMEOUT, 0.0f}};
+    counters.add_burst(a, 3, {UsResult::OK, 10.0f});
+    Reading b[] = {{UsResult::ECHO_STUCK, 0.0f}};
+    counters.add_burst(b, 1, {UsResult::ECHO_STUCK, 0.0f});
+
+    std::string text = to_prometheus(counters.snapshot(), "tank_1");
+    EXPECT_NE(text.find("# TYPE us_pings_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("us_pings_total{sensor=\"tank_1\",result=\"ok\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("us_pings_total{sensor=\"tank_1\",result=\"echo_stuck\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("us_bursts_total{sensor=\"tank_1\",result=\"ok\"} 1\n"), std::string::npos);
+
+    // Buckets are cumulative: 2/3 lands in (0.6, 0.7], 0/1 in bucket 0
+    EXPECT_NE(text.find("# TYPE us_burst_valid_ratio histogram\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_valid_ratio_bucket{sensor=\"tank_1\",le=\"0.1\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_valid_ratio_bucket{sensor=\"tank_1\",le=\"0.6\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_valid_ratio_bucket{sensor=\"tank_1\",le=\"0.7\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_valid_ratio_bucket{sensor=\"tank_1\",le=\"1\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_valid_ratio_bucket{sensor=\"tank_1\",le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_valid_ratio_sum{sensor=\"tank_1\"} 0.666666\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_valid_ratio_count{sensor=\"tank_1\"} 2\n"), std::string::npos);
+
+    EXPECT_NE(text.find("us_burst_pings_bucket{sensor=\"tank_1\",le=\"0\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_pings_bucket{sensor=\"tank_1\",le=\"1\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_pings_bucket{sensor=\"tank_1\",le=\"3\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_pings_sum{sensor=\"tank_1\"} 4\n"), std::string::npos);
+    EXPECT_NE(text.find("us_burst_pings_count{sensor=\"tank_1\"} 2\n"), std::string::npos);
+}
+
+TEST(UsMetricsTest, PrometheusWithoutLabelAndEscaping)
+{
+    UsMetrics m;
+    std::string bare = to_prometheus(m, nullptr);
+    EXPECT_NE(bare.find("us_pings_total{result=\"ok\"} 0\n"), std::string::npos);
+    EXPECT_NE(bare.find("us_burst_pings_sum 0\n"), std::string::npos);
+    EXPECT_EQ(bare.find("sensor"), std::string::npos);
+
+    std::string escaped = to_prometheus(m, "a\"b\\c\nd");
+    EXPECT_NE(escaped.find("{sensor=\"a\\\"b\\\\c\\nd\",result=\"ok\"}"), std::string::npos);
+}
+
+TEST(UsMetricsTest, TruncatesLikeSnprintf)
+{
+    UsMetrics m;
+    m.ping_results[idx(UsResult::OK)] = 123456;
+    const size_t json_len = metrics_to_json(m, nullptr, 0);
+    const size_t prom_len = metrics_to_prometheus(m, "s", nullptr, 0);
+
+    const std::string json = to_json(m);
+    const std::string prom = to_prometheus(m, "s");
+    for (size_t size : {size_t{1}, size_t{2}, size_t{17}, json_len, json_len + 1}) {
+        std::vector<char> buf(size + 1, '#');
+        EXPECT_EQ(metrics_to_json(m, buf.data(), size), json_len);
+        EXPECT_EQ(std::strlen(buf.data()), std::min(size - 1, json_len));
+        EXPECT_EQ(std::string(buf.data()), json.substr(0, size - 1));
+        EXPECT_EQ(buf[size], '#'); // nothing written past the buffer
+    }
+    for (size_t size : {size_t{1}, size_t{64}, prom_len, prom_len + 1}) {
+        std::vector<char> buf(size + 1, '#');
+        EXPECT_EQ(metrics_to_prometheus(m, "s", buf.data(), size), prom_len);
+        EXPECT_EQ(std::string(buf.data()), prom.substr(0, size - 1));
+        EXPECT_EQ(buf[size], '#');
+    }
+}
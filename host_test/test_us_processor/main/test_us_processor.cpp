@@ -1,6 +1,8 @@
+#include "us_packed_reading.hpp"
 #include "us_processor.hpp"
 #include "us_types.hpp"
 #include <algorithm>
+#include <cmath>
 #include <vector>
 #include "gtest/gtest.h"
 
@@ -26,6 +28,43 @@ TEST(UsProcessorTest, MedianFilter)
     EXPECT_FLOAT_EQ(30.0f, result.cm);
 }
 
+TEST(UsProcessorTest, ProcessExReportsBurstDiagnostics)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+    cfg.filter = Filter::DOMINANT_CLUSTER;
+    cfg.max_dev_cm = 200.0f;
+
+    Reading pings[] = {
+        {UsResult::OK, 50.0f},
+        {UsResult::TIMEOUT, 0.0f},
+        {UsResult::OK, 51.0f},
+        {UsResult::OK, 90.0f},
+        {UsResult::OUT_OF_RANGE, 0.0f},
+        {UsResult::OK, 52.0f},
+    };
+    MeasurementInfo info;
+    auto result = processor.process_ex(pings, 6, UsCompiledConfig(cfg), info);
+
+    EXPECT_EQ(result, processor.process(pings, 6, cfg));
+    EXPECT_EQ(info.total_pings, 6);
+    EXPECT_EQ(info.valid_pings, 4);
+    EXPECT_EQ(info.pings_with(UsResult::OK), 4);
+    EXPECT_EQ(info.pings_with(UsResult::TIMEOUT), 1);
+    EXPECT_EQ(info.pings_with(UsResult::OUT_OF_RANGE), 1);
+    EXPECT_EQ(info.filter_samples, 3); // 90 cm lies outside the cluster
+    EXPECT_GT(info.std_dev_cm, 15.0f);
+
+    // Too few valid pings: no deviation and no filter run
+    Reading sparse[] = {{UsResult::OK, 50.0f}, {UsResult::TIMEOUT, 0.0f}, {UsResult::TIMEOUT, 0.0f}};
+    MeasurementInfo none;
+    EXPECT_EQ(processor.process_ex(sparse, 3, UsCompiledConfig(cfg), none).result, UsResult::TIMEOUT);
+    EXPECT_EQ(none.valid_pings, 1);
+    EXPECT_EQ(none.pings_with(UsResult::TIMEOUT), 2);
+    EXPECT_TRUE(std::isnan(none.std_dev_cm));
+    EXPECT_EQ(none.filter_samples, 0);
+}
+
 TEST(UsProcessorTest, ReduceMedianEmpty)
 {
     UsProcessor processor;
@@ -283,3 +322,195 @@ TEST(UsProcessorTest, Boundaries_ExactlyAtThresholds)
     auto result_edge = processor.process(pings_edge, 2, cfg);
     EXPECT_NE(UsResult::INSUFFICIENT_SAMPLES, result_edge.result);
 }
+
+TEST(UsProcessorTest, NonFiniteSamplesAreInvalid)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+
+    Reading pings[] = {
+        {UsResult::OK, 50.0f},
+        {UsResult::OK, NAN},
+        {UsResult::OK, 50.2f},
+        {UsResult::OK, INFINITY},
+        {UsResult::OK, 49.8f}
+    };
+    auto result = processor.process(pings, 5, cfg); // ratio 3/5 = 0.6
+
+    EXPECT_EQ(UsResult::WEAK_SIGNAL, result.result);
+    EXPECT_FLOAT_EQ(50.0f, result.cm);
+
+    Reading all_nan[] = {{UsResult::OK, NAN}, {UsResult::OK, NAN}, {UsResult::OK, NAN}};
+    result = processor.process(all_nan, 3, cfg);
+    EXPECT_EQ(UsResult::INSUFFICIENT_SAMPLES, result.result);
+}
+
+TEST(UsProcessorTest, OverflowingSamplesAreHighVariance)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+
+    Reading pings[] = {{UsResult::OK, 3e38f}, {UsResult::OK, 3e38f}, {UsResult::OK, -3e38f}};
+    auto result = processor.process(pings, 3, cfg);
+
+    EXPECT_EQ(UsResult::HIGH_VARIANCE, result.result);
+}
+
+TEST(UsProcessorTest, TotalPingsAboveMaxIsTruncated)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+
+    std::vector<Reading> pings(IUsProcessor::MAX_PINGS + 10, Reading{UsResult::OK, 50.0f});
+    // Pings past MAX_PINGS must be ignored
+    for (size_t i = IUsProcessor::MAX_PINGS; i < pings.size(); i++) pings[i] = {UsResult::TIMEOUT, 0.0f};
+
+    auto result = processor.process(pings.data(), static_cast<uint8_t>(pings.size()), cfg);
+
+    EXPECT_EQ(UsResult::OK, result.result);
+    EXPECT_FLOAT_EQ(50.0f, result.cm);
+}
+
+TEST(UsProcessorTest, AllIdenticalSamples)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+    cfg.max_dev_cm = 0.0f;
+
+    for (Filter f : {Filter::MEDIAN, Filter::DOMINANT_CLUSTER}) {
+        cfg.filter = f;
+        std::vector<Reading> pings(IUsProcessor::MAX_PINGS, Reading{UsResult::OK, 123.4f});
+        auto result = processor.process(pings.data(), IUsProcessor::MAX_PINGS, cfg);
+
+        EXPECT_EQ(UsResult::OK, result.result);
+        EXPECT_FLOAT_EQ(123.4f, result.cm);
+    }
+}
+
+TEST(UsProcessorTest, JitterRejectsUncorrelatedSamples)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+
+    // Own echo at 100 cm; crosstalk from a jittered neighbour lands anywhere
+    Reading pings[] = {
+        {UsResult::OK, 100.2f},
+        {UsResult::OK, 43.0f},
+        {UsResult::OK, 99.8f},
+        {UsResult::OK, 100.0f},
+        {UsResult::OK, 71.5f},
+        {UsResult::OK, 100.4f},
+        {UsResult::OK, 99.9f},
+        {UsResult::OK, 12.0f},
+        {UsResult::OK, 100.1f},
+    };
+
+    // Without jitter the samples are taken at face value
+    auto result = processor.process(pings, 9, cfg);
+    EXPECT_EQ(UsResult::HIGH_VARIANCE, result.result);
+
+    // With jitter the scattered samples are rejected; 6/9 kept gives WEAK_SIGNAL
+    cfg.trigger_jitter_us = 4000;
+    result = processor.process(pings, 9, cfg);
+    EXPECT_EQ(UsResult::WEAK_SIGNAL, result.result);
+    EXPECT_NEAR(100.0f, result.cm, 0.3f);
+}
+
+TEST(UsProcessorTest, JitterRejectionNeedsACluster)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+    cfg.trigger_jitter_us = 4000;
+    cfg.max_dev_cm = 200.0f;
+
+    // No two samples agree: nothing to correlate against, all are kept
+    Reading pings[] = {
+        {UsResult::OK, 20.0f},
+        {UsResult::OK, 60.0f},
+        {UsResult::OK, 100.0f},
+    };
+    auto result = processor.process(pings, 3, cfg);
+    EXPECT_TRUE(is_success(result.result));
+    EXPECT_FLOAT_EQ(60.0f, result.cm);
+
+    // Too few correlated samples left is INSUFFICIENT_SAMPLES
+    Reading sparse[] = {
+        {UsResult::OK, 50.0f},
+        {UsResult::OK, 51.0f},
+        {UsResult::OK, 10.0f},
+        {UsResult::OK, 90.0f},
+        {UsResult::OK, 130.0f},
+        {UsResult::OK, 170.0f},
+    };
+    result = processor.process(sparse, 6, cfg);
+    EXPECT_EQ(UsResult::INSUFFICIENT_SAMPLES, result.result);
+}
+
+TEST(PackedReadingTest, LayoutAndFields)
+{
+    static_assert(sizeof(PackedReading) == 4);
+    static_assert(sizeof(PackedReading) * 2 == sizeof(Reading));
+
+    constexpr PackedReading p = PackedReading::from_um(UsResult::WEAK_SIGNAL, 1234567);
+    static_assert(p.result() == UsResult::WEAK_SIGNAL);
+    static_assert(p.um() == 1234567);
+
+    for (uint8_t r = 0; r <= static_cast<uint8_t>(UsResult::HW_FAULT); r++) {
+        PackedReading q = PackedReading::from_um(static_cast<UsResult>(r), PackedReading::MAX_UM);
+        EXPECT_EQ(static_cast<UsResult>(r), q.result());
+        EXPECT_EQ(PackedReading::MAX_UM, q.um());
+    }
+}
+
+TEST(PackedReadingTest, RoundTrip)
+{
+    // Reading -> packed keeps the distance to the micrometre
+    Reading r = {UsResult::OK, 123.4567f};
+    PackedReading p = PackedReading::pack(r);
+    EXPECT_EQ(1234567u, p.um());
+    EXPECT_EQ(r, p.unpack());
+
+    // packed -> Reading -> packed is exact over the sensor range (< 512 cm)
+    for (uint32_t um = 0; um < 5120000; um += 7) {
+        PackedReading q = PackedReading::from_um(UsResult::OK, um);
+        ASSERT_EQ(q, PackedReading::pack(q.unpack())) << um;
+    }
+}
+
+TEST(PackedReadingTest, OutOfDomainDistances)
+{
+    EXPECT_EQ(0u, PackedReading::pack({UsResult::TIMEOUT, -5.0f}).um());
+    EXPECT_EQ(0u, PackedReading::pack({UsResult::OK, NAN}).um());
+    EXPECT_EQ(PackedReading::MAX_UM, PackedReading::pack({UsResult::OK, INFINITY}).um());
+    EXPECT_EQ(PackedReading::MAX_UM, PackedReading::pack({UsResult::OK, 1e9f}).um());
+    EXPECT_EQ(UsResult::OK, PackedReading::pack({UsResult::OK, 1e9f}).result());
+}
+
+TEST(UsProcessorTest, PackedInputMatchesUnpacked)
+{
+    UsProcessor processor;
+    UsConfig cfg;
+
+    std::vector<Reading> sets[] = {
+        {{UsResult::OK, 25.0f}, {UsResult::OK, 35.0f}, {UsResult::OK, 20.0f}, {UsResult::OK, 40.0f}, {UsResult::OK, 30.0f}},
+        {{UsResult::OK, 50.1f}, {UsResult::TIMEOUT, 0.0f}, {UsResult::OK, 49.8f}, {UsResult::OUT_OF_RANGE, 0.0f}},
+        {{UsResult::TIMEOUT, 0.0f}, {UsResult::TIMEOUT, 0.0f}, {UsResult::OUT_OF_RANGE, 0.0f}},
+    };
+
+    for (Filter filter : {Filter::MEDIAN, Filter::DOMINANT_CLUSTER}) {
+        cfg.filter = filter;
+        for (auto &pings : sets) {
+            std::vector<PackedReading> packed;
+            for (const auto &r : pings) packed.push_back(PackedReading::pack(r));
+
+            auto n = static_cast<uint8_t>(pings.size());
+            Reading expected = processor.process(pings.data(), n, cfg);
+            Reading actual = processor.process_packed(packed.data(), n, cfg);
+            EXPECT_EQ(expected, actual);
+
+            // The interface fallback (unpack, then process) agrees too
+            IUsProcessor &base = processor;
+            EXPECT_EQ(expected, base.IUsProcessor::process_packed(packed.data(), n, cfg));
+        }
+    }
+}
@@ -0,0 +1,224 @@
+// components/ultrasonic_sensor/host_test/test_us_rollup/main/test_us_rollup.cpp
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "us_rollup.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+
+// Deterministic uniform samples in [0, 1)
+class Rng
+{
+public:
+    explicit Rng(uint32_t seed) : x_(seed) {}
+    float next()
+    {
+        x_ ^= x_ << 13;
+        x_ ^= x_ >> 17;
+        x_ ^= x_ << 5;
+        return static_cast<float>(x_ >> 8) / static_cast<float>(1u << 24);
+    }
+
+private:
+    uint32_t x_;
+};
+
+static float exact_quantile(std::vector<float> v, double p)
+{
+    std::sort(v.begin(), v.end());
+    return v[static_cast<size_t>(std::lround(p * (v.size() - 1)))];
+}
+
+// =================================================================
+// P2Quantile
+// =================================================================
+
+TEST(P2QuantileTest, ExactForFewSamples)
+{
+    P2Quantile q;
+    EXPECT_EQ(0.0f, q.value());
+
+    q.add(30.0f);
+    EXPECT_EQ(30.0f, q.value());
+    q.add(10.0f);
+    q.add(20.0f);
+    EXPECT_EQ(20.0f, q.value());
+    q.add(50.0f);
+    q.add(40.0f);
+    EXPECT_EQ(30.0f, q.value());
+    EXPECT_EQ(5u, q.count());
+
+    q.reset();
+    EXPECT_EQ(0u, q.count());
+    EXPECT_EQ(0.0f, q.value());
+}
+
+TEST(P2QuantileTest, TracksQuantilesOfLargeStreams)
+{
+    for (double p : {0.1, 0.5, 0.9}) {
+        P2Quantile q(static_cast<float>(p));
+        Rng rng(7);
+        std::vector<float> all;
+        for (int i = 0; i < 20000; i++) {
+            // Skewed distribution: most targets near 100 cm, a tail towards 300 cm
+            float u = rng.next();
+            float x = 100.0f + 200.0f * u * u * u;
+            q.add(x);
+            all.push_back(x);
+        }
+        EXPECT_NEAR(exact_quantile(all, p), q.value(), 1.0f) << "p=" << p;
+    }
+}
+
+TEST(P2QuantileTest, HandlesSortedAndConstantInput)
+{
+    P2Quantile ascending;
+    for (int i = 0; i < 1001; i++) {
+        ascending.add(static_cast<float>(i));
+    }
+    EXPECT_NEAR(500.0f, ascending.value(), 5.0f);
+
+    P2Quantile constant;
+    for (int i = 0; i < 100; i++) {
+        constant.add(42.0f);
+    }
+    EXPECT_EQ(42.0f, constant.value());
+}
+
+// =================================================================
+// UsRollup
+// =================================================================
+
+static constexpr int64_t SECOND_US = 1000000;
+static constexpr int64_t MINUTE_US = 60 * SECOND_US;
+
+TEST(UsRollupTest, BucketsMatchBruteForce)
+{
+    UsRollup rollup(60000, 16);
+    Rng rng(99);
+
+    struct Expected
+    {
+        uint32_t results[US_RESULT_COUNT] = {};
+        std::vector<float> cm;
+    };
+    std::vector<Expected> expected(6);
+
+    // One reading per second for five minutes, starting mid-minute
+    for (int64_t t = 30 * SECOND_US; t < 5 * MINUTE_US + 30 * SECOND_US; t += SECOND_US) {
+        float u = rng.next();
+        Reading r = (u < 0.1f) ? Reading{UsResult::TIMEOUT, 0.0f}
+                  : (u < 0.15f) ? Reading{UsResult::WEAK_SIGNAL, 80.0f + 40.0f * rng.next()}
+                                : Reading{UsResult::OK, 80.0f + 40.0f * rng.next()};
+        rollup.on_reading({r, t, false});
+
+        auto &e = expected[t / MINUTE_US];
+        e.results[static_cast<size_t>(r.result)]++;
+        if (is_success(r.result))
+            e.cm.push_back(r.cm);
+    }
+
+    // Minutes 0-4 are finished, minute 5 is still open
+    RollupBucket out[16];
+    ASSERT_EQ(5u, rollup.finished(out, 16));
+    for (size_t m = 0; m < 5; m++) {
+        const auto &e = expected[m];
+        const RollupBucket &b = out[m];
+        EXPECT_EQ(static_cast<int64_t>(m) * MINUTE_US, b.start_us);
+        for (size_t r = 0; r < US_RESULT_COUNT; r++) {
+            EXPECT_EQ(e.results[r], b.results[r]) << "minute " << m << " result " << r;
+        }
+        ASSERT_EQ(e.cm.size(), b.valid);
+        EXPECT_EQ(*std::min_element(e.cm.begin(), e.cm.end()), b.min_cm);
+        EXPECT_EQ(*std::max_element(e.cm.begin(), e.cm.end()), b.max_cm);
+        double sum = 0;
+        for (float c : e.cm)
+            sum += c;
+        EXPECT_NEAR(sum / e.cm.size(), b.mean_cm, 1e-3);
+        EXPECT_NEAR(exact_quantile(e.cm, 0.5), b.p50_cm, 4.0f) << "minute " << m;
+    }
+
+    RollupBucket cur;
+    ASSERT_TRUE(rollup.current(cur));
+    EXPECT_EQ(5 * MINUTE_US, cur.start_us);
+    EXPECT_EQ(30u, cur.total());
+}
+
+TEST(UsRollupTest, AdvanceFinishesIdleBucket)
+{
+    UsRollup rollup(1000, 4);
+    RollupBucket out[4];
+    RollupBucket cur;
+    EXPECT_FALSE(rollup.current(cur));
+
+    rollup.add(100, {UsResult::OK, 50.0f});
+    rollup.add(200, {UsResult::HIGH_VARIANCE, 0.0f});
+    rollup.advance(999999);
+    EXPECT_EQ(0u, rollup.finished(out, 4));
+
+    rollup.advance(1000000);
+    ASSERT_EQ(1u, rollup.finished(out, 4));
+    EXPECT_EQ(2u, out[0].total());
+    EXPECT_EQ(1u, out[0].results[static_cast<size_t>(UsResult::HIGH_VARIANCE)]);
+    EXPECT_EQ(50.0f, out[0].p50_cm);
+    EXPECT_FALSE(rollup.current(cur));
+
+    // Late reading for the finished bucket
+    rollup.add(300, {UsResult::OK, 51.0f});
+    EXPECT_EQ(1u, rollup.dropped());
+    EXPECT_FALSE(rollup.current(cur));
+}
+
+TEST(UsRollupTest, BucketWithoutValidReadings)
+{
+    UsRollup rollup(1000, 4);
+    rollup.add(0, {UsResult::TIMEOUT, 0.0f});
+    rollup.add(1, {UsResult::ECHO_STUCK, 0.0f});
+    rollup.advance(int64_t{1000} * 1000);
+
+    RollupBucket out[1];
+    ASSERT_EQ(1u, rollup.finished(out, 1));
+    EXPECT_EQ(0u, out[0].valid);
+    EXPECT_EQ(2u, out[0].total());
+    EXPECT_EQ(0.0f, out[0].min_cm);
+    EXPECT_EQ(0.0f, out[0].mean_cm);
+}
+
+TEST(UsRollupTest, RingKeepsNewestBuckets)
+{
+    UsRollup rollup(1000, 3);
+
+    // Readings in buckets 0, 1, 2, 5, 6, 9 (gaps are skipped), then bucket 10 opens
+    for (int64_t b : {0, 1, 2, 5, 6, 9, 10}) {
+        rollup.add(b * 1000000 + 10, {UsResult::OK, static_cast<float>(b)});
+    }
+
+    RollupBucket out[8];
+    ASSERT_EQ(3u, rollup.finished(out, 8));
+    EXPECT_EQ(5 * SECOND_US, out[0].start_us);
+    EXPECT_EQ(6 * SECOND_US, out[1].start_us);
+    EXPECT_EQ(9 * SECOND_US, out[2].start_us);
+
+    // Only buckets starting at or after 6 s
+    ASSERT_EQ(2u, rollup.finished(out, 8, 6 * SECOND_US));
+    EXPECT_EQ(6.0f, out[0].mean_cm);
+
+    // A small output gets the newest buckets
+    ASSERT_EQ(1u, rollup.finished(out, 1));
+    EXPECT_EQ(9 * SECOND_US, out[0].start_us);
+}
+
+TEST(UsRollupTest, NegativeTimestampsAlignDownwards)
+{
+    UsRollup rollup(1000, 2);
+    rollup.add(-1, {UsResult::OK, 1.0f});
+    RollupBucket cur;
+    ASSERT_TRUE(rollup.current(cur));
+    EXPECT_EQ(-SECOND_US, cur.start_us);
+}
@@ -3,6 +3,11 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
 #include "esp_err.h"
 
 #include "i_us_driver.hpp"
@@ -10,12 +15,16 @@
 #include "mock_hal_gpio.hpp"
 #include "mock_hal_timer.hpp"
 #include "mock_hal_sys_rom.hpp"
+#include "us_driver.hpp"
 #include "us_processor.hpp"
+#include "us_seqlock.hpp"
 #include "us_sensor.hpp"
+#include "us_timing.hpp"
 #include "us_types.hpp"
 
 using namespace ultrasonic;
 using ::testing::_;
+using ::testing::NiceMock;
 using ::testing::Return;
 
 class MockUsDriver : public IUsDriver
@@ -24,6 +33,7 @@ public:
     MOCK_METHOD(esp_err_t, init, (), (override));
     MOCK_METHOD(esp_err_t, deinit, (), (override));
     MOCK_METHOD(Reading, ping_once, (const UsConfig &cfg), (override));
+    MOCK_METHOD(UsDriverStats, stats, (), (const, override));
 };
 
 class MockUsProcessor : public IUsProcessor
@@ -93,6 +103,71 @@ TEST_F(UsSensorTest, DeinitCallsDriverDeinit)
     ASSERT_EQ(sensor->deinit(), ESP_OK);
 }
 
+TEST_F(UsSensorTest, InitRejectsInconsistentConfig)
+{
+    UsConfig cfg;
+    cfg.timeout_us = 20000;
+    cfg.max_distance_cm = 400.0f; // echo takes 23324 us
+    UsSensor bad(cfg, driver, processor, freertos_hal);
+
+    EXPECT_EQ(bad.compiled_config().error, UsConfigError::TIMEOUT_TOO_SHORT);
+    EXPECT_CALL(*driver, init()).Times(0);
+    EXPECT_EQ(bad.init(), ESP_ERR_INVALID_ARG);
+}
+
+// ==================================================================
+// UsCompiledConfig
+// ==================================================================
+
+// An inconsistent configuration here would fail to compile
+static constexpr UsCompiledConfig TANK = compile_config(UsConfig{.timeout_us = 25000, .max_distance_cm = 400.0f});
+static_assert(TANK.valid());
+static_assert(TANK.range_echo_us == 23324);
+static_assert(UsCompiledConfig(UsConfig{.timeout_us = 23323, .max_distance_cm = 400.0f}).error ==
+              UsConfigError::TIMEOUT_TOO_SHORT);
+
+TEST(UsCompiledConfigTest, DerivesConstants)
+{
+    UsConfig cfg;
+    cfg.min_distance_cm = 10.0f;
+    cfg.max_distance_cm = 200.0f;
+    cfg.max_dev_cm = 10.0f;
+    UsCompiledConfig cc(cfg);
+
+    ASSERT_TRUE(cc.valid());
+    EXPECT_FLOAT_EQ(cc.cm_per_echo_us, SOUND_SPEED_CM_PER_US / 2.0f);
+    EXPECT_NEAR(cc.min_echo_us, 583.1f, 0.1f);
+    EXPECT_NEAR(cc.max_echo_us, 11661.8f, 0.1f);
+    EXPECT_EQ(cc.range_echo_us, 11662u);
+    EXPECT_FLOAT_EQ(cc.weak_dev_cm, 6.0f);
+    EXPECT_NEAR(cc.echo_to_cm(5831.0f), 100.0f, 0.01f);
+    EXPECT_TRUE(cc.echo_in_range(5831.0f));
+    EXPECT_FALSE(cc.echo_in_range(500.0f));
+    EXPECT_FALSE(cc.echo_in_range(12000.0f));
+}
+
+TEST(UsCompiledConfigTest, ReportsFirstInconsistency)
+{
+    auto error_of = [](void (*edit)(UsConfig &)) {
+        UsConfig cfg;
+        edit(cfg);
+        return UsCompiledConfig(cfg).error;
+    };
+
+    EXPECT_EQ(error_of([](UsConfig &c) { c.ping_duration_us = 0; }), UsConfigError::ZERO_TRIGGER);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.min_distance_cm = -1.0f; }), UsConfigError::BAD_RANGE);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.max_distance_cm = c.min_distance_cm; }), UsConfigError::BAD_RANGE);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.max_distance_cm = INFINITY; }), UsConfigError::BAD_RANGE);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.max_dev_cm = NAN; }), UsConfigError::BAD_DEVIATION);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.timeout_us = 1000; }), UsConfigError::TIMEOUT_TOO_SHORT);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.min_ping_interval_ms = 100; }), UsConfigError::BAD_INTERVAL);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.max_echoes = EchoCapture::MAX_ECHOES + 1; }), UsConfigError::BAD_ECHO_COUNT);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.max_echoes = 0; }), UsConfigError::BAD_ECHO_COUNT);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.max_echoes = EchoCapture::MAX_ECHOES; }), UsConfigError::NONE);
+    EXPECT_EQ(error_of([](UsConfig &c) { c.track_gate_cm = -1.0f; }), UsConfigError::BAD_GATE);
+    EXPECT_STREQ(config_error_name(UsConfigError::TIMEOUT_TOO_SHORT), "timeout_too_short");
+}
+
 // ==================================================================
 // read_distance(uint8_t ping_count)
 // ==================================================================
@@ -222,6 +297,611 @@ TEST_F(UsSensorTest, IntegrationWithRealProcessor_Timeout)
     ASSERT_EQ(result.result, UsResult::TIMEOUT);
 }
 
+// ==================================================================
+// Worst-case timing and read_distance(ping_count, deadline_us, deadline_hit)
+// ==================================================================
+
+TEST(UsTimingTest, WorstCaseBounds)
+{
+    constexpr UsConfig cfg;
+    static_assert(worst_case_ping_us(cfg) == 20 + 2 * 30000 + PING_OVERHEAD_US);
+    static_assert(worst_case_read_us(cfg, 1) == worst_case_ping_us(cfg));
+
+    EXPECT_EQ(worst_case_read_us(cfg, 3), 3 * worst_case_ping_us(cfg) + 2 * 70000ULL);
+    EXPECT_EQ(worst_case_read_us(cfg, 0), worst_case_read_us(cfg, 1));
+    EXPECT_EQ(worst_case_read_us(cfg, 200), worst_case_read_us(cfg, IUsProcessor::MAX_PINGS));
+}
+
+TEST(UsTimingTest, GateAddsAbandonedPulseWait)
+{
+    constexpr UsConfig gated{.track_gate_cm = 10.0f};
+    static_assert(worst_case_ping_us(gated) == worst_case_ping_us(UsConfig{}) + 30000 + PING_OVERHEAD_US);
+}
+
+TEST(UsTimingTest, RelaxedWaitsAddATickEach)
+{
+    constexpr UsConfig yield{.echo_wait = EchoWait::SPIN_YIELD};
+    static_assert(worst_case_ping_us(yield) == worst_case_ping_us(UsConfig{}) + 2 * RELAX_OVERRUN_US);
+
+    // Abandoned pulse, both edges and one wait per recovery attempt
+    constexpr UsConfig full{.stuck_recovery_attempts = 2, .echo_wait = EchoWait::SPIN_SLEEP, .track_gate_cm = 10.0f};
+    constexpr UsConfig full_spin{.stuck_recovery_attempts = 2, .track_gate_cm = 10.0f};
+    static_assert(worst_case_ping_us(full) == worst_case_ping_us(full_spin) + 5 * RELAX_OVERRUN_US);
+}
+
+TEST(UsTimingTest, PingBoundHoldsWhenYieldsTakeATick)
+{
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+
+    // Every yield hands a whole tick to another task. ECHO rises during the last
+    // yield of the rise wait and stays HIGH past the timeout.
+    const int64_t rise_us = 29900;
+    int64_t now = 0;
+    int64_t trigger_at = -1;
+    ON_CALL(timer, get_time_us()).WillByDefault([&]() { return ++now; });
+    ON_CALL(sys_rom, delay_us(_)).WillByDefault([&](uint32_t us) { now += us; });
+    ON_CALL(freertos, task_delay(_)).WillByDefault([&](TickType_t) { now += RELAX_OVERRUN_US; });
+    ON_CALL(gpio, set_level(GPIO_NUM_4, _)).WillByDefault([&](gpio_num_t, uint32_t level) {
+        if (level == 0)
+            trigger_at = now;
+        return ESP_OK;
+    });
+    ON_CALL(gpio, get_level(GPIO_NUM_5)).WillByDefault(
+        [&](gpio_num_t) { return (trigger_at >= 0 && now >= trigger_at + rise_us) ? 1 : 0; });
+
+    UsConfig cfg;
+    cfg.echo_wait = EchoWait::SPIN_YIELD;
+    UsDriver driver(gpio, timer, sys_rom, GPIO_NUM_4, GPIO_NUM_5, {.freertos_hal = &freertos});
+
+    // Longer than the SPIN bound allows, within the relaxed one
+    const int64_t start = now;
+    EXPECT_EQ(UsResult::TIMEOUT, driver.ping_once(cfg).result);
+    EXPECT_GT(static_cast<uint64_t>(now - start), worst_case_ping_us(UsConfig{}));
+    EXPECT_LE(static_cast<uint64_t>(now - start), worst_case_ping_us(cfg));
+}
+
+TEST(UsTimingTest, DeadlineHoldsAfterGateLoss)
+{
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+
+    // ECHO (rise delay, width) per trigger: tracked, lost at the gate while the
+    // pulse runs on, then a late and long echo right after the abandoned one.
+    const int64_t echoes[][2] = {{150, 5000}, {150, 29000}, {29000, 29000}};
+    int64_t now = 0;
+    int triggers = 0;
+    int64_t trigger_at = -1;
+    ON_CALL(timer, get_time_us()).WillByDefault([&]() { return ++now; });
+    ON_CALL(sys_rom, delay_us(_)).WillByDefault([&](uint32_t us) { now += us; });
+    ON_CALL(gpio, set_level(GPIO_NUM_4, _)).WillByDefault([&](gpio_num_t, uint32_t level) {
+        if (level == 0 && triggers < 3) {
+            trigger_at = now;
+            triggers++;
+        }
+        return ESP_OK;
+    });
+    ON_CALL(gpio, get_level(GPIO_NUM_5)).WillByDefault([&](gpio_num_t) {
+        if (trigger_at < 0)
+            return 0;
+        const int64_t rise = trigger_at + echoes[triggers - 1][0];
+        return (now >= rise && now < rise + echoes[triggers - 1][1]) ? 1 : 0;
+    });
+
+    UsConfig cfg;
+    cfg.ping_interval_ms = 0;
+    cfg.max_distance_cm = 500.0f;
+    cfg.track_gate_cm = 10.0f;
+    auto driver = std::make_shared<UsDriver>(gpio, timer, sys_rom, GPIO_NUM_4, GPIO_NUM_5);
+    UsSensor sensor(cfg, driver, std::make_shared<UsProcessor>(), freertos, timer);
+
+    // Room for the two quick pings and one worst-case ping
+    const uint64_t budget_us = 5200 + 5800 + worst_case_ping_us(cfg);
+    const int64_t start = now;
+    MeasurementInfo info = sensor.read_distance_ex(3, static_cast<uint32_t>(budget_us));
+
+    EXPECT_EQ(triggers, 3);
+    EXPECT_FALSE(info.deadline_hit);
+    EXPECT_EQ(driver->stats().gate_losses, 1u);
+    EXPECT_LE(static_cast<uint64_t>(now - start), budget_us);
+}
+
+TEST_F(UsSensorTest, DeadlineNotHitWhenBudgetSuffices)
+{
+    Reading driver_reading = {UsResult::OK, 10.0f};
+    Reading processed_reading = {UsResult::OK, 10.0f};
+
+    EXPECT_CALL(*driver, ping_once(_)).Times(3).WillRepeatedly(Return(driver_reading));
+    EXPECT_CALL(freertos_hal, task_delay(pdMS_TO_TICKS(cfg_.ping_interval_ms))).Times(2);
+    EXPECT_CALL(*processor, process(_, 3, _)).WillOnce(Return(processed_reading));
+
+    bool deadline_hit = true;
+    auto result = sensor->read_distance(3, worst_case_read_us(cfg_, 3), deadline_hit);
+    ASSERT_EQ(result, processed_reading);
+    EXPECT_FALSE(deadline_hit);
+}
+
+TEST_F(UsSensorTest, DeadlineStopsBeforeOverrunWithoutTimer)
+{
+    Reading driver_reading = {UsResult::OK, 10.0f};
+    Reading processed_reading = {UsResult::OK, 10.0f};
+
+    // Without a timer every ping is charged at its worst case: two pings fit
+    EXPECT_CALL(*driver, ping_once(_)).Times(2).WillRepeatedly(Return(driver_reading));
+    EXPECT_CALL(freertos_hal, task_delay(pdMS_TO_TICKS(cfg_.ping_interval_ms))).Times(1);
+    EXPECT_CALL(*processor, process(_, 2, _)).WillOnce(Return(processed_reading));
+
+    bool deadline_hit = false;
+    auto result = sensor->read_distance(5, worst_case_read_us(cfg_, 3) - 1, deadline_hit);
+    ASSERT_EQ(result, processed_reading);
+    EXPECT_TRUE(deadline_hit);
+}
+
+TEST_F(UsSensorTest, DeadlineUsesMeasuredTime)
+{
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    UsSensor timed_sensor(cfg_, driver, processor, freertos_hal, timer);
+
+    // Pings return after 1 ms, so a third ping fits where the worst case would not.
+    // The last call timestamps the completed burst for the cache.
+    EXPECT_CALL(timer, get_time_us())
+        .WillOnce(Return(0))
+        .WillOnce(Return(1000))
+        .WillOnce(Return(72000))
+        .WillOnce(Return(143000))
+        .WillOnce(Return(144000));
+
+    Reading driver_reading = {UsResult::OK, 10.0f};
+    Reading processed_reading = {UsResult::OK, 10.0f};
+
+    EXPECT_CALL(*driver, ping_once(_)).Times(3).WillRepeatedly(Return(driver_reading));
+    EXPECT_CALL(freertos_hal, task_delay(pdMS_TO_TICKS(cfg_.ping_interval_ms))).Times(2);
+    EXPECT_CALL(*processor, process(_, 3, _)).WillOnce(Return(processed_reading));
+
+    bool deadline_hit = false;
+    auto result = timed_sensor.read_distance(5, 250000, deadline_hit);
+    ASSERT_EQ(result, processed_reading);
+    EXPECT_TRUE(deadline_hit);
+}
+
+TEST_F(UsSensorTest, DeadlineShorterThanOnePing)
+{
+    EXPECT_CALL(*driver, ping_once(_)).Times(0);
+    EXPECT_CALL(freertos_hal, task_delay(_)).Times(0);
+    EXPECT_CALL(*processor, process(_, _, _)).Times(0);
+
+    bool deadline_hit = false;
+    auto result = sensor->read_distance(3, worst_case_ping_us(cfg_) - 1, deadline_hit);
+    EXPECT_EQ(result.result, UsResult::INSUFFICIENT_SAMPLES);
+    EXPECT_TRUE(deadline_hit);
+}
+
+/** Sensor implementation written before the deadline overload existed. */
+class PlainSensor : public IUsSensor
+{
+public:
+    esp_err_t init() override { return ESP_OK; }
+    esp_err_t deinit() override { return ESP_OK; }
+    Reading read_distance(uint8_t ping_count) override { return {UsResult::OK, static_cast<float>(ping_count)}; }
+    using IUsSensor::read_distance;
+};
+
+TEST(IUsSensorTest, DeadlineDefaultRunsPlainBurst)
+{
+    PlainSensor sensor;
+    bool deadline_hit = true;
+    Reading r = sensor.read_distance(4, 1, deadline_hit);
+    EXPECT_EQ(r.result, UsResult::OK);
+    EXPECT_FLOAT_EQ(r.cm, 4.0f);
+    EXPECT_FALSE(deadline_hit);
+}
+
+TEST_F(UsSensorTest, DriverStatsForwarded)
+{
+    UsDriverStats stats;
+    stats.stuck_events = 3;
+    stats.stuck_recoveries = 2;
+    EXPECT_CALL(*driver, stats()).WillOnce(Return(stats));
+
+    auto result = sensor->driver_stats();
+    EXPECT_EQ(result.stuck_events, 3u);
+    EXPECT_EQ(result.stuck_recoveries, 2u);
+}
+
+TEST_F(UsSensorTest, MetricsCountEveryBurst)
+{
+    EXPECT_CALL(*driver, ping_once(_))
+        .WillOnce(Return(Reading{UsResult::OK, 10.0f}))
+        .WillOnce(Return(Reading{UsResult::TIMEOUT, 0.0f}))
+        .WillOnce(Return(Reading{UsResult::OK, 10.0f}))
+        .WillOnce(Return(Reading{UsResult::HW_FAULT, 0.0f}));
+    EXPECT_CALL(freertos_hal, task_delay(_)).Times(2);
+    EXPECT_CALL(*processor, process(_, 3, _)).WillOnce(Return(Reading{UsResult::OK, 10.0f}));
+
+    sensor->read_distance(3);
+    sensor->read_distance(3); // aborted by the hardware failure
+
+    bool deadline_hit = false;
+    sensor->read_distance(3, 1, deadline_hit); // no ping fits
+
+    UsMetrics m = sensor->metrics();
+    EXPECT_EQ(m.ping_results[static_cast<size_t>(UsResult::OK)], 2u);
+    EXPECT_EQ(m.ping_results[static_cast<size_t>(UsResult::TIMEOUT)], 1u);
+    EXPECT_EQ(m.ping_results[static_cast<size_t>(UsResult::HW_FAULT)], 1u);
+    EXPECT_EQ(m.burst_results[static_cast<size_t>(UsResult::OK)], 1u);
+    EXPECT_EQ(m.burst_results[static_cast<size_t>(UsResult::HW_FAULT)], 1u);
+    EXPECT_EQ(m.burst_results[static_cast<size_t>(UsResult::INSUFFICIENT_SAMPLES)], 1u);
+    EXPECT_EQ(m.pings_per_burst[0], 1u);
+    EXPECT_EQ(m.pings_per_burst[1], 1u);
+    EXPECT_EQ(m.pings_per_burst[3], 1u);
+
+    sensor->reset_metrics();
+    EXPECT_EQ(sensor->metrics().bursts(), 0u);
+}
+
+TEST_F(UsSensorTest, LatencyRecordedPerResult)
+{
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    UsSensor timed_sensor(cfg_, driver, processor, freertos_hal, timer);
+    UsLatencyStats latency;
+    timed_sensor.set_latency_stats(&latency);
+
+    // Call start, ping 1 (2 ms), ping 2 (timeout, 30 ms), call end (100 ms), cache timestamp
+    EXPECT_CALL(timer, get_time_us())
+        .WillOnce(Return(0))
+        .WillOnce(Return(0))
+        .WillOnce(Return(2000))
+        .WillOnce(Return(70000))
+        .WillOnce(Return(100000))
+        .WillOnce(Return(100000))
+        .WillOnce(Return(100000));
+    EXPECT_CALL(*driver, ping_once(_))
+        .WillOnce(Return(Reading{UsResult::OK, 10.0f}))
+        .WillOnce(Return(Reading{UsResult::TIMEOUT, 0.0f}));
+    EXPECT_CALL(freertos_hal, task_delay(_)).Times(1);
+    EXPECT_CALL(*processor, process(_, 2, _)).WillOnce(Return(Reading{UsResult::WEAK_SIGNAL, 10.0f}));
+
+    timed_sensor.read_distance(2);
+
+    UsLatencyHistogram h;
+    latency.ping(UsResult::OK, h);
+    EXPECT_EQ(h.count(), 1u);
+    EXPECT_EQ(h.max(), 2000u);
+    latency.ping(UsResult::TIMEOUT, h);
+    EXPECT_EQ(h.max(), 30000u);
+    latency.read(UsResult::WEAK_SIGNAL, h);
+    EXPECT_EQ(h.count(), 1u);
+    EXPECT_EQ(h.max(), 100000u);
+
+    // Detached: no timer reads for latency
+    timed_sensor.set_latency_stats(nullptr);
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(200000));
+    EXPECT_CALL(*driver, ping_once(_)).WillOnce(Return(Reading{UsResult::OK, 10.0f}));
+    EXPECT_CALL(*processor, process(_, 1, _)).WillOnce(Return(Reading{UsResult::OK, 10.0f}));
+    timed_sensor.read_distance(1);
+    latency.reads(h);
+    EXPECT_EQ(h.count(), 1u);
+}
+
+TEST_F(UsSensorTest, ReadDistanceExReportsDiagnostics)
+{
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    UsSensor timed_sensor(cfg_, driver, std::make_shared<UsProcessor>(), freertos_hal, timer);
+
+    // Burst start, burst end, published timestamp
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(1000)).WillRepeatedly(Return(61000));
+    EXPECT_CALL(*driver, ping_once(_))
+        .WillOnce(Return(Reading{UsResult::OK, 100.0f}))
+        .WillOnce(Return(Reading{UsResult::OK, 102.0f}))
+        .WillOnce(Return(Reading{UsResult::TIMEOUT, 0.0f}))
+        .WillOnce(Return(Reading{UsResult::OK, 101.0f}))
+        .WillOnce(Return(Reading{UsResult::OUT_OF_RANGE, 0.0f}));
+    EXPECT_CALL(freertos_hal, task_delay(_)).Times(4);
+
+    MeasurementInfo info = timed_sensor.read_distance_ex(5);
+
+    EXPECT_EQ(info.reading.result, UsResult::WEAK_SIGNAL); // 3 of 5 valid
+    EXPECT_FLOAT_EQ(info.reading.cm, 101.0f);
+    EXPECT_EQ(info.total_pings, 5);
+    EXPECT_EQ(info.valid_pings, 3);
+    EXPECT_EQ(info.pings_with(UsResult::TIMEOUT), 1);
+    EXPECT_EQ(info.pings_with(UsResult::OUT_OF_RANGE), 1);
+    EXPECT_EQ(info.filter_samples, 3);
+    EXPECT_NEAR(info.std_dev_cm, 1.0f, 0.2f);
+    EXPECT_EQ(info.duration_us, 60000u);
+    EXPECT_EQ(info.timestamp_us, 61000);
+    EXPECT_FALSE(info.deadline_hit);
+    EXPECT_EQ(timed_sensor.get_latest(1000).reading, info.reading);
+}
+
+TEST_F(UsSensorTest, ReadDistanceExCountsAbortedBurst)
+{
+    EXPECT_CALL(*driver, ping_once(_))
+        .WillOnce(Return(Reading{UsResult::OK, 50.0f}))
+        .WillOnce(Return(Reading{UsResult::ECHO_STUCK, 0.0f}));
+    EXPECT_CALL(freertos_hal, task_delay(_)).Times(1);
+    EXPECT_CALL(*processor, process(_, _, _)).Times(0);
+
+    MeasurementInfo info = sensor->read_distance_ex(5);
+
+    EXPECT_EQ(info.reading.result, UsResult::ECHO_STUCK);
+    EXPECT_EQ(info.total_pings, 2);
+    EXPECT_EQ(info.valid_pings, 1);
+    EXPECT_EQ(info.pings_with(UsResult::ECHO_STUCK), 1);
+    EXPECT_TRUE(std::isnan(info.std_dev_cm));
+    EXPECT_EQ(info.filter_samples, 0);
+}
+
+TEST_F(UsSensorTest, CaptureEchoesFallsBackToPingOnce)
+{
+    // Drivers without multi-echo support report the single ping as one pulse
+    EXPECT_CALL(*driver, ping_once(_)).WillOnce(Return(Reading{UsResult::OK, 42.0f}));
+
+    EchoCapture capture;
+    EXPECT_EQ(sensor->capture_echoes(capture), UsResult::OK);
+    ASSERT_EQ(capture.count, 1);
+    EXPECT_FLOAT_EQ(capture.pulses[0].cm, 42.0f);
+
+    EXPECT_CALL(*driver, ping_once(_)).WillOnce(Return(Reading{UsResult::TIMEOUT, 0.0f}));
+    EXPECT_EQ(sensor->capture_echoes(capture), UsResult::TIMEOUT);
+    EXPECT_EQ(capture.count, 0);
+}
+
+// ==================================================================
+// Latest-reading cache
+// ==================================================================
+
+TEST_F(UsSensorTest, GetLatestBeforeFirstBurstIsStale)
+{
+    EXPECT_CALL(*driver, ping_once(_)).Times(0);
+
+    EXPECT_FALSE(sensor->refresh_requested());
+    TimedReading latest = sensor->get_latest(1000);
+    EXPECT_TRUE(latest.stale);
+    EXPECT_EQ(latest.timestamp_us, -1);
+    EXPECT_TRUE(sensor->refresh_requested());
+}
+
+TEST_F(UsSensorTest, GetLatestRefreshesOnlyWhenStale)
+{
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    UsSensor timed_sensor(cfg_, driver, processor, freertos_hal, timer);
+
+    Reading processed_reading = {UsResult::OK, 42.0f};
+    EXPECT_CALL(*driver, ping_once(_)).WillRepeatedly(Return(Reading{UsResult::OK, 42.0f}));
+    EXPECT_CALL(*processor, process(_, 1, _)).WillRepeatedly(Return(processed_reading));
+
+    // Burst completes at t = 1 s
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(1000000));
+    timed_sensor.read_distance(1);
+
+    // 200 ms later: fresh for a 500 ms budget, no refresh requested
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(1200000));
+    TimedReading latest = timed_sensor.get_latest(500);
+    EXPECT_FALSE(latest.stale);
+    EXPECT_EQ(latest.reading, processed_reading);
+    EXPECT_EQ(latest.timestamp_us, 1000000);
+    EXPECT_FALSE(timed_sensor.refresh_if_requested(1));
+
+    // 600 ms later: stale, cached value still returned and a refresh requested
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(1600000));
+    latest = timed_sensor.get_latest(500);
+    EXPECT_TRUE(latest.stale);
+    EXPECT_EQ(latest.reading, processed_reading);
+    EXPECT_TRUE(timed_sensor.refresh_requested());
+
+    // The owner task runs the burst, which clears the request
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(1650000));
+    EXPECT_TRUE(timed_sensor.refresh_if_requested(1));
+    EXPECT_FALSE(timed_sensor.refresh_requested());
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(1700000));
+    EXPECT_FALSE(timed_sensor.get_latest(500).stale);
+}
+
+class CollectingSink : public IUsReadingSink
+{
+public:
+    void on_reading(const TimedReading &reading) override { received.push_back(reading); }
+    std::vector<TimedReading> received;
+};
+
+TEST_F(UsSensorTest, ReadingSinksReceiveEveryBurst)
+{
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    UsSensor timed_sensor(cfg_, driver, processor, freertos_hal, timer);
+
+    Reading processed_reading = {UsResult::OK, 42.0f};
+    EXPECT_CALL(*driver, ping_once(_)).WillRepeatedly(Return(Reading{UsResult::OK, 42.0f}));
+    EXPECT_CALL(*processor, process(_, 1, _)).WillRepeatedly(Return(processed_reading));
+    ON_CALL(timer, get_time_us()).WillByDefault(Return(5000));
+
+    CollectingSink a;
+    CollectingSink b;
+    EXPECT_EQ(timed_sensor.add_reading_sink(nullptr), ESP_ERR_INVALID_ARG);
+    EXPECT_EQ(timed_sensor.add_reading_sink(&a), ESP_OK);
+    EXPECT_EQ(timed_sensor.add_reading_sink(&a), ESP_OK); // already attached, not added twice
+    EXPECT_EQ(timed_sensor.add_reading_sink(&b), ESP_OK);
+
+    timed_sensor.read_distance(1);
+    ASSERT_EQ(a.received.size(), 1u);
+    ASSERT_EQ(b.received.size(), 1u);
+    EXPECT_EQ(a.received[0].reading, processed_reading);
+    EXPECT_EQ(a.received[0].timestamp_us, 5000);
+    EXPECT_FALSE(a.received[0].stale);
+
+    EXPECT_EQ(timed_sensor.remove_reading_sink(&a), ESP_OK);
+    EXPECT_EQ(timed_sensor.remove_reading_sink(&a), ESP_ERR_NOT_FOUND);
+    timed_sensor.read_distance(1);
+    EXPECT_EQ(a.received.size(), 1u);
+    EXPECT_EQ(b.received.size(), 2u);
+
+    // Fixed capacity
+    CollectingSink extra[UsSensor::MAX_READING_SINKS];
+    for (size_t i = 0; i < UsSensor::MAX_READING_SINKS - 1; i++) {
+        EXPECT_EQ(timed_sensor.add_reading_sink(&extra[i]), ESP_OK);
+    }
+    EXPECT_EQ(timed_sensor.add_reading_sink(&extra[UsSensor::MAX_READING_SINKS - 1]), ESP_ERR_NO_MEM);
+}
+
+TEST_F(UsSensorTest, AdaptiveIntervalShrinksAndBacksOff)
+{
+    cfg_.ping_interval_ms = 80;
+    cfg_.min_ping_interval_ms = 20;
+    cfg_.interval_step_ms = 20;
+    UsSensor adaptive(cfg_, driver, processor, freertos_hal);
+    EXPECT_EQ(adaptive.ping_interval_ms(), 80);
+
+    Reading target = {UsResult::OK, 100.0f};
+    Reading early = {UsResult::OK, 30.0f};
+    EXPECT_CALL(*processor, process(_, 3, _)).WillRepeatedly(Return(target));
+
+    // Clean bursts: 80 -> 60 -> 40
+    EXPECT_CALL(*driver, ping_once(_)).WillRepeatedly(Return(target));
+    EXPECT_CALL(freertos_hal, task_delay(pdMS_TO_TICKS(80))).Times(2);
+    adaptive.read_distance(3);
+    EXPECT_CALL(freertos_hal, task_delay(pdMS_TO_TICKS(60))).Times(2);
+    adaptive.read_distance(3);
+    EXPECT_EQ(adaptive.ping_interval_ms(), 40);
+
+    // An early echo on the second ping: 40 -> 60
+    EXPECT_CALL(*driver, ping_once(_)).WillOnce(Return(target)).WillOnce(Return(early)).WillOnce(Return(target));
+    EXPECT_CALL(freertos_hal, task_delay(pdMS_TO_TICKS(40))).Times(2);
+    adaptive.read_distance(3);
+    EXPECT_EQ(adaptive.ping_interval_ms(), 60);
+    EXPECT_EQ(adaptive.early_echoes(), 1u);
+
+    // Single-ping bursts carry no information
+    EXPECT_CALL(*driver, ping_once(_)).WillRepeatedly(Return(target));
+    EXPECT_CALL(*processor, process(_, 1, _)).WillRepeatedly(Return(target));
+    adaptive.read_distance(1);
+    EXPECT_EQ(adaptive.ping_interval_ms(), 60);
+}
+
+TEST_F(UsSensorTest, AdaptiveIntervalDisabledByDefault)
+{
+    Reading target = {UsResult::OK, 100.0f};
+    EXPECT_CALL(*driver, ping_once(_)).WillRepeatedly(Return(target));
+    EXPECT_CALL(*processor, process(_, 3, _)).WillRepeatedly(Return(target));
+    EXPECT_CALL(freertos_hal, task_delay(pdMS_TO_TICKS(cfg_.ping_interval_ms))).Times(4);
+
+    sensor->read_distance(3);
+    sensor->read_distance(3);
+    EXPECT_EQ(sensor->ping_interval_ms(), cfg_.ping_interval_ms);
+}
+
+TEST_F(UsSensorTest, AdaptiveIntervalConvergesOnReverberationTime)
+{
+    // Reverberation of a ping lasts 35 ms; a ping sent earlier hears it as a close target
+    constexpr uint32_t DECAY_MS = 35;
+    cfg_.ping_interval_ms = 70;
+    cfg_.min_ping_interval_ms = 10;
+    cfg_.interval_step_ms = 5;
+    UsSensor adaptive(cfg_, driver, std::make_shared<UsProcessor>(), freertos_hal);
+
+    uint32_t last_delay_ms = UINT32_MAX; // the first ping of a burst follows the long idle gap
+    ON_CALL(freertos_hal, task_delay(_)).WillByDefault([&last_delay_ms](TickType_t ticks) {
+        last_delay_ms = static_cast<uint32_t>(ticks) * 1000 / configTICK_RATE_HZ;
+    });
+    EXPECT_CALL(freertos_hal, task_delay(_)).Times(::testing::AnyNumber());
+    EXPECT_CALL(*driver, ping_once(_)).WillRepeatedly([&last_delay_ms](const UsConfig &) {
+        return (last_delay_ms < DECAY_MS) ? Reading{UsResult::OK, 25.0f} : Reading{UsResult::OK, 150.0f};
+    });
+
+    uint32_t sum_ms = 0;
+    int correct = 0;
+    for (int burst = 0; burst < 200; burst++) {
+        last_delay_ms = UINT32_MAX;
+        Reading r = adaptive.read_distance(5);
+        if (burst >= 100) {
+            sum_ms += adaptive.ping_interval_ms();
+            EXPECT_GE(adaptive.ping_interval_ms(), 25);
+            EXPECT_LE(adaptive.ping_interval_ms(), 55);
+            correct += (is_success(r.result) && r.cm == 150.0f) ? 1 : 0;
+        }
+    }
+
+    // Settles just above the reverberation time: close to twice the fixed ping rate
+    EXPECT_LT(sum_ms / 100, 45u);
+    EXPECT_GT(adaptive.early_echoes(), 0u);
+    EXPECT_GE(correct, 50);
+}
+
+TEST(SeqLockTest, ReadersNeverSeeTornValues)
+{
+    struct Wide
+    {
+        uint32_t a, b, c, d, e;
+    };
+
+    SeqLock<Wide> cell(Wide{0, 0, 0, 0, 0});
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; r++) {
+        readers.emplace_back([&]() {
+            uint32_t last = 0;
+            while (!done.load()) {
+                Wide w = cell.read();
+                if (w.a != w.b || w.b != w.c || w.c != w.d || w.d != w.e || w.a < last)
+                    torn++;
+                last = w.a;
+            }
+        });
+    }
+
+    for (uint32_t i = 1; i <= 200000; i++) {
+        cell.write(Wide{i, i, i, i, i});
+    }
+    done = true;
+    for (auto &t : readers) t.join();
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(cell.read().a, 200000u);
+}
+
+TEST(SeqLockTest, ReadsReturnWrittenValuesNoOlderThanPublished)
+{
+    // Every word is derived from the write index, so a mix of two writes is detected
+    struct Value
+    {
+        uint32_t index, square, inverse, mixed;
+    };
+    auto make = [](uint32_t i) { return Value{i, i * i, ~i, i * 2654435761u}; };
+
+    SeqLock<Value> cell(make(0));
+    std::atomic<uint32_t> published{0};
+    std::atomic<bool> done{false};
+    int bad = 0;
+    int stale = 0;
+
+    std::thread reader([&]() {
+        while (!done.load(std::memory_order_acquire)) {
+            const uint32_t floor = published.load(std::memory_order_acquire);
+            const Value v = cell.read();
+            const Value expected = make(v.index);
+            if (v.square != expected.square || v.inverse != expected.inverse || v.mixed != expected.mixed)
+                bad++;
+            if (v.index < floor)
+                stale++;
+        }
+    });
+
+    for (uint32_t i = 1; i <= 300000; i++) {
+        cell.write(make(i));
+        published.store(i, std::memory_order_release);
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    EXPECT_EQ(bad, 0);
+    EXPECT_EQ(stale, 0);
+}
+
 TEST(UsSensorIntegrationTest, FactoryConstructorCreatesRealObjects)
 {
     UsConfig cfg;
@@ -232,3 +912,31 @@ TEST(UsSensorIntegrationTest, FactoryConstructorCreatesRealObjects)
     UsSensor sensor(gpio, timer, sys_rom, freertos, GPIO_NUM_4, GPIO_NUM_5, cfg);
     EXPECT_TRUE(true);
 }
+
+/** Counter advancing 100 counts per read. */
+class StepCounter : public IUsCycleCounter
+{
+public:
+    uint32_t cycles() override { return count += 100; }
+    uint32_t count = 0;
+};
+
+TEST(UsSensorIntegrationTest, FactoryConstructorCombinesDriverOptions)
+{
+    UsConfig cfg;
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+    StepCounter counter;
+    int64_t now = 0;
+    ON_CALL(timer, get_time_us()).WillByDefault([&now]() { return now += 10; });
+
+    // Power pin and cycle counter together on the production constructor
+    UsSensor sensor(gpio, timer, sys_rom, freertos, GPIO_NUM_4, GPIO_NUM_5, cfg,
+                    {.power_pin = GPIO_NUM_18, .power_on_level = 0, .cycle_counter = &counter});
+    EXPECT_CALL(gpio, set_level(_, _)).Times(::testing::AnyNumber());
+    EXPECT_CALL(gpio, set_level(GPIO_NUM_18, 0)).Times(1);
+    ASSERT_EQ(ESP_OK, sensor.init());
+    EXPECT_EQ(counter.count, 200u); // calibrated in init()
+}
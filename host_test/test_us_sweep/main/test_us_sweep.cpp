@@ -0,0 +1,219 @@
+// components/ultrasonic_sensor/host_test/test_us_sweep/main/test_us_sweep.cpp
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "sweep.hpp"
+#include "us_trace.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using namespace us_sweep;
+
+// =================================================================
+// Trace files
+// =================================================================
+
+/** Echo width of a target at @p cm. */
+static uint32_t echo_of(float cm)
+{
+    return static_cast<uint32_t>(std::lround(cm / (SOUND_SPEED_CM_PER_US / 2.0f)));
+}
+
+/** Append one burst echoing the given distances; 0 cm is a timeout. */
+static void add_burst(std::vector<TraceRecord> &records, std::initializer_list<float> cms)
+{
+    uint8_t i = 0;
+    for (float cm : cms) {
+        TraceRecord rec{};
+        rec.timestamp_us = static_cast<int64_t>(records.size()) * 70000;
+        rec.echo_us = (cm > 0.0f) ? echo_of(cm) : 0;
+        rec.result = static_cast<uint8_t>((cm > 0.0f) ? UsResult::OK : UsResult::TIMEOUT);
+        rec.ping_index = i++;
+        rec.ping_count = static_cast<uint8_t>(cms.size());
+        records.push_back(rec);
+    }
+}
+
+/** Write a trace file recorded with @p cfg. */
+static std::string write_trace(const char *name, const UsConfig &cfg, const std::vector<TraceRecord> &records)
+{
+    const std::string path = ::testing::TempDir() + name;
+    FILE *f = fopen(path.c_str(), "wb");
+    EXPECT_NE(f, nullptr);
+    const TraceHeader header = make_trace_header(cfg, 1);
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(records.data(), sizeof(TraceRecord), records.size(), f);
+    fclose(f);
+    return path;
+}
+
+/**
+ * Eight tight bursts at 100 cm and two split between 100 and 130 cm, whose
+ * median lands on 130 cm. A max_dev_cm between the two spreads keeps the
+ * first and rejects the second.
+ */
+class UsSweepTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        std::vector<TraceRecord> records;
+        for (int b = 0; b < 10; b++) {
+            if (b == 3 || b == 7)
+                add_burst(records, {100.0f, 100.0f, 130.0f, 130.0f, 130.0f});
+            else
+                add_burst(records, {99.5f, 100.0f, 100.5f, 100.0f, 100.0f});
+        }
+        ASSERT_EQ(10, load_trace(write_trace("us_sweep_a.trace", UsConfig{}, records).c_str(), datasets_));
+        ASSERT_EQ(datasets_.size(), 1u);
+        compute_references(datasets_[0], 100.0f);
+    }
+
+    static Candidate candidate(float max_dev_cm, uint8_t ping_count = 5)
+    {
+        Candidate c{UsConfig{}, ping_count};
+        c.cfg.max_dev_cm = max_dev_cm;
+        return c;
+    }
+
+    std::vector<Dataset> datasets_;
+};
+
+// =================================================================
+// Datasets
+// =================================================================
+
+TEST_F(UsSweepTest, LoadGroupsBurstsByPingInterval)
+{
+    // Same interval: appended to the first dataset
+    std::vector<TraceRecord> more;
+    add_burst(more, {50.0f, 0.0f});
+    ASSERT_EQ(1, load_trace(write_trace("us_sweep_b.trace", UsConfig{}, more).c_str(), datasets_));
+
+    // Another interval: a dataset of its own
+    UsConfig fast;
+    fast.ping_interval_ms = 30;
+    std::vector<TraceRecord> other;
+    add_burst(other, {60.0f});
+    add_burst(other, {61.0f, 62.0f, 0.0f});
+    ASSERT_EQ(2, load_trace(write_trace("us_sweep_c.trace", fast, other).c_str(), datasets_));
+
+    ASSERT_EQ(datasets_.size(), 2u);
+    const Dataset &a = datasets_[0];
+    EXPECT_EQ(a.bursts(), 11u);
+    EXPECT_EQ(a.pings.size(), 52u);
+    EXPECT_EQ(a.burst_start[10], 50u);
+    EXPECT_EQ(a.burst_start.back(), 52u);
+
+    const Dataset &b = datasets_[1];
+    EXPECT_EQ(b.recorded_cfg.ping_interval_ms, 30);
+    EXPECT_EQ(b.bursts(), 2u);
+    EXPECT_EQ(b.burst_start, (std::vector<uint32_t>{0, 1, 4}));
+
+    EXPECT_EQ(-1, load_trace((::testing::TempDir() + "us_sweep_missing.trace").c_str(), datasets_));
+    EXPECT_EQ(datasets_.size(), 2u);
+}
+
+TEST_F(UsSweepTest, ReferencesFromTruthOrBurstMedian)
+{
+    Dataset &ds = datasets_[0];
+    ASSERT_EQ(ds.reference_cm.size(), 10u);
+    for (float ref : ds.reference_cm) EXPECT_FLOAT_EQ(ref, 100.0f);
+
+    // Median of the valid pings under the recorded range limits
+    compute_references(ds, NAN);
+    EXPECT_NEAR(ds.reference_cm[0], 100.0f, 0.05f);
+    EXPECT_NEAR(ds.reference_cm[3], 130.0f, 0.05f);
+
+    // A burst without a valid ping has no reference
+    std::vector<TraceRecord> silent;
+    add_burst(silent, {0.0f, 0.0f});
+    add_burst(silent, {250.0f}); // beyond the recorded max_distance_cm
+    std::vector<Dataset> other;
+    UsConfig cfg;
+    cfg.ping_interval_ms = 40;
+    ASSERT_EQ(2, load_trace(write_trace("us_sweep_d.trace", cfg, silent).c_str(), other));
+    compute_references(other[0], NAN);
+    EXPECT_TRUE(std::isnan(other[0].reference_cm[0]));
+    EXPECT_TRUE(std::isnan(other[0].reference_cm[1]));
+}
+
+// =================================================================
+// Scoring
+// =================================================================
+
+TEST_F(UsSweepTest, ScoreFindsBestMaxDev)
+{
+    const Dataset &ds = datasets_[0];
+    const double penalty_cm = 10.0;
+
+    // Too tight: every burst fails
+    const Score tight = score_range(ds, candidate(0.1f), 0, ds.bursts());
+    EXPECT_EQ(tight.bursts, 10u);
+    EXPECT_EQ(tight.successes, 0u);
+
+    // Between the spreads: the split bursts fail, the others are exact
+    const Score best = score_range(ds, candidate(5.0f), 0, ds.bursts());
+    EXPECT_EQ(best.successes, 8u);
+    EXPECT_EQ(best.compared, 8u);
+    EXPECT_NEAR(best.mae_cm(), 0.0, 0.05);
+
+    // Too loose: the split bursts pass 30 cm off
+    const Score loose = score_range(ds, candidate(100.0f), 0, ds.bursts());
+    EXPECT_EQ(loose.successes, 10u);
+    EXPECT_NEAR(loose.mae_cm(), 6.0, 0.05);
+
+    EXPECT_LT(best.rank_value(penalty_cm), loose.rank_value(penalty_cm));
+    EXPECT_LT(best.rank_value(penalty_cm), tight.rank_value(penalty_cm));
+
+    // Fewer pings: shorter bursts, scored on their first pings only
+    const Score three = score_range(ds, candidate(5.0f, 3), 0, ds.bursts());
+    EXPECT_EQ(three.bursts, 10u);
+    EXPECT_EQ(three.successes, 8u);
+    EXPECT_LT(three.mean_latency_ms(), best.mean_latency_ms());
+}
+
+TEST_F(UsSweepTest, ChunkedSweepMatchesSingleThreaded)
+{
+    std::vector<Candidate> candidates;
+    for (float dev : {0.1f, 5.0f, 100.0f}) {
+        for (uint8_t pings : {3, 5}) candidates.push_back(candidate(dev, pings));
+    }
+    Candidate unmatched = candidate(5.0f);
+    unmatched.cfg.ping_interval_ms = 33;
+    candidates.push_back(unmatched);
+
+    std::vector<Score> serial;
+    for (const Candidate &c : candidates) {
+        Score s;
+        if (c.cfg.ping_interval_ms == datasets_[0].recorded_cfg.ping_interval_ms)
+            s = score_range(datasets_[0], c, 0, datasets_[0].bursts());
+        serial.push_back(s);
+    }
+
+    for (unsigned threads : {1u, 4u}) {
+        ThreadPool pool(threads);
+        for (size_t chunk : {0, 1, 3, 1000}) {
+            const std::vector<Score> scores = run_sweep(datasets_, candidates, pool, chunk);
+            ASSERT_EQ(scores.size(), candidates.size());
+            for (size_t c = 0; c < candidates.size(); c++) {
+                SCOPED_TRACE(::testing::Message()
+                             << "threads " << threads << ", chunk " << chunk << ", candidate " << c);
+                EXPECT_EQ(scores[c].bursts, serial[c].bursts);
+                EXPECT_EQ(scores[c].successes, serial[c].successes);
+                EXPECT_EQ(scores[c].ok, serial[c].ok);
+                EXPECT_EQ(scores[c].compared, serial[c].compared);
+                EXPECT_NEAR(scores[c].abs_err_cm, serial[c].abs_err_cm, 1e-9);
+                EXPECT_NEAR(scores[c].latency_us, serial[c].latency_us, 1e-6);
+            }
+        }
+    }
+    EXPECT_EQ(serial.back().bursts, 0u);
+}
@@ -0,0 +1,8 @@
+#include "gtest/gtest.h"
+
+extern "C" void app_main(void)
+{
+    testing::InitGoogleTest();
+    int result = RUN_ALL_TESTS();
+    exit(result);
+}
\ No newline at end of file
@@ -0,0 +1,477 @@
+// components/ultrasonic_sensor/host_test/test_us_trace/main/test_us_trace.cpp
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp_err.h"
+
+#include "i_us_driver.hpp"
+#include "i_us_recorder.hpp"
+#include "mock_hal_freertos.hpp"
+#include "mock_hal_gpio.hpp"
+#include "mock_hal_sys_rom.hpp"
+#include "mock_hal_timer.hpp"
+#include "us_driver.hpp"
+#include "us_processor.hpp"
+#include "us_replay_driver.hpp"
+#include "us_sensor.hpp"
+#include "us_trace.hpp"
+#include "us_trace_file.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+class MockUsDriver : public IUsDriver
+{
+public:
+    MOCK_METHOD(esp_err_t, init, (), (override));
+    MOCK_METHOD(esp_err_t, deinit, (), (override));
+    MOCK_METHOD(Reading, ping_once, (const UsConfig &cfg), (override));
+    MOCK_METHOD(uint32_t, last_echo_us, (), (const, override));
+};
+
+class VectorRecorder : public IUsRecorder
+{
+public:
+    void record(const TraceRecord &rec) override { records.push_back(rec); }
+
+    std::vector<TraceRecord> records;
+};
+
+static uint32_t cmToEcho(float cm)
+{
+    return static_cast<uint32_t>((cm * 2.0f) / UsDriver::SOUND_SPEED_CM_PER_US);
+}
+
+static TraceRecord makeRecord(UsResult result, uint32_t echo_us, uint8_t index, uint8_t count, int64_t ts = 0)
+{
+    TraceRecord rec = {};
+    rec.timestamp_us = ts;
+    rec.echo_us = echo_us;
+    rec.result = static_cast<uint8_t>(result);
+    rec.ping_index = index;
+    rec.ping_count = count;
+    return rec;
+}
+
+class UsTraceFileTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        path_ = ::testing::TempDir() + "us_trace_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".bin";
+    }
+
+    void TearDown() override { std::remove(path_.c_str()); }
+
+    std::string path_;
+};
+
+// =================================================================
+// Format
+// =================================================================
+
+TEST(UsTraceFormatTest, HeaderRoundTrip)
+{
+    UsConfig cfg;
+    cfg.ping_interval_ms = 55;
+    cfg.ping_duration_us = 12;
+    cfg.timeout_us = 25000;
+    cfg.filter = Filter::DOMINANT_CLUSTER;
+    cfg.min_distance_cm = 25.0f;
+    cfg.max_distance_cm = 300.0f;
+    cfg.max_dev_cm = 7.5f;
+    cfg.warmup_time_ms = 0;
+    cfg.track_gate_cm = 8.5f;
+    cfg.trigger_jitter_us = 1000;
+
+    TraceHeader header = make_trace_header(cfg, 42);
+    EXPECT_EQ(TRACE_MAGIC, header.magic);
+    EXPECT_EQ(42u, header.sensor_id);
+
+    UsConfig out;
+    ASSERT_EQ(ESP_OK, trace_header_to_config(header, out));
+    EXPECT_EQ(cfg.ping_interval_ms, out.ping_interval_ms);
+    EXPECT_EQ(cfg.ping_duration_us, out.ping_duration_us);
+    EXPECT_EQ(cfg.timeout_us, out.timeout_us);
+    EXPECT_EQ(cfg.filter, out.filter);
+    EXPECT_FLOAT_EQ(cfg.min_distance_cm, out.min_distance_cm);
+    EXPECT_FLOAT_EQ(cfg.max_distance_cm, out.max_distance_cm);
+    EXPECT_FLOAT_EQ(cfg.max_dev_cm, out.max_dev_cm);
+    EXPECT_EQ(cfg.warmup_time_ms, out.warmup_time_ms);
+    EXPECT_FLOAT_EQ(cfg.track_gate_cm, out.track_gate_cm);
+    EXPECT_EQ(cfg.trigger_jitter_us, out.trigger_jitter_us);
+}
+
+TEST(UsTraceFormatTest, VersionOneHeaderStillRead)
+{
+    // Version 1 wrote zeros where version 2 keeps the gate and jitter
+    UsConfig cfg;
+    cfg.timeout_us = 25000;
+    TraceHeader header = make_trace_header(cfg, 3);
+    header.version = 1;
+    header.track_gate_cm = 0.0f;
+    header.trigger_jitter_us = 0;
+
+    UsConfig out;
+    out.trigger_jitter_us = 500;
+    ASSERT_EQ(ESP_OK, trace_header_to_config(header, out));
+    EXPECT_EQ(25000u, out.timeout_us);
+    EXPECT_EQ(0u, out.trigger_jitter_us);
+    EXPECT_FLOAT_EQ(0.0f, out.track_gate_cm);
+
+    header.version = 0;
+    EXPECT_EQ(ESP_ERR_INVALID_VERSION, trace_header_to_config(header, out));
+}
+
+TEST(UsTraceFormatTest, RecordedJitterKeepsCrosstalkRejection)
+{
+    // Jitter turns on the processor's dominant-cluster rejection; a replay
+    // configured from the header must filter the same way
+    UsConfig cfg;
+    cfg.trigger_jitter_us = 1000;
+    UsConfig replayed;
+    ASSERT_EQ(ESP_OK, trace_header_to_config(make_trace_header(cfg, 1), replayed));
+
+    const Reading pings[] = {{UsResult::OK, 50.0f}, {UsResult::OK, 50.2f}, {UsResult::OK, 49.9f},
+                             {UsResult::OK, 90.0f}, {UsResult::OK, 50.1f}};
+    UsProcessor processor;
+    const Reading recorded = processor.process(pings, 5, cfg);
+    EXPECT_EQ(UsResult::OK, recorded.result);
+    EXPECT_EQ(recorded, processor.process(pings, 5, replayed));
+
+    // Without it, the ghost at 90 cm fails the burst
+    UsConfig unjittered = replayed;
+    unjittered.trigger_jitter_us = 0;
+    EXPECT_EQ(UsResult::HIGH_VARIANCE, processor.process(pings, 5, unjittered).result);
+}
+
+TEST(UsTraceFormatTest, HeaderRejectsForeignData)
+{
+    UsConfig cfg;
+    TraceHeader header = make_trace_header(cfg, 0);
+
+    header.magic = 0;
+    EXPECT_EQ(ESP_ERR_INVALID_ARG, trace_header_to_config(header, cfg));
+
+    header = make_trace_header(cfg, 0);
+    header.version = TRACE_VERSION + 1;
+    EXPECT_EQ(ESP_ERR_INVALID_VERSION, trace_header_to_config(header, cfg));
+
+    header = make_trace_header(cfg, 0);
+    header.record_size = 8;
+    EXPECT_EQ(ESP_ERR_INVALID_VERSION, trace_header_to_config(header, cfg));
+}
+
+// =================================================================
+// File writer / reader
+// =================================================================
+
+TEST_F(UsTraceFileTest, WriteThenRead)
+{
+    UsConfig cfg;
+    cfg.max_distance_cm = 350.0f;
+
+    UsTraceWriter writer;
+    ASSERT_EQ(ESP_OK, writer.open(path_.c_str(), cfg, 7));
+    EXPECT_EQ(ESP_ERR_INVALID_STATE, writer.open(path_.c_str(), cfg, 7));
+
+    writer.record(makeRecord(UsResult::OK, 1000, 0, 2, 100));
+    writer.record(makeRecord(UsResult::TIMEOUT, 0, 1, 2, 70100));
+    EXPECT_EQ(2u, writer.written());
+    ASSERT_EQ(ESP_OK, writer.close());
+
+    UsTraceReader reader;
+    ASSERT_EQ(ESP_OK, reader.open(path_.c_str()));
+    EXPECT_EQ(7u, reader.sensor_id());
+    EXPECT_FLOAT_EQ(350.0f, reader.config().max_distance_cm);
+
+    TraceRecord rec;
+    ASSERT_TRUE(reader.next(rec));
+    EXPECT_EQ(100, rec.timestamp_us);
+    EXPECT_EQ(1000u, rec.echo_us);
+    EXPECT_EQ(static_cast<uint8_t>(UsResult::OK), rec.result);
+    ASSERT_TRUE(reader.next(rec));
+    EXPECT_EQ(70100, rec.timestamp_us);
+    EXPECT_EQ(static_cast<uint8_t>(UsResult::TIMEOUT), rec.result);
+    EXPECT_EQ(1, rec.ping_index);
+    EXPECT_FALSE(reader.next(rec));
+}
+
+TEST_F(UsTraceFileTest, RecordWithoutFileIsDropped)
+{
+    UsTraceWriter writer;
+    writer.record(makeRecord(UsResult::OK, 1000, 0, 1));
+    EXPECT_EQ(0u, writer.written());
+    EXPECT_EQ(1u, writer.dropped());
+}
+
+TEST_F(UsTraceFileTest, ReaderRejectsMissingOrShortFile)
+{
+    UsTraceReader reader;
+    EXPECT_EQ(ESP_ERR_NOT_FOUND, reader.open(path_.c_str()));
+
+    FILE *f = fopen(path_.c_str(), "wb");
+    ASSERT_NE(nullptr, f);
+    fputs("USTR", f);
+    fclose(f);
+
+    EXPECT_EQ(ESP_ERR_INVALID_SIZE, reader.open(path_.c_str()));
+}
+
+// =================================================================
+// Recorder hook on UsSensor
+// =================================================================
+
+TEST(UsSensorRecorderTest, RecordsEveryPingWithTimestamps)
+{
+    auto driver = std::make_shared<MockUsDriver>();
+    auto processor = std::make_shared<UsProcessor>();
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+    idf_hals::MockTimerHAL timer;
+    UsConfig cfg;
+    UsSensor sensor(cfg, driver, processor, freertos, timer);
+
+    VectorRecorder recorder;
+    sensor.set_recorder(&recorder);
+
+    // One timestamp per ping, then the completion time of the burst for the cache
+    EXPECT_CALL(timer, get_time_us())
+        .WillOnce(Return(1000))
+        .WillOnce(Return(71000))
+        .WillOnce(Return(141000))
+        .WillOnce(Return(141500));
+    EXPECT_CALL(*driver, ping_once(_))
+        .WillOnce(Return(Reading{UsResult::OK, 50.0f}))
+        .WillOnce(Return(Reading{UsResult::TIMEOUT, 0.0f}))
+        .WillOnce(Return(Reading{UsResult::OK, 50.1f}));
+    EXPECT_CALL(*driver, last_echo_us()).WillOnce(Return(2915)).WillOnce(Return(0)).WillOnce(Return(2921));
+
+    sensor.read_distance(3);
+
+    ASSERT_EQ(3u, recorder.records.size());
+    EXPECT_EQ(1000, recorder.records[0].timestamp_us);
+    EXPECT_EQ(2915u, recorder.records[0].echo_us);
+    EXPECT_EQ(static_cast<uint8_t>(UsResult::TIMEOUT), recorder.records[1].result);
+    EXPECT_EQ(0u, recorder.records[1].echo_us);
+    EXPECT_EQ(141000, recorder.records[2].timestamp_us);
+    for (uint8_t i = 0; i < 3; i++) {
+        EXPECT_EQ(i, recorder.records[i].ping_index);
+        EXPECT_EQ(3, recorder.records[i].ping_count);
+    }
+
+    // Detached recorder receives nothing
+    sensor.set_recorder(nullptr);
+    EXPECT_CALL(timer, get_time_us()).WillOnce(Return(200000));
+    EXPECT_CALL(*driver, ping_once(_)).WillOnce(Return(Reading{UsResult::OK, 50.0f}));
+    sensor.read_distance(1);
+    EXPECT_EQ(3u, recorder.records.size());
+}
+
+TEST(UsSensorRecorderTest, RecordsAbortedBurst)
+{
+    auto driver = std::make_shared<MockUsDriver>();
+    auto processor = std::make_shared<UsProcessor>();
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+    UsConfig cfg;
+    UsSensor sensor(cfg, driver, processor, freertos);
+
+    VectorRecorder recorder;
+    sensor.set_recorder(&recorder);
+
+    EXPECT_CALL(*driver, ping_once(_))
+        .WillOnce(Return(Reading{UsResult::OK, 50.0f}))
+        .WillOnce(Return(Reading{UsResult::ECHO_STUCK, 0.0f}));
+    EXPECT_CALL(*driver, last_echo_us()).WillRepeatedly(Return(0));
+
+    auto result = sensor.read_distance(5);
+    EXPECT_EQ(UsResult::ECHO_STUCK, result.result);
+
+    ASSERT_EQ(2u, recorder.records.size());
+    EXPECT_EQ(2, recorder.records[1].ping_count);
+    EXPECT_EQ(static_cast<uint8_t>(UsResult::ECHO_STUCK), recorder.records[1].result);
+    // Without a timer HAL, timestamps are left at zero
+    EXPECT_EQ(0, recorder.records[0].timestamp_us);
+}
+
+// =================================================================
+// Replay driver
+// =================================================================
+
+TEST(UsReplayDriverTest, ReevaluatesEchoAgainstConfig)
+{
+    UsReplayDriver replay({
+        makeRecord(UsResult::OK, cmToEcho(50.0f), 0, 3),
+        makeRecord(UsResult::OUT_OF_RANGE, cmToEcho(250.0f), 1, 3),
+        makeRecord(UsResult::TIMEOUT, 0, 2, 3),
+    });
+
+    UsConfig cfg;
+    cfg.max_distance_cm = 300.0f; // wider than while recording
+
+    EXPECT_EQ(3, replay.next_burst_size());
+
+    Reading r = replay.ping_once(cfg);
+    EXPECT_EQ(UsResult::OK, r.result);
+    EXPECT_NEAR(50.0f, r.cm, 0.05f);
+
+    r = replay.ping_once(cfg);
+    EXPECT_EQ(UsResult::OK, r.result); // now within range
+    EXPECT_NEAR(250.0f, r.cm, 0.05f);
+    EXPECT_EQ(cmToEcho(250.0f), replay.last_echo_us());
+
+    EXPECT_EQ(1, replay.next_burst_size());
+    EXPECT_EQ((Reading{UsResult::TIMEOUT, 0.0f}), replay.ping_once(cfg));
+    EXPECT_EQ(0u, replay.last_echo_us());
+
+    EXPECT_TRUE(replay.finished());
+    EXPECT_EQ(0, replay.next_burst_size());
+    EXPECT_EQ(UsResult::HW_FAULT, replay.ping_once(cfg).result);
+}
+
+TEST(UsReplayDriverTest, GateRejectStaysRejected)
+{
+    NiceMock<idf_hals::MockGpioHAL> gpio;
+    NiceMock<idf_hals::MockTimerHAL> timer;
+    NiceMock<idf_hals::MockSysRomHAL> sys_rom;
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+
+    // A tracked echo at 5000 us, then a nearer reflector far outside the gate
+    const int64_t widths[] = {5000, 2000};
+    int64_t now = 0;
+    int triggers = 0;
+    int64_t trigger_at = -1;
+    ON_CALL(timer, get_time_us()).WillByDefault([&]() { return ++now; });
+    ON_CALL(sys_rom, delay_us(_)).WillByDefault([&](uint32_t us) { now += us; });
+    ON_CALL(gpio, set_level(GPIO_NUM_4, _)).WillByDefault([&](gpio_num_t, uint32_t level) {
+        if (level == 0 && triggers < 2) {
+            trigger_at = now;
+            triggers++;
+        }
+        return ESP_OK;
+    });
+    ON_CALL(gpio, get_level(GPIO_NUM_5)).WillByDefault([&](gpio_num_t) {
+        const int64_t rise = trigger_at + 150;
+        return (trigger_at >= 0 && now >= rise && now < rise + widths[triggers - 1]) ? 1 : 0;
+    });
+
+    UsConfig cfg;
+    cfg.ping_interval_ms = 0;
+    cfg.track_gate_cm = 10.0f;
+    auto driver = std::make_shared<UsDriver>(gpio, timer, sys_rom, GPIO_NUM_4, GPIO_NUM_5);
+    UsSensor sensor(cfg, driver, std::make_shared<UsProcessor>(), freertos, timer);
+    VectorRecorder recorder;
+    sensor.set_recorder(&recorder);
+    sensor.read_distance(2);
+
+    ASSERT_EQ(2u, recorder.records.size());
+    EXPECT_EQ(0, recorder.records[0].flags);
+    const TraceRecord &rejected = recorder.records[1];
+    EXPECT_EQ(static_cast<uint8_t>(UsResult::OUT_OF_RANGE), rejected.result);
+    EXPECT_EQ(TRACE_FLAG_GATE_REJECT, rejected.flags);
+    EXPECT_NEAR(rejected.echo_us, 2000u, 5u);
+
+    // The echo is in range, but the replay cannot re-run the gate: still rejected
+    UsReplayDriver replay(recorder.records);
+    EXPECT_EQ(UsResult::OK, replay.ping_once(cfg).result);
+    EXPECT_FALSE(replay.last_echo_gated());
+    EXPECT_EQ((Reading{UsResult::OUT_OF_RANGE, 0.0f}), replay.ping_once(cfg));
+    EXPECT_TRUE(replay.last_echo_gated());
+    EXPECT_EQ(rejected.echo_us, replay.last_echo_us());
+
+    TraceRecord unflagged = rejected;
+    unflagged.flags = 0;
+    EXPECT_EQ(UsResult::OK, UsReplayDriver::reevaluate(unflagged, UsCompiledConfig(cfg)).result);
+}
+
+TEST(UsReplayDriverTest, NarrowerRangeRejectsRecordedEcho)
+{
+    UsReplayDriver replay({makeRecord(UsResult::OK, cmToEcho(150.0f), 0, 1)});
+
+    UsConfig cfg;
+    cfg.max_distance_cm = 100.0f;
+
+    EXPECT_EQ(UsResult::OUT_OF_RANGE, replay.ping_once(cfg).result);
+}
+
+TEST_F(UsTraceFileTest, RecordAndReplayThroughRealSensor)
+{
+    UsConfig cfg;
+    cfg.filter = Filter::MEDIAN;
+    cfg.max_dev_cm = 200.0f;
+
+    // 1. Record two bursts from a scripted driver into a trace file
+    auto driver = std::make_shared<MockUsDriver>();
+    NiceMock<idf_hals::MockHalFreertos> freertos;
+    UsSensor sensor(cfg, driver, std::make_shared<UsProcessor>(), freertos);
+
+    const float burst[] = {50.1f, 50.3f, 49.9f, 120.0f, 50.2f};
+    for (float cm : burst) {
+        EXPECT_CALL(*driver, ping_once(_)).WillOnce(Return(Reading{UsResult::OK, cm})).RetiresOnSaturation();
+    }
+    EXPECT_CALL(*driver, last_echo_us()).WillRepeatedly(Return(0));
+
+    UsTraceWriter writer;
+    ASSERT_EQ(ESP_OK, writer.open(path_.c_str(), sensor.config(), 1));
+
+    // Echo widths must match the scripted distances for the replay to be faithful
+    class EchoRecorder : public IUsRecorder
+    {
+    public:
+        EchoRecorder(IUsRecorder &sink, const float *cm)
+            : sink_(sink)
+            , cm_(cm)
+        {
+        }
+        void record(const TraceRecord &rec) override
+        {
+            TraceRecord copy = rec;
+            copy.echo_us = cmToEcho(cm_[rec.ping_index]);
+            sink_.record(copy);
+        }
+
+    private:
+        IUsRecorder &sink_;
+        const float *cm_;
+    } echo_recorder(writer, burst);
+
+    sensor.set_recorder(&echo_recorder);
+    Reading recorded = sensor.read_distance(5);
+    ASSERT_EQ(ESP_OK, writer.close());
+
+    // 2. Replay through the real sensor and processor with the recorded config
+    UsTraceReader reader;
+    ASSERT_EQ(ESP_OK, reader.open(path_.c_str()));
+    std::vector<TraceRecord> records;
+    ASSERT_EQ(5u, UsReplayDriver::load(reader, records));
+
+    auto replay = std::make_shared<UsReplayDriver>(records);
+    UsSensor replay_sensor(reader.config(), replay, std::make_shared<UsProcessor>(), freertos);
+
+    std::vector<Reading> replayed;
+    while (uint8_t n = replay->next_burst_size()) {
+        replayed.push_back(replay_sensor.read_distance(n));
+    }
+    ASSERT_EQ(1u, replayed.size());
+    EXPECT_EQ(recorded.result, replayed[0].result);
+    EXPECT_NEAR(recorded.cm, replayed[0].cm, 0.05f);
+
+    // 3. Same data, different filter: the outlier no longer shifts the result
+    UsConfig cluster_cfg = reader.config();
+    cluster_cfg.filter = Filter::DOMINANT_CLUSTER;
+    auto replay2 = std::make_shared<UsReplayDriver>(records);
+    UsSensor cluster_sensor(cluster_cfg, replay2, std::make_shared<UsProcessor>(), freertos);
+
+    Reading clustered = cluster_sensor.read_distance(replay2->next_burst_size());
+    EXPECT_TRUE(is_success(clustered.result));
+    EXPECT_NEAR(50.1f, clustered.cm, 0.1f);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ultrasonic {
+
+/**
+ * @brief Free-running high-resolution counter used to time echo edges.
+ *
+ * Reading it must be much cheaper than ITimerHAL::get_time_us(), typically
+ * a single CPU register read. The rate does not need to be known: UsDriver
+ * calibrates it against the timer HAL in init().
+ */
+class IUsCycleCounter
+{
+public:
+    virtual ~IUsCycleCounter() = default;
+
+    /**
+     * @brief Current counter value.
+     * @return Count that increases at a constant rate and wraps modulo 2^32.
+     */
+    virtual uint32_t cycles() = 0;
+};
+
+} // namespace ultrasonic
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "esp_err.h"
+#include "us_compiled_config.hpp"
+#include "us_task.hpp"
 #include "us_types.hpp"
 #include "driver/gpio.h"
 
 namespace ultrasonic {
 
+class UsExecutor;
+
 /**
  * @brief Interface for the low-level ultrasonic hardware driver.
  * @internal
@@ -23,8 +27,95 @@ public:
     /** @internal */
     virtual esp_err_t deinit() = 0;
 
-    /** @internal */
+    /**
+     * @internal
+     * @brief Trigger once and measure the echo, compiling @p cfg on every call.
+     */
     virtual Reading ping_once(const UsConfig &cfg) = 0;
+
+    /**
+     * @internal
+     * @brief Same as ping_once() with the constants already derived.
+     *
+     * UsSensor calls this with the configuration it compiled at construction,
+     * so drivers that override it convert and range-check the echo without
+     * touching the source configuration. The default forwards to ping_once().
+     */
+    virtual Reading ping_compiled(const UsCompiledConfig &cc) { return ping_once(cc.cfg); }
+
+    /**
+     * @internal
+     * @brief Awaitable ping_once().
+     *
+     * Drivers that can suspend while waiting for the echo override this. The
+     * default runs ping_once() to completion without suspending.
+     *
+     * @param exec Executor the calling coroutine runs on.
+     * @param cfg  Sensor configuration.
+     */
+    virtual UsTask<Reading> ping(UsExecutor &exec, const UsConfig &cfg)
+    {
+        (void)exec;
+        co_return ping_once(cfg);
+    }
+
+    /**
+     * @internal
+     * @brief Same as ping() with the constants already derived.
+     *
+     * UsSensor::measure() calls this with its compiled configuration, which
+     * must stay alive until the task completes. The default forwards to
+     * ping(exec, cc.cfg).
+     */
+    virtual UsTask<Reading> ping(UsExecutor &exec, const UsCompiledConfig &cc) { return ping(exec, cc.cfg); }
+
+    /**
+     * @internal
+     * @brief Raw echo pulse width measured by the last ping_once() call (us).
+     *
+     * Zero when the last ping did not measure an echo (timeout, stuck pin or
+     * hardware fault). Used for trace recording; drivers that cannot report it
+     * keep the default.
+     */
+    virtual uint32_t last_echo_us() const { return 0; }
+
+    /**
+     * @internal
+     * @brief The last ping measured an echo but rejected it as OUT_OF_RANGE
+     *        because it ended before the tracking gate (UsConfig::track_gate_cm).
+     *
+     * last_echo_us() still holds its width. Recorded in TraceRecord::flags.
+     */
+    virtual bool last_echo_gated() const { return false; }
+
+    /**
+     * @internal
+     * @brief Counters accumulated since construction.
+     *
+     * Drivers that keep no counters return all zeros.
+     */
+    virtual UsDriverStats stats() const { return {}; }
+
+    /**
+     * @internal
+     * @brief Trigger once and record up to cfg.max_echoes echo pulses.
+     *
+     * The default implementation falls back to ping_once() and reports at most
+     * one pulse, with an unknown start time.
+     *
+     * @return OK if at least one complete pulse was captured, TIMEOUT if none,
+     *         or the hardware failure that prevented the trigger.
+     */
+    virtual UsResult capture_echoes(const UsConfig &cfg, EchoCapture &out)
+    {
+        Reading r = ping_once(cfg);
+        out.count = 0;
+        if (is_success(r.result)) {
+            out.pulses[0] = {0, last_echo_us(), r.cm};
+            out.count = 1;
+        }
+        return r.result;
+    }
 };
 
 } // namespace ultrasonic
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ultrasonic {
+
+/**
+ * @brief Reads the input level of every GPIO at once.
+ *
+ * Used by UsMultiDriver to poll all ECHO pins with a single read instead of
+ * one IGpioHAL::get_level() call per pin. Reading it must be about as cheap
+ * as one get_level(), typically one or two register reads.
+ */
+class IUsGpioBulk
+{
+public:
+    virtual ~IUsGpioBulk() = default;
+
+    /**
+     * @brief Current input levels.
+     * @return Bit n set if GPIO n reads HIGH.
+     */
+    virtual uint64_t read_inputs() = 0;
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+namespace ultrasonic {
+
+/**
+ * @brief Block storage behind UsHistory.
+ *
+ * The storage is a fixed number of equally sized blocks that UsHistory uses
+ * as a ring. Blocks are always rewritten as a whole, starting at offset 0,
+ * which maps onto erase-and-program on raw flash as well as onto files.
+ */
+class IUsHistoryStorage
+{
+public:
+    virtual ~IUsHistoryStorage() = default;
+
+    /** @brief Size of one block in bytes. */
+    virtual size_t block_size() const = 0;
+
+    /** @brief Number of blocks. */
+    virtual uint32_t block_count() const = 0;
+
+    /**
+     * @brief Read part of a block.
+     *
+     * @param block  Block index, below block_count().
+     * @param offset Byte offset within the block.
+     * @param dst    Output buffer.
+     * @param len    Number of bytes; offset + len must not exceed block_size().
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_ARG: Out of bounds
+     *     - ESP_FAIL: The backend failed
+     */
+    virtual esp_err_t read(uint32_t block, size_t offset, void *dst, size_t len) = 0;
+
+    /**
+     * @brief Replace the contents of a block.
+     *
+     * Bytes after @p len keep an unspecified value.
+     *
+     * @param block Block index, below block_count().
+     * @param src   New contents.
+     * @param len   Number of bytes, at most block_size().
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_ARG: Out of bounds
+     *     - ESP_FAIL: The backend failed
+     */
+    virtual esp_err_t write(uint32_t block, const void *src, size_t len) = 0;
+};
+
+} // namespace ultrasonic
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "us_compiled_config.hpp"
+#include "us_packed_reading.hpp"
 #include "us_types.hpp"
 #include <cstdint>
 
@@ -21,6 +23,50 @@ public:
 
     /** @internal */
     virtual Reading process(const Reading *pings, uint8_t total_pings, const UsConfig &cfg) = 0;
+
+    /**
+     * @internal
+     * @brief Same as process() on packed pings.
+     *
+     * The default implementation unpacks into a local buffer; processors that
+     * can read the packed form directly override it.
+     */
+    virtual Reading process_packed(const PackedReading *pings, uint8_t total_pings, const UsConfig &cfg)
+    {
+        Reading unpacked[MAX_PINGS];
+        uint8_t count = (total_pings > MAX_PINGS) ? MAX_PINGS : total_pings;
+        for (uint8_t i = 0; i < count; i++) {
+            unpacked[i] = pings[i].unpack();
+        }
+        return process(unpacked, count, cfg);
+    }
+
+    /**
+     * @internal
+     * @brief Same as process() with the constants already derived.
+     *
+     * UsSensor calls this with the configuration it compiled at construction.
+     * The default implementation forwards the source configuration to process().
+     */
+    virtual Reading process_compiled(const Reading *pings, uint8_t total_pings, const UsCompiledConfig &cc)
+    {
+        return process(pings, total_pings, cc.cfg);
+    }
+
+    /**
+     * @internal
+     * @brief Same as process_compiled(), also filling the processor fields of @p info.
+     *
+     * Fills total_pings, valid_pings, ping_results, std_dev_cm and
+     * filter_samples; the caller sets the rest. The default implementation
+     * counts the pings itself and leaves std_dev_cm and filter_samples unset.
+     */
+    virtual Reading process_ex(const Reading *pings, uint8_t total_pings, const UsCompiledConfig &cc,
+                               MeasurementInfo &info)
+    {
+        info.count_pings(pings, (total_pings > MAX_PINGS) ? MAX_PINGS : total_pings);
+        return process_compiled(pings, total_pings, cc);
+    }
 };
 
 } // namespace ultrasonic
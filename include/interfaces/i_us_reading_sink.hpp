@@ -0,0 +1,30 @@
+#pragma once
+
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Interface for receiving every processed reading.
+ *
+ * Attached to UsSensor through UsSensor::add_reading_sink(). The sensor calls
+ * every attached sink once per read_distance(), with the same value it
+ * publishes to get_latest().
+ */
+class IUsReadingSink
+{
+public:
+    virtual ~IUsReadingSink() = default;
+
+    /**
+     * @brief Receive a reading.
+     *
+     * Called from the task running read_distance(), after the burst has been
+     * processed. Implementations should be cheap.
+     *
+     * @param reading Processed reading and the time it was published.
+     */
+    virtual void on_reading(const TimedReading &reading) = 0;
+};
+
+} // namespace ultrasonic
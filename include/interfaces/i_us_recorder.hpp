@@ -0,0 +1,29 @@
+#pragma once
+
+#include "us_trace.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Interface for receiving the raw pings of every measurement burst.
+ *
+ * Attached to UsSensor through UsSensor::set_recorder(). The sensor emits one
+ * TraceRecord per fired ping once the burst has finished, in firing order.
+ */
+class IUsRecorder
+{
+public:
+    virtual ~IUsRecorder() = default;
+
+    /**
+     * @brief Receive a single raw ping.
+     *
+     * Called from the task running read_distance(). Implementations should be
+     * cheap; the call sits between the last ping and the processing step.
+     *
+     * @param rec Raw ping record.
+     */
+    virtual void record(const TraceRecord &rec) = 0;
+};
+
+} // namespace ultrasonic
@@ -25,6 +25,7 @@ public:
      *
      * @return
      *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_ARG: Inconsistent configuration
      *     - Other: error codes propagated from the underlying driver HAL implementation
      */
     virtual esp_err_t init() = 0;
@@ -57,6 +58,34 @@ public:
      *       refined to the most frequent logical error encountered.
      */
     virtual Reading read_distance(uint8_t ping_count) = 0;
+
+    /**
+     * @brief Perform a distance measurement that finishes within a time budget.
+     *
+     * Same as read_distance(uint8_t), but no new ping is started if it could
+     * end after @p deadline_us, counted from the call. The pings fired so far
+     * are then processed as if fewer pings had been requested. The bound
+     * assumes that every remaining ping takes worst_case_ping_us() (see
+     * us_timing.hpp).
+     *
+     * @param ping_count   Number of pings to attempt (limited by IUsProcessor::MAX_PINGS).
+     * @param deadline_us  Time budget for the measurement, in microseconds.
+     * @param deadline_hit Set to true if fewer pings were fired because of the deadline.
+     *
+     * @return Reading structure as for read_distance(uint8_t). If not even one
+     *         ping fits the budget, no ping is fired and INSUFFICIENT_SAMPLES is
+     *         returned.
+     *
+     * @note The default implementation cannot bound its time: it runs
+     *       read_distance(ping_count) and reports no deadline hit. UsSensor
+     *       overrides it.
+     */
+    virtual Reading read_distance(uint8_t ping_count, uint32_t deadline_us, bool &deadline_hit)
+    {
+        (void)deadline_us;
+        deadline_hit = false;
+        return read_distance(ping_count);
+    }
 };
 
 } // namespace ultrasonic
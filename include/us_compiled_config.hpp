@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/** @brief Fraction of max_dev_cm above which an otherwise good burst is WEAK_SIGNAL. */
+inline constexpr float WEAK_VARIANCE_RATIO = 0.6f;
+
+/**
+ * @brief First inconsistency found in a UsConfig.
+ */
+enum class UsConfigError : uint8_t
+{
+    NONE,              /**< Configuration is consistent. */
+    ZERO_TRIGGER,      /**< ping_duration_us is 0. */
+    BAD_RANGE,         /**< min_distance_cm negative, max_distance_cm not above it, or not finite. */
+    BAD_DEVIATION,     /**< max_dev_cm negative or NaN. */
+    TIMEOUT_TOO_SHORT, /**< timeout_us shorter than the echo from max_distance_cm. */
+    BAD_INTERVAL,      /**< min_ping_interval_ms above ping_interval_ms. */
+    BAD_ECHO_COUNT,    /**< max_echoes outside 1..EchoCapture::MAX_ECHOES. */
+    BAD_GATE,          /**< track_gate_cm negative or NaN. */
+};
+
+/**
+ * @brief UsConfig validated once, with the constants derived from it.
+ *
+ * UsSensor builds one at construction and hands it to the driver and the
+ * processor, so a ping converts and range-checks the echo width without
+ * re-deriving anything from the configuration. Everything is constexpr:
+ * compile_config() turns an inconsistent constexpr configuration into a
+ * compile error.
+ */
+struct UsCompiledConfig
+{
+    UsConfig cfg;                              /**< Source configuration. */
+    UsConfigError error = UsConfigError::NONE; /**< First inconsistency, or NONE. */
+
+    float cm_per_echo_us = 0.0f; /**< Distance per microsecond of echo (half the speed of sound). */
+    float min_echo_us = 0.0f;    /**< Shortest echo inside the distance range (us). */
+    float max_echo_us = 0.0f;    /**< Longest echo inside the distance range (us). */
+    uint32_t range_echo_us = 0;  /**< max_echo_us rounded up; timeout_us must cover it. */
+    float weak_dev_cm = 0.0f;    /**< max_dev_cm * WEAK_VARIANCE_RATIO. */
+    uint8_t max_echoes = 1;      /**< max_echoes clamped to 1..EchoCapture::MAX_ECHOES, as capture_echoes() uses it. */
+    float track_gate_us = 0.0f;  /**< track_gate_cm as echo width (us), 0 when tracking is disabled. */
+
+    /**
+     * @brief Validate @p config and derive the constants.
+     *
+     * Never fails: an inconsistent configuration is recorded in #error and
+     * the constants are still derived from it as far as possible.
+     */
+    constexpr explicit UsCompiledConfig(const UsConfig &config = UsConfig{})
+        : cfg(config)
+        , cm_per_echo_us(SOUND_SPEED_CM_PER_US / 2.0f)
+        , min_echo_us(config.min_distance_cm / (SOUND_SPEED_CM_PER_US / 2.0f))
+        , max_echo_us(config.max_distance_cm / (SOUND_SPEED_CM_PER_US / 2.0f))
+        , weak_dev_cm(config.max_dev_cm * WEAK_VARIANCE_RATIO)
+        , max_echoes(EchoCapture::clamp_count(config.max_echoes))
+        , track_gate_us((config.track_gate_cm > 0.0f) ? config.track_gate_cm / (SOUND_SPEED_CM_PER_US / 2.0f) : 0.0f)
+    {
+        constexpr float INF = std::numeric_limits<float>::infinity();
+        const bool range_ok = config.min_distance_cm >= 0.0f && config.max_distance_cm > config.min_distance_cm &&
+                              config.max_distance_cm < INF;
+        if (range_ok && max_echo_us < static_cast<float>(UINT32_MAX)) {
+            range_echo_us = static_cast<uint32_t>(max_echo_us);
+            if (static_cast<float>(range_echo_us) < max_echo_us)
+                range_echo_us++;
+        } else {
+            range_echo_us = UINT32_MAX;
+        }
+
+        if (config.ping_duration_us == 0)
+            error = UsConfigError::ZERO_TRIGGER;
+        else if (!range_ok)
+            error = UsConfigError::BAD_RANGE;
+        else if (!(config.max_dev_cm >= 0.0f))
+            error = UsConfigError::BAD_DEVIATION;
+        else if (config.timeout_us < range_echo_us)
+            error = UsConfigError::TIMEOUT_TOO_SHORT;
+        else if (config.min_ping_interval_ms > config.ping_interval_ms)
+            error = UsConfigError::BAD_INTERVAL;
+        else if (config.max_echoes != EchoCapture::clamp_count(config.max_echoes))
+            error = UsConfigError::BAD_ECHO_COUNT;
+        else if (!(config.track_gate_cm >= 0.0f))
+            error = UsConfigError::BAD_GATE;
+    }
+
+    /** @brief True if the configuration is consistent. */
+    constexpr bool valid() const { return error == UsConfigError::NONE; }
+
+    /** @brief Distance of an echo of @p echo_us microseconds (cm). */
+    constexpr float echo_to_cm(float echo_us) const { return echo_us * cm_per_echo_us; }
+
+    /** @brief True if an echo of @p echo_us microseconds lies inside the distance range. */
+    constexpr bool echo_in_range(float echo_us) const { return echo_us >= min_echo_us && echo_us <= max_echo_us; }
+};
+
+/** @internal Not constexpr: reaching it in a constant evaluation is the compile error. */
+void us_config_rejected(UsConfigError error);
+
+/**
+ * @brief Compile a constexpr configuration, rejecting inconsistent ones at compile time.
+ *
+ * @code
+ * constexpr UsCompiledConfig TANK = compile_config(UsConfig{.timeout_us = 25000, .max_distance_cm = 400.0f});
+ *
+ * // Does not compile: a 400 cm echo takes 23324 us
+ * constexpr UsCompiledConfig BAD = compile_config(UsConfig{.timeout_us = 20000, .max_distance_cm = 400.0f});
+ * @endcode
+ *
+ * @param config Configuration to validate.
+ * @return The compiled configuration; only valid ones compile.
+ */
+consteval UsCompiledConfig compile_config(const UsConfig &config)
+{
+    UsCompiledConfig compiled(config);
+    if (!compiled.valid())
+        us_config_rejected(compiled.error);
+    return compiled;
+}
+
+/** @brief Short name of a configuration error ("timeout_too_short"). */
+const char *config_error_name(UsConfigError error);
+
+} // namespace ultrasonic
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include "i_us_cycle_counter.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief IUsCycleCounter backed by the CPU cycle counter.
+ *
+ * On the chip this is esp_cpu_get_cycle_count(). The counter is per core,
+ * so the task measuring with it must be pinned to one core, and its rate
+ * follows the CPU clock: with dynamic frequency scaling enabled, hold a
+ * CPU frequency lock while measuring or stay on the timer HAL. On the linux
+ * target the steady clock in nanoseconds stands in for it.
+ */
+class UsCpuCycleCounter : public IUsCycleCounter
+{
+public:
+    /** @copydoc IUsCycleCounter::cycles() */
+    uint32_t cycles() override;
+};
+
+} // namespace ultrasonic
@@ -1,57 +1,203 @@
 #pragma once
 
 #include "esp_err.h"
+#include "i_us_cycle_counter.hpp"
 #include "i_us_driver.hpp"
+#include "us_jitter.hpp"
+#include "interfaces/i_hal_freertos.hpp"
 #include "interfaces/i_hal_gpio.hpp"
 #include "interfaces/i_hal_timer.hpp"
 #include "interfaces/i_hal_sys_rom.hpp"
 
 namespace ultrasonic {
 
+/**
+ * @brief Optional hardware of a UsDriver.
+ *
+ * Every field can be combined with the others. The defaults give a driver
+ * without power switching that spins on ECHO and times it with the timer HAL.
+ */
+struct UsDriverOptions
+{
+    /** GPIO switching the sensor supply, used by ECHO_STUCK recovery. GPIO_NUM_NC if not wired. */
+    gpio_num_t power_pin = GPIO_NUM_NC;
+    /** Level of power_pin that powers the sensor (0 for a high-side PNP/P-MOSFET switch). */
+    uint32_t power_on_level = 1;
+    /** FreeRTOS HAL for the UsConfig::echo_wait policies. Without it, every echo wait spins. */
+    idf_hals::IHalFreertos *freertos_hal = nullptr;
+    /**
+     * Counter timing the echo edges instead of the timer HAL. ping_once()
+     * then reads it in its polling loops and converts only the two edge
+     * timestamps, which raises both the polling rate and the resolution of
+     * the echo width. It is calibrated in init() and must outlive the driver.
+     */
+    IUsCycleCounter *cycle_counter = nullptr;
+};
+
 /**
  * @brief Concrete implementation of IUsDriver for HC-SR04-compatible sensors.
  * @internal
  *
  * Handles the low-level GPIO protocol: trigger pulse, echo detection, and
  * pulse duration measurement. Maps hardware errors to UsResult.
+ *
+ * An instance is driven by one task. The HAL objects may be shared with
+ * drivers on other tasks: the driver only touches its own pins, keeps no
+ * state in the HALs and takes no locks (see "Sharing HALs Between Sensors"
+ * in API.md for what a shared HAL must guarantee).
  */
 class UsDriver : public IUsDriver
 {
 public:
     /** @internal */
-    static constexpr float SOUND_SPEED_CM_PER_US = 0.0343f;
+    static constexpr float SOUND_SPEED_CM_PER_US = ultrasonic::SOUND_SPEED_CM_PER_US;
 
-    /** @internal */
+    /**
+     * @internal
+     * @param opts Optional power pin, echo wait HAL and cycle counter.
+     */
     UsDriver(
         idf_hals::IGpioHAL &gpio_hal,
         idf_hals::ITimerHAL &timer_hal,
         idf_hals::ISysRomHAL &sys_rom_hal,
         gpio_num_t trig_pin,
-        gpio_num_t echo_pin);
+        gpio_num_t echo_pin,
+        const UsDriverOptions &opts = UsDriverOptions{});
 
     ~UsDriver() override = default;
 
-    /** @copydoc IUsDriver::init() */
+    /** @internal Busy-wait used to calibrate the cycle counter (us). */
+    static constexpr uint32_t CYCLE_CALIBRATION_US = 2000;
+
+    /**
+     * Longest time the task may be away from an echo edge (us, about 1.7 cm).
+     * A ping whose edge was first seen after a longer yield or sleep
+     * (UsConfig::echo_wait) returns HIGH_VARIANCE instead of a late reading.
+     */
+    static constexpr uint32_t MAX_EDGE_GAP_US = 100;
+
+    /**
+     * @copydoc IUsDriver::init()
+     *
+     * With a cycle counter, init() also calibrates it (see calibrate_cycle_counter()).
+     */
     esp_err_t init() override;
 
+    /**
+     * @internal
+     * @brief Measure the cycle counter rate against the timer HAL.
+     *
+     * Busy-waits CYCLE_CALIBRATION_US. Call it again after the CPU clock
+     * changed. If the counter does not advance, the driver falls back to
+     * timing edges with the timer HAL.
+     *
+     * @return ESP_OK, ESP_ERR_INVALID_STATE if no counter was given or it did
+     *         not advance.
+     */
+    esp_err_t calibrate_cycle_counter();
+
+    /** @internal Calibrated counter rate (counts per us), 0 when edges are timed with the timer HAL. */
+    float cycles_per_us() const { return cycles_per_us_; }
+
     /** @copydoc IUsDriver::deinit() */
     esp_err_t deinit() override;
 
     /** @copydoc IUsDriver::ping_once() */
     Reading ping_once(const UsConfig &cfg) override;
 
+    /** @copydoc IUsDriver::ping_compiled() */
+    Reading ping_compiled(const UsCompiledConfig &cc) override;
+
+    /**
+     * @internal
+     * @brief Same as ping_once(), suspending instead of blocking.
+     *
+     * The trigger jitter and the trigger pulse are awaited with
+     * UsExecutor::sleep_us(), and every poll of ECHO that does not see the
+     * awaited edge yields with UsExecutor::poll(). The pulse lasts at least
+     * ping_duration_us, which the sensor accepts. ECHO_STUCK recovery, when
+     * needed, still blocks.
+     */
+    UsTask<Reading> ping(UsExecutor &exec, const UsConfig &cfg) override;
+
+    /** @copydoc IUsDriver::ping(UsExecutor &, const UsCompiledConfig &) */
+    UsTask<Reading> ping(UsExecutor &exec, const UsCompiledConfig &cc) override;
+
+    /** @copydoc IUsDriver::last_echo_us() */
+    uint32_t last_echo_us() const override { return last_echo_us_; }
+
+    /** @copydoc IUsDriver::last_echo_gated() */
+    bool last_echo_gated() const override { return echo_gated_; }
+
+    /** @copydoc IUsDriver::stats() */
+    UsDriverStats stats() const override { return stats_; }
+
+    /**
+     * @internal
+     * @brief Trigger once and record up to cfg.max_echoes echo pulses.
+     *
+     * ECHO is polled for the whole timeout_us window after the trigger, and
+     * every complete HIGH pulse is recorded. A pulse still HIGH when the window
+     * closes is dropped. Capture stops early once max_echoes pulses are stored
+     * (clamped to 1..EchoCapture::MAX_ECHOES, which UsSensor validates).
+     * Pulses are not range-checked, so near targets and far walls are all
+     * reported.
+     */
+    UsResult capture_echoes(const UsConfig &cfg, EchoCapture &out) override;
+
 private:
+    /** @internal */
+    UsResult start_ping(const UsConfig &cfg);
+
+    /** @internal */
+    UsResult prepare_ping(const UsConfig &cfg);
+
+    /** @internal */
+    uint32_t next_jitter_us(const UsConfig &cfg);
+
+    /** @internal */
+    Reading to_reading(const UsCompiledConfig &cc, float duration_us);
+
     /** @internal */
     bool is_echo_stuck();
 
+    /** @internal */
+    esp_err_t recover_stuck_echo(const UsConfig &cfg);
+
+    /** @internal */
+    esp_err_t discharge_echo(uint16_t settle_us);
+
     /** @internal */
     esp_err_t trigger(uint16_t pulse_duration_us);
 
     /** @internal */
-    esp_err_t wait_rising_edge(uint32_t timeout_us);
+    esp_err_t wait_rising_edge(const UsConfig &cfg, uint32_t &rise_us);
+
+    /**
+     * @internal
+     * @brief Wait for the falling edge and return the pulse width.
+     * @param limit_us     Give up with ESP_ERR_TIMEOUT once the pulse is longer (us).
+     * @param predicted_us Expected width from the last ping, 0 if unknown.
+     */
+    esp_err_t measure_pulse(const UsConfig &cfg, uint32_t limit_us, uint32_t predicted_us, float &duration_us);
 
     /** @internal */
-    esp_err_t measure_pulse(uint32_t timeout_us, uint32_t &duration_us);
+    esp_err_t wait_rising_edge_cycles(const UsConfig &cfg, uint32_t &rise_us);
+
+    /** @internal */
+    esp_err_t measure_pulse_cycles(const UsConfig &cfg, uint32_t limit_us, uint32_t predicted_us, float &duration_us);
+
+    /**
+     * @internal
+     * @brief Apply cfg.echo_wait after a poll that did not see the awaited edge.
+     * @param elapsed_us   Time since the wait started.
+     * @param predicted_us Expected edge time from the last ping, 0 if unknown.
+     * @return true if the task yielded or slept, so an edge seen next may be late.
+     */
+    bool relax(const UsConfig &cfg, uint32_t elapsed_us, uint32_t predicted_us);
+
+    /** @internal Timeout converted to counts, capped below half the counter range. */
+    uint32_t timeout_cycles(uint32_t timeout_us) const;
 
     /** @internal */
     idf_hals::IGpioHAL &gpio_hal_;
@@ -59,11 +205,42 @@ private:
     idf_hals::ITimerHAL &timer_hal_;
     /** @internal */
     idf_hals::ISysRomHAL &sys_rom_hal_;
+    /** @internal */
+    idf_hals::IHalFreertos *freertos_hal_ = nullptr;
+    /** @internal */
+    IUsCycleCounter *cycle_counter_ = nullptr;
+    /** @internal */
+    float cycles_per_us_ = 0.0f;
 
     /** @internal */
     gpio_num_t trig_pin_;
     /** @internal */
     gpio_num_t echo_pin_;
+    /** @internal */
+    gpio_num_t power_pin_;
+    /** @internal */
+    uint32_t power_on_level_;
+
+    /** @internal */
+    uint32_t last_echo_us_ = 0;
+    /** @internal */
+    bool echo_gated_ = false;
+    /** @internal ECHO is an input and was seen LOW at the end of the last ping. */
+    bool echo_clean_ = false;
+    /** @internal Trigger to rising edge of the last measured echo (us), 0 if none. */
+    uint32_t predicted_rise_us_ = 0;
+    /** @internal Width of the last measured echo (us), 0 if none. */
+    uint32_t predicted_width_us_ = 0;
+    /** @internal Time away before the poll that saw the last awaited edge (us); 0 if the wait spun into it. */
+    uint32_t edge_gap_us_ = 0;
+    /** @internal Width of the last in-range echo, the centre of the tracking gate (us); 0 = not tracking. */
+    float track_echo_us_ = 0.0f;
+    /** @internal The last ping gave up on a pulse that was still HIGH. */
+    bool echo_abandoned_ = false;
+    /** @internal */
+    UsDriverStats stats_;
+    /** @internal */
+    UsJitter jitter_;
 };
 
 } // namespace ultrasonic
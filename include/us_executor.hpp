@@ -0,0 +1,226 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <queue>
+#include <vector>
+
+#include "us_task.hpp"
+#include "interfaces/i_hal_freertos.hpp"
+#include "interfaces/i_hal_sys_rom.hpp"
+#include "interfaces/i_hal_timer.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Minimal single-threaded executor for UsTask coroutines.
+ *
+ * Keeps a queue of ready coroutines and a queue of sleeping ones ordered by
+ * wake-up time. run() resumes ready coroutines in FIFO order. When all of
+ * them are suspended on a timer it sleeps until the earliest wake-up: whole
+ * ticks through IHalFreertos::task_delay(), so other FreeRTOS tasks run, and
+ * the remainder with ISysRomHAL::delay_us(). Time comes from ITimerHAL.
+ *
+ * All coroutines run on the task calling run(). Nothing in the executor is
+ * thread-safe.
+ */
+class UsExecutor
+{
+public:
+    /**
+     * @brief Construct an executor.
+     *
+     * @param timer_hal    Time source for sleeps.
+     * @param sys_rom_hal  Busy wait for sleeps shorter than a tick.
+     * @param freertos_hal Task delay for sleeps of a tick or more.
+     * @param poll_us      Interval between polls of a GPIO wait (us). 0 polls
+     *                     again as soon as the other ready coroutines ran,
+     *                     which is the most precise but never lets the
+     *                     executor sleep while an echo is awaited.
+     */
+    UsExecutor(
+        idf_hals::ITimerHAL &timer_hal,
+        idf_hals::ISysRomHAL &sys_rom_hal,
+        idf_hals::IHalFreertos &freertos_hal,
+        uint32_t poll_us = 0);
+
+    /** @brief Destroys coroutines that were spawned and have not finished. */
+    ~UsExecutor();
+
+    UsExecutor(const UsExecutor &) = delete;
+    UsExecutor &operator=(const UsExecutor &) = delete;
+
+    /** @internal */
+    struct SleepAwaiter
+    {
+        UsExecutor &exec;
+        int64_t wake_us;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { exec.schedule_at(wake_us, h); }
+        void await_resume() const noexcept {}
+    };
+
+    /** @internal */
+    struct PollAwaiter
+    {
+        UsExecutor &exec;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            if (exec.poll_us_ > 0) {
+                exec.schedule_at(exec.now_us() + exec.poll_us_, h);
+            } else {
+                exec.schedule(h);
+            }
+        }
+        void await_resume() const noexcept {}
+    };
+
+    /** @internal */
+    struct YieldAwaiter
+    {
+        UsExecutor &exec;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) { exec.schedule(h); }
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * @brief Suspend the calling coroutine for at least @p us microseconds.
+     * @code co_await exec.sleep_us(1000); @endcode
+     */
+    SleepAwaiter sleep_us(uint32_t us) { return SleepAwaiter{*this, now_us() + us}; }
+
+    /** @brief Suspend until the coroutines that are ready now have run. */
+    YieldAwaiter yield() { return YieldAwaiter{*this}; }
+
+    /**
+     * @brief Suspend between two polls of a GPIO wait (see the poll_us constructor argument).
+     */
+    PollAwaiter poll() { return PollAwaiter{*this}; }
+
+    /**
+     * @brief Start a task that runs until completion without being awaited.
+     *
+     * The executor owns the task; it starts on the next run() step.
+     *
+     * @param task Task to run.
+     */
+    void spawn(UsTask<void> task);
+
+    /**
+     * @brief Run until no spawned task is left and no coroutine is queued.
+     */
+    void run();
+
+    /**
+     * @brief Run the ready coroutines and the sleeping ones that are due, once.
+     * @return true if at least one coroutine was resumed.
+     */
+    bool run_once();
+
+    /**
+     * @brief Run @p task (and every other queued coroutine) until it finishes.
+     *
+     * Convenient from plain code, e.g. in a FreeRTOS task or a test.
+     *
+     * @param task Task to run.
+     * @return The task's result.
+     */
+    template <typename T>
+    T block_on(UsTask<T> task)
+    {
+        task.start();
+        while (!task.done()) {
+            if (!run_once())
+                idle();
+        }
+        return task.await_resume();
+    }
+
+    /** @brief Spawned tasks that have not finished yet. */
+    size_t active() const { return roots_.size(); }
+
+    /** @brief Coroutine resumptions since construction. */
+    uint64_t resumptions() const { return resumptions_; }
+
+    /** @brief Current time of the executor clock (us). */
+    int64_t now_us() const;
+
+private:
+    /** @internal */
+    struct Timer
+    {
+        int64_t wake_us;
+        uint64_t seq;
+        std::coroutine_handle<> handle;
+
+        bool operator>(const Timer &other) const
+        {
+            return (wake_us != other.wake_us) ? wake_us > other.wake_us : seq > other.seq;
+        }
+    };
+
+    /** @internal Coroutine frame owning a spawned task. */
+    struct Root
+    {
+        struct promise_type
+        {
+            UsExecutor *exec = nullptr;
+            std::list<std::coroutine_handle<>>::iterator self;
+
+            Root get_return_object() { return Root{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::abort(); }
+            ~promise_type()
+            {
+                if (exec != nullptr)
+                    exec->forget(self);
+            }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    /** @internal */
+    static Root run_root(UsTask<void> task);
+    /** @internal */
+    void forget(std::list<std::coroutine_handle<>>::iterator it);
+    /** @internal */
+    void schedule(std::coroutine_handle<> h) { ready_.push_back(h); }
+    /** @internal */
+    void schedule_at(int64_t wake_us, std::coroutine_handle<> h);
+    /** @internal */
+    void idle();
+
+    /** @internal */
+    idf_hals::ITimerHAL &timer_hal_;
+    /** @internal */
+    idf_hals::ISysRomHAL &sys_rom_hal_;
+    /** @internal */
+    idf_hals::IHalFreertos &freertos_hal_;
+    /** @internal */
+    uint32_t poll_us_;
+    /** @internal */
+    std::deque<std::coroutine_handle<>> ready_;
+    /** @internal */
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    /** @internal */
+    std::list<std::coroutine_handle<>> roots_;
+    /** @internal */
+    uint64_t timer_seq_ = 0;
+    /** @internal */
+    uint64_t resumptions_ = 0;
+    /** @internal */
+    bool destroying_ = false;
+};
+
+} // namespace ultrasonic
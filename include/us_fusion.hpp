@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "us_sensor.hpp"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Voting parameters of a UsFusion.
+ */
+struct UsFusionConfig
+{
+    uint8_t pings_per_sensor = 3; /**< Burst length run on each sensor (clamped to [1, 15]). */
+    float agree_cm = 3.0f;        /**< Largest distance from the consensus at which a sensor agrees (cm). */
+    uint8_t quorum = 2;           /**< Agreeing sensors needed for OK, capped at the number of sensors. */
+    uint8_t fault_after = 3;      /**< Consecutive strikes after which a sensor is reported faulty (0 = never). */
+};
+
+/**
+ * @brief Result of one fused measurement.
+ *
+ * Bit i of the masks refers to the i-th sensor added.
+ */
+struct FusedReading
+{
+    Reading reading;            /**< Fused distance and result. */
+    uint8_t sensors = 0;        /**< Sensors whose burst succeeded (OK or WEAK_SIGNAL). */
+    uint8_t agreeing = 0;       /**< Successful sensors within agree_cm of the consensus. */
+    uint8_t samples = 0;        /**< Pings behind the fused distance, summed over the agreeing sensors. */
+    uint8_t disagree_mask = 0;  /**< Successful sensors outside agree_cm of the consensus. */
+    uint8_t failed_mask = 0;    /**< Sensors whose burst failed. */
+    uint8_t faulty_mask = 0;    /**< Sensors with fault_after or more consecutive strikes. */
+    float spread_cm = 0.0f;     /**< Largest distance of an agreeing sensor from the fused distance (cm). */
+};
+
+/**
+ * @brief Votes across redundant sensors measuring the same surface.
+ *
+ * Each read_distance() runs a short burst on every sensor and takes a
+ * weighted median of their distances, each weighted by the pings its burst
+ * kept. The sensors within agree_cm of that median form the consensus, and
+ * the fused distance is their weighted mean. It pools the pings of every
+ * agreeing sensor, so a few pings per sensor give the confidence of a long
+ * single-sensor burst, and a sensor that reads another surface cannot pull
+ * the result.
+ *
+ * A sensor earns a strike when its burst fails while another sensor
+ * succeeds, or when it disagrees with a quorum. A sensor in an accepted
+ * consensus (OK or WEAK_SIGNAL) has its strikes cleared. After
+ * fault_after consecutive strikes it is reported in faulty_mask. A faulty
+ * sensor keeps being measured and voting, so it recovers on its own once it
+ * agrees again.
+ *
+ * Sensors aimed at the same surface hear each other's bursts, so the bursts
+ * run one after another rather than at the same time.
+ */
+class UsFusion
+{
+public:
+    /** @brief Maximum number of sensors voting together. */
+    static constexpr size_t MAX_SENSORS = 4;
+
+    explicit UsFusion(const UsFusionConfig &cfg = UsFusionConfig{});
+
+    /**
+     * @brief Add a sensor to the vote.
+     *
+     * The sensor must be initialised by the caller and outlive the fusion.
+     *
+     * @param sensor Sensor to add.
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_ARG: sensor is nullptr or already added
+     *     - ESP_ERR_NO_MEM: MAX_SENSORS sensors are already added
+     */
+    esp_err_t add_sensor(UsSensor *sensor);
+
+    /** @brief Number of sensors added. */
+    size_t sensor_count() const { return count_; }
+
+    /**
+     * @brief Run a pings_per_sensor burst on every sensor and vote.
+     *
+     * The result is:
+     *     - OK: at least quorum sensors agree
+     *     - WEAK_SIGNAL: fewer than quorum succeeded and all of them agree
+     *     - HIGH_VARIANCE: the successful sensors disagree and no quorum agrees
+     *     - The most frequent failure: no sensor succeeded
+     *     - INSUFFICIENT_SAMPLES: no sensors added
+     */
+    FusedReading read_distance();
+
+    /**
+     * @brief Vote on bursts measured elsewhere, one per sensor in order.
+     *
+     * Updates the strikes like read_distance(). Bursts beyond MAX_SENSORS
+     * are ignored.
+     */
+    FusedReading combine(const MeasurementInfo *bursts, size_t count);
+
+    /** @brief Sensors currently reported faulty. */
+    uint8_t faulty_mask() const;
+
+    /** @brief Clear every strike. */
+    void reset_faults();
+
+    /** @brief Voting parameters. */
+    const UsFusionConfig &config() const { return cfg_; }
+
+private:
+    /** @internal */
+    UsFusionConfig cfg_;
+    /** @internal */
+    UsSensor *sensors_[MAX_SENSORS] = {};
+    /** @internal */
+    size_t count_ = 0;
+    /** @internal Consecutive strikes per sensor. */
+    uint8_t strikes_[MAX_SENSORS] = {};
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "i_us_gpio_bulk.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief IUsGpioBulk backed by the GPIO input registers.
+ *
+ * On the chip this reads GPIO_IN_REG, and GPIO_IN1_REG on targets with more
+ * than 32 GPIOs. The pins must be configured as inputs (UsMultiDriver::init()
+ * does this for its ECHO pins). The linux target has no GPIOs, so every
+ * input reads LOW there.
+ */
+class UsGpioInputRegister : public IUsGpioBulk
+{
+public:
+    /** @copydoc IUsGpioBulk::read_inputs() */
+    uint64_t read_inputs() override;
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "esp_err.h"
+#include "i_us_history_storage.hpp"
+#include "i_us_reading_sink.hpp"
+#include "us_packed_reading.hpp"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief One entry of the reading history.
+ */
+struct HistorySample
+{
+    int64_t timestamp_us = 0; /**< Time the reading was published (us). */
+    PackedReading reading;    /**< Result and distance. */
+};
+
+/**
+ * @brief Header at the start of every history block.
+ *
+ * The first sample of a block is stored verbatim in the header, so every
+ * block decodes on its own. Each further sample is two zigzag varints: the
+ * delta-of-delta of the timestamp and the delta of the PackedReading bits.
+ * With a steady ping rate and a slowly moving target both stay small.
+ * All fields are little-endian.
+ */
+struct HistoryBlockHeader
+{
+    uint32_t magic;       /**< HISTORY_MAGIC. */
+    uint32_t seq;         /**< Block sequence number, increasing by one per block. */
+    int64_t first_us;     /**< Timestamp of the first sample. */
+    int64_t last_us;      /**< Timestamp of the last sample. */
+    uint32_t first_bits;  /**< PackedReading of the first sample. */
+    uint16_t count;       /**< Number of samples in the block. */
+    uint16_t used;        /**< Bytes used, header included. */
+};
+
+static_assert(sizeof(HistoryBlockHeader) == 32, "HistoryBlockHeader layout is part of the storage format");
+
+/** @brief "USHB" in little-endian byte order. */
+static constexpr uint32_t HISTORY_MAGIC = 0x42485355;
+
+/** @brief Bytes per sample when stored uncompressed (Reading plus timestamp). */
+static constexpr size_t HISTORY_RAW_SAMPLE_BYTES = sizeof(Reading) + sizeof(int64_t);
+
+/**
+ * @brief Counters describing the history and its compression.
+ */
+struct UsHistoryStats
+{
+    uint32_t appended = 0;       /**< Samples appended since init(). */
+    uint32_t retained = 0;       /**< Samples currently stored (older blocks are overwritten). */
+    uint32_t dropped = 0;        /**< Samples rejected (out of order, storage failure). */
+    uint32_t blocks_written = 0; /**< Block writes to the storage. */
+    uint32_t blocks_decoded = 0; /**< Blocks decoded by query(). */
+    uint64_t stored_bytes = 0;   /**< Storage taken by the retained samples (full blocks count whole). */
+};
+
+/**
+ * @brief Compressed ring buffer of readings on top of an IUsHistoryStorage.
+ *
+ * Samples are delta encoded into blocks. The newest block is kept in RAM and
+ * written out when it is full or on flush(); when the ring is full the oldest
+ * block is overwritten. A range query reads block headers to find the blocks
+ * that overlap the range and decodes only those.
+ *
+ * UsHistory is an IUsReadingSink, so it can be attached to a UsSensor with
+ * UsSensor::add_reading_sink(). All methods are thread-safe.
+ */
+class UsHistory : public IUsReadingSink
+{
+public:
+    /** @brief Smallest supported block size in bytes. */
+    static constexpr size_t MIN_BLOCK_SIZE = 64;
+    /** @brief Largest supported block size in bytes. */
+    static constexpr size_t MAX_BLOCK_SIZE = UINT16_MAX;
+
+    /**
+     * @brief Construct a history.
+     * @param storage Block storage. Must outlive the history.
+     */
+    explicit UsHistory(IUsHistoryStorage &storage);
+    ~UsHistory() override = default;
+
+    UsHistory(const UsHistory &) = delete;
+    UsHistory &operator=(const UsHistory &) = delete;
+
+    /**
+     * @brief Scan the storage and resume after its newest block.
+     *
+     * Blank or foreign blocks are ignored, so a fresh storage starts empty.
+     *
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_SIZE: Block size out of range or fewer than two blocks
+     *     - ESP_ERR_NO_MEM: Block buffers could not be allocated
+     *     - ESP_FAIL: The storage failed
+     */
+    esp_err_t init();
+
+    /**
+     * @brief Append a reading.
+     *
+     * @param timestamp_us Time of the reading; must not be before the previous one.
+     * @param reading      Reading to store (packed, see PackedReading).
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_STATE: init() has not succeeded
+     *     - ESP_ERR_INVALID_ARG: Timestamp older than the previous sample
+     *     - ESP_FAIL: Writing a full block failed
+     */
+    esp_err_t append(int64_t timestamp_us, const Reading &reading);
+
+    /** @brief Append a published reading; errors are counted in UsHistoryStats::dropped. */
+    void on_reading(const TimedReading &reading) override;
+
+    /**
+     * @brief Write the partially filled newest block to the storage.
+     * @return ESP_OK on success (or nothing to write), ESP_FAIL if the storage failed.
+     */
+    esp_err_t flush();
+
+    /**
+     * @brief Copy the samples with from_us <= timestamp <= to_us, oldest first.
+     *
+     * @param from_us First timestamp of the range.
+     * @param to_us   Last timestamp of the range.
+     * @param out     Output array.
+     * @param max_out Capacity of @p out. The query stops when it is full.
+     * @return Number of samples copied.
+     */
+    size_t query(int64_t from_us, int64_t to_us, HistorySample *out, size_t max_out);
+
+    /** @brief Counters since init(). */
+    UsHistoryStats stats() const;
+
+    /** @brief Uncompressed size divided by stored size of the retained samples (0 if empty). */
+    float compression_ratio() const;
+
+    /** @brief Stored bytes per retained sample (0 if empty). */
+    float bytes_per_sample() const;
+
+private:
+    /** @internal */
+    bool read_header(uint32_t seq, HistoryBlockHeader &header);
+    /** @internal */
+    void start_block(uint32_t seq, int64_t timestamp_us, uint32_t bits);
+    /** @internal */
+    esp_err_t seal_block();
+    /** @internal */
+    void decode_into(const HistoryBlockHeader &header, const uint8_t *block, int64_t from_us, int64_t to_us, HistorySample *out, size_t max_out,
+                     size_t &n);
+
+    /** @internal */
+    IUsHistoryStorage &storage_;
+    /** @internal */
+    mutable std::mutex mutex_;
+    /** @internal */
+    std::unique_ptr<uint8_t[]> head_;
+    /** @internal */
+    std::unique_ptr<uint8_t[]> scratch_;
+    /** @internal */
+    size_t block_size_ = 0;
+    /** @internal */
+    uint32_t block_count_ = 0;
+    /** @internal Header of the block in head_ (copied into it when written out). */
+    HistoryBlockHeader head_hdr_ = {};
+    /** @internal Sequence number of the block in head_. */
+    uint32_t head_seq_ = 0;
+    /** @internal Oldest block still in the storage; blocks [oldest_seq_, head_seq_) are sealed. */
+    uint32_t oldest_seq_ = 0;
+    /** @internal */
+    int64_t prev_us_ = 0;
+    /** @internal */
+    int64_t prev_delta_us_ = 0;
+    /** @internal */
+    uint32_t prev_bits_ = 0;
+    /** @internal */
+    UsHistoryStats stats_;
+};
+
+/**
+ * @brief IUsHistoryStorage kept in RAM.
+ */
+class UsHistoryRamStorage : public IUsHistoryStorage
+{
+public:
+    /**
+     * @brief Allocate a zeroed storage area.
+     * @param block_size  Size of one block in bytes.
+     * @param block_count Number of blocks.
+     */
+    UsHistoryRamStorage(size_t block_size, uint32_t block_count);
+
+    /** @copydoc IUsHistoryStorage::block_size() */
+    size_t block_size() const override { return block_size_; }
+
+    /** @copydoc IUsHistoryStorage::block_count() */
+    uint32_t block_count() const override { return block_count_; }
+
+    /** @copydoc IUsHistoryStorage::read() */
+    esp_err_t read(uint32_t block, size_t offset, void *dst, size_t len) override;
+
+    /** @copydoc IUsHistoryStorage::write() */
+    esp_err_t write(uint32_t block, const void *src, size_t len) override;
+
+private:
+    /** @internal */
+    std::unique_ptr<uint8_t[]> data_;
+    /** @internal */
+    size_t block_size_;
+    /** @internal */
+    uint32_t block_count_;
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "esp_err.h"
+#include "i_us_history_storage.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief IUsHistoryStorage backed by a file.
+ *
+ * Works with any stdio path: a LittleFS/FAT partition on the device, so the
+ * history survives a reboot, or a regular file on the linux target.
+ */
+class UsHistoryFileStorage : public IUsHistoryStorage
+{
+public:
+    UsHistoryFileStorage() = default;
+    ~UsHistoryFileStorage() override;
+
+    UsHistoryFileStorage(const UsHistoryFileStorage &) = delete;
+    UsHistoryFileStorage &operator=(const UsHistoryFileStorage &) = delete;
+
+    /**
+     * @brief Open an existing history file, or create it.
+     *
+     * The file is extended to block_size * block_count bytes. An existing
+     * file must have been created with the same geometry for UsHistory to
+     * find its blocks again.
+     *
+     * @param path        File path.
+     * @param block_size  Size of one block in bytes.
+     * @param block_count Number of blocks.
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_STATE: A file is already open
+     *     - ESP_ERR_INVALID_ARG: Zero block size or count
+     *     - ESP_FAIL: The file could not be opened or extended
+     */
+    esp_err_t open(const char *path, size_t block_size, uint32_t block_count);
+
+    /** @brief Close the file. */
+    void close();
+
+    /** @copydoc IUsHistoryStorage::block_size() */
+    size_t block_size() const override { return block_size_; }
+
+    /** @copydoc IUsHistoryStorage::block_count() */
+    uint32_t block_count() const override { return block_count_; }
+
+    /** @copydoc IUsHistoryStorage::read() */
+    esp_err_t read(uint32_t block, size_t offset, void *dst, size_t len) override;
+
+    /** @copydoc IUsHistoryStorage::write() */
+    esp_err_t write(uint32_t block, const void *src, size_t len) override;
+
+private:
+    /** @internal */
+    FILE *file_ = nullptr;
+    /** @internal */
+    size_t block_size_ = 0;
+    /** @internal */
+    uint32_t block_count_ = 0;
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ultrasonic {
+
+/**
+ * @brief Seeded pseudo-random sequence of trigger delays (xorshift32).
+ *
+ * Each sensor draws a random delay before every trigger. Co-located sensors
+ * with different seeds then drift in and out of phase instead of staying
+ * aligned, so an echo from a neighbour lands at a different apparent
+ * distance on every ping. The sequence is deterministic per seed, which
+ * lets host simulations predict the trigger times.
+ */
+class UsJitter
+{
+public:
+    /**
+     * @brief Construct a generator.
+     * @param seed Sequence seed. Zero is mapped to a fixed non-zero value.
+     */
+    explicit UsJitter(uint32_t seed = 1) { reseed(seed); }
+
+    /**
+     * @brief Restart the sequence from @p seed.
+     * @param seed Sequence seed. Zero is mapped to a fixed non-zero value.
+     */
+    void reseed(uint32_t seed)
+    {
+        seed_ = seed;
+        state_ = (seed != 0) ? seed : DEFAULT_STATE;
+    }
+
+    /** @brief Seed the sequence was last started from. */
+    uint32_t seed() const { return seed_; }
+
+    /** @brief Next raw 32-bit value. */
+    uint32_t next()
+    {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 17;
+        state_ ^= state_ << 5;
+        return state_;
+    }
+
+    /**
+     * @brief Next delay, uniform in [0, max_us].
+     * @param max_us Upper bound (us). Zero always yields zero.
+     */
+    uint32_t next_delay_us(uint32_t max_us) { return (max_us == 0) ? 0 : next() % (max_us + 1); }
+
+private:
+    /** @internal State used for a zero seed (zero is a fixed point of xorshift). */
+    static constexpr uint32_t DEFAULT_STATE = 0x9E3779B9u;
+
+    /** @internal */
+    uint32_t seed_ = 0;
+    /** @internal */
+    uint32_t state_ = DEFAULT_STATE;
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "esp_err.h"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Fixed-memory log-linear latency histogram (HDR style), in microseconds.
+ *
+ * Values below SUB_COUNT get one bucket each. Above that, every power of two
+ * is split into SUB_COUNT equal buckets, so a bucket is at most 1/SUB_COUNT
+ * (6.25%) of its lower bound wide, whatever the magnitude. Values from
+ * 2^MAX_EXPONENT us (134 s) share the last bucket. Count, sum, minimum and
+ * maximum are kept exactly.
+ *
+ * Histograms with the same layout merge by adding their buckets, so the
+ * histograms of many nodes can be combined into one distribution. encode()
+ * and decode() carry them over the network in a compact sparse form.
+ *
+ * Not thread-safe; UsLatencyStats adds the locking.
+ */
+class UsLatencyHistogram
+{
+public:
+    static constexpr uint32_t SUB_BITS = 4;                      /**< log2 of the buckets per power of two. */
+    static constexpr uint32_t SUB_COUNT = 1u << SUB_BITS;        /**< Buckets per power of two. */
+    static constexpr uint32_t MAX_EXPONENT = 27;                 /**< Values from 2^MAX_EXPONENT us share the last bucket. */
+    static constexpr size_t BUCKETS = SUB_COUNT * (MAX_EXPONENT - SUB_BITS + 1); /**< Number of buckets (384). */
+
+    /** @brief Largest output of encode(). */
+    static constexpr size_t MAX_ENCODED_BYTES = 4 + 10 + 5 + 5 + 2 + BUCKETS * (2 + 5);
+
+    UsLatencyHistogram() { reset(); }
+
+    /** @brief Forget all samples. */
+    void reset();
+
+    /** @brief Add one sample (us). */
+    void record(uint32_t us);
+
+    /** @brief Add all samples of @p other. */
+    void merge(const UsLatencyHistogram &other);
+
+    /** @brief Number of samples. */
+    uint64_t count() const { return count_; }
+
+    /** @brief Smallest sample (0 without samples). */
+    uint32_t min() const { return (count_ > 0) ? min_ : 0; }
+
+    /** @brief Largest sample (0 without samples). */
+    uint32_t max() const { return max_; }
+
+    /** @brief Mean of the samples (0 without samples). */
+    double mean() const { return (count_ > 0) ? static_cast<double>(sum_us_) / static_cast<double>(count_) : 0.0; }
+
+    /**
+     * @brief Value at quantile @p q.
+     *
+     * Returns the upper bound of the bucket holding the sample of rank
+     * ceil(q * count()), clamped to [min(), max()]. The true quantile lies in
+     * the same bucket, so it is overestimated by less than one bucket width.
+     *
+     * @param q Quantile in [0, 1], e.g. 0.99. Values outside are clamped.
+     * @return Latency in us (0 without samples).
+     */
+    uint32_t percentile(double q) const;
+
+    /** @brief Samples in bucket @p index. */
+    uint32_t bucket_count(size_t index) const { return (index < BUCKETS) ? counts_[index] : 0; }
+
+    /** @brief Bucket that holds @p us. */
+    static size_t bucket_of(uint32_t us);
+
+    /** @brief Smallest value of bucket @p index. */
+    static uint32_t bucket_low(size_t index);
+
+    /** @brief Largest value of bucket @p index (UINT32_MAX for the last one). */
+    static uint32_t bucket_high(size_t index);
+
+    /**
+     * @brief Serialize into @p buf.
+     *
+     * Layout: a 4-byte header (magic, version, SUB_BITS, MAX_EXPONENT), then
+     * varints for the sum, minimum, maximum and number of non-empty buckets,
+     * and for each non-empty bucket the index gap to the previous one and
+     * its count.
+     *
+     * @param buf  Output buffer; MAX_ENCODED_BYTES always suffice.
+     * @param size Size of @p buf in bytes.
+     * @return Bytes written, or 0 if @p buf is too small.
+     */
+    size_t encode(uint8_t *buf, size_t size) const;
+
+    /**
+     * @brief Replace the contents with a histogram written by encode().
+     * @param buf Encoded histogram.
+     * @param len Length of @p buf in bytes.
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_VERSION: Header from another format or bucket layout
+     *     - ESP_ERR_INVALID_SIZE: Truncated or corrupt input (contents unchanged)
+     */
+    esp_err_t decode(const uint8_t *buf, size_t len);
+
+private:
+    /** @internal */
+    uint32_t counts_[BUCKETS];
+    /** @internal */
+    uint64_t count_;
+    /** @internal */
+    uint64_t sum_us_;
+    /** @internal */
+    uint32_t min_;
+    /** @internal */
+    uint32_t max_;
+};
+
+/**
+ * @brief Latency histograms of ping_once() and read_distance(), per final result.
+ *
+ * Attached to a UsSensor with set_latency_stats(). Recording and the queries
+ * take an internal mutex, so the histograms can be read or merged from any
+ * task. The histograms take about 25 KB, so allocate the object statically
+ * or on the heap.
+ */
+class UsLatencyStats
+{
+public:
+    UsLatencyStats() = default;
+
+    UsLatencyStats(const UsLatencyStats &) = delete;
+    UsLatencyStats &operator=(const UsLatencyStats &) = delete;
+
+    /** @brief Record the wall time of one ping. */
+    void record_ping(UsResult result, uint32_t us);
+
+    /** @brief Record the wall time of one read_distance() or measure(). */
+    void record_read(UsResult result, uint32_t us);
+
+    /**
+     * @brief Copy the ping histogram of one result.
+     * @param result Result of the pings.
+     * @param out    Receives the histogram (emptied for unknown results).
+     */
+    void ping(UsResult result, UsLatencyHistogram &out) const;
+
+    /** @brief Copy the read histogram of one result. */
+    void read(UsResult result, UsLatencyHistogram &out) const;
+
+    /** @brief Ping histograms of all results merged into @p out. */
+    void pings(UsLatencyHistogram &out) const;
+
+    /** @brief Read histograms of all results merged into @p out. */
+    void reads(UsLatencyHistogram &out) const;
+
+    /** @brief Add all histograms of @p other, result by result. */
+    void merge(const UsLatencyStats &other);
+
+    /** @brief Empty all histograms. */
+    void reset();
+
+private:
+    /** @internal */
+    mutable std::mutex mutex_;
+    /** @internal */
+    UsLatencyHistogram ping_[US_RESULT_COUNT];
+    /** @internal */
+    UsLatencyHistogram read_[US_RESULT_COUNT];
+};
+
+} // namespace ultrasonic
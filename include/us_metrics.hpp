@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "i_us_processor.hpp"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/** @brief Buckets of the per-burst valid-ping ratio histogram, 10% wide. */
+static constexpr size_t VALID_RATIO_BUCKETS = 10;
+
+/**
+ * @brief Snapshot of the cumulative outcome counters of a sensor.
+ *
+ * Index the result arrays by the UsResult value. A burst is one call of
+ * read_distance() or measure(), and its pings are the pings it fired.
+ */
+struct UsMetrics
+{
+    uint32_t ping_results[US_RESULT_COUNT] = {};  /**< Pings per result reported by the driver. */
+    uint32_t burst_results[US_RESULT_COUNT] = {}; /**< Bursts per final result. */
+
+    /**
+     * Bursts by share of successful pings. Bucket i holds ratios in
+     * (i/10, (i+1)/10]; bucket 0 also holds bursts without a successful ping.
+     * Bursts that fired no ping are not counted.
+     */
+    uint32_t valid_ratio[VALID_RATIO_BUCKETS] = {};
+    uint64_t valid_ratio_sum_ppm = 0; /**< Sum of the per-burst ratios, in parts per million. */
+
+    uint32_t pings_per_burst[IUsProcessor::MAX_PINGS + 1] = {}; /**< Bursts by number of pings fired. */
+
+    /** @brief Total pings fired. */
+    uint32_t pings() const;
+
+    /** @brief Total bursts. */
+    uint32_t bursts() const;
+
+    /** @brief Successful pings over all pings (0 without pings). */
+    float mean_valid_ratio() const;
+};
+
+/**
+ * @brief Lock-free cumulative outcome counters.
+ *
+ * Written by the task running the bursts and read from any task. Every
+ * counter is an independent relaxed atomic, so a snapshot taken during a
+ * burst may include part of it. reset() is not atomic with respect to a
+ * running burst either.
+ */
+class UsMetricsCounters
+{
+public:
+    UsMetricsCounters() { reset(); }
+
+    UsMetricsCounters(const UsMetricsCounters &) = delete;
+    UsMetricsCounters &operator=(const UsMetricsCounters &) = delete;
+
+    /**
+     * @brief Count one burst.
+     * @param pings  Pings fired, as returned by the driver.
+     * @param count  Number of pings fired (may be 0).
+     * @param result Final result of the burst.
+     */
+    void add_burst(const Reading *pings, uint8_t count, const Reading &result);
+
+    /** @brief Copy of all counters. */
+    UsMetrics snapshot() const;
+
+    /** @brief Zero all counters. */
+    void reset();
+
+private:
+    /** @internal */
+    std::atomic<uint32_t> ping_results_[US_RESULT_COUNT];
+    /** @internal */
+    std::atomic<uint32_t> burst_results_[US_RESULT_COUNT];
+    /** @internal */
+    std::atomic<uint32_t> valid_ratio_[VALID_RATIO_BUCKETS];
+    /** @internal */
+    std::atomic<uint64_t> valid_ratio_sum_ppm_;
+    /** @internal */
+    std::atomic<uint32_t> pings_per_burst_[IUsProcessor::MAX_PINGS + 1];
+};
+
+/**
+ * @brief Lowercase name of a result, as used in the metric outputs ("timeout").
+ * @return Name, or "unknown" for values outside UsResult.
+ */
+const char *result_name(UsResult result);
+
+/**
+ * @brief Serialize metrics as compact JSON.
+ *
+ * Example: `{"pings":{"ok":41,...},"bursts":{...},"valid_ratio":[0,...,9],
+ * "valid_ratio_sum":8.75,"pings_per_burst":[0,...],"mean_valid_ratio":0.911}`.
+ * Behaves like snprintf(): the output is always NUL-terminated and truncated
+ * to @p size, and the full length is returned.
+ *
+ * @param metrics Snapshot to write.
+ * @param buf     Output buffer (may be nullptr if @p size is 0).
+ * @param size    Size of @p buf in bytes.
+ * @return Length of the full output, excluding the terminating NUL.
+ */
+size_t metrics_to_json(const UsMetrics &metrics, char *buf, size_t size);
+
+/**
+ * @brief Serialize metrics in the Prometheus text exposition format.
+ *
+ * Writes the counters us_pings_total and us_bursts_total (label result) and
+ * the histograms us_burst_valid_ratio and us_burst_pings. Every sample gets
+ * a sensor label when @p sensor is not nullptr. Truncation and return value
+ * as for metrics_to_json().
+ *
+ * @param metrics Snapshot to write.
+ * @param sensor  Value of the sensor label, or nullptr for none.
+ * @param buf     Output buffer (may be nullptr if @p size is 0).
+ * @param size    Size of @p buf in bytes.
+ * @return Length of the full output, excluding the terminating NUL.
+ */
+size_t metrics_to_prometheus(const UsMetrics &metrics, const char *sensor, char *buf, size_t size);
+
+} // namespace ultrasonic
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "i_us_gpio_bulk.hpp"
+#include "us_compiled_config.hpp"
+#include "us_types.hpp"
+#include "interfaces/i_hal_gpio.hpp"
+#include "interfaces/i_hal_sys_rom.hpp"
+#include "interfaces/i_hal_timer.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief TRIG and ECHO pins of one UsMultiDriver channel.
+ */
+struct UsChannelPins
+{
+    gpio_num_t trig_pin;
+    gpio_num_t echo_pin;
+};
+
+/**
+ * @brief Pings several HC-SR04-compatible sensors at once from one polling loop.
+ *
+ * ping_all() triggers every channel together and then watches all ECHO pins
+ * with one IUsGpioBulk::read_inputs() per iteration, timestamping each
+ * channel's edges on its own. N sensors are measured in the time of the
+ * longest echo instead of the sum of all of them.
+ *
+ * The sensors fire at the same moment, so they must not hear each other:
+ * point them apart or use it for sensors in separate spaces. Co-located
+ * sensors that share an acoustic space need separate UsDriver instances with
+ * trigger jitter instead (see "Concurrent Firing" in API.md).
+ *
+ * Compared to UsDriver the loop always spins, and there is no ECHO_STUCK
+ * recovery, tracking gate or multi-echo capture. A channel found stuck HIGH
+ * is reported and left out of that ping.
+ */
+class UsMultiDriver
+{
+public:
+    /** @brief Most channels one driver handles. */
+    static constexpr size_t MAX_CHANNELS = 8;
+
+    /**
+     * @param channels Pins of each channel; copied. At most MAX_CHANNELS,
+     *                 ECHO pins distinct and below 64.
+     * @param count    Number of channels.
+     */
+    UsMultiDriver(
+        idf_hals::IGpioHAL &gpio_hal,
+        idf_hals::ITimerHAL &timer_hal,
+        idf_hals::ISysRomHAL &sys_rom_hal,
+        IUsGpioBulk &gpio_bulk,
+        const UsChannelPins *channels,
+        size_t count);
+
+    /**
+     * @brief Configure every TRIG pin as output LOW and every ECHO pin as input.
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_ARG: No channels, more than MAX_CHANNELS, an ECHO
+     *       pin above 63 or used twice
+     *     - Other: errors from the GPIO HAL
+     */
+    esp_err_t init();
+
+    /** @brief Drive the TRIG pins LOW and reset all pins. */
+    esp_err_t deinit();
+
+    /** @brief Number of channels. */
+    size_t channel_count() const { return count_; }
+
+    /**
+     * @brief Trigger every channel and measure all echoes in one loop.
+     *
+     * Each channel gets OK, OUT_OF_RANGE, TIMEOUT (no rising edge within
+     * timeout_us of the trigger, or a pulse longer than timeout_us),
+     * ECHO_STUCK or HW_FAULT (its TRIG pin could not be driven). The call
+     * returns once every channel has a result.
+     *
+     * @param cc       Compiled configuration shared by all channels.
+     * @param readings One entry per channel, in channel order.
+     */
+    void ping_all(const UsCompiledConfig &cc, Reading *readings);
+
+    /** @brief Same, compiling @p cfg on every call. Loops should keep a UsCompiledConfig. */
+    void ping_all(const UsConfig &cfg, Reading *readings);
+
+    /** @brief Raw echo width of a channel's last ping (us), 0 if no falling edge was seen. */
+    uint32_t last_echo_us(size_t channel) const { return (channel < count_) ? channels_[channel].last_echo_us : 0; }
+
+private:
+    /** @internal */
+    enum class Phase : uint8_t
+    {
+        DONE,
+        WAIT_RISE,
+        WAIT_FALL,
+    };
+
+    /** @internal */
+    struct Channel
+    {
+        UsChannelPins pins;
+        uint64_t echo_mask = 0;
+        Phase phase = Phase::DONE;
+        int64_t rise_us = 0;
+        uint32_t last_echo_us = 0;
+    };
+
+    /** @internal */
+    esp_err_t configure(gpio_num_t pin, gpio_mode_t mode);
+
+    /** @internal */
+    idf_hals::IGpioHAL &gpio_hal_;
+    /** @internal */
+    idf_hals::ITimerHAL &timer_hal_;
+    /** @internal */
+    idf_hals::ISysRomHAL &sys_rom_hal_;
+    /** @internal */
+    IUsGpioBulk &gpio_bulk_;
+
+    /** @internal */
+    Channel channels_[MAX_CHANNELS];
+    /** @internal */
+    size_t count_ = 0;
+    /** @internal The channel list passed to the constructor is usable. */
+    bool pins_ok_ = false;
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Reading packed into 4 bytes for large in-memory histories.
+ *
+ * Bits 0-2 hold the UsResult, bits 3-31 the distance in micrometres
+ * (0 to 536.87 m). A Reading is half the size with padding, so history
+ * buffers and host analytics get twice the density.
+ *
+ * Packing rounds the distance to the nearest micrometre, far below the
+ * ~0.17 mm that one microsecond of echo corresponds to. Negative and
+ * non-finite distances pack as 0, distances beyond the range saturate.
+ * Below 512 cm a float has sub-micrometre resolution, so
+ * pack(unpack()) returns the same bits.
+ */
+struct PackedReading
+{
+    static constexpr uint32_t RESULT_BITS = 3;                       /**< Width of the result field. */
+    static constexpr uint32_t RESULT_MASK = (1u << RESULT_BITS) - 1; /**< Result field mask. */
+    static constexpr uint32_t MAX_UM = UINT32_MAX >> RESULT_BITS;    /**< Largest distance (um). */
+
+    uint32_t bits = 0; /**< Raw packed value. */
+
+    /** @brief Pack a result and a distance already in micrometres. */
+    static constexpr PackedReading from_um(UsResult result, uint32_t um)
+    {
+        return PackedReading{((um > MAX_UM ? MAX_UM : um) << RESULT_BITS) | static_cast<uint32_t>(result)};
+    }
+
+    /** @brief Pack a Reading (distance rounded to the nearest micrometre). */
+    static PackedReading pack(const Reading &r)
+    {
+        double um = static_cast<double>(r.cm) * 10000.0;
+        uint32_t rounded = 0;
+        if (um > 0.0) { // also false for NaN
+            rounded = (um >= MAX_UM) ? MAX_UM : static_cast<uint32_t>(std::lround(um));
+        }
+        return from_um(r.result, rounded);
+    }
+
+    /** @brief Result code. */
+    constexpr UsResult result() const { return static_cast<UsResult>(bits & RESULT_MASK); }
+
+    /** @brief Distance in micrometres. */
+    constexpr uint32_t um() const { return bits >> RESULT_BITS; }
+
+    /** @brief Distance in centimetres. */
+    float cm() const { return static_cast<float>(um() / 10000.0); }
+
+    /** @brief Expand to a Reading. */
+    Reading unpack() const { return {result(), cm()}; }
+
+    /** @internal */
+    constexpr bool operator==(const PackedReading &other) const { return bits == other.bits; }
+
+    /** @internal */
+    constexpr bool operator!=(const PackedReading &other) const { return bits != other.bits; }
+};
+
+static_assert(sizeof(PackedReading) == 4, "PackedReading must stay 4 bytes");
+static_assert(static_cast<uint32_t>(UsResult::HW_FAULT) <= PackedReading::RESULT_MASK,
+              "UsResult no longer fits the packed result field");
+
+} // namespace ultrasonic
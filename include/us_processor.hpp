@@ -20,12 +20,29 @@ public:
     /** @copydoc IUsProcessor::process() */
     Reading process(const Reading *pings, uint8_t total_pings, const UsConfig &cfg) override;
 
+    /** @copydoc IUsProcessor::process_packed() */
+    Reading process_packed(const PackedReading *pings, uint8_t total_pings, const UsConfig &cfg) override;
+
+    /** @copydoc IUsProcessor::process_compiled() */
+    Reading process_compiled(const Reading *pings, uint8_t total_pings, const UsCompiledConfig &cc) override;
+
+    /** @copydoc IUsProcessor::process_ex() */
+    Reading process_ex(const Reading *pings, uint8_t total_pings, const UsCompiledConfig &cc,
+                       MeasurementInfo &info) override;
+
 private:
+    /** @internal */
+    template <typename Ping>
+    Reading process_pings(const Ping *pings, uint8_t total_pings, const UsCompiledConfig &cc, MeasurementInfo *info);
+
     /** @internal */
     float reduce_median(float *v, std::size_t n);
 
     /** @internal */
-    float reduce_dominant_cluster(float *v, std::size_t n);
+    float reduce_dominant_cluster(float *v, std::size_t n, uint8_t &used);
+
+    /** @internal */
+    uint8_t reject_uncorrelated(float *v, uint8_t n);
 
     /** @internal */
     float get_std_dev(const float *samples, uint8_t count);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esp_err.h"
+#include "i_us_driver.hpp"
+#include "us_trace.hpp"
+#include "us_trace_file.hpp"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief IUsDriver that plays back recorded pings instead of touching GPIOs.
+ *
+ * Inject it into UsSensor through the dependency-injection constructor to run
+ * a field trace through the real UsSensor/UsProcessor. Pings that carry a raw
+ * echo are re-converted and range-checked against the configuration passed to
+ * ping_once(), so range and filter changes can be evaluated on real data.
+ * Pings without an echo return their recorded result.
+ *
+ * Replay is as fast as the injected IHalFreertos::task_delay() allows; a mock
+ * with no-op delays runs a trace far faster than real time.
+ *
+ * @code
+ * UsReplayDriver::load(reader, records);
+ * auto replay = std::make_shared<UsReplayDriver>(std::move(records));
+ * UsSensor sensor(reader.config(), replay, std::make_shared<UsProcessor>(), freertos);
+ * while (uint8_t n = replay->next_burst_size())
+ *     sensor.read_distance(n);
+ * @endcode
+ */
+class UsReplayDriver : public IUsDriver
+{
+public:
+    /**
+     * @brief Construct a replay driver over an in-memory trace.
+     * @param records Records in file order.
+     */
+    explicit UsReplayDriver(std::vector<TraceRecord> records);
+
+    ~UsReplayDriver() override = default;
+
+    /**
+     * @brief Read all remaining records of an open trace.
+     * @param reader  Open trace reader.
+     * @param records Output vector; records are appended.
+     * @return Number of records appended.
+     */
+    static size_t load(UsTraceReader &reader, std::vector<TraceRecord> &records);
+
+    /**
+     * @brief Re-evaluate a recorded ping against a (possibly different) configuration.
+     *
+     * Pings that measured an echo are converted and range-checked against
+     * @p cc like UsDriver does; all other pings keep their recorded result.
+     *
+     * @param rec Recorded ping.
+     * @param cc  Compiled configuration to evaluate against.
+     * @return The Reading the driver would have produced under @p cc.
+     */
+    static Reading reevaluate(const TraceRecord &rec, const UsCompiledConfig &cc);
+
+    /** @copydoc IUsDriver::init() */
+    esp_err_t init() override { return ESP_OK; }
+
+    /** @copydoc IUsDriver::deinit() */
+    esp_err_t deinit() override { return ESP_OK; }
+
+    /**
+     * @copydoc IUsDriver::ping_once()
+     *
+     * Returns HW_FAULT once the trace is exhausted.
+     */
+    Reading ping_once(const UsConfig &cfg) override;
+
+    /** @copydoc IUsDriver::ping_compiled() */
+    Reading ping_compiled(const UsCompiledConfig &cc) override;
+
+    /** @copydoc IUsDriver::last_echo_us() */
+    uint32_t last_echo_us() const override { return last_echo_us_; }
+
+    /** @copydoc IUsDriver::last_echo_gated() */
+    bool last_echo_gated() const override { return last_echo_gated_; }
+
+    /**
+     * @brief Number of pings recorded in the next burst, or 0 when the trace is exhausted.
+     *
+     * Pass it to read_distance() so that replayed bursts line up with recorded ones.
+     */
+    uint8_t next_burst_size() const;
+
+    /** @brief Recorded timestamp of the next ping, or of the last one once exhausted. */
+    int64_t next_timestamp_us() const;
+
+    /** @brief true when every record has been played back. */
+    bool finished() const { return pos_ >= records_.size(); }
+
+private:
+    /** @internal */
+    std::vector<TraceRecord> records_;
+    /** @internal */
+    size_t pos_ = 0;
+    /** @internal */
+    uint32_t last_echo_us_ = 0;
+    /** @internal */
+    bool last_echo_gated_ = false;
+};
+
+} // namespace ultrasonic
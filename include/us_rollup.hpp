@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "i_us_reading_sink.hpp"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Streaming quantile estimate in constant memory (P² algorithm).
+ *
+ * Jain and Chlamtac's P² keeps five markers whose heights approximate the
+ * minimum, the p/2, p and (1+p)/2 quantiles and the maximum. Each sample
+ * moves the markers by at most one position, adjusting their heights with a
+ * piecewise-parabolic fit. The first five samples are kept exactly.
+ */
+class P2Quantile
+{
+public:
+    /**
+     * @brief Construct an estimator.
+     * @param p Quantile to estimate, in (0, 1). 0.5 is the median.
+     */
+    explicit P2Quantile(float p = 0.5f);
+
+    /** @brief Forget all samples. */
+    void reset();
+
+    /** @brief Add a sample. */
+    void add(float x);
+
+    /** @brief Current estimate (exact up to five samples, 0 without samples). */
+    float value() const;
+
+    /** @brief Number of samples added. */
+    uint32_t count() const { return count_; }
+
+private:
+    /** @internal */
+    double parabolic(int i, int d) const;
+    /** @internal */
+    double linear(int i, int d) const;
+
+    /** @internal */
+    double p_;
+    /** @internal */
+    uint32_t count_ = 0;
+    /** @internal Marker heights. */
+    double height_[5] = {};
+    /** @internal Actual marker positions (0-based). */
+    int32_t pos_[5] = {};
+    /** @internal Desired marker positions. */
+    double desired_[5] = {};
+    /** @internal Desired position increments per sample. */
+    double step_[5] = {};
+};
+
+/**
+ * @brief Summary of the readings in one time bucket.
+ *
+ * Distance statistics cover the successful readings (see is_success()) and
+ * are zero when there are none.
+ */
+struct RollupBucket
+{
+    int64_t start_us = 0;                    /**< Start of the bucket (aligned to the bucket length). */
+    uint32_t results[US_RESULT_COUNT] = {};  /**< Number of readings per UsResult. */
+    uint32_t valid = 0;                      /**< Number of successful readings. */
+    float min_cm = 0.0f;                     /**< Smallest distance. */
+    float max_cm = 0.0f;                     /**< Largest distance. */
+    float mean_cm = 0.0f;                    /**< Mean distance. */
+    float p50_cm = 0.0f;                     /**< Median distance (P² estimate beyond five readings). */
+
+    /** @brief Total number of readings. */
+    uint32_t total() const
+    {
+        uint32_t n = 0;
+        for (uint32_t c : results) {
+            n += c;
+        }
+        return n;
+    }
+};
+
+/**
+ * @brief Per-bucket aggregates of a reading stream.
+ *
+ * Readings are grouped into buckets aligned to multiples of the bucket
+ * length (e.g. whole minutes of the timer clock). Each bucket is summarised
+ * in constant memory; when a reading falls into a later bucket, the current
+ * one is finished and kept in a ring of the most recent finished buckets.
+ * Buckets without readings are skipped.
+ *
+ * UsRollup is an IUsReadingSink: attach one instance per resolution
+ * (e.g. per minute and per hour) with UsSensor::add_reading_sink(). All
+ * methods are thread-safe.
+ */
+class UsRollup : public IUsReadingSink
+{
+public:
+    /**
+     * @brief Construct a rollup.
+     * @param bucket_ms Bucket length (ms), at least 1.
+     * @param capacity  Number of finished buckets kept, at least 1.
+     */
+    UsRollup(uint32_t bucket_ms, size_t capacity);
+    ~UsRollup() override = default;
+
+    UsRollup(const UsRollup &) = delete;
+    UsRollup &operator=(const UsRollup &) = delete;
+
+    /**
+     * @brief Add a reading.
+     * @param timestamp_us Time of the reading. Readings that belong to the
+     *                     current bucket's predecessors are dropped.
+     * @param reading      Reading to aggregate.
+     */
+    void add(int64_t timestamp_us, const Reading &reading);
+
+    /** @brief Add a published reading. */
+    void on_reading(const TimedReading &reading) override { add(reading.timestamp_us, reading.reading); }
+
+    /**
+     * @brief Finish the current bucket if @p now_us is past its end.
+     *
+     * Lets a bucket be reported on time when no further reading arrives.
+     *
+     * @param now_us Current time.
+     */
+    void advance(int64_t now_us);
+
+    /**
+     * @brief Copy finished buckets starting at or after @p since_us, oldest first.
+     *
+     * @param out      Output array.
+     * @param max_out  Capacity of @p out. The newest buckets are returned if it is too small.
+     * @param since_us Earliest bucket start to return.
+     * @return Number of buckets copied.
+     */
+    size_t finished(RollupBucket *out, size_t max_out, int64_t since_us = INT64_MIN) const;
+
+    /**
+     * @brief Snapshot of the bucket being filled.
+     * @param out Output bucket.
+     * @return false if no reading has arrived since the last finished bucket.
+     */
+    bool current(RollupBucket &out) const;
+
+    /** @brief Readings dropped for belonging to an already finished bucket. */
+    uint32_t dropped() const;
+
+    /** @brief Bucket length (us). */
+    int64_t bucket_us() const { return bucket_us_; }
+
+private:
+    /** @internal */
+    void finish_current();
+    /** @internal */
+    RollupBucket snapshot() const;
+
+    /** @internal */
+    mutable std::mutex mutex_;
+    /** @internal */
+    int64_t bucket_us_;
+    /** @internal */
+    std::unique_ptr<RollupBucket[]> ring_;
+    /** @internal */
+    size_t capacity_;
+    /** @internal Index of the next ring slot to write. */
+    size_t next_ = 0;
+    /** @internal Number of finished buckets in the ring. */
+    size_t size_ = 0;
+    /** @internal Earliest bucket start still accepted. */
+    int64_t next_start_us_ = INT64_MIN;
+    /** @internal */
+    bool open_ = false;
+    /** @internal */
+    RollupBucket cur_;
+    /** @internal */
+    double sum_cm_ = 0.0;
+    /** @internal */
+    P2Quantile median_{0.5f};
+    /** @internal */
+    uint32_t dropped_ = 0;
+};
+
+} // namespace ultrasonic
@@ -1,11 +1,23 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 #include "esp_err.h"
+#include "us_compiled_config.hpp"
+#include "us_driver.hpp"
 #include "i_us_driver.hpp"
 #include "i_us_processor.hpp"
+#include "i_us_reading_sink.hpp"
+#include "i_us_recorder.hpp"
 #include "i_us_sensor.hpp"
+#include "us_executor.hpp"
+#include "us_latency.hpp"
+#include "us_metrics.hpp"
+#include "us_seqlock.hpp"
+#include "us_task.hpp"
 #include "us_types.hpp"
 #include "interfaces/i_hal_gpio.hpp"
 #include "interfaces/i_hal_timer.hpp"
@@ -40,6 +52,10 @@ public:
      * @param trig_pin     GPIO number for the trigger pin.
      * @param echo_pin     GPIO number for the echo pin.
      * @param cfg          Configuration structure for the sensor.
+     * @param driver_opts  Optional driver hardware: power pin for ECHO_STUCK
+     *                     recovery (see UsConfig::power_cycle_us) and cycle
+     *                     counter. The driver uses @p freertos_hal for the
+     *                     echo wait policies unless driver_opts names another.
      */
     UsSensor(
         idf_hals::IGpioHAL &gpio_hal,
@@ -48,7 +64,8 @@ public:
         idf_hals::IHalFreertos &freertos_hal,
         gpio_num_t trig_pin,
         gpio_num_t echo_pin,
-        const UsConfig &cfg);
+        const UsConfig &cfg,
+        const UsDriverOptions &driver_opts = UsDriverOptions{});
 
     /**
      * @brief Construct a new UsSensor object with dependency injection.
@@ -67,6 +84,25 @@ public:
         std::shared_ptr<IUsProcessor> processor,
         idf_hals::IHalFreertos &freertos_hal);
 
+    /**
+     * @brief Construct a new UsSensor object with dependency injection and a time source.
+     *
+     * Same as the injection constructor above, but ping timestamps (used by the
+     * trace recorder) are taken from @p timer_hal instead of being left at zero.
+     *
+     * @param cfg          Configuration structure for the sensor.
+     * @param driver       Shared pointer to a driver implementation.
+     * @param processor    Shared pointer to a processor implementation.
+     * @param freertos_hal FreeRTOS HAL reference.
+     * @param timer_hal    Timer HAL reference.
+     */
+    UsSensor(
+        const UsConfig &cfg,
+        std::shared_ptr<IUsDriver> driver,
+        std::shared_ptr<IUsProcessor> processor,
+        idf_hals::IHalFreertos &freertos_hal,
+        idf_hals::ITimerHAL &timer_hal);
+
     ~UsSensor() override = default;
 
     /** @copydoc IUsSensor::init() */
@@ -75,21 +111,265 @@ public:
     /** @copydoc IUsSensor::deinit() */
     esp_err_t deinit() override;
 
-    /** @copydoc IUsSensor::read_distance() */
+    /** @copydoc IUsSensor::read_distance(uint8_t) */
     Reading read_distance(uint8_t ping_count) override;
 
+    /** @copydoc IUsSensor::read_distance(uint8_t, uint32_t, bool &) */
+    Reading read_distance(uint8_t ping_count, uint32_t deadline_us, bool &deadline_hit) override;
+
+    /**
+     * @brief Same as read_distance(uint8_t), returning the burst diagnostics with the Reading.
+     *
+     * The ping tallies, standard deviation and filter sample count are the
+     * values the processor computes anyway to reach its result, so the burst
+     * costs the same as read_distance(). Use them to judge a value without
+     * firing extra bursts.
+     *
+     * @param ping_count Number of pings (clamped to [1, 15]).
+     * @return The Reading and its diagnostics.
+     */
+    MeasurementInfo read_distance_ex(uint8_t ping_count);
+
+    /**
+     * @brief Same as read_distance(uint8_t, uint32_t, bool &), returning the burst diagnostics.
+     *
+     * MeasurementInfo::deadline_hit reports whether the deadline cut the burst short.
+     */
+    MeasurementInfo read_distance_ex(uint8_t ping_count, uint32_t deadline_us);
+
+    /**
+     * @brief Awaitable read_distance(uint8_t).
+     *
+     * Runs the same burst, but awaits each ping with IUsDriver::ping() and
+     * sleeps the inter-ping delay on @p exec, so other coroutines on the
+     * executor run while this sensor waits for echoes. The result is
+     * published to get_latest() and the reading sinks, and the recorder gets
+     * the raw pings, as with read_distance().
+     *
+     * @code
+     * Reading r = co_await sensor.measure(exec, 5);
+     * @endcode
+     *
+     * @param exec       Executor the calling coroutine runs on.
+     * @param ping_count Number of pings (clamped to [1, 15]).
+     * @return Task producing the processed Reading.
+     */
+    UsTask<Reading> measure(UsExecutor &exec, uint8_t ping_count);
+
+    /**
+     * @brief Latest cached reading, without measuring.
+     *
+     * Every read_distance() call publishes its result to a cache that any
+     * number of tasks can read with this method. It never blocks on a burst or
+     * touches the GPIOs. If the cached reading is older than @p max_age_ms, or
+     * no burst has completed yet, it is returned with stale set and a refresh
+     * is requested from the task that owns the sensor (see refresh_if_requested()).
+     *
+     * Ages are measured with the timer HAL; without one (injection constructor
+     * without a timer) a reading never becomes stale once measured.
+     *
+     * @param max_age_ms Maximum acceptable age of the reading (ms).
+     * @return The cached reading, its timestamp and whether it is stale.
+     */
+    TimedReading get_latest(uint32_t max_age_ms);
+
+    /** @brief Whether a get_latest() caller found the cache stale since the last burst. */
+    bool refresh_requested() const { return refresh_requested_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Run a burst if a reader asked for one.
+     *
+     * Meant to be called periodically by the single task that owns the
+     * sensor. Readers only raise a flag, so measuring always happens in the
+     * owner's context.
+     *
+     * @param ping_count Number of pings for the refresh burst.
+     * @return true if a burst was run.
+     */
+    bool refresh_if_requested(uint8_t ping_count);
+
+    /**
+     * @brief Trigger once and capture several echo pulses.
+     *
+     * Useful when one trigger returns several targets, e.g. a near object and
+     * a far wall. Up to UsConfig::max_echoes pulses are captured within
+     * timeout_us, in arrival order. No statistical filtering is applied and
+     * the pulses are not range-checked.
+     *
+     * @param[out] out Captured pulses.
+     * @return OK if at least one pulse was captured, TIMEOUT if none, or
+     *         ECHO_STUCK / HW_FAULT on hardware failure.
+     */
+    UsResult capture_echoes(EchoCapture &out) { return driver_->capture_echoes(cfg_, out); }
+
+    /**
+     * @brief Attach a recorder that receives every raw ping.
+     *
+     * After each burst the recorder gets one TraceRecord per fired ping,
+     * including pings of bursts aborted by a hardware failure. Pass nullptr to
+     * detach. The recorder must outlive the sensor or be detached first.
+     *
+     * @param recorder Recorder to attach, or nullptr.
+     */
+    void set_recorder(IUsRecorder *recorder) { recorder_ = recorder; }
+
+    /**
+     * @brief Attach a sink that receives every processed reading.
+     *
+     * Each read_distance() passes its result, with the timestamp also
+     * published to get_latest(), to all attached sinks (e.g. a UsHistory).
+     * A sink must outlive the sensor or be removed first.
+     *
+     * @param sink Sink to attach.
+     * @return
+     *     - ESP_OK: Success (or already attached)
+     *     - ESP_ERR_INVALID_ARG: sink is nullptr
+     *     - ESP_ERR_NO_MEM: MAX_READING_SINKS sinks are already attached
+     */
+    esp_err_t add_reading_sink(IUsReadingSink *sink);
+
+    /**
+     * @brief Detach a sink added with add_reading_sink().
+     * @param sink Sink to detach.
+     * @return ESP_OK on success, ESP_ERR_NOT_FOUND if it was not attached.
+     */
+    esp_err_t remove_reading_sink(IUsReadingSink *sink);
+
+    /** @brief Maximum number of reading sinks attached at once. */
+    static constexpr size_t MAX_READING_SINKS = 4;
+
+    /**
+     * @brief Driver counters, e.g. ECHO_STUCK events and successful recoveries.
+     *
+     * @return Counters since construction (all zero for drivers without counters).
+     */
+    UsDriverStats driver_stats() const { return driver_->stats(); }
+
+    /**
+     * @brief Inter-ping delay currently in use (ms).
+     *
+     * Equals UsConfig::ping_interval_ms unless adaptive mode is enabled with
+     * UsConfig::min_ping_interval_ms. In adaptive mode every burst of two or
+     * more pings is checked for early echoes: a later ping reporting a target
+     * more than EARLY_ECHO_MARGIN_CM closer than the burst result (or the
+     * first ping, if that is farther) heard the reverberation of the ping
+     * before it. A clean burst shortens the delay by
+     * interval_step_ms, down to min_ping_interval_ms. A burst with early echoes
+     * lengthens it by half, up to ping_interval_ms. The delay settles just above
+     * the shortest one the installation tolerates.
+     */
+    uint16_t ping_interval_ms() const { return interval_ms_; }
+
+    /** @brief Early echoes detected by the adaptive interval since construction. */
+    uint32_t early_echoes() const { return early_echoes_; }
+
+    /** @brief How much closer than the burst result a ping must be to count as an early echo (cm). */
+    static constexpr float EARLY_ECHO_MARGIN_CM = 5.0f;
+
+    /**
+     * @brief Cumulative outcome counters of read_distance() and measure().
+     *
+     * Counts every ping by its driver result, every burst by its final
+     * result, the share of successful pings per burst and the pings fired
+     * per burst. Safe to call from any task while a burst runs; serialize the
+     * snapshot with metrics_to_json() or metrics_to_prometheus().
+     *
+     * @return Counters since construction or the last reset_metrics().
+     */
+    UsMetrics metrics() const { return metrics_.snapshot(); }
+
+    /** @brief Zero the counters returned by metrics(). */
+    void reset_metrics() { metrics_.reset(); }
+
+    /**
+     * @brief Attach latency histograms.
+     *
+     * Every ping and every read_distance() / measure() call is timed with the
+     * timer HAL and recorded under its result: a ping under the driver
+     * result, a call under the final result. Nothing is recorded by sensors
+     * constructed without a timer HAL. Pass nullptr to detach. The stats must
+     * outlive the sensor or be detached first.
+     *
+     * @param stats Histograms to record into, or nullptr.
+     */
+    void set_latency_stats(UsLatencyStats *stats) { latency_ = stats; }
+
+    /** @brief Configuration the sensor was constructed with. */
+    const UsConfig &config() const { return cfg_; }
+
+    /**
+     * @brief Configuration validated at construction, with its derived constants.
+     *
+     * init() fails with ESP_ERR_INVALID_ARG unless compiled_config().valid();
+     * compiled_config().error names the first inconsistency.
+     */
+    const UsCompiledConfig &compiled_config() const { return compiled_; }
+
 private:
+    /** @internal */
+    Reading run_burst(uint8_t ping_count, uint64_t budget_us, bool &deadline_hit, MeasurementInfo *info = nullptr);
+
+    /** @internal */
+    MeasurementInfo run_burst_ex(uint8_t ping_count, uint64_t budget_us);
+
+    /** @internal */
+    int64_t publish(const Reading &reading);
+
+    /** @internal */
+    void adapt_interval(const Reading *pings, uint8_t count, const Reading &reading);
+
+    /** @internal */
+    int64_t now_us() const;
+
+    /** @internal */
+    int64_t latency_start() const;
+
+    /** @internal */
+    void record_ping_latency(int64_t start_us, const Reading &ping);
+
+    /** @internal */
+    void record_read_latency(int64_t start_us, const Reading &reading);
+
+    /** @internal */
+    uint32_t elapsed_us(int64_t start_us) const;
+
+    /** @internal */
+    void record_burst(const Reading *pings, const int64_t *fired_at, const uint32_t *echo_us,
+                      const uint8_t *echo_flags, uint8_t count);
+
     /** @internal */
     UsConfig cfg_;
     /** @internal */
+    UsCompiledConfig compiled_;
+    /** @internal */
     std::shared_ptr<IUsDriver> driver_;
     /** @internal */
     std::shared_ptr<IUsProcessor> processor_;
     /** @internal */
     idf_hals::IHalFreertos &freertos_hal_;
+    /** @internal */
+    idf_hals::ITimerHAL *timer_hal_ = nullptr;
+    /** @internal */
+    IUsRecorder *recorder_ = nullptr;
+    /** @internal */
+    UsLatencyStats *latency_ = nullptr;
+    /** @internal */
+    IUsReadingSink *sinks_[MAX_READING_SINKS] = {};
+    /** @internal */
+    SeqLock<TimedReading> latest_;
+    /** @internal */
+    std::atomic<bool> refresh_requested_{false};
+    /** @internal */
+    uint16_t interval_ms_;
+    /** @internal */
+    uint32_t early_echoes_ = 0;
+    /** @internal */
+    UsMetricsCounters metrics_;
 
     /** @internal */
     static constexpr uint8_t MAX_PINGS = 15;
+    /** @internal */
+    static constexpr uint64_t NO_DEADLINE = UINT64_MAX;
 };
 
 } // namespace ultrasonic
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ultrasonic {
+
+/**
+ * @brief Single-writer, multi-reader value cell (seqlock latch).
+ *
+ * The value is kept in two copies. The writer bumps the sequence counter
+ * before updating each copy, so at any time one copy is stable and the
+ * counter tells readers which one. A reader that is interrupted by a writer
+ * only retries if the writer completed a half-update meanwhile. A writer
+ * preempted in the middle of an update never stalls readers, which matters
+ * on a single core where the reader may have the higher priority.
+ *
+ * Both copies are stored as atomic words, so concurrent access is free of
+ * data races. T must be trivially copyable.
+ *
+ * @tparam T Value type.
+ */
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requires a trivially copyable type");
+
+public:
+    /**
+     * @brief Construct with an initial value.
+     * @param initial Value returned until the first write().
+     */
+    explicit SeqLock(const T &initial = T{})
+    {
+        store(0, initial);
+        store(1, initial);
+    }
+
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    /**
+     * @brief Publish a new value. Must only be called from one task at a time.
+     * @param value Value to publish.
+     */
+    void write(const T &value)
+    {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+
+        // Odd sequence: readers use copy 1 while copy 0 is rewritten. Release,
+        // so copy 1 from the previous write is complete before readers switch to it.
+        seq_.store(seq + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        store(0, value);
+
+        // Even sequence: readers use copy 0 while copy 1 is rewritten
+        seq_.store(seq + 2, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+        store(1, value);
+    }
+
+    /**
+     * @brief Read the latest complete value. Never waits for the writer.
+     * @return Snapshot of the last published value (or of the one before it,
+     *         if a write is in progress).
+     */
+    T read() const
+    {
+        T out;
+        uint32_t before;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            load((before & 1) ? 1 : 0, out);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while (seq_.load(std::memory_order_relaxed) != before);
+        return out;
+    }
+
+private:
+    /** @internal */
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    /** @internal */
+    void store(int copy, const T &value)
+    {
+        uint32_t words[WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < WORDS; i++) {
+            data_[copy][i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+
+    /** @internal */
+    void load(int copy, T &value) const
+    {
+        uint32_t words[WORDS];
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i] = data_[copy][i].load(std::memory_order_relaxed);
+        }
+        std::memcpy(&value, words, sizeof(T));
+    }
+
+    /** @internal */
+    std::atomic<uint32_t> seq_{0};
+    /** @internal */
+    std::atomic<uint32_t> data_[2][WORDS];
+};
+
+} // namespace ultrasonic
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdlib>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace ultrasonic {
+
+template <typename T>
+class UsTask;
+
+namespace detail {
+
+/** @internal Resumes the awaiting coroutine when a task finishes (symmetric transfer). */
+struct UsTaskFinalAwaiter
+{
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+    {
+        std::coroutine_handle<> next = h.promise().continuation;
+        return next ? next : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+/** @internal */
+struct UsTaskPromiseBase
+{
+    std::coroutine_handle<> continuation;
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    UsTaskFinalAwaiter final_suspend() const noexcept { return {}; }
+
+    // Firmware is built without exceptions; an escaping one is a bug
+    void unhandled_exception() const noexcept { std::abort(); }
+};
+
+/** @internal */
+template <typename T>
+struct UsTaskPromise : UsTaskPromiseBase
+{
+    std::optional<T> value;
+
+    UsTask<T> get_return_object() noexcept;
+    void return_value(T v) { value.emplace(std::move(v)); }
+};
+
+/** @internal */
+template <>
+struct UsTaskPromise<void> : UsTaskPromiseBase
+{
+    UsTask<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+};
+
+} // namespace detail
+
+/**
+ * @brief Lazily started coroutine producing a T.
+ *
+ * A UsTask does nothing until it is awaited (or handed to
+ * UsExecutor::spawn() / UsExecutor::block_on()). Awaiting it runs the task
+ * until it suspends; when it finishes, the awaiting coroutine is resumed
+ * directly, without a round trip through the executor. The task owns its
+ * coroutine frame and destroys it when it goes out of scope.
+ *
+ * @tparam T Result type (void for none).
+ */
+template <typename T = void>
+class [[nodiscard]] UsTask
+{
+public:
+    /** @internal */
+    using promise_type = detail::UsTaskPromise<T>;
+
+    UsTask() = default;
+
+    /** @internal */
+    explicit UsTask(std::coroutine_handle<promise_type> h)
+        : handle_(h)
+    {
+    }
+
+    UsTask(UsTask &&other) noexcept
+        : handle_(std::exchange(other.handle_, {}))
+    {
+    }
+
+    UsTask &operator=(UsTask &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    UsTask(const UsTask &) = delete;
+    UsTask &operator=(const UsTask &) = delete;
+
+    ~UsTask() { reset(); }
+
+    /** @brief Whether the task has run to completion. */
+    bool done() const { return handle_ && handle_.done(); }
+
+    /** @internal */
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+    /** @internal */
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+
+    /** @internal */
+    T await_resume()
+    {
+        if constexpr (!std::is_void_v<T>) {
+            return std::move(*handle_.promise().value);
+        }
+    }
+
+    /** @internal Starts the task without an awaiting coroutine. */
+    void start() { handle_.resume(); }
+
+private:
+    void reset()
+    {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+UsTask<T> UsTaskPromise<T>::get_return_object() noexcept
+{
+    return UsTask<T>(std::coroutine_handle<UsTaskPromise<T>>::from_promise(*this));
+}
+
+inline UsTask<void> UsTaskPromise<void>::get_return_object() noexcept
+{
+    return UsTask<void>(std::coroutine_handle<UsTaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace detail
+
+} // namespace ultrasonic
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "i_us_processor.hpp"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Fixed allowance per ping for HAL call overhead, polling-loop overshoot
+ *        and task wake-up latency (us).
+ */
+inline constexpr uint32_t PING_OVERHEAD_US = 500;
+
+/**
+ * @brief Longest a yield or sleep of an echo wait (UsConfig::echo_wait) can
+ *        run past the end of the wait while other tasks of equal priority
+ *        are ready: one tick (us).
+ */
+inline constexpr uint32_t RELAX_OVERRUN_US = 1000000 / configTICK_RATE_HZ;
+
+/**
+ * @brief Worst-case blocking time of the ECHO_STUCK recovery sequence (us).
+ *
+ * Every attempt runs all steps: discharge, retrigger with a timed-out wait,
+ * and the power toggle. The power step is counted whenever power_cycle_us is
+ * set, since the configuration does not say whether a power pin is wired.
+ *
+ * @param cfg Sensor configuration.
+ * @return Upper bound of the recovery in microseconds (0 when disabled).
+ */
+constexpr uint64_t worst_case_recovery_us(const UsConfig &cfg)
+{
+    const uint64_t attempt_us = 3ULL * cfg.stuck_settle_us + cfg.ping_duration_us + cfg.timeout_us +
+                                2ULL * cfg.power_cycle_us + PING_OVERHEAD_US;
+    return cfg.stuck_recovery_attempts * attempt_us;
+}
+
+/**
+ * @brief Worst-case blocking time of a single ping (us).
+ *
+ * A ping sends the trigger pulse, then polls for the rising edge and for the
+ * falling edge of the echo, each bounded by timeout_us. The worst case is a
+ * ping with the longest trigger jitter whose echo starts just before the first
+ * timeout and never ends, after an ECHO_STUCK recovery that succeeded on its
+ * last step. With a tracking gate, the previous ping may have given up on a
+ * pulse that is still HIGH, and this ping first waits up to timeout_us for it.
+ *
+ * Unless echo_wait is SPIN, each of these echo waits (the abandoned pulse,
+ * both edges, one per recovery attempt) can end up to RELAX_OVERRUN_US late.
+ *
+ * @param cfg Sensor configuration.
+ * @return Upper bound of IUsDriver::ping_once() in microseconds.
+ */
+constexpr uint64_t worst_case_ping_us(const UsConfig &cfg)
+{
+    const bool gated = (cfg.track_gate_cm > 0.0f);
+    const uint64_t abandoned_us = gated ? uint64_t{cfg.timeout_us} + PING_OVERHEAD_US : 0;
+    const uint64_t relaxed_waits = 2ULL + (gated ? 1 : 0) + cfg.stuck_recovery_attempts;
+    const uint64_t overrun_us = (cfg.echo_wait != EchoWait::SPIN) ? relaxed_waits * RELAX_OVERRUN_US : 0;
+    return uint64_t{cfg.ping_duration_us} + cfg.trigger_jitter_us + 2ULL * cfg.timeout_us + PING_OVERHEAD_US +
+           abandoned_us + worst_case_recovery_us(cfg) + overrun_us;
+}
+
+/**
+ * @brief Worst-case blocking time of the delay between two pings (us).
+ *
+ * pdMS_TO_TICKS() rounds down, so the delay never exceeds ping_interval_ms.
+ *
+ * @param cfg Sensor configuration.
+ * @return Upper bound of one inter-ping delay in microseconds.
+ */
+constexpr uint64_t worst_case_interval_us(const UsConfig &cfg)
+{
+    return uint64_t{cfg.ping_interval_ms} * 1000ULL;
+}
+
+/**
+ * @brief Worst-case blocking time of IUsSensor::read_distance() (us).
+ *
+ * Assumes every ping times out as late as possible. @p ping_count is clamped
+ * the same way read_distance() clamps it. The bound does not cover log output
+ * (keep the log level at WARN or lower where it matters) or preemption by
+ * higher-priority tasks; equal-priority tasks are covered through
+ * worst_case_ping_us(). The init() warm-up is not part of a reading.
+ *
+ * @param cfg        Sensor configuration.
+ * @param ping_count Number of pings requested.
+ * @return Upper bound of a reading in microseconds.
+ */
+constexpr uint64_t worst_case_read_us(const UsConfig &cfg, uint8_t ping_count)
+{
+    if (ping_count == 0)
+        ping_count = 1;
+    if (ping_count > IUsProcessor::MAX_PINGS)
+        ping_count = IUsProcessor::MAX_PINGS;
+
+    return ping_count * worst_case_ping_us(cfg) + (ping_count - 1) * worst_case_interval_us(cfg);
+}
+
+} // namespace ultrasonic
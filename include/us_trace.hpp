@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "esp_err.h"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief Binary trace file layout.
+ *
+ * A trace file is a TraceHeader followed by a flat array of TraceRecord, one
+ * per fired ping. All fields are little-endian, as written by the ESP32 and
+ * x86/ARM hosts. Both structures have a fixed size that is a multiple of 16
+ * bytes, so a memory-mapped file can be accessed in place.
+ */
+struct TraceHeader
+{
+    uint32_t magic;             /**< TRACE_MAGIC. */
+    uint16_t version;           /**< TRACE_VERSION. */
+    uint16_t record_size;       /**< sizeof(TraceRecord). */
+    uint32_t sensor_id;         /**< Application-defined sensor identifier. */
+    uint16_t ping_interval_ms;  /**< UsConfig::ping_interval_ms active while recording. */
+    uint16_t ping_duration_us;  /**< UsConfig::ping_duration_us active while recording. */
+    uint32_t timeout_us;        /**< UsConfig::timeout_us active while recording. */
+    float min_distance_cm;      /**< UsConfig::min_distance_cm active while recording. */
+    float max_distance_cm;      /**< UsConfig::max_distance_cm active while recording. */
+    float max_dev_cm;           /**< UsConfig::max_dev_cm active while recording. */
+    uint8_t filter;             /**< UsConfig::filter active while recording. */
+    uint8_t reserved0;          /**< Written as zero. */
+    uint16_t warmup_time_ms;    /**< UsConfig::warmup_time_ms active while recording. */
+    float track_gate_cm;        /**< UsConfig::track_gate_cm active while recording (version 2). */
+    uint16_t trigger_jitter_us; /**< UsConfig::trigger_jitter_us active while recording (version 2). */
+    uint8_t reserved[6];        /**< Written as zero. */
+};
+
+/**
+ * @brief A single raw ping as seen by UsSensor.
+ */
+struct TraceRecord
+{
+    int64_t timestamp_us; /**< Time the ping was fired (ITimerHAL clock, us). */
+    uint32_t echo_us;     /**< Raw echo pulse width (us). Zero if no echo was measured. */
+    uint8_t result;       /**< UsResult reported by the driver for this ping. */
+    uint8_t ping_index;   /**< Position of the ping within its burst. */
+    uint8_t ping_count;   /**< Number of pings actually fired in the burst. */
+    uint8_t flags;        /**< TRACE_FLAG_* bits; others are written as zero. */
+};
+
+static_assert(sizeof(TraceHeader) == 48, "TraceHeader layout is part of the file format");
+static_assert(sizeof(TraceRecord) == 16, "TraceRecord layout is part of the file format");
+
+/** @brief "USTR" in little-endian byte order. */
+static constexpr uint32_t TRACE_MAGIC = 0x52545355;
+/** @brief Current trace format version. */
+static constexpr uint16_t TRACE_VERSION = 2;
+/** @brief Oldest version still read; its headers leave the version 2 fields zero. */
+static constexpr uint16_t TRACE_VERSION_MIN = 1;
+
+/**
+ * @brief TraceRecord::flags: the driver rejected the echo as OUT_OF_RANGE
+ *        because it ended before the tracking gate, whatever its distance.
+ */
+static constexpr uint8_t TRACE_FLAG_GATE_REJECT = 0x01;
+
+/**
+ * @brief Build a trace header describing the given configuration.
+ * @param cfg       Configuration active while recording.
+ * @param sensor_id Application-defined sensor identifier.
+ */
+TraceHeader make_trace_header(const UsConfig &cfg, uint32_t sensor_id);
+
+/**
+ * @brief Validate a trace header and extract the recorded configuration.
+ *
+ * Fields that are not part of the trace format keep their defaults.
+ *
+ * @param header Header read from a trace file.
+ * @param cfg    Output configuration.
+ * @return
+ *     - ESP_OK: Success
+ *     - ESP_ERR_INVALID_ARG: Not a trace header (bad magic)
+ *     - ESP_ERR_INVALID_VERSION: Version outside TRACE_VERSION_MIN..TRACE_VERSION, or bad record size
+ */
+esp_err_t trace_header_to_config(const TraceHeader &header, UsConfig &cfg);
+
+} // namespace ultrasonic
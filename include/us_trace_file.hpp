@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+
+#include "esp_err.h"
+#include "i_us_recorder.hpp"
+#include "us_trace.hpp"
+#include "us_types.hpp"
+
+namespace ultrasonic {
+
+/**
+ * @brief IUsRecorder that appends raw pings to a binary trace file.
+ *
+ * Works with any stdio path: SPIFFS/LittleFS/FAT mounts on the device, or a
+ * regular file on the linux target.
+ */
+class UsTraceWriter : public IUsRecorder
+{
+public:
+    UsTraceWriter() = default;
+    ~UsTraceWriter() override;
+
+    UsTraceWriter(const UsTraceWriter &) = delete;
+    UsTraceWriter &operator=(const UsTraceWriter &) = delete;
+
+    /**
+     * @brief Create (or truncate) a trace file and write its header.
+     *
+     * @param path      File path.
+     * @param cfg       Configuration of the sensor being recorded (see UsSensor::config()).
+     * @param sensor_id Application-defined sensor identifier stored in the header.
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_STATE: A file is already open
+     *     - ESP_FAIL: The file could not be created or written
+     */
+    esp_err_t open(const char *path, const UsConfig &cfg, uint32_t sensor_id);
+
+    /**
+     * @brief Flush and close the trace file.
+     * @return
+     *     - ESP_OK: Success (or no file open)
+     *     - ESP_FAIL: Flushing buffered records failed
+     */
+    esp_err_t close();
+
+    /** @copydoc IUsRecorder::record() */
+    void record(const TraceRecord &rec) override;
+
+    /** @brief Number of records written since open(). */
+    uint32_t written() const { return written_; }
+
+    /** @brief Number of records lost because no file was open or a write failed. */
+    uint32_t dropped() const { return dropped_; }
+
+private:
+    /** @internal */
+    FILE *file_ = nullptr;
+    /** @internal */
+    uint32_t written_ = 0;
+    /** @internal */
+    uint32_t dropped_ = 0;
+};
+
+/**
+ * @brief Sequential reader for trace files produced by UsTraceWriter.
+ */
+class UsTraceReader
+{
+public:
+    UsTraceReader() = default;
+    ~UsTraceReader();
+
+    UsTraceReader(const UsTraceReader &) = delete;
+    UsTraceReader &operator=(const UsTraceReader &) = delete;
+
+    /**
+     * @brief Open a trace file and validate its header.
+     *
+     * @param path File path.
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_STATE: A file is already open
+     *     - ESP_ERR_NOT_FOUND: The file could not be opened
+     *     - ESP_ERR_INVALID_SIZE: The file is shorter than a header
+     *     - Other: errors from trace_header_to_config()
+     */
+    esp_err_t open(const char *path);
+
+    /** @brief Close the trace file. */
+    void close();
+
+    /**
+     * @brief Read the next record.
+     * @param rec Output record.
+     * @return true if a complete record was read, false at end of file.
+     */
+    bool next(TraceRecord &rec);
+
+    /** @brief Configuration stored in the header. Valid after a successful open(). */
+    const UsConfig &config() const { return cfg_; }
+
+    /** @brief Sensor identifier stored in the header. Valid after a successful open(). */
+    uint32_t sensor_id() const { return sensor_id_; }
+
+private:
+    /** @internal */
+    FILE *file_ = nullptr;
+    /** @internal */
+    UsConfig cfg_;
+    /** @internal */
+    uint32_t sensor_id_ = 0;
+};
+
+} // namespace ultrasonic
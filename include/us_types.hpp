@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 
 namespace ultrasonic {
@@ -17,7 +18,7 @@ enum class UsResult
     // Logical failures — not enough valid data
     TIMEOUT,              /**< Sensor did not respond to trigger within timeout_us. */
     OUT_OF_RANGE,         /**< Measured distance is outside [min_distance_cm, max_distance_cm]. */
-    HIGH_VARIANCE,        /**< Standard deviation of valid pings exceeds max_dev_cm. */
+    HIGH_VARIANCE,        /**< Standard deviation of valid pings exceeds max_dev_cm; for one ping, an echo edge seen late (UsDriver::MAX_EDGE_GAP_US). */
     INSUFFICIENT_SAMPLES, /**< Too few valid pings (ratio below minimum threshold). */
 
     // Hardware failures — require application-level action
@@ -25,6 +26,12 @@ enum class UsResult
     HW_FAULT,   /**< GPIO/HAL operation failed. */
 };
 
+/** @brief Speed of sound in air at about 20 °C (cm/us). */
+static constexpr float SOUND_SPEED_CM_PER_US = 0.0343f;
+
+/** @brief Number of UsResult values. */
+static constexpr size_t US_RESULT_COUNT = static_cast<size_t>(UsResult::HW_FAULT) + 1;
+
 /**
  * @brief Result of a single ping attempt or a full measurement cycle.
  */
@@ -44,6 +51,16 @@ struct Reading
     bool operator!=(const Reading &other) const { return !(*this == other); }
 };
 
+/**
+ * @brief A reading together with the time it was measured.
+ */
+struct TimedReading
+{
+    Reading reading = {UsResult::INSUFFICIENT_SAMPLES, 0.0f}; /**< Result of the burst. */
+    int64_t timestamp_us = -1; /**< Completion time of the burst (timer HAL clock), -1 if none yet. */
+    bool stale = true;         /**< Set by UsSensor::get_latest() when older than the requested age. */
+};
+
 /**
  * @brief Helper to check if a result represents a valid distance measurement.
  * @param r UsResult to check.
@@ -54,6 +71,48 @@ inline bool is_success(UsResult r)
     return r == UsResult::OK || r == UsResult::WEAK_SIGNAL;
 }
 
+/**
+ * @brief A burst result with the diagnostics computed while producing it.
+ *
+ * Returned by UsSensor::read_distance_ex(). Fields a burst did not get far
+ * enough to compute keep their defaults: std_dev_cm stays NaN when too few
+ * pings were valid, filter_samples stays 0 when no distance was chosen.
+ */
+struct MeasurementInfo
+{
+    Reading reading = {UsResult::INSUFFICIENT_SAMPLES, 0.0f}; /**< Same as read_distance() returns. */
+    uint8_t total_pings = 0;                 /**< Pings fired. */
+    uint8_t valid_pings = 0;                 /**< Pings with a usable distance (after jitter rejection). */
+    uint8_t ping_results[US_RESULT_COUNT] = {}; /**< Pings per driver result, indexed by UsResult. */
+    uint8_t filter_samples = 0;              /**< Samples the distance was drawn from (dominant cluster size, or valid_pings for MEDIAN). */
+    float std_dev_cm = NAN;                  /**< Standard deviation of the valid pings (cm). */
+    uint32_t duration_us = 0;                /**< Wall time of the burst (us), 0 without a timer HAL. */
+    int64_t timestamp_us = 0;                /**< Completion time, as published to get_latest() (timer HAL clock). */
+    bool deadline_hit = false;               /**< The burst was cut short by its deadline. */
+
+    /** @brief Pings that ended with @p r. */
+    uint8_t pings_with(UsResult r) const
+    {
+        const size_t i = static_cast<size_t>(r);
+        return (i < US_RESULT_COUNT) ? ping_results[i] : 0;
+    }
+
+    /** @brief Set total_pings, valid_pings and ping_results from raw pings. */
+    void count_pings(const Reading *pings, uint8_t count)
+    {
+        total_pings = count;
+        valid_pings = 0;
+        for (auto &n : ping_results) n = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            const size_t r = static_cast<size_t>(pings[i].result);
+            if (r < US_RESULT_COUNT)
+                ping_results[r]++;
+            if (is_success(pings[i].result) && std::isfinite(pings[i].cm))
+                valid_pings++;
+        }
+    }
+};
+
 /**
  * @brief Statistical filter algorithm to apply to the collected ping samples.
  */
@@ -63,6 +122,16 @@ enum class Filter
     DOMINANT_CLUSTER, /**< Averages the largest cluster of similar measurements. */
 };
 
+/**
+ * @brief How UsDriver waits between polls of ECHO while it expects an edge.
+ */
+enum class EchoWait
+{
+    SPIN,       /**< Poll continuously. Best precision; the CPU is busy for the whole echo. */
+    SPIN_YIELD, /**< Spin near expected edges, yield to ready tasks of equal priority elsewhere. */
+    SPIN_SLEEP, /**< Spin near expected edges, sleep whole ticks up to the predicted edge. */
+};
+
 /**
  * @brief Configuration for the ultrasonic sensor hardware and processing.
  */
@@ -76,6 +145,63 @@ struct UsConfig
     float max_distance_cm = 200.0f; /**< Maximum valid distance (cm). */
     float max_dev_cm = 15.0f;       /**< Max standard deviation for OK result (cm). */
     uint16_t warmup_time_ms = 600;  /**< Time to wait after init before first ping (ms). */
+    uint8_t stuck_recovery_attempts = 0; /**< ECHO_STUCK recovery attempts before reporting it (0 = disabled). */
+    uint16_t stuck_settle_us = 1000;     /**< Settle time after each recovery step (us). */
+    uint32_t power_cycle_us = 0;         /**< Power-enable off time and boot wait in recovery (us, 0 = no power toggle). */
+    uint8_t max_echoes = 1;              /**< Echo pulses kept per trigger by capture_echoes() (1..EchoCapture::MAX_ECHOES). */
+    uint16_t trigger_jitter_us = 0;      /**< Max random delay before each trigger (us, 0 = disabled). */
+    uint32_t jitter_seed = 1;            /**< Jitter sequence seed; give each co-located sensor its own. */
+    uint16_t min_ping_interval_ms = 0;   /**< Lower bound of the adaptive inter-ping delay (ms, 0 = fixed ping_interval_ms). */
+    uint16_t interval_step_ms = 5;       /**< Adaptive delay decrease per clean burst (ms). */
+    bool fast_ping = false;              /**< Skip the ECHO clear sequence after a ping that ended with ECHO low. */
+    EchoWait echo_wait = EchoWait::SPIN; /**< Wait policy for echo edges (needs UsDriverOptions::freertos_hal). */
+    uint16_t spin_window_us = 600;       /**< Time spun after the trigger and after the rising edge (us). */
+    uint16_t spin_guard_us = 300;        /**< Time spun on either side of a predicted edge (us). */
+    float track_gate_cm = 0.0f;          /**< Half-width of the tracking gate around the previous reading (cm, 0 = disabled). */
+};
+
+/**
+ * @brief One echo pulse seen after a trigger.
+ */
+struct EchoPulse
+{
+    uint32_t start_us; /**< Rising edge, relative to the start of the listening window (us). */
+    uint32_t width_us; /**< Pulse width (us). */
+    float cm;          /**< Distance corresponding to width_us (cm), not range-checked. */
+};
+
+/**
+ * @brief Echo pulses captured from a single trigger, in arrival order.
+ */
+struct EchoCapture
+{
+    static constexpr uint8_t MAX_ECHOES = 4; /**< Capacity of pulses[]. */
+
+    /** @brief @p max_echoes clamped to 1..MAX_ECHOES; validation rejects values it changes. */
+    static constexpr uint8_t clamp_count(uint8_t max_echoes)
+    {
+        return (max_echoes == 0) ? 1 : (max_echoes > MAX_ECHOES) ? MAX_ECHOES : max_echoes;
+    }
+
+    EchoPulse pulses[MAX_ECHOES] = {}; /**< Captured pulses; only the first count entries are valid. */
+    uint8_t count = 0;                 /**< Number of valid pulses. */
+};
+
+/**
+ * @brief Counters kept by the hardware driver.
+ */
+struct UsDriverStats
+{
+    uint32_t stuck_events = 0;     /**< Pings that found ECHO stuck HIGH before triggering. */
+    uint32_t stuck_recoveries = 0; /**< Stuck events cleared by the recovery sequence. */
+    uint32_t power_cycles = 0;     /**< Sensor power toggles done by the recovery sequence. */
+    uint32_t full_preps = 0;       /**< Pings that ran the ECHO clear sequence (output low, back to input). */
+    uint32_t fast_preps = 0;       /**< Pings that skipped it (UsConfig::fast_ping, previous ping ended cleanly). */
+    uint32_t wait_yields = 0;      /**< Echo polls followed by a yield (UsConfig::echo_wait). */
+    uint32_t wait_sleeps = 0;      /**< Echo polls followed by a sleep of one or more ticks. */
+    uint32_t late_edges = 0;       /**< Pings rejected because an edge was seen more than MAX_EDGE_GAP_US after a yield or sleep. */
+    uint32_t gate_losses = 0;      /**< Gated pings that declared TIMEOUT at the end of the gate (UsConfig::track_gate_cm). */
+    uint32_t gate_rejects = 0;     /**< Gated pings whose echo ended before the gate opened (OUT_OF_RANGE). */
 };
 
 } // namespace ultrasonic
@@ -0,0 +1,36 @@
+// components/ultrasonic_sensor/src/us_compiled_config.cpp
+
+#include "us_compiled_config.hpp"
+
+namespace ultrasonic {
+
+void us_config_rejected(UsConfigError error)
+{
+    // Only reachable from compile_config(), which is consteval
+    (void)error;
+}
+
+const char *config_error_name(UsConfigError error)
+{
+    switch (error) {
+    case UsConfigError::NONE:
+        return "none";
+    case UsConfigError::ZERO_TRIGGER:
+        return "zero_trigger";
+    case UsConfigError::BAD_RANGE:
+        return "bad_range";
+    case UsConfigError::BAD_DEVIATION:
+        return "bad_deviation";
+    case UsConfigError::TIMEOUT_TOO_SHORT:
+        return "timeout_too_short";
+    case UsConfigError::BAD_INTERVAL:
+        return "bad_interval";
+    case UsConfigError::BAD_ECHO_COUNT:
+        return "bad_echo_count";
+    case UsConfigError::BAD_GATE:
+        return "bad_gate";
+    }
+    return "unknown";
+}
+
+} // namespace ultrasonic
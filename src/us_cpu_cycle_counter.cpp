@@ -0,0 +1,28 @@
+// components/ultrasonic_sensor/src/us_cpu_cycle_counter.cpp
+
+#include "us_cpu_cycle_counter.hpp"
+
+#include <cstdint>
+
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_LINUX
+#include <chrono>
+#else
+#include "esp_cpu.h"
+#endif
+
+namespace ultrasonic {
+
+uint32_t UsCpuCycleCounter::cycles()
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#else
+    return static_cast<uint32_t>(esp_cpu_get_cycle_count());
+#endif
+}
+
+} // namespace ultrasonic
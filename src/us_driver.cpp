@@ -2,8 +2,12 @@
 
 #include "us_driver.hpp"
 
+#include <cmath>
 #include <cstdint>
 
+#include "freertos/FreeRTOS.h"
+#include "us_executor.hpp"
+
 #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
 #include "esp_log.h"
 
@@ -11,17 +15,25 @@ namespace ultrasonic {
 
 static const char *TAG = "UsDriver";
 
+// One FreeRTOS tick in microseconds
+static constexpr uint32_t TICK_US = 1000000 / configTICK_RATE_HZ;
+
 UsDriver::UsDriver(
     idf_hals::IGpioHAL &gpio_hal,
     idf_hals::ITimerHAL &timer_hal,
     idf_hals::ISysRomHAL &sys_rom_hal,
     gpio_num_t trig_pin,
-    gpio_num_t echo_pin)
+    gpio_num_t echo_pin,
+    const UsDriverOptions &opts)
     : gpio_hal_(gpio_hal)
     , timer_hal_(timer_hal)
     , sys_rom_hal_(sys_rom_hal)
+    , freertos_hal_(opts.freertos_hal)
+    , cycle_counter_(opts.cycle_counter)
     , trig_pin_(trig_pin)
     , echo_pin_(echo_pin)
+    , power_pin_(opts.power_pin)
+    , power_on_level_(opts.power_on_level)
 {
 }
 
@@ -67,7 +79,13 @@ esp_err_t UsDriver::init()
     if (ret != ESP_OK)
         return ret;
 
-    // Pulse echo low to clear any residual state
+    // Pulse echo low to clear any residual state; ECHO stays an output until the first ping.
+    // Nothing learned from pings before init() carries over.
+    echo_clean_ = false;
+    echo_abandoned_ = false;
+    track_echo_us_ = 0.0f;
+    predicted_rise_us_ = 0;
+    predicted_width_us_ = 0;
     ret = gpio_hal_.set_direction(echo_pin_, GPIO_MODE_OUTPUT);
     if (ret != ESP_OK)
         return ret;
@@ -76,6 +94,53 @@ esp_err_t UsDriver::init()
     if (ret != ESP_OK)
         return ret;
 
+    // Optional power-enable pin: configure as output and power the sensor
+    if (power_pin_ != GPIO_NUM_NC) {
+        ret = gpio_hal_.reset_pin(power_pin_);
+        if (ret != ESP_OK)
+            return ret;
+
+        gpio_config_t power_conf = {
+            .pin_bit_mask = 1ULL << power_pin_,
+            .mode = GPIO_MODE_OUTPUT,
+            .pull_up_en = GPIO_PULLUP_DISABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_DISABLE,
+        };
+        ret = gpio_hal_.config(&power_conf);
+        if (ret != ESP_OK)
+            return ret;
+
+        ret = gpio_hal_.set_level(power_pin_, power_on_level_);
+        if (ret != ESP_OK)
+            return ret;
+    }
+
+    // A counter that cannot be calibrated is not an init failure: edges use the timer instead
+    if (cycle_counter_ != nullptr && calibrate_cycle_counter() != ESP_OK) {
+        ESP_LOGW(TAG, "Cycle counter not advancing, timing echoes with the timer HAL");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t UsDriver::calibrate_cycle_counter()
+{
+    cycles_per_us_ = 0.0f;
+    if (cycle_counter_ == nullptr)
+        return ESP_ERR_INVALID_STATE;
+
+    int64_t t0 = timer_hal_.get_time_us();
+    uint32_t c0 = cycle_counter_->cycles();
+    sys_rom_hal_.delay_us(CYCLE_CALIBRATION_US);
+    uint32_t c1 = cycle_counter_->cycles();
+    int64_t t1 = timer_hal_.get_time_us();
+
+    if (t1 <= t0 || c1 == c0)
+        return ESP_ERR_INVALID_STATE;
+
+    cycles_per_us_ = static_cast<float>(c1 - c0) / static_cast<float>(t1 - t0);
+    ESP_LOGD(TAG, "Cycle counter: %.2f counts/us", cycles_per_us_);
     return ESP_OK;
 }
 
@@ -83,6 +148,7 @@ esp_err_t UsDriver::deinit()
 {
     // Reset pins to a safe state
     esp_err_t ret;
+    echo_clean_ = false;
 
     ret = gpio_hal_.set_level(trig_pin_, 0);
     if (ret != ESP_OK)
@@ -98,54 +164,280 @@ esp_err_t UsDriver::deinit()
     if (ret != ESP_OK)
         return ret;
 
+    // Power the sensor down before releasing the pin that switches it
+    if (power_pin_ != GPIO_NUM_NC) {
+        ret = gpio_hal_.set_level(power_pin_, power_on_level_ ? 0 : 1);
+        if (ret != ESP_OK)
+            return ret;
+        ret = gpio_hal_.reset_pin(power_pin_);
+        if (ret != ESP_OK)
+            return ret;
+    }
+
     return ESP_OK;
 }
 
 Reading UsDriver::ping_once(const UsConfig &cfg)
 {
-    // 1. Prepare: set ECHO as output low to clear residual state
-    if (gpio_hal_.set_direction(echo_pin_, GPIO_MODE_OUTPUT) != ESP_OK)
-        return {UsResult::HW_FAULT, 0.0f};
-    if (gpio_hal_.set_level(echo_pin_, 0) != ESP_OK)
-        return {UsResult::HW_FAULT, 0.0f};
-
-    // 2. Switch ECHO to input for measurement
-    if (gpio_hal_.set_direction(echo_pin_, GPIO_MODE_INPUT) != ESP_OK)
-        return {UsResult::HW_FAULT, 0.0f};
-
-    // 3. Check if ECHO is stuck HIGH before triggering
-    if (is_echo_stuck())
-        return {UsResult::ECHO_STUCK, 0.0f};
-
-    // 4. Send trigger pulse
-    esp_err_t ret = trigger(cfg.ping_duration_us);
-    if (ret != ESP_OK)
-        return {UsResult::HW_FAULT, 0.0f};
+    return ping_compiled(UsCompiledConfig(cfg));
+}
 
-    // 5. Wait for rising edge (start of echo pulse)
-    ret = wait_rising_edge(cfg.timeout_us);
+Reading UsDriver::ping_compiled(const UsCompiledConfig &cc)
+{
+    const UsConfig &cfg = cc.cfg;
+    last_echo_us_ = 0;
+    echo_gated_ = false;
+
+    // 1-5. Prepare ECHO, check for a stuck line and send the trigger pulse
+    UsResult started = start_ping(cfg);
+    if (started != UsResult::OK)
+        return {started, 0.0f};
+
+    // 6. Wait for rising edge (start of echo pulse)
+    uint32_t rise_us = 0;
+    esp_err_t ret = wait_rising_edge(cfg, rise_us);
     if (ret == ESP_ERR_TIMEOUT)
         return {UsResult::TIMEOUT, 0.0f};
     if (ret != ESP_OK)
         return {UsResult::HW_FAULT, 0.0f};
-
-    // 6. Measure the HIGH pulse duration
-    uint32_t duration_us = 0;
-    ret = measure_pulse(cfg.timeout_us, duration_us);
-    if (ret == ESP_ERR_TIMEOUT)
+    const uint32_t rise_gap_us = edge_gap_us_;
+
+    // 7. Measure the HIGH pulse duration. While tracking, the echo is expected
+    //    within track_gate_us of the last one, and a later one counts as lost.
+    const bool gated = (cc.track_gate_us > 0.0f && track_echo_us_ > 0.0f);
+    const float gate_open_us = gated ? track_echo_us_ - cc.track_gate_us : 0.0f;
+    uint32_t limit_us = cfg.timeout_us;
+    if (gated && track_echo_us_ + cc.track_gate_us < static_cast<float>(limit_us))
+        limit_us = static_cast<uint32_t>(std::ceil(track_echo_us_ + cc.track_gate_us));
+    track_echo_us_ = 0.0f;
+
+    float duration_us = 0.0f;
+    ret = measure_pulse(cfg, limit_us, predicted_width_us_, duration_us);
+    if (ret == ESP_ERR_TIMEOUT) {
+        if (limit_us < cfg.timeout_us) {
+            // The sensor still holds ECHO HIGH; the next ping waits for it to drop
+            stats_.gate_losses++;
+            echo_abandoned_ = true;
+        }
         return {UsResult::TIMEOUT, 0.0f};
+    }
     if (ret != ESP_OK)
         return {UsResult::HW_FAULT, 0.0f};
 
-    // 7. Convert to distance
-    float cm = (duration_us * SOUND_SPEED_CM_PER_US) / 2.0f;
+    // Predict the next echo from this one. An edge seen after a yield or sleep came
+    // after the poll before it, so the next ping spins from there.
+    const uint32_t fall_gap_us = edge_gap_us_;
+    predicted_rise_us_ = rise_us - rise_gap_us;
+    predicted_width_us_ = static_cast<uint32_t>(duration_us) - fall_gap_us;
+
+    // The edge may lie anywhere in the time the task was away: no usable width
+    if (rise_gap_us > MAX_EDGE_GAP_US || fall_gap_us > MAX_EDGE_GAP_US) {
+        ESP_LOGD(TAG, "Edge seen late: %.0f us echo", duration_us);
+        stats_.late_edges++;
+        echo_clean_ = true;
+        return {UsResult::HIGH_VARIANCE, 0.0f};
+    }
 
-    if (cm < cfg.min_distance_cm || cm > cfg.max_distance_cm) {
-        ESP_LOGD(TAG, "Out of range: %.1f cm (limits: %.1f-%.1f)", cm, cfg.min_distance_cm, cfg.max_distance_cm);
+    // An echo ending well before the gate is a nearer reflector (multipath, crosstalk)
+    if (duration_us < gate_open_us) {
+        ESP_LOGD(TAG, "Echo before gate: %.0f us (gate %.0f-%u)", duration_us, gate_open_us, limit_us);
+        stats_.gate_rejects++;
+        last_echo_us_ = static_cast<uint32_t>(std::lround(duration_us));
+        echo_gated_ = true;
+        echo_clean_ = true;
         return {UsResult::OUT_OF_RANGE, 0.0f};
     }
 
-    return {UsResult::OK, cm};
+    Reading reading = to_reading(cc, duration_us);
+    if (reading.result == UsResult::OK && cc.track_gate_us > 0.0f)
+        track_echo_us_ = duration_us;
+    return reading;
+}
+
+UsTask<Reading> UsDriver::ping(UsExecutor &exec, const UsConfig &cfg)
+{
+    // The compiled configuration lives in this frame until the ping completes
+    const UsCompiledConfig cc(cfg);
+    co_return co_await ping(exec, cc);
+}
+
+UsTask<Reading> UsDriver::ping(UsExecutor &exec, const UsCompiledConfig &cc)
+{
+    const UsConfig &cfg = cc.cfg;
+    last_echo_us_ = 0;
+    echo_gated_ = false;
+
+    // 1-3. Prepare ECHO and check for a stuck line
+    UsResult prepared = prepare_ping(cfg);
+    if (prepared != UsResult::OK)
+        co_return Reading{prepared, 0.0f};
+
+    // 4. Trigger jitter is slept, not busy-waited
+    if (cfg.trigger_jitter_us > 0)
+        co_await exec.sleep_us(next_jitter_us(cfg));
+
+    // 5. Send trigger pulse; the pulse may run longer than ping_duration_us
+    if (gpio_hal_.set_level(trig_pin_, 1) != ESP_OK)
+        co_return Reading{UsResult::HW_FAULT, 0.0f};
+    co_await exec.sleep_us(cfg.ping_duration_us);
+    if (gpio_hal_.set_level(trig_pin_, 0) != ESP_OK)
+        co_return Reading{UsResult::HW_FAULT, 0.0f};
+
+    // 6. Wait for rising edge, suspending between polls
+    int64_t start = timer_hal_.get_time_us();
+    while (true) {
+        int level = gpio_hal_.get_level(echo_pin_);
+        int64_t now = timer_hal_.get_time_us();
+        if (level != 0)
+            break;
+        if (now - start > cfg.timeout_us)
+            co_return Reading{UsResult::TIMEOUT, 0.0f};
+        co_await exec.poll();
+    }
+
+    // 7. Measure the HIGH pulse duration
+    int64_t echo_start = timer_hal_.get_time_us();
+    while (true) {
+        int level = gpio_hal_.get_level(echo_pin_);
+        int64_t now = timer_hal_.get_time_us();
+        if (level == 0)
+            break;
+        if (now - echo_start > cfg.timeout_us)
+            co_return Reading{UsResult::TIMEOUT, 0.0f};
+        co_await exec.poll();
+    }
+    int64_t echo_end = timer_hal_.get_time_us();
+
+    co_return to_reading(cc, static_cast<float>(echo_end - echo_start));
+}
+
+Reading UsDriver::to_reading(const UsCompiledConfig &cc, float duration_us)
+{
+    last_echo_us_ = static_cast<uint32_t>(std::lround(duration_us));
+
+    // The falling edge was seen, so the next ping may skip the clear sequence
+    echo_clean_ = true;
+
+    // 8. Range-check the echo width, then convert to distance
+    if (!cc.echo_in_range(duration_us)) {
+        ESP_LOGD(TAG, "Out of range: %.0f us (limits: %.0f-%.0f)", duration_us, cc.min_echo_us, cc.max_echo_us);
+        return {UsResult::OUT_OF_RANGE, 0.0f};
+    }
+
+    return {UsResult::OK, cc.echo_to_cm(duration_us)};
+}
+
+UsResult UsDriver::capture_echoes(const UsConfig &cfg, EchoCapture &out)
+{
+    out.count = 0;
+    last_echo_us_ = 0;
+    echo_gated_ = false;
+
+    UsResult started = start_ping(cfg);
+    if (started != UsResult::OK)
+        return started;
+
+    const uint8_t max_echoes = EchoCapture::clamp_count(cfg.max_echoes);
+
+    // Listen for the whole window and record every complete HIGH pulse
+    int64_t window_start = timer_hal_.get_time_us();
+    int64_t rise = 0;
+    int prev_level = 0;
+
+    while (out.count < max_echoes) {
+        int level = gpio_hal_.get_level(echo_pin_);
+        int64_t now = timer_hal_.get_time_us();
+
+        if (level != 0 && prev_level == 0) {
+            rise = now;
+        }
+        else if (level == 0 && prev_level != 0) {
+            EchoPulse &pulse = out.pulses[out.count++];
+            pulse.start_us = static_cast<uint32_t>(rise - window_start);
+            pulse.width_us = static_cast<uint32_t>(now - rise);
+            pulse.cm = (pulse.width_us * SOUND_SPEED_CM_PER_US) / 2.0f;
+        }
+        prev_level = level;
+
+        // A pulse still HIGH at the end of the window is incomplete and dropped
+        if (now - window_start > cfg.timeout_us)
+            break;
+    }
+
+    if (out.count == 0)
+        return UsResult::TIMEOUT;
+
+    last_echo_us_ = out.pulses[0].width_us;
+    return UsResult::OK;
+}
+
+UsResult UsDriver::start_ping(const UsConfig &cfg)
+{
+    // 1-3. Prepare ECHO and check for a stuck line
+    UsResult prepared = prepare_ping(cfg);
+    if (prepared != UsResult::OK)
+        return prepared;
+
+    // 4. Optional random delay, so co-located sensors firing at the same rate do not stay aligned
+    if (cfg.trigger_jitter_us > 0)
+        sys_rom_hal_.delay_us(next_jitter_us(cfg));
+
+    // 5. Send trigger pulse
+    if (trigger(cfg.ping_duration_us) != ESP_OK)
+        return UsResult::HW_FAULT;
+
+    return UsResult::OK;
+}
+
+UsResult UsDriver::prepare_ping(const UsConfig &cfg)
+{
+    // 0. Let a pulse abandoned at the end of a tracking gate run out, so it is not taken for a stuck line
+    if (echo_abandoned_) {
+        echo_abandoned_ = false;
+        float unused_us = 0.0f;
+        (void)measure_pulse(cfg, cfg.timeout_us, 0, unused_us); // still HIGH after timeout_us: the stuck check decides
+    }
+
+    // Until this ping completes, any exit (timeout, stuck, fault) forces the full sequence next time
+    const bool skip_clear = cfg.fast_ping && echo_clean_;
+    echo_clean_ = false;
+
+    if (skip_clear) {
+        stats_.fast_preps++;
+    }
+    else {
+        stats_.full_preps++;
+
+        // 1. Prepare: set ECHO as output low to clear residual state
+        if (gpio_hal_.set_direction(echo_pin_, GPIO_MODE_OUTPUT) != ESP_OK)
+            return UsResult::HW_FAULT;
+        if (gpio_hal_.set_level(echo_pin_, 0) != ESP_OK)
+            return UsResult::HW_FAULT;
+
+        // 2. Switch ECHO to input for measurement
+        if (gpio_hal_.set_direction(echo_pin_, GPIO_MODE_INPUT) != ESP_OK)
+            return UsResult::HW_FAULT;
+    }
+
+    // 3. Check if ECHO is stuck HIGH before triggering; try to clear it if enabled
+    if (is_echo_stuck()) {
+        stats_.stuck_events++;
+        esp_err_t rec = recover_stuck_echo(cfg);
+        if (rec == ESP_ERR_INVALID_STATE)
+            return UsResult::ECHO_STUCK;
+        if (rec != ESP_OK)
+            return UsResult::HW_FAULT;
+        stats_.stuck_recoveries++;
+    }
+
+    return UsResult::OK;
+}
+
+uint32_t UsDriver::next_jitter_us(const UsConfig &cfg)
+{
+    if (jitter_.seed() != cfg.jitter_seed)
+        jitter_.reseed(cfg.jitter_seed);
+    return jitter_.next_delay_us(cfg.trigger_jitter_us);
 }
 
 bool UsDriver::is_echo_stuck()
@@ -153,6 +445,66 @@ bool UsDriver::is_echo_stuck()
     return gpio_hal_.get_level(echo_pin_) != 0;
 }
 
+esp_err_t UsDriver::recover_stuck_echo(const UsConfig &cfg)
+{
+    esp_err_t ret;
+
+    for (uint8_t attempt = 0; attempt < cfg.stuck_recovery_attempts; attempt++) {
+        // a. Drive ECHO low to discharge the line, then release it
+        ret = discharge_echo(cfg.stuck_settle_us);
+        if (ret != ESP_OK)
+            return ret;
+        if (!is_echo_stuck())
+            return ESP_OK;
+
+        // b. Retrigger so the sensor can finish its measurement cycle, wait for ECHO to drop
+        ret = trigger(cfg.ping_duration_us);
+        if (ret != ESP_OK)
+            return ret;
+        float unused_us = 0.0f;
+        ret = measure_pulse(cfg, cfg.timeout_us, 0, unused_us);
+        if (ret != ESP_OK && ret != ESP_ERR_TIMEOUT)
+            return ret;
+        sys_rom_hal_.delay_us(cfg.stuck_settle_us);
+        if (!is_echo_stuck())
+            return ESP_OK;
+
+        // c. Power-cycle the sensor, if a power-enable pin is wired
+        if (power_pin_ != GPIO_NUM_NC && cfg.power_cycle_us > 0) {
+            ESP_LOGW(TAG, "ECHO stuck, power-cycling sensor (attempt %d)", attempt + 1);
+            ret = gpio_hal_.set_level(power_pin_, power_on_level_ ? 0 : 1);
+            if (ret != ESP_OK)
+                return ret;
+            sys_rom_hal_.delay_us(cfg.power_cycle_us);
+            ret = gpio_hal_.set_level(power_pin_, power_on_level_);
+            if (ret != ESP_OK)
+                return ret;
+            sys_rom_hal_.delay_us(cfg.power_cycle_us);
+            stats_.power_cycles++;
+
+            ret = discharge_echo(cfg.stuck_settle_us);
+            if (ret != ESP_OK)
+                return ret;
+            if (!is_echo_stuck())
+                return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t UsDriver::discharge_echo(uint16_t settle_us)
+{
+    esp_err_t ret = gpio_hal_.set_direction(echo_pin_, GPIO_MODE_OUTPUT);
+    if (ret != ESP_OK)
+        return ret;
+    ret = gpio_hal_.set_level(echo_pin_, 0);
+    if (ret != ESP_OK)
+        return ret;
+    sys_rom_hal_.delay_us(settle_us);
+    return gpio_hal_.set_direction(echo_pin_, GPIO_MODE_INPUT);
+}
+
 esp_err_t UsDriver::trigger(uint16_t pulse_duration_us)
 {
     esp_err_t ret;
@@ -167,43 +519,161 @@ esp_err_t UsDriver::trigger(uint16_t pulse_duration_us)
     return ret;
 }
 
-esp_err_t UsDriver::wait_rising_edge(uint32_t timeout_us)
+esp_err_t UsDriver::wait_rising_edge(const UsConfig &cfg, uint32_t &rise_us)
 {
+    if (cycles_per_us_ > 0.0f)
+        return wait_rising_edge_cycles(cfg, rise_us);
+
     int64_t start = timer_hal_.get_time_us();
+    int64_t polled = start;
     int level = 0;
+    bool relaxed = false;
 
     do {
         level = gpio_hal_.get_level(echo_pin_);
         int64_t now = timer_hal_.get_time_us();
 
         if (level != 0) {
+            rise_us = static_cast<uint32_t>(now - start);
+            edge_gap_us_ = relaxed ? static_cast<uint32_t>(now - polled) : 0;
             return ESP_OK;
         }
 
-        if (now - start > timeout_us)
+        if (now - start > cfg.timeout_us)
             return ESP_ERR_TIMEOUT;
+
+        polled = now;
+        relaxed = relax(cfg, static_cast<uint32_t>(now - start), predicted_rise_us_);
     } while (true);
 }
 
-esp_err_t UsDriver::measure_pulse(uint32_t timeout_us, uint32_t &duration_us)
+esp_err_t UsDriver::measure_pulse(const UsConfig &cfg, uint32_t limit_us, uint32_t predicted_us, float &duration_us)
 {
+    if (cycles_per_us_ > 0.0f)
+        return measure_pulse_cycles(cfg, limit_us, predicted_us, duration_us);
+
     int64_t echo_start = timer_hal_.get_time_us();
+    int64_t polled = echo_start;
     int level = 1;
+    bool relaxed = false;
 
     do {
         level = gpio_hal_.get_level(echo_pin_);
         int64_t now = timer_hal_.get_time_us();
 
         if (level == 0) {
+            edge_gap_us_ = relaxed ? static_cast<uint32_t>(now - polled) : 0;
             break;
         }
 
-        if (now - echo_start > timeout_us)
+        if (now - echo_start > limit_us)
             return ESP_ERR_TIMEOUT;
+
+        polled = now;
+        relaxed = relax(cfg, static_cast<uint32_t>(now - echo_start), predicted_us);
     } while (true);
 
     int64_t echo_end = timer_hal_.get_time_us();
-    duration_us = static_cast<uint32_t>(echo_end - echo_start);
+    duration_us = static_cast<float>(echo_end - echo_start);
+    return ESP_OK;
+}
+
+bool UsDriver::relax(const UsConfig &cfg, uint32_t elapsed_us, uint32_t predicted_us)
+{
+    if (cfg.echo_wait == EchoWait::SPIN || freertos_hal_ == nullptr)
+        return false;
+
+    // Spin through the near field, and around the predicted edge
+    if (elapsed_us < cfg.spin_window_us)
+        return false;
+    const uint32_t spin_from = (predicted_us > cfg.spin_guard_us) ? predicted_us - cfg.spin_guard_us : 0;
+    if (predicted_us != 0 && elapsed_us >= spin_from && elapsed_us <= predicted_us + cfg.spin_guard_us)
+        return false;
+
+    // Sleep only whole ticks that end before the predicted edge. The task wakes
+    // later when other tasks of equal or higher priority are ready; the caller
+    // rejects an edge seen after too long a gap.
+    if (cfg.echo_wait == EchoWait::SPIN_SLEEP && predicted_us != 0 && elapsed_us < spin_from) {
+        uint32_t ticks = (spin_from - elapsed_us) / TICK_US;
+        if (ticks > 0) {
+            stats_.wait_sleeps++;
+            freertos_hal_->task_delay(ticks);
+            return true;
+        }
+    }
+
+    // Let ready tasks of the same priority run; returns at once if there are none,
+    // after a whole time slice if one is ready
+    stats_.wait_yields++;
+    freertos_hal_->task_delay(0);
+    return true;
+}
+
+uint32_t UsDriver::timeout_cycles(uint32_t timeout_us) const
+{
+    // Unsigned differences stay correct across one wrap, so keep timeouts under half the range
+    float cycles = static_cast<float>(timeout_us) * cycles_per_us_;
+    return (cycles >= static_cast<float>(UINT32_MAX / 2)) ? UINT32_MAX / 2 : static_cast<uint32_t>(cycles);
+}
+
+esp_err_t UsDriver::wait_rising_edge_cycles(const UsConfig &cfg, uint32_t &rise_us)
+{
+    const uint32_t limit = timeout_cycles(cfg.timeout_us);
+    const bool relaxing = (cfg.echo_wait != EchoWait::SPIN);
+    const uint32_t start = cycle_counter_->cycles();
+    uint32_t polled = start;
+    bool relaxed = false;
+
+    do {
+        int level = gpio_hal_.get_level(echo_pin_);
+        uint32_t now = cycle_counter_->cycles();
+
+        if (level != 0) {
+            rise_us = static_cast<uint32_t>((now - start) / cycles_per_us_);
+            edge_gap_us_ = relaxed ? static_cast<uint32_t>((now - polled) / cycles_per_us_) : 0;
+            return ESP_OK;
+        }
+
+        if (now - start > limit)
+            return ESP_ERR_TIMEOUT;
+
+        if (relaxing) {
+            polled = now;
+            relaxed = relax(cfg, static_cast<uint32_t>((now - start) / cycles_per_us_), predicted_rise_us_);
+        }
+    } while (true);
+}
+
+esp_err_t UsDriver::measure_pulse_cycles(const UsConfig &cfg, uint32_t limit_us, uint32_t predicted_us,
+                                         float &duration_us)
+{
+    const uint32_t limit = timeout_cycles(limit_us);
+    const bool relaxing = (cfg.echo_wait != EchoWait::SPIN);
+    const uint32_t echo_start = cycle_counter_->cycles();
+    uint32_t now;
+    uint32_t polled = echo_start;
+    bool relaxed = false;
+
+    do {
+        int level = gpio_hal_.get_level(echo_pin_);
+        now = cycle_counter_->cycles();
+
+        if (level == 0)
+            break;
+
+        if (now - echo_start > limit)
+            return ESP_ERR_TIMEOUT;
+
+        if (relaxing) {
+            polled = now;
+            relaxed = relax(cfg, static_cast<uint32_t>((now - echo_start) / cycles_per_us_), predicted_us);
+        }
+    } while (true);
+
+    edge_gap_us_ = relaxed ? static_cast<uint32_t>((now - polled) / cycles_per_us_) : 0;
+
+    // Only the edge timestamps are converted; the counter read after the falling edge ends the pulse
+    duration_us = static_cast<float>(now - echo_start) / cycles_per_us_;
     return ESP_OK;
 }
 
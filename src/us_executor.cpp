@@ -0,0 +1,106 @@
+// components/ultrasonic_sensor/src/us_executor.cpp
+
+#include "us_executor.hpp"
+
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+
+namespace ultrasonic {
+
+// One FreeRTOS tick in microseconds
+static constexpr int64_t TICK_US = 1000000 / configTICK_RATE_HZ;
+
+UsExecutor::UsExecutor(
+    idf_hals::ITimerHAL &timer_hal,
+    idf_hals::ISysRomHAL &sys_rom_hal,
+    idf_hals::IHalFreertos &freertos_hal,
+    uint32_t poll_us)
+    : timer_hal_(timer_hal)
+    , sys_rom_hal_(sys_rom_hal)
+    , freertos_hal_(freertos_hal)
+    , poll_us_(poll_us)
+{
+}
+
+UsExecutor::~UsExecutor()
+{
+    // Destroying a root destroys the whole chain of tasks it awaits
+    destroying_ = true;
+    for (std::coroutine_handle<> h : roots_) {
+        h.destroy();
+    }
+    roots_.clear();
+}
+
+UsExecutor::Root UsExecutor::run_root(UsTask<void> task)
+{
+    co_await task;
+}
+
+void UsExecutor::spawn(UsTask<void> task)
+{
+    Root root = run_root(std::move(task));
+    root.handle.promise().exec = this;
+    roots_.push_front(root.handle);
+    root.handle.promise().self = roots_.begin();
+    ready_.push_back(root.handle);
+}
+
+void UsExecutor::forget(std::list<std::coroutine_handle<>>::iterator it)
+{
+    if (!destroying_)
+        roots_.erase(it);
+}
+
+void UsExecutor::run()
+{
+    while (!roots_.empty() || !ready_.empty() || !timers_.empty()) {
+        if (!run_once())
+            idle();
+    }
+}
+
+bool UsExecutor::run_once()
+{
+    const int64_t now = now_us();
+    while (!timers_.empty() && timers_.top().wake_us <= now) {
+        ready_.push_back(timers_.top().handle);
+        timers_.pop();
+    }
+
+    // Only the coroutines ready now; the ones they schedule wait for the next step
+    size_t n = ready_.size();
+    for (size_t i = 0; i < n; i++) {
+        std::coroutine_handle<> h = ready_.front();
+        ready_.pop_front();
+        resumptions_++;
+        h.resume();
+    }
+    return n > 0;
+}
+
+int64_t UsExecutor::now_us() const
+{
+    return timer_hal_.get_time_us();
+}
+
+void UsExecutor::schedule_at(int64_t wake_us, std::coroutine_handle<> h)
+{
+    timers_.push(Timer{wake_us, timer_seq_++, h});
+}
+
+void UsExecutor::idle()
+{
+    if (timers_.empty() || !ready_.empty())
+        return;
+
+    const int64_t wait_us = timers_.top().wake_us - now_us();
+    if (wait_us >= TICK_US) {
+        freertos_hal_.task_delay(static_cast<TickType_t>(wait_us / TICK_US));
+    } else if (wait_us > 0) {
+        sys_rom_hal_.delay_us(static_cast<uint32_t>(wait_us));
+    }
+}
+
+} // namespace ultrasonic
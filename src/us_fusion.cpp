@@ -0,0 +1,165 @@
+// components/ultrasonic_sensor/src/us_fusion.cpp
+
+#include "us_fusion.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ultrasonic {
+
+UsFusion::UsFusion(const UsFusionConfig &cfg)
+    : cfg_(cfg)
+{
+}
+
+esp_err_t UsFusion::add_sensor(UsSensor *sensor)
+{
+    if (sensor == nullptr)
+        return ESP_ERR_INVALID_ARG;
+    for (size_t i = 0; i < count_; i++) {
+        if (sensors_[i] == sensor)
+            return ESP_ERR_INVALID_ARG;
+    }
+    if (count_ == MAX_SENSORS)
+        return ESP_ERR_NO_MEM;
+
+    sensors_[count_] = sensor;
+    strikes_[count_] = 0;
+    count_++;
+    return ESP_OK;
+}
+
+FusedReading UsFusion::read_distance()
+{
+    MeasurementInfo bursts[MAX_SENSORS];
+    for (size_t i = 0; i < count_; i++) {
+        bursts[i] = sensors_[i]->read_distance_ex(cfg_.pings_per_sensor);
+    }
+    return combine(bursts, count_);
+}
+
+FusedReading UsFusion::combine(const MeasurementInfo *bursts, size_t count)
+{
+    FusedReading out;
+    out.reading = {UsResult::INSUFFICIENT_SAMPLES, 0.0f};
+    count = std::min(count, MAX_SENSORS);
+    if (count == 0)
+        return out;
+
+    struct Vote
+    {
+        float cm;
+        float weight;
+        uint8_t bit;
+        uint8_t samples;
+    };
+    Vote votes[MAX_SENSORS];
+    size_t n = 0;
+    uint8_t failures[US_RESULT_COUNT] = {};
+
+    // 1. Successful bursts vote with the pings they kept; a weak burst counts half
+    for (size_t i = 0; i < count; i++) {
+        const MeasurementInfo &b = bursts[i];
+        const uint8_t bit = static_cast<uint8_t>(1u << i);
+        if (is_success(b.reading.result)) {
+            const uint8_t samples = std::max<uint8_t>(b.filter_samples, 1);
+            const float weight = (b.reading.result == UsResult::WEAK_SIGNAL) ? samples * 0.5f : samples;
+            votes[n++] = {b.reading.cm, weight, bit, samples};
+        }
+        else {
+            out.failed_mask |= bit;
+            const size_t r = static_cast<size_t>(b.reading.result);
+            failures[(r < US_RESULT_COUNT) ? r : static_cast<size_t>(UsResult::HW_FAULT)]++;
+        }
+    }
+    out.sensors = static_cast<uint8_t>(n);
+
+    // No distance at all: report the failure most sensors saw
+    if (n == 0) {
+        const size_t worst = static_cast<size_t>(std::max_element(failures, failures + US_RESULT_COUNT) - failures);
+        out.reading = {static_cast<UsResult>(worst), 0.0f};
+        out.faulty_mask = faulty_mask();
+        return out;
+    }
+
+    // 2. Weighted median of the sensor distances
+    std::sort(votes, votes + n, [](const Vote &a, const Vote &b) { return a.cm < b.cm; });
+    float total = 0.0f;
+    for (size_t i = 0; i < n; i++) total += votes[i].weight;
+    float median = votes[n - 1].cm;
+    float acc = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        acc += votes[i].weight;
+        if (2.0f * acc >= total) {
+            median = votes[i].cm;
+            break;
+        }
+    }
+
+    // 3. The sensors around it form the consensus; their weighted mean is the distance
+    float sum_cm = 0.0f;
+    float sum_weight = 0.0f;
+    unsigned samples = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (std::fabs(votes[i].cm - median) <= cfg_.agree_cm) {
+            sum_cm += votes[i].weight * votes[i].cm;
+            sum_weight += votes[i].weight;
+            samples += votes[i].samples;
+            out.agreeing++;
+        }
+        else {
+            out.disagree_mask |= votes[i].bit;
+        }
+    }
+    const float fused = sum_cm / sum_weight;
+    out.samples = static_cast<uint8_t>(std::min(samples, 255u));
+    for (size_t i = 0; i < n; i++) {
+        if ((out.disagree_mask & votes[i].bit) == 0)
+            out.spread_cm = std::max(out.spread_cm, std::fabs(votes[i].cm - fused));
+    }
+
+    // 4. Result
+    const uint8_t quorum = static_cast<uint8_t>(std::clamp<size_t>(cfg_.quorum, 1, count));
+    const bool has_quorum = out.agreeing >= quorum;
+    if (has_quorum)
+        out.reading = {UsResult::OK, fused};
+    else if (out.disagree_mask == 0)
+        out.reading = {UsResult::WEAK_SIGNAL, fused};
+    else
+        out.reading = {UsResult::HIGH_VARIANCE, 0.0f};
+
+    // 5. Strikes: a failed burst next to a working sensor always counts, a
+    //    disagreeing one only against a quorum; a sensor in an accepted consensus is cleared
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t bit = static_cast<uint8_t>(1u << i);
+        const bool strike = (out.failed_mask & bit) || (has_quorum && (out.disagree_mask & bit));
+        if (strike) {
+            if (strikes_[i] < UINT8_MAX)
+                strikes_[i]++;
+        }
+        else if (!(out.disagree_mask & bit) && out.reading.result != UsResult::HIGH_VARIANCE) {
+            strikes_[i] = 0;
+        }
+    }
+
+    out.faulty_mask = faulty_mask();
+    return out;
+}
+
+uint8_t UsFusion::faulty_mask() const
+{
+    uint8_t mask = 0;
+    for (size_t i = 0; i < MAX_SENSORS; i++) {
+        if (cfg_.fault_after > 0 && strikes_[i] >= cfg_.fault_after)
+            mask |= static_cast<uint8_t>(1u << i);
+    }
+    return mask;
+}
+
+void UsFusion::reset_faults()
+{
+    for (uint8_t &s : strikes_) s = 0;
+}
+
+} // namespace ultrasonic
@@ -0,0 +1,30 @@
+// components/ultrasonic_sensor/src/us_gpio_input_register.cpp
+
+#include "us_gpio_input_register.hpp"
+
+#include <cstdint>
+
+#include "sdkconfig.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+#endif
+
+namespace ultrasonic {
+
+uint64_t UsGpioInputRegister::read_inputs()
+{
+#if CONFIG_IDF_TARGET_LINUX
+    return 0;
+#else
+    uint64_t levels = REG_READ(GPIO_IN_REG);
+#if SOC_GPIO_PIN_COUNT > 32
+    levels |= static_cast<uint64_t>(REG_READ(GPIO_IN1_REG)) << 32;
+#endif
+    return levels;
+#endif
+}
+
+} // namespace ultrasonic
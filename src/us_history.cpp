@@ -0,0 +1,485 @@
+// components/ultrasonic_sensor/src/us_history.cpp
+
+#include "us_history.hpp"
+#include "us_history_file.hpp"
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "esp_log.h"
+
+namespace ultrasonic {
+
+static const char *TAG = "UsHistory";
+
+// Two varints of at most 10 bytes each
+static constexpr size_t MAX_SAMPLE_BYTES = 20;
+
+static inline uint64_t zigzag(int64_t v)
+{
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v)
+{
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+static size_t put_varint(uint8_t *p, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = static_cast<uint8_t>(v);
+    return n;
+}
+
+static bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool header_valid(const HistoryBlockHeader &h, size_t block_size)
+{
+    return h.magic == HISTORY_MAGIC && h.count > 0 && h.used >= sizeof(HistoryBlockHeader) && h.used <= block_size;
+}
+
+namespace {
+
+// Walks the samples of one block, oldest first
+class BlockCursor
+{
+public:
+    BlockCursor(const HistoryBlockHeader &header, const uint8_t *block)
+        : header_(header)
+        , p_(block + sizeof(HistoryBlockHeader))
+        , end_(block + header.used)
+    {
+    }
+
+    bool next(HistorySample &s)
+    {
+        if (index_ >= header_.count)
+            return false;
+
+        if (index_ == 0) {
+            us_ = header_.first_us;
+            bits_ = header_.first_bits;
+        } else {
+            uint64_t dd;
+            uint64_t db;
+            if (!get_varint(p_, end_, dd) || !get_varint(p_, end_, db))
+                return false;
+            delta_us_ += unzigzag(dd);
+            us_ += delta_us_;
+            bits_ = static_cast<uint32_t>(static_cast<int64_t>(bits_) + unzigzag(db));
+        }
+
+        index_++;
+        s.timestamp_us = us_;
+        s.reading.bits = bits_;
+        return true;
+    }
+
+    uint16_t index() const { return index_; }
+    size_t offset(const uint8_t *block) const { return static_cast<size_t>(p_ - block); }
+    int64_t delta_us() const { return delta_us_; }
+
+private:
+    const HistoryBlockHeader &header_;
+    const uint8_t *p_;
+    const uint8_t *end_;
+    uint16_t index_ = 0;
+    int64_t us_ = 0;
+    int64_t delta_us_ = 0;
+    uint32_t bits_ = 0;
+};
+
+} // namespace
+
+// =================================================================
+// UsHistory
+// =================================================================
+
+UsHistory::UsHistory(IUsHistoryStorage &storage)
+    : storage_(storage)
+{
+}
+
+esp_err_t UsHistory::init()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    block_size_ = storage_.block_size();
+    block_count_ = storage_.block_count();
+    if (block_size_ < MIN_BLOCK_SIZE || block_size_ > MAX_BLOCK_SIZE || block_count_ < 2) {
+        head_.reset();
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    head_.reset(new (std::nothrow) uint8_t[block_size_]);
+    scratch_.reset(new (std::nothrow) uint8_t[block_size_]);
+    if (!head_ || !scratch_) {
+        head_.reset();
+        return ESP_ERR_NO_MEM;
+    }
+
+    stats_ = UsHistoryStats{};
+    head_hdr_ = HistoryBlockHeader{};
+    head_seq_ = 0;
+    oldest_seq_ = 0;
+
+    // Find the newest block
+    bool found = false;
+    uint32_t newest = 0;
+    for (uint32_t i = 0; i < block_count_; i++) {
+        HistoryBlockHeader h;
+        if (storage_.read(i, 0, &h, sizeof(h)) != ESP_OK) {
+            head_.reset();
+            return ESP_FAIL;
+        }
+        if (header_valid(h, block_size_) && h.seq % block_count_ == i && (!found || h.seq > newest)) {
+            newest = h.seq;
+            found = true;
+        }
+    }
+    if (!found)
+        return ESP_OK;
+
+    // Older blocks belong to the history as long as their sequence is unbroken
+    uint32_t retained = 0;
+    oldest_seq_ = newest;
+    while (oldest_seq_ > 0 && newest - (oldest_seq_ - 1) < block_count_) {
+        HistoryBlockHeader h;
+        if (!read_header(oldest_seq_ - 1, h))
+            break;
+        oldest_seq_--;
+        retained += h.count;
+    }
+
+    // The newest block becomes the RAM block again; replay it to restore the encoder state
+    if (storage_.read(newest % block_count_, 0, head_.get(), block_size_) != ESP_OK) {
+        head_.reset();
+        return ESP_FAIL;
+    }
+    memcpy(&head_hdr_, head_.get(), sizeof(head_hdr_));
+    head_seq_ = newest;
+
+    BlockCursor cursor(head_hdr_, head_.get());
+    HistorySample s;
+    while (cursor.next(s)) {
+        head_hdr_.last_us = s.timestamp_us;
+        prev_us_ = s.timestamp_us;
+        prev_bits_ = s.reading.bits;
+    }
+    prev_delta_us_ = cursor.delta_us();
+    if (cursor.index() < head_hdr_.count) {
+        ESP_LOGW(TAG, "Block %" PRIu32 " truncated to %u samples", newest, cursor.index());
+        head_hdr_.count = cursor.index();
+        head_hdr_.used = static_cast<uint16_t>(cursor.offset(head_.get()));
+    }
+
+    stats_.retained = retained + head_hdr_.count;
+    ESP_LOGI(TAG, "Resumed at block %" PRIu32 " with %" PRIu32 " samples", newest, stats_.retained);
+    return ESP_OK;
+}
+
+esp_err_t UsHistory::append(int64_t timestamp_us, const Reading &reading)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!head_) {
+        stats_.dropped++;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const uint32_t bits = PackedReading::pack(reading).bits;
+
+    if (head_hdr_.count == 0) {
+        start_block(head_seq_, timestamp_us, bits);
+    } else {
+        if (timestamp_us < prev_us_) {
+            stats_.dropped++;
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        const int64_t delta_us = timestamp_us - prev_us_;
+        uint8_t buf[MAX_SAMPLE_BYTES];
+        size_t len = put_varint(buf, zigzag(delta_us - prev_delta_us_));
+        len += put_varint(buf + len, zigzag(static_cast<int64_t>(bits) - static_cast<int64_t>(prev_bits_)));
+
+        if (head_hdr_.used + len > block_size_) {
+            if (seal_block() != ESP_OK) {
+                stats_.dropped++;
+                return ESP_FAIL;
+            }
+
+            // The next block takes the slot of the oldest one once the ring is full
+            const uint32_t seq = head_seq_ + 1;
+            if (seq >= block_count_ && seq - block_count_ >= oldest_seq_) {
+                HistoryBlockHeader evicted;
+                if (read_header(seq - block_count_, evicted)) {
+                    stats_.retained -= evicted.count;
+                }
+                oldest_seq_ = seq - block_count_ + 1;
+            }
+            start_block(seq, timestamp_us, bits);
+        } else {
+            memcpy(head_.get() + head_hdr_.used, buf, len);
+            head_hdr_.used += static_cast<uint16_t>(len);
+            head_hdr_.count++;
+            head_hdr_.last_us = timestamp_us;
+            prev_us_ = timestamp_us;
+            prev_delta_us_ = delta_us;
+            prev_bits_ = bits;
+        }
+    }
+
+    stats_.appended++;
+    stats_.retained++;
+    return ESP_OK;
+}
+
+void UsHistory::on_reading(const TimedReading &reading)
+{
+    append(reading.timestamp_us, reading.reading);
+}
+
+esp_err_t UsHistory::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!head_ || head_hdr_.count == 0)
+        return ESP_OK;
+    return seal_block();
+}
+
+size_t UsHistory::query(int64_t from_us, int64_t to_us, HistorySample *out, size_t max_out)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t n = 0;
+    if (!head_ || out == nullptr || max_out == 0 || from_us > to_us)
+        return 0;
+
+    // Blocks are in time order: binary search the first one ending at or after from_us
+    uint32_t lo = oldest_seq_;
+    uint32_t hi = head_seq_;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        HistoryBlockHeader h;
+        if (read_header(mid, h) && h.last_us < from_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for (uint32_t seq = lo; seq < head_seq_ && n < max_out; seq++) {
+        HistoryBlockHeader h;
+        if (!read_header(seq, h))
+            continue;
+        if (h.first_us > to_us)
+            return n;
+        if (storage_.read(seq % block_count_, 0, scratch_.get(), h.used) != ESP_OK)
+            continue;
+        decode_into(h, scratch_.get(), from_us, to_us, out, max_out, n);
+    }
+
+    if (n < max_out && head_hdr_.count > 0 && head_hdr_.last_us >= from_us && head_hdr_.first_us <= to_us) {
+        decode_into(head_hdr_, head_.get(), from_us, to_us, out, max_out, n);
+    }
+    return n;
+}
+
+UsHistoryStats UsHistory::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    UsHistoryStats s = stats_;
+    s.stored_bytes = static_cast<uint64_t>(head_seq_ - oldest_seq_) * block_size_ + head_hdr_.used;
+    return s;
+}
+
+float UsHistory::compression_ratio() const
+{
+    UsHistoryStats s = stats();
+    if (s.stored_bytes == 0)
+        return 0.0f;
+    return static_cast<float>(static_cast<double>(s.retained) * HISTORY_RAW_SAMPLE_BYTES / s.stored_bytes);
+}
+
+float UsHistory::bytes_per_sample() const
+{
+    UsHistoryStats s = stats();
+    if (s.retained == 0)
+        return 0.0f;
+    return static_cast<float>(static_cast<double>(s.stored_bytes) / s.retained);
+}
+
+bool UsHistory::read_header(uint32_t seq, HistoryBlockHeader &header)
+{
+    if (storage_.read(seq % block_count_, 0, &header, sizeof(header)) != ESP_OK)
+        return false;
+    return header_valid(header, block_size_) && header.seq == seq;
+}
+
+void UsHistory::start_block(uint32_t seq, int64_t timestamp_us, uint32_t bits)
+{
+    head_seq_ = seq;
+    head_hdr_ = HistoryBlockHeader{};
+    head_hdr_.magic = HISTORY_MAGIC;
+    head_hdr_.seq = seq;
+    head_hdr_.first_us = timestamp_us;
+    head_hdr_.last_us = timestamp_us;
+    head_hdr_.first_bits = bits;
+    head_hdr_.count = 1;
+    head_hdr_.used = sizeof(HistoryBlockHeader);
+
+    prev_us_ = timestamp_us;
+    prev_delta_us_ = 0;
+    prev_bits_ = bits;
+}
+
+esp_err_t UsHistory::seal_block()
+{
+    memcpy(head_.get(), &head_hdr_, sizeof(head_hdr_));
+    if (storage_.write(head_seq_ % block_count_, head_.get(), head_hdr_.used) != ESP_OK) {
+        ESP_LOGE(TAG, "Cannot write block %" PRIu32, head_seq_);
+        return ESP_FAIL;
+    }
+    stats_.blocks_written++;
+    return ESP_OK;
+}
+
+void UsHistory::decode_into(const HistoryBlockHeader &header, const uint8_t *block, int64_t from_us, int64_t to_us,
+                            HistorySample *out, size_t max_out, size_t &n)
+{
+    stats_.blocks_decoded++;
+
+    BlockCursor cursor(header, block);
+    HistorySample s;
+    while (n < max_out && cursor.next(s)) {
+        if (s.timestamp_us > to_us)
+            break;
+        if (s.timestamp_us >= from_us)
+            out[n++] = s;
+    }
+}
+
+// =================================================================
+// UsHistoryRamStorage
+// =================================================================
+
+UsHistoryRamStorage::UsHistoryRamStorage(size_t block_size, uint32_t block_count)
+    : data_(new uint8_t[block_size * block_count]())
+    , block_size_(block_size)
+    , block_count_(block_count)
+{
+}
+
+esp_err_t UsHistoryRamStorage::read(uint32_t block, size_t offset, void *dst, size_t len)
+{
+    if (block >= block_count_ || offset > block_size_ || len > block_size_ - offset)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(dst, data_.get() + block * block_size_ + offset, len);
+    return ESP_OK;
+}
+
+esp_err_t UsHistoryRamStorage::write(uint32_t block, const void *src, size_t len)
+{
+    if (block >= block_count_ || len > block_size_)
+        return ESP_ERR_INVALID_ARG;
+    memcpy(data_.get() + block * block_size_, src, len);
+    return ESP_OK;
+}
+
+// =================================================================
+// UsHistoryFileStorage
+// =================================================================
+
+UsHistoryFileStorage::~UsHistoryFileStorage()
+{
+    close();
+}
+
+esp_err_t UsHistoryFileStorage::open(const char *path, size_t block_size, uint32_t block_count)
+{
+    if (file_ != nullptr)
+        return ESP_ERR_INVALID_STATE;
+    if (block_size == 0 || block_count == 0)
+        return ESP_ERR_INVALID_ARG;
+
+    file_ = fopen(path, "r+b");
+    if (file_ == nullptr) {
+        file_ = fopen(path, "w+b");
+    }
+    if (file_ == nullptr) {
+        ESP_LOGE(TAG, "Cannot open history file %s", path);
+        return ESP_FAIL;
+    }
+
+    // Extend the file so that every block can be read
+    const long total = static_cast<long>(block_size * block_count);
+    bool ok = fseek(file_, 0, SEEK_END) == 0;
+    long size = ok ? ftell(file_) : -1;
+    ok = ok && size >= 0;
+    static const uint8_t zeros[64] = {};
+    while (ok && size < total) {
+        size_t chunk = (total - size < static_cast<long>(sizeof(zeros))) ? static_cast<size_t>(total - size)
+                                                                         : sizeof(zeros);
+        ok = fwrite(zeros, chunk, 1, file_) == 1;
+        size += static_cast<long>(chunk);
+    }
+    if (!ok || fflush(file_) != 0) {
+        ESP_LOGE(TAG, "Cannot size history file %s", path);
+        close();
+        return ESP_FAIL;
+    }
+
+    block_size_ = block_size;
+    block_count_ = block_count;
+    return ESP_OK;
+}
+
+void UsHistoryFileStorage::close()
+{
+    if (file_ != nullptr) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+esp_err_t UsHistoryFileStorage::read(uint32_t block, size_t offset, void *dst, size_t len)
+{
+    if (file_ == nullptr || block >= block_count_ || offset > block_size_ || len > block_size_ - offset)
+        return ESP_ERR_INVALID_ARG;
+    if (fseek(file_, static_cast<long>(block * block_size_ + offset), SEEK_SET) != 0)
+        return ESP_FAIL;
+    return (len == 0 || fread(dst, len, 1, file_) == 1) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t UsHistoryFileStorage::write(uint32_t block, const void *src, size_t len)
+{
+    if (file_ == nullptr || block >= block_count_ || len > block_size_)
+        return ESP_ERR_INVALID_ARG;
+    if (fseek(file_, static_cast<long>(block * block_size_), SEEK_SET) != 0)
+        return ESP_FAIL;
+    if (len > 0 && fwrite(src, len, 1, file_) != 1)
+        return ESP_FAIL;
+    return (fflush(file_) == 0) ? ESP_OK : ESP_FAIL;
+}
+
+} // namespace ultrasonic
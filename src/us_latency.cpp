@@ -0,0 +1,289 @@
+// components/ultrasonic_sensor/src/us_latency.cpp
+
+#include "us_latency.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace ultrasonic {
+
+static constexpr uint8_t LATENCY_MAGIC = 0x4C; // 'L'
+static constexpr uint8_t LATENCY_VERSION = 1;
+
+static size_t put_varint(uint8_t *p, uint64_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = static_cast<uint8_t>(v) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = static_cast<uint8_t>(v);
+    return n;
+}
+
+static size_t varint_len(uint64_t v)
+{
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static bool get_varint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+{
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+// =================================================================
+// UsLatencyHistogram
+// =================================================================
+
+void UsLatencyHistogram::reset()
+{
+    std::memset(counts_, 0, sizeof(counts_));
+    count_ = 0;
+    sum_us_ = 0;
+    min_ = UINT32_MAX;
+    max_ = 0;
+}
+
+size_t UsLatencyHistogram::bucket_of(uint32_t us)
+{
+    if (us < SUB_COUNT)
+        return us;
+
+    // Bucket SUB_COUNT * (msb - SUB_BITS + 1) + the SUB_BITS bits below the MSB
+    const uint32_t msb = 31 - static_cast<uint32_t>(__builtin_clz(us));
+    if (msb >= MAX_EXPONENT)
+        return BUCKETS - 1;
+    const uint32_t shift = msb - SUB_BITS;
+    return SUB_COUNT * shift + (us >> shift);
+}
+
+uint32_t UsLatencyHistogram::bucket_low(size_t index)
+{
+    if (index < SUB_COUNT)
+        return static_cast<uint32_t>(index);
+    if (index >= BUCKETS)
+        index = BUCKETS - 1;
+    const uint32_t shift = static_cast<uint32_t>(index / SUB_COUNT) - 1;
+    return static_cast<uint32_t>(SUB_COUNT + index % SUB_COUNT) << shift;
+}
+
+uint32_t UsLatencyHistogram::bucket_high(size_t index)
+{
+    if (index >= BUCKETS - 1)
+        return UINT32_MAX;
+    return bucket_low(index + 1) - 1;
+}
+
+void UsLatencyHistogram::record(uint32_t us)
+{
+    counts_[bucket_of(us)]++;
+    count_++;
+    sum_us_ += us;
+    min_ = std::min(min_, us);
+    max_ = std::max(max_, us);
+}
+
+void UsLatencyHistogram::merge(const UsLatencyHistogram &other)
+{
+    for (size_t i = 0; i < BUCKETS; i++) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_us_ += other.sum_us_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+uint32_t UsLatencyHistogram::percentile(double q) const
+{
+    if (count_ == 0)
+        return 0;
+    if (!(q > 0.0)) // also catches NaN
+        return min_;
+    if (q >= 1.0)
+        return max_;
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        seen += counts_[i];
+        if (seen >= rank)
+            return std::clamp(bucket_high(i), min_, max_);
+    }
+    return max_;
+}
+
+size_t UsLatencyHistogram::encode(uint8_t *buf, size_t size) const
+{
+    // Size first, so nothing is written to a buffer that is too small
+    size_t used = 0;
+    size_t n = 4 + varint_len(sum_us_) + varint_len(min()) + varint_len(max_);
+    size_t next = 0; // index the next gap is counted from
+    for (size_t i = 0; i < BUCKETS; i++) {
+        if (counts_[i] == 0)
+            continue;
+        n += varint_len(i - next) + varint_len(counts_[i]);
+        next = i + 1;
+        used++;
+    }
+    n += varint_len(used);
+    if (buf == nullptr || n > size)
+        return 0;
+
+    size_t w = 0;
+    buf[w++] = LATENCY_MAGIC;
+    buf[w++] = LATENCY_VERSION;
+    buf[w++] = SUB_BITS;
+    buf[w++] = MAX_EXPONENT;
+    w += put_varint(buf + w, sum_us_);
+    w += put_varint(buf + w, min());
+    w += put_varint(buf + w, max_);
+    w += put_varint(buf + w, used);
+    next = 0;
+    for (size_t i = 0; i < BUCKETS; i++) {
+        if (counts_[i] == 0)
+            continue;
+        w += put_varint(buf + w, i - next);
+        w += put_varint(buf + w, counts_[i]);
+        next = i + 1;
+    }
+    return w;
+}
+
+esp_err_t UsLatencyHistogram::decode(const uint8_t *buf, size_t len)
+{
+    if (buf == nullptr || len < 4)
+        return ESP_ERR_INVALID_SIZE;
+    if (buf[0] != LATENCY_MAGIC || buf[1] != LATENCY_VERSION || buf[2] != SUB_BITS || buf[3] != MAX_EXPONENT)
+        return ESP_ERR_INVALID_VERSION;
+
+    const uint8_t *p = buf + 4;
+    const uint8_t *end = buf + len;
+    uint64_t sum = 0;
+    uint64_t lo = 0;
+    uint64_t hi = 0;
+    uint64_t used = 0;
+    if (!get_varint(p, end, sum) || !get_varint(p, end, lo) || !get_varint(p, end, hi) ||
+        !get_varint(p, end, used) || lo > UINT32_MAX || hi > UINT32_MAX || used > BUCKETS)
+        return ESP_ERR_INVALID_SIZE;
+
+    UsLatencyHistogram out;
+    uint64_t next = 0;
+    for (uint64_t k = 0; k < used; k++) {
+        uint64_t gap = 0;
+        uint64_t count = 0;
+        if (!get_varint(p, end, gap) || !get_varint(p, end, count) || gap >= BUCKETS - next || count == 0 ||
+            count > UINT32_MAX)
+            return ESP_ERR_INVALID_SIZE;
+        const size_t index = static_cast<size_t>(next + gap);
+        out.counts_[index] = static_cast<uint32_t>(count);
+        out.count_ += count;
+        next = index + 1;
+    }
+    if (p != end)
+        return ESP_ERR_INVALID_SIZE;
+
+    out.sum_us_ = sum;
+    if (out.count_ > 0) {
+        out.min_ = static_cast<uint32_t>(lo);
+        out.max_ = static_cast<uint32_t>(hi);
+    }
+    *this = out;
+    return ESP_OK;
+}
+
+// =================================================================
+// UsLatencyStats
+// =================================================================
+
+void UsLatencyStats::record_ping(UsResult result, uint32_t us)
+{
+    const size_t r = static_cast<size_t>(result);
+    if (r >= US_RESULT_COUNT)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    ping_[r].record(us);
+}
+
+void UsLatencyStats::record_read(UsResult result, uint32_t us)
+{
+    const size_t r = static_cast<size_t>(result);
+    if (r >= US_RESULT_COUNT)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    read_[r].record(us);
+}
+
+void UsLatencyStats::ping(UsResult result, UsLatencyHistogram &out) const
+{
+    out.reset();
+    const size_t r = static_cast<size_t>(result);
+    if (r >= US_RESULT_COUNT)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    out = ping_[r];
+}
+
+void UsLatencyStats::read(UsResult result, UsLatencyHistogram &out) const
+{
+    out.reset();
+    const size_t r = static_cast<size_t>(result);
+    if (r >= US_RESULT_COUNT)
+        return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    out = read_[r];
+}
+
+void UsLatencyStats::pings(UsLatencyHistogram &out) const
+{
+    out.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &h : ping_) {
+        out.merge(h);
+    }
+}
+
+void UsLatencyStats::reads(UsLatencyHistogram &out) const
+{
+    out.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &h : read_) {
+        out.merge(h);
+    }
+}
+
+void UsLatencyStats::merge(const UsLatencyStats &other)
+{
+    if (&other == this)
+        return;
+    std::scoped_lock lock(mutex_, other.mutex_);
+    for (size_t r = 0; r < US_RESULT_COUNT; r++) {
+        ping_[r].merge(other.ping_[r]);
+        read_[r].merge(other.read_[r]);
+    }
+}
+
+void UsLatencyStats::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t r = 0; r < US_RESULT_COUNT; r++) {
+        ping_[r].reset();
+        read_[r].reset();
+    }
+}
+
+} // namespace ultrasonic
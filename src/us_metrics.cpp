@@ -0,0 +1,306 @@
+// components/ultrasonic_sensor/src/us_metrics.cpp
+
+#include "us_metrics.hpp"
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+namespace ultrasonic {
+
+// =================================================================
+// UsMetrics
+// =================================================================
+
+uint32_t UsMetrics::pings() const
+{
+    uint32_t total = 0;
+    for (uint32_t n : ping_results) {
+        total += n;
+    }
+    return total;
+}
+
+uint32_t UsMetrics::bursts() const
+{
+    uint32_t total = 0;
+    for (uint32_t n : burst_results) {
+        total += n;
+    }
+    return total;
+}
+
+float UsMetrics::mean_valid_ratio() const
+{
+    uint32_t total = pings();
+    if (total == 0)
+        return 0.0f;
+    return static_cast<float>(ping_results[static_cast<size_t>(UsResult::OK)]) / static_cast<float>(total);
+}
+
+// =================================================================
+// UsMetricsCounters
+// =================================================================
+
+void UsMetricsCounters::add_burst(const Reading *pings, uint8_t count, const Reading &result)
+{
+    uint32_t valid = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        size_t r = static_cast<size_t>(pings[i].result);
+        if (r < US_RESULT_COUNT)
+            ping_results_[r].fetch_add(1, std::memory_order_relaxed);
+        if (pings[i].result == UsResult::OK)
+            valid++;
+    }
+
+    size_t r = static_cast<size_t>(result.result);
+    if (r < US_RESULT_COUNT)
+        burst_results_[r].fetch_add(1, std::memory_order_relaxed);
+
+    uint8_t clamped = (count > IUsProcessor::MAX_PINGS) ? IUsProcessor::MAX_PINGS : count;
+    pings_per_burst_[clamped].fetch_add(1, std::memory_order_relaxed);
+
+    if (count == 0)
+        return;
+
+    // Bucket i holds ratios in (i/10, (i+1)/10]
+    size_t bucket = (valid == 0) ? 0 : (valid * VALID_RATIO_BUCKETS + count - 1) / count - 1;
+    valid_ratio_[bucket].fetch_add(1, std::memory_order_relaxed);
+    valid_ratio_sum_ppm_.fetch_add(static_cast<uint64_t>(valid) * 1000000u / count, std::memory_order_relaxed);
+}
+
+UsMetrics UsMetricsCounters::snapshot() const
+{
+    UsMetrics m;
+    for (size_t i = 0; i < US_RESULT_COUNT; i++) {
+        m.ping_results[i] = ping_results_[i].load(std::memory_order_relaxed);
+        m.burst_results[i] = burst_results_[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < VALID_RATIO_BUCKETS; i++) {
+        m.valid_ratio[i] = valid_ratio_[i].load(std::memory_order_relaxed);
+    }
+    m.valid_ratio_sum_ppm = valid_ratio_sum_ppm_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= IUsProcessor::MAX_PINGS; i++) {
+        m.pings_per_burst[i] = pings_per_burst_[i].load(std::memory_order_relaxed);
+    }
+    return m;
+}
+
+void UsMetricsCounters::reset()
+{
+    for (size_t i = 0; i < US_RESULT_COUNT; i++) {
+        ping_results_[i].store(0, std::memory_order_relaxed);
+        burst_results_[i].store(0, std::memory_order_relaxed);
+    }
+    for (auto &bucket : valid_ratio_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    valid_ratio_sum_ppm_.store(0, std::memory_order_relaxed);
+    for (auto &bucket : pings_per_burst_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+// =================================================================
+// Serialization
+// =================================================================
+
+const char *result_name(UsResult result)
+{
+    switch (result) {
+    case UsResult::OK:
+        return "ok";
+    case UsResult::WEAK_SIGNAL:
+        return "weak_signal";
+    case UsResult::TIMEOUT:
+        return "timeout";
+    case UsResult::OUT_OF_RANGE:
+        return "out_of_range";
+    case UsResult::HIGH_VARIANCE:
+        return "high_variance";
+    case UsResult::INSUFFICIENT_SAMPLES:
+        return "insufficient_samples";
+    case UsResult::ECHO_STUCK:
+        return "echo_stuck";
+    case UsResult::HW_FAULT:
+        return "hw_fault";
+    }
+    return "unknown";
+}
+
+namespace {
+
+/** snprintf() into a fixed buffer that keeps counting past its end. */
+class Writer
+{
+public:
+    Writer(char *buf, size_t size)
+        : buf_(buf)
+        , size_(size)
+    {
+        if (size_ > 0)
+            buf_[0] = '\0';
+    }
+
+    __attribute__((format(printf, 2, 3))) void printf(const char *fmt, ...)
+    {
+        char *dst = (len_ < size_) ? buf_ + len_ : nullptr;
+        size_t room = (len_ < size_) ? size_ - len_ : 0;
+        va_list args;
+        va_start(args, fmt);
+        int n = std::vsnprintf(dst, room, fmt, args);
+        va_end(args);
+        if (n > 0)
+            len_ += static_cast<size_t>(n);
+    }
+
+    void put(char c)
+    {
+        if (len_ + 1 < size_) {
+            buf_[len_] = c;
+            buf_[len_ + 1] = '\0';
+        }
+        len_++;
+    }
+
+    size_t length() const { return len_; }
+
+private:
+    char *buf_;
+    size_t size_;
+    size_t len_ = 0;
+};
+
+void json_results(Writer &w, const char *key, const uint32_t (&results)[US_RESULT_COUNT])
+{
+    w.printf("\"%s\":{", key);
+    for (size_t i = 0; i < US_RESULT_COUNT; i++) {
+        w.printf("%s\"%s\":%lu", (i > 0) ? "," : "", result_name(static_cast<UsResult>(i)),
+                 static_cast<unsigned long>(results[i]));
+    }
+    w.put('}');
+}
+
+template <size_t N>
+void json_array(Writer &w, const char *key, const uint32_t (&values)[N])
+{
+    w.printf("\"%s\":[", key);
+    for (size_t i = 0; i < N; i++) {
+        w.printf("%s%lu", (i > 0) ? "," : "", static_cast<unsigned long>(values[i]));
+    }
+    w.put(']');
+}
+
+/** Writes `{sensor="..."` (escaped) or `{`; the caller adds further labels and the closing brace. */
+void prom_labels_open(Writer &w, const char *sensor)
+{
+    w.put('{');
+    if (sensor == nullptr)
+        return;
+    w.printf("sensor=\"");
+    for (const char *c = sensor; *c != '\0'; c++) {
+        if (*c == '\\' || *c == '"') {
+            w.put('\\');
+            w.put(*c);
+        } else if (*c == '\n') {
+            w.printf("\\n");
+        } else {
+            w.put(*c);
+        }
+    }
+    w.put('"');
+}
+
+void prom_results(Writer &w, const char *name, const char *help, const char *sensor,
+                  const uint32_t (&results)[US_RESULT_COUNT])
+{
+    w.printf("# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+    for (size_t i = 0; i < US_RESULT_COUNT; i++) {
+        w.printf("%s", name);
+        prom_labels_open(w, sensor);
+        w.printf("%sresult=\"%s\"} %lu\n", (sensor != nullptr) ? "," : "", result_name(static_cast<UsResult>(i)),
+                 static_cast<unsigned long>(results[i]));
+    }
+}
+
+void prom_bucket(Writer &w, const char *name, const char *sensor, const char *le, unsigned long count)
+{
+    w.printf("%s_bucket", name);
+    prom_labels_open(w, sensor);
+    w.printf("%sle=\"%s\"} %lu\n", (sensor != nullptr) ? "," : "", le, count);
+}
+
+void prom_total(Writer &w, const char *name, const char *suffix, const char *sensor)
+{
+    w.printf("%s_%s", name, suffix);
+    if (sensor != nullptr) {
+        prom_labels_open(w, sensor);
+        w.put('}');
+    }
+    w.put(' ');
+}
+
+} // namespace
+
+size_t metrics_to_json(const UsMetrics &metrics, char *buf, size_t size)
+{
+    Writer w(buf, size);
+    w.put('{');
+    json_results(w, "pings", metrics.ping_results);
+    w.put(',');
+    json_results(w, "bursts", metrics.burst_results);
+    w.put(',');
+    json_array(w, "valid_ratio", metrics.valid_ratio);
+    w.printf(",\"valid_ratio_sum\":%.6f,", static_cast<double>(metrics.valid_ratio_sum_ppm) / 1e6);
+    json_array(w, "pings_per_burst", metrics.pings_per_burst);
+    w.printf(",\"mean_valid_ratio\":%.4f}", static_cast<double>(metrics.mean_valid_ratio()));
+    return w.length();
+}
+
+size_t metrics_to_prometheus(const UsMetrics &metrics, const char *sensor, char *buf, size_t size)
+{
+    Writer w(buf, size);
+
+    prom_results(w, "us_pings_total", "Pings by driver result.", sensor, metrics.ping_results);
+    prom_results(w, "us_bursts_total", "Measurements by final result.", sensor, metrics.burst_results);
+
+    // Bursts without pings are not part of the ratio histogram
+    const char *name = "us_burst_valid_ratio";
+    w.printf("# HELP %s Share of successful pings per measurement.\n# TYPE %s histogram\n", name, name);
+    unsigned long cumulative = 0;
+    for (size_t i = 0; i < VALID_RATIO_BUCKETS; i++) {
+        cumulative += metrics.valid_ratio[i];
+        char le[8];
+        if (i + 1 == VALID_RATIO_BUCKETS)
+            std::snprintf(le, sizeof(le), "1");
+        else
+            std::snprintf(le, sizeof(le), "0.%zu", i + 1);
+        prom_bucket(w, name, sensor, le, cumulative);
+    }
+    prom_bucket(w, name, sensor, "+Inf", cumulative);
+    prom_total(w, name, "sum", sensor);
+    w.printf("%.6f\n", static_cast<double>(metrics.valid_ratio_sum_ppm) / 1e6);
+    prom_total(w, name, "count", sensor);
+    w.printf("%lu\n", cumulative);
+
+    name = "us_burst_pings";
+    w.printf("# HELP %s Pings fired per measurement.\n# TYPE %s histogram\n", name, name);
+    cumulative = 0;
+    unsigned long long sum = 0;
+    for (size_t i = 0; i <= IUsProcessor::MAX_PINGS; i++) {
+        cumulative += metrics.pings_per_burst[i];
+        sum += static_cast<unsigned long long>(i) * metrics.pings_per_burst[i];
+        char le[8];
+        std::snprintf(le, sizeof(le), "%zu", i);
+        prom_bucket(w, name, sensor, le, cumulative);
+    }
+    prom_bucket(w, name, sensor, "+Inf", cumulative);
+    prom_total(w, name, "sum", sensor);
+    w.printf("%llu\n", sum);
+    prom_total(w, name, "count", sensor);
+    w.printf("%lu\n", cumulative);
+
+    return w.length();
+}
+
+} // namespace ultrasonic
@@ -0,0 +1,192 @@
+// components/ultrasonic_sensor/src/us_multi_driver.cpp
+
+#include "us_multi_driver.hpp"
+
+#include <cstdint>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
+#include "esp_log.h"
+
+namespace ultrasonic {
+
+static const char *TAG = "UsMultiDriver";
+
+UsMultiDriver::UsMultiDriver(
+    idf_hals::IGpioHAL &gpio_hal,
+    idf_hals::ITimerHAL &timer_hal,
+    idf_hals::ISysRomHAL &sys_rom_hal,
+    IUsGpioBulk &gpio_bulk,
+    const UsChannelPins *channels,
+    size_t count)
+    : gpio_hal_(gpio_hal)
+    , timer_hal_(timer_hal)
+    , sys_rom_hal_(sys_rom_hal)
+    , gpio_bulk_(gpio_bulk)
+{
+    pins_ok_ = (channels != nullptr && count > 0 && count <= MAX_CHANNELS);
+    if (!pins_ok_)
+        return;
+
+    uint64_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        const gpio_num_t echo = channels[i].echo_pin;
+        if (echo < 0 || echo >= 64 || (used & (1ULL << echo)) != 0) {
+            pins_ok_ = false;
+            return;
+        }
+        used |= 1ULL << echo;
+        channels_[i].pins = channels[i];
+        channels_[i].echo_mask = 1ULL << echo;
+    }
+    count_ = count;
+}
+
+esp_err_t UsMultiDriver::configure(gpio_num_t pin, gpio_mode_t mode)
+{
+    esp_err_t ret = gpio_hal_.reset_pin(pin);
+    if (ret != ESP_OK)
+        return ret;
+
+    gpio_config_t conf = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = mode,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    return gpio_hal_.config(&conf);
+}
+
+esp_err_t UsMultiDriver::init()
+{
+    if (!pins_ok_) {
+        ESP_LOGE(TAG, "Invalid channel list");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret;
+    for (size_t i = 0; i < count_; i++) {
+        const UsChannelPins &pins = channels_[i].pins;
+
+        ret = configure(pins.trig_pin, GPIO_MODE_OUTPUT);
+        if (ret != ESP_OK)
+            return ret;
+        ret = gpio_hal_.set_level(pins.trig_pin, 0);
+        if (ret != ESP_OK)
+            return ret;
+
+        ret = configure(pins.echo_pin, GPIO_MODE_INPUT);
+        if (ret != ESP_OK)
+            return ret;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t UsMultiDriver::deinit()
+{
+    esp_err_t ret;
+    for (size_t i = 0; i < count_; i++) {
+        const UsChannelPins &pins = channels_[i].pins;
+
+        ret = gpio_hal_.set_level(pins.trig_pin, 0);
+        if (ret != ESP_OK)
+            return ret;
+        ret = gpio_hal_.reset_pin(pins.trig_pin);
+        if (ret != ESP_OK)
+            return ret;
+        ret = gpio_hal_.reset_pin(pins.echo_pin);
+        if (ret != ESP_OK)
+            return ret;
+    }
+
+    return ESP_OK;
+}
+
+void UsMultiDriver::ping_all(const UsConfig &cfg, Reading *readings)
+{
+    ping_all(UsCompiledConfig(cfg), readings);
+}
+
+void UsMultiDriver::ping_all(const UsCompiledConfig &cc, Reading *readings)
+{
+    const UsConfig &cfg = cc.cfg;
+    size_t pending = 0;
+
+    // 1. One read for the stuck check of every channel; stuck ones sit this ping out
+    const uint64_t idle = gpio_bulk_.read_inputs();
+    for (size_t i = 0; i < count_; i++) {
+        Channel &ch = channels_[i];
+        ch.last_echo_us = 0;
+        if (idle & ch.echo_mask) {
+            ch.phase = Phase::DONE;
+            readings[i] = {UsResult::ECHO_STUCK, 0.0f};
+            continue;
+        }
+        ch.phase = Phase::WAIT_RISE;
+        pending++;
+    }
+    if (pending == 0)
+        return;
+
+    // 2. Raise every TRIG, hold them together for one pulse, lower them
+    for (size_t i = 0; i < count_; i++) {
+        Channel &ch = channels_[i];
+        if (ch.phase == Phase::WAIT_RISE && gpio_hal_.set_level(ch.pins.trig_pin, 1) != ESP_OK) {
+            ch.phase = Phase::DONE;
+            readings[i] = {UsResult::HW_FAULT, 0.0f};
+            pending--;
+        }
+    }
+    sys_rom_hal_.delay_us(cfg.ping_duration_us);
+    for (size_t i = 0; i < count_; i++) {
+        Channel &ch = channels_[i];
+        if (ch.phase == Phase::WAIT_RISE && gpio_hal_.set_level(ch.pins.trig_pin, 0) != ESP_OK) {
+            ch.phase = Phase::DONE;
+            readings[i] = {UsResult::HW_FAULT, 0.0f};
+            pending--;
+        }
+    }
+
+    // 3. Poll all ECHO pins at once; each channel times its own edges
+    const int64_t start = timer_hal_.get_time_us();
+    while (pending > 0) {
+        const uint64_t levels = gpio_bulk_.read_inputs();
+        const int64_t now = timer_hal_.get_time_us();
+
+        for (size_t i = 0; i < count_; i++) {
+            Channel &ch = channels_[i];
+            const bool high = (levels & ch.echo_mask) != 0;
+
+            if (ch.phase == Phase::WAIT_RISE) {
+                if (high) {
+                    ch.rise_us = now;
+                    ch.phase = Phase::WAIT_FALL;
+                }
+                else if (now - start > cfg.timeout_us) {
+                    ch.phase = Phase::DONE;
+                    readings[i] = {UsResult::TIMEOUT, 0.0f};
+                    pending--;
+                }
+            }
+            else if (ch.phase == Phase::WAIT_FALL) {
+                const int64_t width_us = now - ch.rise_us;
+                if (!high) {
+                    ch.phase = Phase::DONE;
+                    ch.last_echo_us = static_cast<uint32_t>(width_us);
+                    const float duration_us = static_cast<float>(width_us);
+                    readings[i] = cc.echo_in_range(duration_us) ? Reading{UsResult::OK, cc.echo_to_cm(duration_us)}
+                                                                : Reading{UsResult::OUT_OF_RANGE, 0.0f};
+                    pending--;
+                }
+                else if (width_us > cfg.timeout_us) {
+                    ch.phase = Phase::DONE;
+                    readings[i] = {UsResult::TIMEOUT, 0.0f};
+                    pending--;
+                }
+            }
+        }
+    }
+}
+
+} // namespace ultrasonic
@@ -15,35 +15,86 @@ static const char *TAG = "UsProcessor";
 static constexpr float VALID_PING_RATIO = 0.7f;   // >= this → OK quality
 static constexpr float INVALID_PING_RATIO = 0.4f; // <  this → INSUFFICIENT_SAMPLES
 
-// Fraction of max_dev_cm that triggers WEAK_SIGNAL (instead of OK)
-static constexpr float WEAK_VARIANCE_RATIO = 0.6f;
-
 // Dominant cluster parameters
 static constexpr float CLUSTER_DELTA_CM = 5.0f; // max spread within a cluster
 static constexpr size_t CLUSTER_MIN_SIZE = 2;   // minimum cluster size to be considered
 
+// Field access shared by the Reading and PackedReading paths
+static inline UsResult ping_result(const Reading &p) { return p.result; }
+static inline float ping_cm(const Reading &p) { return p.cm; }
+static inline UsResult ping_result(const PackedReading &p) { return p.result(); }
+static inline float ping_cm(const PackedReading &p) { return p.cm(); }
+
 Reading UsProcessor::process(const Reading *pings, uint8_t total_pings, const UsConfig &cfg)
 {
+    return process_pings(pings, total_pings, UsCompiledConfig(cfg), nullptr);
+}
+
+Reading UsProcessor::process_packed(const PackedReading *pings, uint8_t total_pings, const UsConfig &cfg)
+{
+    return process_pings(pings, total_pings, UsCompiledConfig(cfg), nullptr);
+}
+
+Reading UsProcessor::process_compiled(const Reading *pings, uint8_t total_pings, const UsCompiledConfig &cc)
+{
+    return process_pings(pings, total_pings, cc, nullptr);
+}
+
+Reading UsProcessor::process_ex(const Reading *pings, uint8_t total_pings, const UsCompiledConfig &cc,
+                                MeasurementInfo &info)
+{
+    return process_pings(pings, total_pings, cc, &info);
+}
+
+template <typename Ping>
+Reading UsProcessor::process_pings(const Ping *pings, uint8_t total_pings, const UsCompiledConfig &cc,
+                                   MeasurementInfo *info)
+{
+    const UsConfig &cfg = cc.cfg;
+
     if (total_pings == 0) {
         return {UsResult::INSUFFICIENT_SAMPLES, 0.0f};
     }
 
+    // samples[] holds at most MAX_PINGS entries; anything beyond is ignored
+    if (total_pings > MAX_PINGS) {
+        ESP_LOGW(TAG, "total_pings %d exceeds %d, truncating", total_pings, MAX_PINGS);
+        total_pings = MAX_PINGS;
+    }
+
     float samples[MAX_PINGS];
     uint8_t valid_count = 0;
-    uint8_t timeouts = 0;
-    uint8_t out_of_range = 0;
+    uint8_t tally[US_RESULT_COUNT] = {};
 
-    // 1. Extract valid samples and count specific errors
+    // 1. Extract valid samples and count every result (non-finite distances are not valid)
     for (uint8_t i = 0; i < total_pings; i++) {
-        if (is_success(pings[i].result)) {
-            samples[valid_count++] = pings[i].cm;
+        UsResult result = ping_result(pings[i]);
+        float cm = ping_cm(pings[i]);
+        if (is_success(result) && std::isfinite(cm)) {
+            samples[valid_count++] = cm;
         }
-        else if (pings[i].result == UsResult::TIMEOUT) {
-            timeouts++;
+        const size_t r = static_cast<size_t>(result);
+        if (r < US_RESULT_COUNT) {
+            tally[r]++;
         }
-        else if (pings[i].result == UsResult::OUT_OF_RANGE) {
-            out_of_range++;
+    }
+    const uint8_t timeouts = tally[static_cast<size_t>(UsResult::TIMEOUT)];
+    const uint8_t out_of_range = tally[static_cast<size_t>(UsResult::OUT_OF_RANGE)];
+
+    // 1b. With trigger jitter, echoes from other sensors land at a different distance
+    //     on every ping; keep the dominant cluster and count the rest as invalid
+    if (cfg.trigger_jitter_us > 0) {
+        uint8_t kept = reject_uncorrelated(samples, valid_count);
+        if (kept < valid_count) {
+            ESP_LOGD(TAG, "Rejected %d uncorrelated samples", valid_count - kept);
         }
+        valid_count = kept;
+    }
+
+    if (info != nullptr) {
+        info->total_pings = total_pings;
+        info->valid_pings = valid_count;
+        std::copy(tally, tally + US_RESULT_COUNT, info->ping_results);
     }
 
     // 2. Compute valid ping ratio
@@ -64,25 +115,33 @@ Reading UsProcessor::process(const Reading *pings, uint8_t total_pings, const Us
     }
 
     // 4. Check variance
+    // Negated comparison so that a non-finite deviation (overflowing samples) is rejected too
     float std_dev = get_std_dev(samples, valid_count);
-    if (std_dev > cfg.max_dev_cm) {
+    if (info != nullptr) {
+        info->std_dev_cm = std_dev;
+    }
+    if (!(std_dev <= cfg.max_dev_cm)) {
         ESP_LOGD(TAG, "High variance: std_dev=%.2f cm (limit=%.2f cm)", std_dev, cfg.max_dev_cm);
         return {UsResult::HIGH_VARIANCE, 0.0f};
     }
 
     // 5. Apply filter
     float distance_cm;
+    uint8_t used = valid_count;
     if (cfg.filter == Filter::MEDIAN) {
         distance_cm = reduce_median(samples, valid_count);
     }
     else {
-        distance_cm = reduce_dominant_cluster(samples, valid_count);
+        distance_cm = reduce_dominant_cluster(samples, valid_count, used);
+    }
+    if (info != nullptr) {
+        info->filter_samples = used;
     }
 
     // 6. Determine quality based on ping ratio
     if (ratio >= VALID_PING_RATIO) {
         // Good ratio — check if variance is elevated (but still within limit)
-        if (std_dev > cfg.max_dev_cm * WEAK_VARIANCE_RATIO) {
+        if (std_dev > cc.weak_dev_cm) {
             ESP_LOGD(TAG, "Weak signal (high ratio, elevated variance): std_dev=%.2f", std_dev);
             return {UsResult::WEAK_SIGNAL, distance_cm};
         }
@@ -100,10 +159,13 @@ float UsProcessor::reduce_median(float *v, std::size_t n)
     return v[n / 2];
 }
 
-float UsProcessor::reduce_dominant_cluster(float *v, std::size_t n)
+float UsProcessor::reduce_dominant_cluster(float *v, std::size_t n, uint8_t &used)
 {
     std::sort(v, v + n);
 
+    // Sums are kept as offsets from the cluster's first element, so the
+    // average of identical values is exact and never leaves the cluster.
+    float best_cluster_base = 0.0f;
     float best_cluster_sum = 0.0f;
     size_t best_cluster_size = 0;
 
@@ -113,7 +175,7 @@ float UsProcessor::reduce_dominant_cluster(float *v, std::size_t n)
 
         for (size_t j = i; j < n; j++) {
             if (std::abs(v[j] - v[i]) <= CLUSTER_DELTA_CM) {
-                current_sum += v[j];
+                current_sum += v[j] - v[i];
                 current_size++;
             }
             else {
@@ -123,26 +185,63 @@ float UsProcessor::reduce_dominant_cluster(float *v, std::size_t n)
 
         if (current_size >= CLUSTER_MIN_SIZE && current_size > best_cluster_size) {
             best_cluster_size = current_size;
+            best_cluster_base = v[i];
             best_cluster_sum = current_sum;
         }
     }
 
     if (best_cluster_size == 0) {
         ESP_LOGW(TAG, "No valid cluster found, falling back to median");
+        used = static_cast<uint8_t>(n);
         return reduce_median(v, n);
     }
 
-    return best_cluster_sum / static_cast<float>(best_cluster_size);
+    used = static_cast<uint8_t>(best_cluster_size);
+    return best_cluster_base + best_cluster_sum / static_cast<float>(best_cluster_size);
+}
+
+uint8_t UsProcessor::reject_uncorrelated(float *v, uint8_t n)
+{
+    std::sort(v, v + n);
+
+    // Largest window of samples within CLUSTER_DELTA_CM of its first element
+    uint8_t best_start = 0;
+    uint8_t best_size = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        uint8_t j = i;
+        while (j < n && v[j] - v[i] <= CLUSTER_DELTA_CM) j++;
+        if (j - i > best_size) {
+            best_start = i;
+            best_size = j - i;
+        }
+    }
+
+    // Without a cluster there is nothing to correlate against; keep everything
+    if (best_size < CLUSTER_MIN_SIZE) {
+        return n;
+    }
+
+    if (best_start > 0) {
+        std::copy(v + best_start, v + best_start + best_size, v);
+    }
+    return best_size;
 }
 
 float UsProcessor::get_std_dev(const float *samples, uint8_t count)
 {
+    // Accumulate offsets from the first sample: identical samples then give an
+    // exact zero instead of the rounding residue of a large running sum.
+    const float shift = samples[0];
+
     float mean = 0.0f;
-    for (uint8_t i = 0; i < count; i++) mean += samples[i];
+    for (uint8_t i = 0; i < count; i++) mean += samples[i] - shift;
     mean /= count;
 
     float variance = 0.0f;
-    for (uint8_t i = 0; i < count; i++) variance += std::pow(samples[i] - mean, 2);
+    for (uint8_t i = 0; i < count; i++) {
+        float d = samples[i] - shift - mean;
+        variance += d * d;
+    }
     return std::sqrt(variance / count);
 }
 
@@ -0,0 +1,85 @@
+// components/ultrasonic_sensor/src/us_replay_driver.cpp
+
+#include "us_replay_driver.hpp"
+
+#include <cstdint>
+#include <utility>
+
+#include "us_compiled_config.hpp"
+
+namespace ultrasonic {
+
+UsReplayDriver::UsReplayDriver(std::vector<TraceRecord> records)
+    : records_(std::move(records))
+{
+}
+
+size_t UsReplayDriver::load(UsTraceReader &reader, std::vector<TraceRecord> &records)
+{
+    size_t count = 0;
+    TraceRecord rec;
+    while (reader.next(rec)) {
+        records.push_back(rec);
+        count++;
+    }
+    return count;
+}
+
+Reading UsReplayDriver::ping_once(const UsConfig &cfg)
+{
+    return ping_compiled(UsCompiledConfig(cfg));
+}
+
+Reading UsReplayDriver::ping_compiled(const UsCompiledConfig &cc)
+{
+    if (finished()) {
+        last_echo_us_ = 0;
+        last_echo_gated_ = false;
+        return {UsResult::HW_FAULT, 0.0f};
+    }
+
+    const TraceRecord &rec = records_[pos_++];
+    last_echo_us_ = rec.echo_us;
+    last_echo_gated_ = (rec.flags & TRACE_FLAG_GATE_REJECT) != 0;
+    return reevaluate(rec, cc);
+}
+
+Reading UsReplayDriver::reevaluate(const TraceRecord &rec, const UsCompiledConfig &cc)
+{
+    UsResult result = static_cast<UsResult>(rec.result);
+
+    // Only pings that produced a measured echo can be re-evaluated. The tracking
+    // gate depends on the pings before, so a gate reject stays one.
+    if (rec.echo_us == 0 || (rec.flags & TRACE_FLAG_GATE_REJECT) != 0 ||
+        (result != UsResult::OK && result != UsResult::OUT_OF_RANGE)) {
+        return {result, 0.0f};
+    }
+
+    const float echo_us = static_cast<float>(rec.echo_us);
+    if (!cc.echo_in_range(echo_us)) {
+        return {UsResult::OUT_OF_RANGE, 0.0f};
+    }
+
+    return {UsResult::OK, cc.echo_to_cm(echo_us)};
+}
+
+uint8_t UsReplayDriver::next_burst_size() const
+{
+    if (finished())
+        return 0;
+
+    const TraceRecord &rec = records_[pos_];
+    // A well-formed trace always starts a burst at index 0; resume mid-burst otherwise
+    if (rec.ping_count <= rec.ping_index)
+        return 1;
+    return static_cast<uint8_t>(rec.ping_count - rec.ping_index);
+}
+
+int64_t UsReplayDriver::next_timestamp_us() const
+{
+    if (records_.empty())
+        return 0;
+    return finished() ? records_.back().timestamp_us : records_[pos_].timestamp_us;
+}
+
+} // namespace ultrasonic
@@ -0,0 +1,243 @@
+// components/ultrasonic_sensor/src/us_rollup.cpp
+
+#include "us_rollup.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace ultrasonic {
+
+// =================================================================
+// P2Quantile
+// =================================================================
+
+P2Quantile::P2Quantile(float p)
+    : p_(std::clamp(static_cast<double>(p), 0.0, 1.0))
+{
+    reset();
+}
+
+void P2Quantile::reset()
+{
+    count_ = 0;
+    for (int i = 0; i < 5; i++) {
+        pos_[i] = i;
+    }
+    desired_[0] = 0.0;
+    desired_[1] = 2.0 * p_;
+    desired_[2] = 4.0 * p_;
+    desired_[3] = 2.0 + 2.0 * p_;
+    desired_[4] = 4.0;
+    step_[0] = 0.0;
+    step_[1] = p_ / 2.0;
+    step_[2] = p_;
+    step_[3] = (1.0 + p_) / 2.0;
+    step_[4] = 1.0;
+}
+
+void P2Quantile::add(float sample)
+{
+    const double x = sample;
+
+    // The first five samples become the initial marker heights
+    if (count_ < 5) {
+        height_[count_++] = x;
+        if (count_ == 5) {
+            std::sort(height_, height_ + 5);
+        }
+        return;
+    }
+    count_++;
+
+    // Cell k holds x: height_[k] <= x < height_[k + 1]
+    int k;
+    if (x < height_[0]) {
+        height_[0] = x;
+        k = 0;
+    } else if (x >= height_[4]) {
+        height_[4] = std::max(height_[4], x);
+        k = 3;
+    } else {
+        k = 0;
+        while (k < 3 && x >= height_[k + 1]) {
+            k++;
+        }
+    }
+
+    for (int i = k + 1; i < 5; i++) {
+        pos_[i]++;
+    }
+    for (int i = 0; i < 5; i++) {
+        desired_[i] += step_[i];
+    }
+
+    // Move the middle markers that drifted off their desired position
+    for (int i = 1; i <= 3; i++) {
+        const double off = desired_[i] - pos_[i];
+        if ((off >= 1.0 && pos_[i + 1] - pos_[i] > 1) || (off <= -1.0 && pos_[i - 1] - pos_[i] < -1)) {
+            const int d = (off > 0.0) ? 1 : -1;
+            double h = parabolic(i, d);
+            if (!(height_[i - 1] < h && h < height_[i + 1])) {
+                h = linear(i, d);
+            }
+            height_[i] = h;
+            pos_[i] += d;
+        }
+    }
+}
+
+float P2Quantile::value() const
+{
+    if (count_ == 0)
+        return 0.0f;
+
+    if (count_ < 5) {
+        double sorted[5];
+        std::copy(height_, height_ + count_, sorted);
+        std::sort(sorted, sorted + count_);
+        auto idx = static_cast<size_t>(std::lround(p_ * (count_ - 1)));
+        return static_cast<float>(sorted[idx]);
+    }
+    if (count_ == 5) {
+        return static_cast<float>(height_[static_cast<size_t>(std::lround(p_ * 4))]);
+    }
+    return static_cast<float>(height_[2]);
+}
+
+double P2Quantile::parabolic(int i, int d) const
+{
+    const double n_prev = pos_[i - 1];
+    const double n = pos_[i];
+    const double n_next = pos_[i + 1];
+    return height_[i] + d / (n_next - n_prev) *
+                            ((n - n_prev + d) * (height_[i + 1] - height_[i]) / (n_next - n) +
+                             (n_next - n - d) * (height_[i] - height_[i - 1]) / (n - n_prev));
+}
+
+double P2Quantile::linear(int i, int d) const
+{
+    return height_[i] + d * (height_[i + d] - height_[i]) / (pos_[i + d] - pos_[i]);
+}
+
+// =================================================================
+// UsRollup
+// =================================================================
+
+UsRollup::UsRollup(uint32_t bucket_ms, size_t capacity)
+    : bucket_us_(int64_t{std::max<uint32_t>(bucket_ms, 1)} * 1000)
+    , ring_(new RollupBucket[std::max<size_t>(capacity, 1)])
+    , capacity_(std::max<size_t>(capacity, 1))
+{
+}
+
+void UsRollup::add(int64_t timestamp_us, const Reading &reading)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Floor division, so buckets stay aligned for negative timestamps too
+    int64_t start = (timestamp_us / bucket_us_) * bucket_us_;
+    if (start > timestamp_us) {
+        start -= bucket_us_;
+    }
+
+    if (start < next_start_us_ || (open_ && start < cur_.start_us)) {
+        dropped_++;
+        return;
+    }
+    if (open_ && start > cur_.start_us) {
+        finish_current();
+    }
+    if (!open_) {
+        cur_ = RollupBucket{};
+        cur_.start_us = start;
+        sum_cm_ = 0.0;
+        median_.reset();
+        open_ = true;
+    }
+
+    auto r = static_cast<size_t>(reading.result);
+    if (r < US_RESULT_COUNT) {
+        cur_.results[r]++;
+    }
+
+    if (is_success(reading.result)) {
+        if (cur_.valid == 0 || reading.cm < cur_.min_cm)
+            cur_.min_cm = reading.cm;
+        if (cur_.valid == 0 || reading.cm > cur_.max_cm)
+            cur_.max_cm = reading.cm;
+        cur_.valid++;
+        sum_cm_ += reading.cm;
+        median_.add(reading.cm);
+    }
+}
+
+void UsRollup::advance(int64_t now_us)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (open_ && now_us >= cur_.start_us + bucket_us_) {
+        finish_current();
+    }
+}
+
+size_t UsRollup::finished(RollupBucket *out, size_t max_out, int64_t since_us) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (out == nullptr)
+        return 0;
+
+    // Oldest first; skip the oldest ones if the output is too small
+    const size_t oldest = (next_ + capacity_ - size_) % capacity_;
+    size_t first = 0;
+    while (first < size_ && ring_[(oldest + first) % capacity_].start_us < since_us) {
+        first++;
+    }
+    if (size_ - first > max_out) {
+        first = size_ - max_out;
+    }
+
+    size_t n = 0;
+    for (size_t i = first; i < size_; i++) {
+        out[n++] = ring_[(oldest + i) % capacity_];
+    }
+    return n;
+}
+
+bool UsRollup::current(RollupBucket &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!open_)
+        return false;
+    out = snapshot();
+    return true;
+}
+
+uint32_t UsRollup::dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+void UsRollup::finish_current()
+{
+    ring_[next_] = snapshot();
+    next_start_us_ = cur_.start_us + bucket_us_;
+    next_ = (next_ + 1) % capacity_;
+    size_ = std::min(size_ + 1, capacity_);
+    open_ = false;
+}
+
+RollupBucket UsRollup::snapshot() const
+{
+    RollupBucket b = cur_;
+    if (b.valid > 0) {
+        b.mean_cm = static_cast<float>(sum_cm_ / b.valid);
+        b.p50_cm = median_.value();
+    }
+    return b;
+}
+
+} // namespace ultrasonic
@@ -2,6 +2,7 @@
 
 #include "us_sensor.hpp"
 
+#include <algorithm>
 #include <memory>
 
 #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
@@ -9,11 +10,20 @@
 
 #include "us_driver.hpp"
 #include "us_processor.hpp"
+#include "us_timing.hpp"
 
 namespace ultrasonic {
 
 static const char *TAG = "UsSensor";
 
+/** The sensor's FreeRTOS HAL drives the echo wait policies unless the options name another. */
+static UsDriverOptions with_freertos(UsDriverOptions opts, idf_hals::IHalFreertos &freertos_hal)
+{
+    if (opts.freertos_hal == nullptr)
+        opts.freertos_hal = &freertos_hal;
+    return opts;
+}
+
 // Production constructor: creates concrete driver and processor internally
 UsSensor::UsSensor(
     idf_hals::IGpioHAL &gpio_hal,
@@ -22,11 +32,16 @@ UsSensor::UsSensor(
     idf_hals::IHalFreertos &freertos_hal,
     gpio_num_t trig_pin,
     gpio_num_t echo_pin,
-    const UsConfig &cfg)
+    const UsConfig &cfg,
+    const UsDriverOptions &driver_opts)
     : cfg_(cfg)
-    , driver_(std::make_shared<UsDriver>(gpio_hal, timer_hal, sys_rom_hal, trig_pin, echo_pin))
+    , compiled_(cfg)
+    , driver_(std::make_shared<UsDriver>(gpio_hal, timer_hal, sys_rom_hal, trig_pin, echo_pin,
+                                         with_freertos(driver_opts, freertos_hal)))
     , processor_(std::make_shared<UsProcessor>())
     , freertos_hal_(freertos_hal)
+    , timer_hal_(&timer_hal)
+    , interval_ms_(cfg.ping_interval_ms)
 {
 }
 
@@ -37,14 +52,38 @@ UsSensor::UsSensor(
     std::shared_ptr<IUsProcessor> processor,
     idf_hals::IHalFreertos &freertos_hal)
     : cfg_(cfg)
+    , compiled_(cfg)
     , driver_(driver)
     , processor_(processor)
     , freertos_hal_(freertos_hal)
+    , interval_ms_(cfg.ping_interval_ms)
+{
+}
+
+// Test constructor with a time source for ping timestamps
+UsSensor::UsSensor(
+    const UsConfig &cfg,
+    std::shared_ptr<IUsDriver> driver,
+    std::shared_ptr<IUsProcessor> processor,
+    idf_hals::IHalFreertos &freertos_hal,
+    idf_hals::ITimerHAL &timer_hal)
+    : cfg_(cfg)
+    , compiled_(cfg)
+    , driver_(driver)
+    , processor_(processor)
+    , freertos_hal_(freertos_hal)
+    , timer_hal_(&timer_hal)
+    , interval_ms_(cfg.ping_interval_ms)
 {
 }
 
 esp_err_t UsSensor::init()
 {
+    if (!compiled_.valid()) {
+        ESP_LOGE(TAG, "Invalid configuration: %s", config_error_name(compiled_.error));
+        return ESP_ERR_INVALID_ARG;
+    }
+
     esp_err_t ret = driver_->init();
     if (ret != ESP_OK) {
         return ret;
@@ -65,27 +104,128 @@ esp_err_t UsSensor::deinit()
 
 Reading UsSensor::read_distance(uint8_t ping_count)
 {
+    bool deadline_hit = false;
+    const int64_t start_us = latency_start();
+    Reading reading = run_burst(ping_count, NO_DEADLINE, deadline_hit);
+    record_read_latency(start_us, reading);
+    publish(reading);
+    return reading;
+}
+
+Reading UsSensor::read_distance(uint8_t ping_count, uint32_t deadline_us, bool &deadline_hit)
+{
+    const int64_t start_us = latency_start();
+    Reading reading = run_burst(ping_count, deadline_us, deadline_hit);
+    record_read_latency(start_us, reading);
+    publish(reading);
+    return reading;
+}
+
+MeasurementInfo UsSensor::read_distance_ex(uint8_t ping_count)
+{
+    return run_burst_ex(ping_count, NO_DEADLINE);
+}
+
+MeasurementInfo UsSensor::read_distance_ex(uint8_t ping_count, uint32_t deadline_us)
+{
+    return run_burst_ex(ping_count, deadline_us);
+}
+
+MeasurementInfo UsSensor::run_burst_ex(uint8_t ping_count, uint64_t budget_us)
+{
+    MeasurementInfo info;
+    const int64_t start_us = now_us();
+    info.reading = run_burst(ping_count, budget_us, info.deadline_hit, &info);
+    info.duration_us = elapsed_us(start_us);
+    record_read_latency(start_us, info.reading);
+    info.timestamp_us = publish(info.reading);
+    return info;
+}
+
+TimedReading UsSensor::get_latest(uint32_t max_age_ms)
+{
+    TimedReading latest = latest_.read();
+
+    latest.stale = (latest.timestamp_us < 0) || (now_us() - latest.timestamp_us > int64_t{max_age_ms} * 1000);
+    if (latest.stale) {
+        refresh_requested_.store(true, std::memory_order_relaxed);
+    }
+    return latest;
+}
+
+bool UsSensor::refresh_if_requested(uint8_t ping_count)
+{
+    if (!refresh_requested_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    read_distance(ping_count);
+    return true;
+}
+
+Reading UsSensor::run_burst(uint8_t ping_count, uint64_t budget_us, bool &deadline_hit, MeasurementInfo *info)
+{
+    deadline_hit = false;
+
     // Clamp ping_count to valid range
     if (ping_count == 0 || ping_count > MAX_PINGS) {
         ESP_LOGW(TAG, "ping_count %d out of range [1, %d], clamping", ping_count, MAX_PINGS);
         ping_count = (ping_count == 0) ? 1 : MAX_PINGS;
     }
 
+    const bool bounded = (budget_us != NO_DEADLINE);
+    const uint64_t ping_wcet_us = worst_case_ping_us(cfg_);
+    const uint64_t interval_wcet_us = uint64_t{interval_ms_} * 1000ULL; // never above worst_case_interval_us()
+
+    if (bounded && ping_wcet_us > budget_us) {
+        ESP_LOGW(TAG, "Deadline %llu us shorter than one ping (%llu us)",
+                 static_cast<unsigned long long>(budget_us), static_cast<unsigned long long>(ping_wcet_us));
+        deadline_hit = true;
+        Reading reading{UsResult::INSUFFICIENT_SAMPLES, 0.0f};
+        metrics_.add_burst(nullptr, 0, reading);
+        return reading;
+    }
+
+    // Elapsed time comes from the timer when one is available; otherwise every
+    // ping and delay is charged at its worst case.
+    const int64_t burst_start = (bounded && timer_hal_ != nullptr) ? now_us() : 0;
+    uint64_t charged_us = 0;
+
     Reading pings[MAX_PINGS];
+    int64_t fired_at[MAX_PINGS];
+    uint32_t echo_us[MAX_PINGS];
+    uint8_t echo_flags[MAX_PINGS];
     char log_buf[128] = "";
     int offset = 0;
+    uint8_t fired = 0;
 
     for (uint8_t i = 0; i < ping_count; i++) {
-        pings[i] = driver_->ping_once(cfg_);
+        if (recorder_ != nullptr) {
+            fired_at[i] = now_us();
+        }
+
+        const int64_t ping_start_us = latency_start();
+        pings[i] = driver_->ping_compiled(compiled_);
+        record_ping_latency(ping_start_us, pings[i]);
+        fired = i + 1;
+        charged_us += ping_wcet_us;
 
-        offset += snprintf(log_buf + offset, sizeof(log_buf) - offset, "%.1f-%d%s",
-                           pings[i].cm, static_cast<int>(pings[i].result),
-                           (i == ping_count - 1) ? "" : ", ");
+        if (recorder_ != nullptr) {
+            echo_us[i] = driver_->last_echo_us();
+            echo_flags[i] = driver_->last_echo_gated() ? TRACE_FLAG_GATE_REJECT : 0;
+        }
+
+        offset += snprintf(log_buf + offset, sizeof(log_buf) - offset, "%s%.1f-%d",
+                           (i == 0) ? "" : ", ", pings[i].cm, static_cast<int>(pings[i].result));
 
         // Hardware failures abort the loop immediately — application must act
         if (pings[i].result == UsResult::ECHO_STUCK || pings[i].result == UsResult::HW_FAULT) {
             ESP_LOGE(TAG, "Hardware failure on ping %d: %d — aborting", i, static_cast<int>(pings[i].result));
             ESP_LOGI(TAG, "UsSensor: %s (aborted)", log_buf);
+            record_burst(pings, fired_at, echo_us, echo_flags, fired);
+            metrics_.add_burst(pings, fired, pings[i]);
+            if (info != nullptr) {
+                info->count_pings(pings, fired);
+            }
             return pings[i];
         }
 
@@ -94,16 +234,222 @@ Reading UsSensor::read_distance(uint8_t ping_count)
             ESP_LOGD(TAG, "Ping %d failed: result=%d", i, static_cast<int>(pings[i].result));
         }
 
+        if (i == ping_count - 1) {
+            break;
+        }
+
+        // Stop before the delay if the next ping could end past the deadline
+        if (bounded) {
+            uint64_t elapsed_us = (timer_hal_ != nullptr) ? static_cast<uint64_t>(now_us() - burst_start) : charged_us;
+            if (elapsed_us + interval_wcet_us + ping_wcet_us > budget_us) {
+                deadline_hit = true;
+                break;
+            }
+        }
+
         // Apply inter-ping delay between pings, but not after the last ping
-        if (i < ping_count - 1 && cfg_.ping_interval_ms > 0) {
-            freertos_hal_.task_delay(pdMS_TO_TICKS(cfg_.ping_interval_ms));
+        if (interval_ms_ > 0) {
+            freertos_hal_.task_delay(pdMS_TO_TICKS(interval_ms_));
+            charged_us += interval_wcet_us;
         }
     }
 
-    ESP_LOGI(TAG, "UsSensor: %s", log_buf);
+    ESP_LOGI(TAG, "UsSensor: %s%s", log_buf, deadline_hit ? " (deadline)" : "");
+    record_burst(pings, fired_at, echo_us, echo_flags, fired);
 
     // Delegate processing (including logical error refinement) to the processor
-    return processor_->process(pings, ping_count, cfg_);
+    Reading reading = (info != nullptr) ? processor_->process_ex(pings, fired, compiled_, *info)
+                                        : processor_->process_compiled(pings, fired, compiled_);
+    adapt_interval(pings, fired, reading);
+    metrics_.add_burst(pings, fired, reading);
+    return reading;
+}
+
+UsTask<Reading> UsSensor::measure(UsExecutor &exec, uint8_t ping_count)
+{
+    if (ping_count == 0 || ping_count > MAX_PINGS) {
+        ESP_LOGW(TAG, "ping_count %d out of range [1, %d], clamping", ping_count, MAX_PINGS);
+        ping_count = (ping_count == 0) ? 1 : MAX_PINGS;
+    }
+
+    const int64_t start_us = latency_start();
+    Reading pings[MAX_PINGS];
+    int64_t fired_at[MAX_PINGS];
+    uint32_t echo_us[MAX_PINGS];
+    uint8_t echo_flags[MAX_PINGS];
+    uint8_t fired = 0;
+
+    for (uint8_t i = 0; i < ping_count; i++) {
+        if (recorder_ != nullptr) {
+            fired_at[i] = now_us();
+        }
+
+        const int64_t ping_start_us = latency_start();
+        pings[i] = co_await driver_->ping(exec, compiled_);
+        record_ping_latency(ping_start_us, pings[i]);
+        fired = i + 1;
+
+        if (recorder_ != nullptr) {
+            echo_us[i] = driver_->last_echo_us();
+            echo_flags[i] = driver_->last_echo_gated() ? TRACE_FLAG_GATE_REJECT : 0;
+        }
+
+        // Hardware failures abort the burst, as in read_distance()
+        if (pings[i].result == UsResult::ECHO_STUCK || pings[i].result == UsResult::HW_FAULT) {
+            ESP_LOGE(TAG, "Hardware failure on ping %d: %d — aborting", i, static_cast<int>(pings[i].result));
+            record_burst(pings, fired_at, echo_us, echo_flags, fired);
+            metrics_.add_burst(pings, fired, pings[i]);
+            record_read_latency(start_us, pings[i]);
+            publish(pings[i]);
+            co_return pings[i];
+        }
+
+        if (i < ping_count - 1 && interval_ms_ > 0) {
+            co_await exec.sleep_us(uint32_t{interval_ms_} * 1000);
+        }
+    }
+
+    record_burst(pings, fired_at, echo_us, echo_flags, fired);
+
+    Reading reading = processor_->process_compiled(pings, fired, compiled_);
+    adapt_interval(pings, fired, reading);
+    metrics_.add_burst(pings, fired, reading);
+    record_read_latency(start_us, reading);
+    publish(reading);
+    co_return reading;
+}
+
+void UsSensor::adapt_interval(const Reading *pings, uint8_t count, const Reading &reading)
+{
+    if (cfg_.min_ping_interval_ms == 0 || count < 2)
+        return;
+
+    const uint16_t max_ms = cfg_.ping_interval_ms;
+    const uint16_t min_ms = std::min(cfg_.min_ping_interval_ms, max_ms);
+
+    // Reference target: the farther of the burst result and the first ping. The first ping follows the
+    // long gap between bursts, so it is clean even when early echoes dominate the burst result.
+    const bool have_result = is_success(reading.result);
+    const bool have_first = is_success(pings[0].result);
+    if (!have_result && !have_first)
+        return;
+    const float ref_cm = std::max(have_result ? reading.cm : 0.0f, have_first ? pings[0].cm : 0.0f);
+
+    // Every later ping follows an inter-ping delay; a much closer target is residual echo
+    uint8_t early = 0;
+    for (uint8_t i = 1; i < count; i++) {
+        if (is_success(pings[i].result) && pings[i].cm < ref_cm - EARLY_ECHO_MARGIN_CM) {
+            early++;
+        }
+    }
+
+    if (early > 0) {
+        early_echoes_ += early;
+        uint32_t grown = interval_ms_ + std::max(interval_ms_ / 2, 1);
+        interval_ms_ = static_cast<uint16_t>(std::min<uint32_t>(grown, max_ms));
+        ESP_LOGD(TAG, "%d early echoes, ping interval %d ms", early, interval_ms_);
+    } else if (interval_ms_ > min_ms) {
+        interval_ms_ = static_cast<uint16_t>(std::max<int32_t>(interval_ms_ - cfg_.interval_step_ms, min_ms));
+    }
+}
+
+int64_t UsSensor::publish(const Reading &reading)
+{
+    // Clear the request first: a reader finding the new value stale asks again
+    refresh_requested_.store(false, std::memory_order_relaxed);
+
+    TimedReading latest;
+    latest.reading = reading;
+    latest.timestamp_us = now_us();
+    latest.stale = false;
+    latest_.write(latest);
+
+    for (IUsReadingSink *sink : sinks_) {
+        if (sink != nullptr) {
+            sink->on_reading(latest);
+        }
+    }
+    return latest.timestamp_us;
+}
+
+esp_err_t UsSensor::add_reading_sink(IUsReadingSink *sink)
+{
+    if (sink == nullptr)
+        return ESP_ERR_INVALID_ARG;
+
+    IUsReadingSink **free_slot = nullptr;
+    for (IUsReadingSink *&slot : sinks_) {
+        if (slot == sink)
+            return ESP_OK;
+        if (slot == nullptr && free_slot == nullptr)
+            free_slot = &slot;
+    }
+    if (free_slot == nullptr)
+        return ESP_ERR_NO_MEM;
+
+    *free_slot = sink;
+    return ESP_OK;
+}
+
+esp_err_t UsSensor::remove_reading_sink(IUsReadingSink *sink)
+{
+    for (IUsReadingSink *&slot : sinks_) {
+        if (sink != nullptr && slot == sink) {
+            slot = nullptr;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+int64_t UsSensor::now_us() const
+{
+    return (timer_hal_ != nullptr) ? timer_hal_->get_time_us() : 0;
+}
+
+int64_t UsSensor::latency_start() const
+{
+    return (latency_ != nullptr) ? now_us() : 0;
+}
+
+void UsSensor::record_ping_latency(int64_t start_us, const Reading &ping)
+{
+    if (latency_ != nullptr && timer_hal_ != nullptr) {
+        latency_->record_ping(ping.result, elapsed_us(start_us));
+    }
+}
+
+void UsSensor::record_read_latency(int64_t start_us, const Reading &reading)
+{
+    if (latency_ != nullptr && timer_hal_ != nullptr) {
+        latency_->record_read(reading.result, elapsed_us(start_us));
+    }
+}
+
+uint32_t UsSensor::elapsed_us(int64_t start_us) const
+{
+    int64_t elapsed = now_us() - start_us;
+    if (elapsed < 0)
+        return 0;
+    return (elapsed > UINT32_MAX) ? UINT32_MAX : static_cast<uint32_t>(elapsed);
+}
+
+void UsSensor::record_burst(const Reading *pings, const int64_t *fired_at, const uint32_t *echo_us,
+                            const uint8_t *echo_flags, uint8_t count)
+{
+    if (recorder_ == nullptr)
+        return;
+
+    for (uint8_t i = 0; i < count; i++) {
+        TraceRecord rec = {};
+        rec.timestamp_us = fired_at[i];
+        rec.echo_us = echo_us[i];
+        rec.result = static_cast<uint8_t>(pings[i].result);
+        rec.ping_index = i;
+        rec.ping_count = count;
+        rec.flags = echo_flags[i];
+        recorder_->record(rec);
+    }
 }
 
 } // namespace ultrasonic
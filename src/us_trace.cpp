@@ -0,0 +1,161 @@
+// components/ultrasonic_sensor/src/us_trace.cpp
+
+#include "us_trace.hpp"
+#include "us_trace_file.hpp"
+
+#include <cstdint>
+#include <cstdio>
+
+#define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
+#include "esp_log.h"
+
+namespace ultrasonic {
+
+static const char *TAG = "UsTrace";
+
+TraceHeader make_trace_header(const UsConfig &cfg, uint32_t sensor_id)
+{
+    TraceHeader h = {};
+    h.magic = TRACE_MAGIC;
+    h.version = TRACE_VERSION;
+    h.record_size = sizeof(TraceRecord);
+    h.sensor_id = sensor_id;
+    h.ping_interval_ms = cfg.ping_interval_ms;
+    h.ping_duration_us = cfg.ping_duration_us;
+    h.timeout_us = cfg.timeout_us;
+    h.min_distance_cm = cfg.min_distance_cm;
+    h.max_distance_cm = cfg.max_distance_cm;
+    h.max_dev_cm = cfg.max_dev_cm;
+    h.filter = static_cast<uint8_t>(cfg.filter);
+    h.warmup_time_ms = cfg.warmup_time_ms;
+    h.track_gate_cm = cfg.track_gate_cm;
+    h.trigger_jitter_us = cfg.trigger_jitter_us;
+    return h;
+}
+
+esp_err_t trace_header_to_config(const TraceHeader &header, UsConfig &cfg)
+{
+    if (header.magic != TRACE_MAGIC)
+        return ESP_ERR_INVALID_ARG;
+    if (header.version < TRACE_VERSION_MIN || header.version > TRACE_VERSION ||
+        header.record_size != sizeof(TraceRecord))
+        return ESP_ERR_INVALID_VERSION;
+
+    cfg = UsConfig{};
+    cfg.ping_interval_ms = header.ping_interval_ms;
+    cfg.ping_duration_us = header.ping_duration_us;
+    cfg.timeout_us = header.timeout_us;
+    cfg.min_distance_cm = header.min_distance_cm;
+    cfg.max_distance_cm = header.max_distance_cm;
+    cfg.max_dev_cm = header.max_dev_cm;
+    cfg.filter = static_cast<Filter>(header.filter);
+    cfg.warmup_time_ms = header.warmup_time_ms;
+    if (header.version >= 2) {
+        cfg.track_gate_cm = header.track_gate_cm;
+        cfg.trigger_jitter_us = header.trigger_jitter_us;
+    }
+    return ESP_OK;
+}
+
+// =================================================================
+// UsTraceWriter
+// =================================================================
+
+UsTraceWriter::~UsTraceWriter()
+{
+    close();
+}
+
+esp_err_t UsTraceWriter::open(const char *path, const UsConfig &cfg, uint32_t sensor_id)
+{
+    if (file_ != nullptr)
+        return ESP_ERR_INVALID_STATE;
+
+    file_ = fopen(path, "wb");
+    if (file_ == nullptr) {
+        ESP_LOGE(TAG, "Cannot create trace file %s", path);
+        return ESP_FAIL;
+    }
+
+    TraceHeader header = make_trace_header(cfg, sensor_id);
+    if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+        ESP_LOGE(TAG, "Cannot write trace header to %s", path);
+        fclose(file_);
+        file_ = nullptr;
+        return ESP_FAIL;
+    }
+
+    written_ = 0;
+    dropped_ = 0;
+    return ESP_OK;
+}
+
+esp_err_t UsTraceWriter::close()
+{
+    if (file_ == nullptr)
+        return ESP_OK;
+
+    int ret = fclose(file_);
+    file_ = nullptr;
+    return (ret == 0) ? ESP_OK : ESP_FAIL;
+}
+
+void UsTraceWriter::record(const TraceRecord &rec)
+{
+    if (file_ == nullptr || fwrite(&rec, sizeof(rec), 1, file_) != 1) {
+        dropped_++;
+        return;
+    }
+    written_++;
+}
+
+// =================================================================
+// UsTraceReader
+// =================================================================
+
+UsTraceReader::~UsTraceReader()
+{
+    close();
+}
+
+esp_err_t UsTraceReader::open(const char *path)
+{
+    if (file_ != nullptr)
+        return ESP_ERR_INVALID_STATE;
+
+    file_ = fopen(path, "rb");
+    if (file_ == nullptr)
+        return ESP_ERR_NOT_FOUND;
+
+    TraceHeader header;
+    esp_err_t ret = ESP_ERR_INVALID_SIZE;
+    if (fread(&header, sizeof(header), 1, file_) == 1) {
+        ret = trace_header_to_config(header, cfg_);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Invalid trace file %s: %s", path, esp_err_to_name(ret));
+        close();
+        return ret;
+    }
+
+    sensor_id_ = header.sensor_id;
+    return ESP_OK;
+}
+
+void UsTraceReader::close()
+{
+    if (file_ != nullptr) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool UsTraceReader::next(TraceRecord &rec)
+{
+    if (file_ == nullptr)
+        return false;
+    return fread(&rec, sizeof(rec), 1, file_) == 1;
+}
+
+} // namespace ultrasonic
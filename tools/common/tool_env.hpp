@@ -0,0 +1,41 @@
+#pragma once
+
+// Option parsing shared by the host tools. The linux target does not forward
+// argv to app_main, so every option comes from an environment variable.
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace us_tools {
+
+/** @brief Non-empty fields of @p s separated by @p sep; empty if @p s is nullptr. */
+inline std::vector<std::string> split(const char *s, char sep)
+{
+    std::vector<std::string> out;
+    if (s == nullptr)
+        return out;
+    std::string cur;
+    for (const char *p = s; *p; p++) {
+        if (*p == sep) {
+            if (!cur.empty())
+                out.push_back(cur);
+            cur.clear();
+        }
+        else {
+            cur += *p;
+        }
+    }
+    if (!cur.empty())
+        out.push_back(cur);
+    return out;
+}
+
+/** @brief Integer value of environment variable @p name, @p fallback when unset or empty. */
+inline long env_long(const char *name, long fallback)
+{
+    const char *v = getenv(name);
+    return (v != nullptr && *v != '\0') ? strtol(v, nullptr, 10) : fallback;
+}
+
+} // namespace us_tools
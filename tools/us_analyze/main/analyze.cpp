@@ -0,0 +1,280 @@
+// components/ultrasonic_sensor/tools/us_analyze/main/analyze.cpp
+
+#include "analyze.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <csignal>
+#include <fcntl.h>
+#include <map>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "us_compiled_config.hpp"
+#include "us_processor.hpp"
+#include "us_replay_driver.hpp"
+
+namespace us_analyze {
+
+using namespace ultrasonic;
+
+// =================================================================
+// MappedTrace
+// =================================================================
+
+MappedTrace::~MappedTrace()
+{
+    close();
+}
+
+esp_err_t MappedTrace::open(const char *path)
+{
+    if (base_ != nullptr)
+        return ESP_ERR_INVALID_STATE;
+
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return ESP_ERR_NOT_FOUND;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (static_cast<size_t>(st.st_size) < sizeof(TraceHeader)) {
+        ::close(fd);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // The mapping keeps its own reference to the file
+    void *base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+        return ESP_ERR_NOT_FOUND;
+
+    const auto *header = static_cast<const TraceHeader *>(base);
+    UsConfig cfg;
+    esp_err_t ret = trace_header_to_config(*header, cfg);
+    if (ret != ESP_OK) {
+        munmap(base, static_cast<size_t>(st.st_size));
+        return ret;
+    }
+
+    // The header is a multiple of 16 bytes, so the records are aligned in place
+    base_ = base;
+    size_ = static_cast<size_t>(st.st_size);
+    records_ = reinterpret_cast<const TraceRecord *>(static_cast<const uint8_t *>(base) + sizeof(TraceHeader));
+    count_ = (size_ - sizeof(TraceHeader)) / sizeof(TraceRecord);
+    cfg_ = cfg;
+    sensor_id_ = header->sensor_id;
+    madvise(base_, size_, MADV_SEQUENTIAL);
+    return ESP_OK;
+}
+
+void MappedTrace::close()
+{
+    if (base_ != nullptr)
+        munmap(base_, size_);
+    base_ = nullptr;
+    size_ = 0;
+    records_ = nullptr;
+    count_ = 0;
+}
+
+void MappedTrace::release(size_t first, size_t last) const
+{
+    if (base_ == nullptr || first >= last)
+        return;
+
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    uintptr_t begin = reinterpret_cast<uintptr_t>(records_ + first);
+    uintptr_t end = reinterpret_cast<uintptr_t>(records_ + std::min(last, count_));
+    begin = (begin + page - 1) & ~(page - 1);
+    end &= ~(page - 1);
+    if (begin < end)
+        madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+}
+
+// =================================================================
+// Overrides and Summary
+// =================================================================
+
+UsConfig Overrides::apply(const UsConfig &recorded) const
+{
+    UsConfig cfg = recorded;
+    if (!std::isnan(max_dev_cm))
+        cfg.max_dev_cm = max_dev_cm;
+    if (!std::isnan(min_distance_cm))
+        cfg.min_distance_cm = min_distance_cm;
+    if (!std::isnan(max_distance_cm))
+        cfg.max_distance_cm = max_distance_cm;
+    if (filter >= 0)
+        cfg.filter = static_cast<Filter>(filter);
+    return cfg;
+}
+
+void Summary::merge(const Summary &other)
+{
+    bursts += other.bursts;
+    pings += other.pings;
+    for (size_t a = 0; a < RESULTS; a++) {
+        baseline[a] += other.baseline[a];
+        candidate[a] += other.candidate[a];
+        for (size_t b = 0; b < RESULTS; b++) {
+            transitions[a][b] += other.transitions[a][b];
+        }
+    }
+    both_success += other.both_success;
+    shift_cm += other.shift_cm;
+}
+
+uint64_t Summary::changed() const
+{
+    uint64_t n = 0;
+    for (size_t a = 0; a < RESULTS; a++) {
+        for (size_t b = 0; b < RESULTS; b++) {
+            if (a != b)
+                n += transitions[a][b];
+        }
+    }
+    return n;
+}
+
+double Summary::success_rate(const uint64_t *results) const
+{
+    if (bursts == 0)
+        return 0.0;
+    const uint64_t ok = results[static_cast<size_t>(UsResult::OK)] + results[static_cast<size_t>(UsResult::WEAK_SIGNAL)];
+    return static_cast<double>(ok) / static_cast<double>(bursts);
+}
+
+// =================================================================
+// Chunking and reprocessing
+// =================================================================
+
+void plan_chunks(const MappedTrace &trace, size_t records, std::vector<Chunk> &out)
+{
+    if (records == 0)
+        records = 1;
+
+    const TraceRecord *rec = trace.records();
+    size_t first = 0;
+    while (first < trace.count()) {
+        size_t last = std::min(first + records, trace.count());
+        while (last < trace.count() && rec[last].ping_index != 0) {
+            last++;
+        }
+        out.push_back({&trace, first, last});
+        first = last;
+    }
+}
+
+// Corrupt result bytes are counted as hardware faults
+static size_t result_index(UsResult r)
+{
+    const size_t i = static_cast<size_t>(r);
+    return (i < US_RESULT_COUNT) ? i : static_cast<size_t>(UsResult::HW_FAULT);
+}
+
+// Same sequence as UsSensor::read_distance(): a hardware failure ends the
+// burst with its own result, everything else goes to the processor
+static Reading process_burst(const TraceRecord *rec, uint8_t count, const UsCompiledConfig &cc, UsProcessor &processor)
+{
+    Reading pings[IUsProcessor::MAX_PINGS];
+    for (uint8_t i = 0; i < count; i++) {
+        pings[i] = UsReplayDriver::reevaluate(rec[i], cc);
+        if (pings[i].result == UsResult::ECHO_STUCK || pings[i].result == UsResult::HW_FAULT)
+            return pings[i];
+    }
+    return processor.process_compiled(pings, count, cc);
+}
+
+Summary analyze_chunk(const Chunk &chunk, const Overrides &overrides)
+{
+    const MappedTrace &trace = *chunk.trace;
+    const UsCompiledConfig baseline(trace.config());
+    const UsCompiledConfig candidate(overrides.apply(trace.config()));
+    const uint8_t max_pings = (overrides.ping_count == 0 || overrides.ping_count > IUsProcessor::MAX_PINGS)
+                                  ? IUsProcessor::MAX_PINGS
+                                  : overrides.ping_count;
+
+    UsProcessor processor;
+    Summary s;
+    s.sensor_id = trace.sensor_id();
+
+    const TraceRecord *rec = trace.records();
+    size_t i = chunk.first;
+    while (i < chunk.last) {
+        // A burst runs until the next record that starts one
+        size_t end = i + 1;
+        while (end < chunk.last && rec[end].ping_index != 0) {
+            end++;
+        }
+        s.pings += end - i;
+
+        const uint8_t recorded = static_cast<uint8_t>(std::min<size_t>(end - i, IUsProcessor::MAX_PINGS));
+        const Reading before = process_burst(rec + i, recorded, baseline, processor);
+        const Reading after = process_burst(rec + i, std::min(recorded, max_pings), candidate, processor);
+
+        const size_t b = result_index(before.result);
+        const size_t a = result_index(after.result);
+        s.bursts++;
+        s.baseline[b]++;
+        s.candidate[a]++;
+        s.transitions[b][a]++;
+        if (is_success(before.result) && is_success(after.result)) {
+            s.both_success++;
+            s.shift_cm += std::fabs(after.cm - before.cm);
+        }
+        i = end;
+    }
+    return s;
+}
+
+std::vector<Summary> analyze(const std::vector<Chunk> &chunks, const Overrides &overrides, unsigned threads)
+{
+    if (threads == 0)
+        threads = 1;
+
+    // Each chunk owns its slot, so workers never contend on the results
+    std::vector<Summary> partial(chunks.size());
+    std::atomic<size_t> next{0};
+
+    auto worker = [&] {
+        // Workers are plain pthreads next to the FreeRTOS simulator; keep its
+        // tick and context-switch signals away from them.
+        sigset_t all;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+        size_t c;
+        while ((c = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size()) {
+            partial[c] = analyze_chunk(chunks[c], overrides);
+            chunks[c].trace->release(chunks[c].first, chunks[c].last);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back(worker);
+    }
+    for (auto &w : workers) w.join();
+
+    std::map<uint32_t, Summary> by_sensor;
+    for (const Summary &p : partial) {
+        Summary &s = by_sensor[p.sensor_id];
+        s.sensor_id = p.sensor_id;
+        s.merge(p);
+    }
+
+    std::vector<Summary> out;
+    out.reserve(by_sensor.size());
+    for (const auto &[id, s] : by_sensor) out.push_back(s);
+    return out;
+}
+
+} // namespace us_analyze
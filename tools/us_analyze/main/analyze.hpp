@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esp_err.h"
+#include "us_trace.hpp"
+#include "us_types.hpp"
+
+namespace us_analyze {
+
+/**
+ * @brief Read-only memory mapping of one trace file.
+ *
+ * The records are used in place: records() points into the mapping, so a
+ * file of any size costs address space but no heap. Pages are read in on
+ * first access and can be dropped again with release().
+ */
+class MappedTrace
+{
+public:
+    MappedTrace() = default;
+    ~MappedTrace();
+
+    MappedTrace(const MappedTrace &) = delete;
+    MappedTrace &operator=(const MappedTrace &) = delete;
+
+    /**
+     * @brief Map a trace file and validate its header.
+     *
+     * A partial record at the end of the file (a writer cut off mid-record)
+     * is ignored.
+     *
+     * @param path File path.
+     * @return
+     *     - ESP_OK: Success
+     *     - ESP_ERR_INVALID_STATE: A file is already mapped
+     *     - ESP_ERR_NOT_FOUND: The file could not be opened or mapped
+     *     - ESP_ERR_INVALID_SIZE: The file is shorter than a header
+     *     - Other: errors from trace_header_to_config()
+     */
+    esp_err_t open(const char *path);
+
+    /** @brief Unmap the file. */
+    void close();
+
+    /** @brief Records of the file, in recording order. */
+    const ultrasonic::TraceRecord *records() const { return records_; }
+
+    /** @brief Number of complete records. */
+    size_t count() const { return count_; }
+
+    /** @brief Configuration stored in the header. */
+    const ultrasonic::UsConfig &config() const { return cfg_; }
+
+    /** @brief Sensor identifier stored in the header. */
+    uint32_t sensor_id() const { return sensor_id_; }
+
+    /**
+     * @brief Drop the resident pages of records [first, last).
+     *
+     * Only pages entirely inside the range are dropped; the data stays in
+     * the mapping and is read in again if touched.
+     */
+    void release(size_t first, size_t last) const;
+
+private:
+    void *base_ = nullptr;
+    size_t size_ = 0;
+    const ultrasonic::TraceRecord *records_ = nullptr;
+    size_t count_ = 0;
+    ultrasonic::UsConfig cfg_;
+    uint32_t sensor_id_ = 0;
+};
+
+/**
+ * @brief Processing changes applied on top of each file's recorded configuration.
+ *
+ * NaN floats, a negative filter and a zero ping count keep the recorded value.
+ */
+struct Overrides
+{
+    float max_dev_cm;      /**< UsConfig::max_dev_cm. */
+    float min_distance_cm; /**< UsConfig::min_distance_cm. */
+    float max_distance_cm; /**< UsConfig::max_distance_cm. */
+    int filter;            /**< UsConfig::filter, as its integer value. */
+    uint8_t ping_count;    /**< Pings used from each recorded burst (0 = all). */
+
+    /** @brief @p recorded with the overrides applied. */
+    ultrasonic::UsConfig apply(const ultrasonic::UsConfig &recorded) const;
+};
+
+/**
+ * @brief Recorded bursts of one sensor, reprocessed under the recorded and the candidate configuration.
+ */
+struct Summary
+{
+    static constexpr size_t RESULTS = ultrasonic::US_RESULT_COUNT;
+
+    uint32_t sensor_id = 0;
+    uint64_t bursts = 0;                          /**< Bursts reprocessed. */
+    uint64_t pings = 0;                           /**< Pings read, including those beyond the ping count. */
+    uint64_t baseline[RESULTS] = {};              /**< Burst results under the recorded configuration. */
+    uint64_t candidate[RESULTS] = {};             /**< Burst results under the candidate configuration. */
+    uint64_t transitions[RESULTS][RESULTS] = {};  /**< Bursts by [baseline][candidate] result. */
+    uint64_t both_success = 0;                    /**< Bursts successful under both configurations. */
+    double shift_cm = 0.0;                        /**< Sum of |candidate - baseline| over both_success bursts. */
+
+    void merge(const Summary &other);
+
+    /** @brief Bursts whose result changed. */
+    uint64_t changed() const;
+
+    /** @brief Bursts ending in OK or WEAK_SIGNAL under the given counts, as a fraction. */
+    double success_rate(const uint64_t *results) const;
+
+    /** @brief Mean distance change over both_success bursts (cm). */
+    double mean_shift_cm() const { return both_success ? shift_cm / both_success : 0.0; }
+};
+
+/**
+ * @brief A range of records of one trace that starts on a burst boundary.
+ */
+struct Chunk
+{
+    const MappedTrace *trace;
+    size_t first; /**< First record, the start of a burst (or of the file). */
+    size_t last;  /**< One past the last record, the start of the next chunk's first burst. */
+};
+
+/**
+ * @brief Split a trace into chunks of about @p records records.
+ *
+ * Boundaries are moved forward to the next burst start, so no burst is
+ * split. Only the records near each boundary are touched.
+ */
+void plan_chunks(const MappedTrace &trace, size_t records, std::vector<Chunk> &out);
+
+/**
+ * @brief Reprocess the bursts of one chunk.
+ *
+ * Every burst is run through UsProcessor twice: under the recorded
+ * configuration and under @p overrides applied to it.
+ */
+Summary analyze_chunk(const Chunk &chunk, const Overrides &overrides);
+
+/**
+ * @brief Reprocess every chunk on @p threads worker threads.
+ *
+ * Workers take chunks in order from a shared counter, so pages are read
+ * roughly sequentially. A chunk's pages are released once it is done, which
+ * keeps the resident set near threads x chunk size however large the files.
+ *
+ * @return One summary per sensor identifier, sorted by identifier.
+ */
+std::vector<Summary> analyze(const std::vector<Chunk> &chunks, const Overrides &overrides, unsigned threads);
+
+} // namespace us_analyze
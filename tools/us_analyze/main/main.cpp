@@ -0,0 +1,143 @@
+// components/ultrasonic_sensor/tools/us_analyze/main/main.cpp
+//
+// Host tool: reprocesses archived field traces under a changed UsConfig and
+// reports, per sensor, how the burst results would change.
+// The linux target does not forward argv to app_main, so options come from
+// environment variables (see tools/README.md).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analyze.hpp"
+#include "tool_env.hpp"
+#include "us_metrics.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using namespace us_analyze;
+using namespace us_tools;
+
+static float env_float(const char *name)
+{
+    const char *v = getenv(name);
+    return v ? strtof(v, nullptr) : std::numeric_limits<float>::quiet_NaN();
+}
+
+static int env_filter(const char *name)
+{
+    const char *v = getenv(name);
+    if (v == nullptr)
+        return -1;
+    if (strcmp(v, "MEDIAN") == 0)
+        return static_cast<int>(Filter::MEDIAN);
+    if (strcmp(v, "CLUSTER") == 0)
+        return static_cast<int>(Filter::DOMINANT_CLUSTER);
+    fprintf(stderr, "%s must be MEDIAN or CLUSTER\n", name);
+    exit(2);
+}
+
+static double pct(uint64_t n, uint64_t total)
+{
+    return total ? 100.0 * static_cast<double>(n) / static_cast<double>(total) : 0.0;
+}
+
+extern "C" void app_main(void)
+{
+    std::vector<std::string> paths = split(getenv("US_ANALYZE_TRACES"), ':');
+    if (paths.empty()) {
+        fprintf(stderr, "US_ANALYZE_TRACES is empty: set it to a ':'-separated list of trace files\n");
+        exit(2);
+    }
+
+    Overrides overrides{};
+    overrides.max_dev_cm = env_float("US_ANALYZE_MAX_DEV");
+    overrides.min_distance_cm = env_float("US_ANALYZE_MIN_CM");
+    overrides.max_distance_cm = env_float("US_ANALYZE_MAX_CM");
+    overrides.filter = env_filter("US_ANALYZE_FILTER");
+    overrides.ping_count = static_cast<uint8_t>(std::max(0L, std::min(env_long("US_ANALYZE_PINGS", 0), 255L)));
+
+    // Map every file up front; only the records at chunk boundaries are touched here
+    std::vector<std::unique_ptr<MappedTrace>> traces;
+    std::vector<Chunk> chunks;
+    const size_t chunk = static_cast<size_t>(env_long("US_ANALYZE_CHUNK", 1L << 20));
+    uint64_t records = 0;
+    for (const auto &path : paths) {
+        auto trace = std::make_unique<MappedTrace>();
+        esp_err_t ret = trace->open(path.c_str());
+        if (ret != ESP_OK) {
+            fprintf(stderr, "Cannot map trace %s: %s\n", path.c_str(), esp_err_to_name(ret));
+            exit(2);
+        }
+        records += trace->count();
+        plan_chunks(*trace, chunk, chunks);
+        traces.push_back(std::move(trace));
+    }
+
+    unsigned threads = static_cast<unsigned>(env_long("US_ANALYZE_THREADS", std::thread::hardware_concurrency()));
+    printf("Mapped %llu pings (%.1f MB) from %zu trace(s) in %zu chunk(s)\n", static_cast<unsigned long long>(records),
+           static_cast<double>(records) * sizeof(TraceRecord) / 1e6, traces.size(), chunks.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<Summary> sensors = analyze(chunks, overrides, threads);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    Summary fleet;
+    for (const Summary &s : sensors) fleet.merge(s);
+    printf("Reprocessed %llu bursts on %u threads in %.2f s (%.1f M pings/s)\n\n",
+           static_cast<unsigned long long>(fleet.bursts), threads, secs,
+           (secs > 0) ? static_cast<double>(fleet.pings) / secs / 1e6 : 0.0);
+
+    printf("%10s %10s %8s %8s %8s %8s %8s %9s\n", "sensor", "bursts", "ok%", "ok%'", "succ%", "succ%'", "changed%",
+           "shift_cm");
+    const size_t ok = static_cast<size_t>(UsResult::OK);
+    for (const Summary &s : sensors) {
+        printf("%10u %10llu %8.2f %8.2f %8.2f %8.2f %8.2f %9.3f\n", s.sensor_id,
+               static_cast<unsigned long long>(s.bursts), pct(s.baseline[ok], s.bursts), pct(s.candidate[ok], s.bursts),
+               100.0 * s.success_rate(s.baseline), 100.0 * s.success_rate(s.candidate), pct(s.changed(), s.bursts),
+               s.mean_shift_cm());
+    }
+
+    printf("\nResult changes (recorded -> candidate), all sensors:\n");
+    for (size_t a = 0; a < Summary::RESULTS; a++) {
+        for (size_t b = 0; b < Summary::RESULTS; b++) {
+            if (a != b && fleet.transitions[a][b] > 0) {
+                printf("  %-20s -> %-20s %12llu (%.2f%%)\n", result_name(static_cast<UsResult>(a)),
+                       result_name(static_cast<UsResult>(b)), static_cast<unsigned long long>(fleet.transitions[a][b]),
+                       pct(fleet.transitions[a][b], fleet.bursts));
+            }
+        }
+    }
+
+    const char *csv_path = getenv("US_ANALYZE_CSV");
+    if (csv_path != nullptr) {
+        FILE *csv = fopen(csv_path, "w");
+        if (csv == nullptr) {
+            fprintf(stderr, "Cannot create %s\n", csv_path);
+            exit(1);
+        }
+        fprintf(csv, "sensor_id,bursts,pings,changed,mean_shift_cm");
+        for (size_t r = 0; r < Summary::RESULTS; r++) fprintf(csv, ",%s", result_name(static_cast<UsResult>(r)));
+        for (size_t r = 0; r < Summary::RESULTS; r++) fprintf(csv, ",%s_new", result_name(static_cast<UsResult>(r)));
+        fprintf(csv, "\n");
+        for (const Summary &s : sensors) {
+            fprintf(csv, "%u,%llu,%llu,%llu,%.4f", s.sensor_id, static_cast<unsigned long long>(s.bursts),
+                    static_cast<unsigned long long>(s.pings), static_cast<unsigned long long>(s.changed()),
+                    s.mean_shift_cm());
+            for (uint64_t n : s.baseline) fprintf(csv, ",%llu", static_cast<unsigned long long>(n));
+            for (uint64_t n : s.candidate) fprintf(csv, ",%llu", static_cast<unsigned long long>(n));
+            fprintf(csv, "\n");
+        }
+        fclose(csv);
+    }
+
+    exit(0);
+}
@@ -0,0 +1,185 @@
+// components/ultrasonic_sensor/tools/us_sweep/main/main.cpp
+//
+// Host tool: ranks UsConfig candidates on recorded field traces.
+// The linux target does not forward argv to app_main, so options come from
+// environment variables (see tools/README.md).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "i_us_processor.hpp"
+#include "sweep.hpp"
+#include "tool_env.hpp"
+#include "us_types.hpp"
+
+using namespace ultrasonic;
+using namespace us_sweep;
+using namespace us_tools;
+
+/** Comma-separated list from @p name; @p fallback (never empty) when unset or listing nothing. */
+static std::vector<float> env_floats(const char *name, const char *fallback)
+{
+    const char *v = getenv(name);
+    std::vector<std::string> items = split(v, ',');
+    if (items.empty()) {
+        if (v != nullptr)
+            fprintf(stderr, "%s lists no values, using %s\n", name, fallback);
+        items = split(fallback, ',');
+    }
+    std::vector<float> out;
+    for (const auto &s : items) out.push_back(strtof(s.c_str(), nullptr));
+    return out;
+}
+
+static const char *filter_name(Filter f)
+{
+    return (f == Filter::MEDIAN) ? "MEDIAN" : "CLUSTER";
+}
+
+static std::vector<Candidate> grid_candidates(
+    const std::vector<Dataset> &datasets,
+    const std::vector<float> &max_devs,
+    const std::vector<float> &ping_counts,
+    const std::vector<Filter> &filters)
+{
+    std::vector<Candidate> out;
+    for (const Dataset &ds : datasets) {
+        for (float dev : max_devs) {
+            for (float pc : ping_counts) {
+                for (Filter f : filters) {
+                    Candidate c{ds.recorded_cfg, static_cast<uint8_t>(pc)};
+                    c.cfg.max_dev_cm = dev;
+                    c.cfg.filter = f;
+                    out.push_back(c);
+                }
+            }
+        }
+    }
+    return out;
+}
+
+static std::vector<Candidate> random_candidates(
+    const std::vector<Dataset> &datasets,
+    const std::vector<float> &max_devs,
+    const std::vector<float> &ping_counts,
+    long samples,
+    unsigned seed)
+{
+    std::mt19937 rng(seed);
+    auto [dev_lo, dev_hi] = std::minmax_element(max_devs.begin(), max_devs.end());
+    auto [pc_lo, pc_hi] = std::minmax_element(ping_counts.begin(), ping_counts.end());
+    std::uniform_real_distribution<float> dev(*dev_lo, *dev_hi);
+    std::uniform_int_distribution<int> pc(static_cast<int>(*pc_lo), static_cast<int>(*pc_hi));
+    std::uniform_int_distribution<size_t> ds(0, datasets.size() - 1);
+    std::bernoulli_distribution cluster(0.5);
+
+    std::vector<Candidate> out;
+    for (long i = 0; i < samples; i++) {
+        Candidate c{datasets[ds(rng)].recorded_cfg, static_cast<uint8_t>(pc(rng))};
+        c.cfg.max_dev_cm = dev(rng);
+        c.cfg.filter = cluster(rng) ? Filter::DOMINANT_CLUSTER : Filter::MEDIAN;
+        out.push_back(c);
+    }
+    return out;
+}
+
+extern "C" void app_main(void)
+{
+    std::vector<std::string> traces = split(getenv("US_SWEEP_TRACES"), ':');
+    if (traces.empty()) {
+        fprintf(stderr, "US_SWEEP_TRACES is empty: set it to a ':'-separated list of trace files\n");
+        exit(2);
+    }
+
+    std::vector<Dataset> datasets;
+    long total_bursts = 0;
+    for (const auto &path : traces) {
+        long n = load_trace(path.c_str(), datasets);
+        if (n < 0) {
+            fprintf(stderr, "Cannot read trace %s\n", path.c_str());
+            exit(2);
+        }
+        total_bursts += n;
+    }
+
+    const char *truth = getenv("US_SWEEP_TRUTH_CM");
+    float truth_cm = truth ? strtof(truth, nullptr) : std::numeric_limits<float>::quiet_NaN();
+    for (Dataset &ds : datasets) compute_references(ds, truth_cm);
+
+    std::vector<float> max_devs = env_floats("US_SWEEP_MAX_DEV", "2,5,10,15,20,30");
+    std::vector<float> ping_counts = env_floats("US_SWEEP_PINGS", "1,3,5,7,9,11,15");
+    for (float &pc : ping_counts) pc = std::clamp(pc, 1.0f, static_cast<float>(IUsProcessor::MAX_PINGS));
+
+    long random = env_long("US_SWEEP_RANDOM", 0);
+    std::vector<Candidate> candidates =
+        (random > 0)
+            ? random_candidates(datasets, max_devs, ping_counts, random, static_cast<unsigned>(env_long("US_SWEEP_SEED", 1)))
+            : grid_candidates(datasets, max_devs, ping_counts, {Filter::MEDIAN, Filter::DOMINANT_CLUSTER});
+
+    unsigned threads = static_cast<unsigned>(env_long("US_SWEEP_THREADS", std::thread::hardware_concurrency()));
+    size_t chunk = static_cast<size_t>(env_long("US_SWEEP_CHUNK", 65536));
+    double penalty = env_floats("US_SWEEP_MISS_PENALTY_CM", "10").front();
+
+    printf("Loaded %ld bursts from %zu trace(s) in %zu dataset(s)\n", total_bursts, traces.size(), datasets.size());
+    printf("Scoring %zu configs on %u threads\n", candidates.size(), threads);
+
+    auto t0 = std::chrono::steady_clock::now();
+    ThreadPool pool(threads);
+    std::vector<Score> scores = run_sweep(datasets, candidates, pool, chunk);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::vector<size_t> order(candidates.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        double ra = scores[a].rank_value(penalty);
+        double rb = scores[b].rank_value(penalty);
+        if (ra != rb)
+            return ra < rb;
+        return scores[a].mean_latency_ms() < scores[b].mean_latency_ms();
+    });
+
+    printf("Done in %.2f s (%.1f M burst evaluations/s)\n\n", secs,
+           (secs > 0) ? static_cast<double>(total_bursts) * candidates.size() / secs / 1e6 : 0.0);
+    printf("%4s %6s %8s %8s %6s %9s %9s %9s %10s %9s\n", "rank", "pings", "interval", "filter", "maxdev", "success%",
+           "ok%", "mae_cm", "latency_ms", "score");
+
+    long top = env_long("US_SWEEP_TOP", 20);
+    for (size_t r = 0; r < order.size() && static_cast<long>(r) < top; r++) {
+        const Candidate &c = candidates[order[r]];
+        const Score &s = scores[order[r]];
+        printf("%4zu %6u %8u %8s %6.1f %9.2f %9.2f %9.3f %10.1f %9.3f\n", r + 1, c.ping_count,
+               c.cfg.ping_interval_ms, filter_name(c.cfg.filter), c.cfg.max_dev_cm, 100.0 * s.success_rate(),
+               s.bursts ? 100.0 * s.ok / s.bursts : 0.0, s.mae_cm(), s.mean_latency_ms(), s.rank_value(penalty));
+    }
+
+    const char *csv_path = getenv("US_SWEEP_CSV");
+    if (csv_path != nullptr) {
+        FILE *csv = fopen(csv_path, "w");
+        if (csv == nullptr) {
+            fprintf(stderr, "Cannot create %s\n", csv_path);
+            exit(1);
+        }
+        fprintf(csv, "rank,pings,interval_ms,filter,max_dev_cm,bursts,success_rate,ok_rate,mae_cm,latency_ms,score\n");
+        for (size_t r = 0; r < order.size(); r++) {
+            const Candidate &c = candidates[order[r]];
+            const Score &s = scores[order[r]];
+            fprintf(csv, "%zu,%u,%u,%s,%.3f,%llu,%.5f,%.5f,%.4f,%.2f,%.4f\n", r + 1, c.ping_count,
+                    c.cfg.ping_interval_ms, filter_name(c.cfg.filter), c.cfg.max_dev_cm,
+                    static_cast<unsigned long long>(s.bursts), s.success_rate(),
+                    s.bursts ? static_cast<double>(s.ok) / s.bursts : 0.0, s.mae_cm(), s.mean_latency_ms(),
+                    s.rank_value(penalty));
+        }
+        fclose(csv);
+    }
+
+    exit(0);
+}
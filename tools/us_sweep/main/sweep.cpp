@@ -0,0 +1,273 @@
+// components/ultrasonic_sensor/tools/us_sweep/main/sweep.cpp
+
+#include "sweep.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <limits>
+#include <pthread.h>
+
+#include "us_processor.hpp"
+#include "us_replay_driver.hpp"
+#include "us_trace_file.hpp"
+
+namespace us_sweep {
+
+using namespace ultrasonic;
+
+void Score::merge(const Score &other)
+{
+    bursts += other.bursts;
+    successes += other.successes;
+    ok += other.ok;
+    compared += other.compared;
+    abs_err_cm += other.abs_err_cm;
+    latency_us += other.latency_us;
+}
+
+// =================================================================
+// ThreadPool
+// =================================================================
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+        threads = 1;
+    for (unsigned i = 0; i < threads; i++) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto &t : workers_) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push(std::move(job));
+    }
+    job_cv_.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return jobs_.empty() && active_ == 0; });
+}
+
+void ThreadPool::worker_loop()
+{
+    // Workers are plain pthreads next to the FreeRTOS simulator; keep its
+    // tick and context-switch signals away from them.
+    sigset_t all;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, nullptr);
+
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            job_cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop();
+            active_++;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_--;
+            if (jobs_.empty() && active_ == 0)
+                idle_cv_.notify_all();
+        }
+    }
+}
+
+// =================================================================
+// Datasets
+// =================================================================
+
+long load_trace(const char *path, std::vector<Dataset> &datasets)
+{
+    UsTraceReader reader;
+    if (reader.open(path) != ESP_OK)
+        return -1;
+
+    const UsConfig &cfg = reader.config();
+    auto it = std::find_if(datasets.begin(), datasets.end(), [&](const Dataset &ds) {
+        return ds.recorded_cfg.ping_interval_ms == cfg.ping_interval_ms;
+    });
+    if (it == datasets.end()) {
+        datasets.emplace_back();
+        it = datasets.end() - 1;
+        it->recorded_cfg = cfg;
+    }
+    Dataset &ds = *it;
+
+    long bursts = 0;
+    bool first = true;
+    TraceRecord rec;
+    while (reader.next(rec)) {
+        // burst_start always ends with a sentinel equal to pings.size(),
+        // which doubles as the start of the next burst
+        if (rec.ping_index == 0 || first) {
+            if (ds.burst_start.empty())
+                ds.burst_start.push_back(static_cast<uint32_t>(ds.pings.size()));
+            ds.burst_start.push_back(static_cast<uint32_t>(ds.pings.size()));
+            bursts++;
+            first = false;
+        }
+        ds.pings.push_back(rec);
+        ds.burst_start.back() = static_cast<uint32_t>(ds.pings.size());
+    }
+    return bursts;
+}
+
+void compute_references(Dataset &ds, float truth_cm)
+{
+    ds.reference_cm.assign(ds.bursts(), std::numeric_limits<float>::quiet_NaN());
+    const UsCompiledConfig recorded(ds.recorded_cfg);
+
+    for (size_t b = 0; b < ds.bursts(); b++) {
+        if (!std::isnan(truth_cm)) {
+            ds.reference_cm[b] = truth_cm;
+            continue;
+        }
+
+        float samples[IUsProcessor::MAX_PINGS];
+        size_t n = 0;
+        for (uint32_t i = ds.burst_start[b]; i < ds.burst_start[b + 1] && n < IUsProcessor::MAX_PINGS; i++) {
+            Reading r = UsReplayDriver::reevaluate(ds.pings[i], recorded);
+            if (is_success(r.result))
+                samples[n++] = r.cm;
+        }
+        if (n > 0) {
+            std::nth_element(samples, samples + n / 2, samples + n);
+            ds.reference_cm[b] = samples[n / 2];
+        }
+    }
+}
+
+// =================================================================
+// Scoring
+// =================================================================
+
+double burst_latency_us(const TraceRecord *pings, uint8_t count, const UsConfig &cfg)
+{
+    if (count == 0)
+        return 0.0;
+
+    double total = (count - 1) * cfg.ping_interval_ms * 1000.0;
+    for (uint8_t i = 0; i < count; i++) {
+        total += cfg.ping_duration_us;
+        // Pings without an echo waited for the full timeout
+        total += (pings[i].echo_us != 0) ? pings[i].echo_us : cfg.timeout_us;
+    }
+    return total;
+}
+
+Score score_range(const Dataset &ds, const Candidate &cand, size_t first_burst, size_t last_burst)
+{
+    const UsCompiledConfig cc(cand.cfg);
+    UsProcessor processor;
+    Score score;
+    Reading pings[IUsProcessor::MAX_PINGS];
+
+    for (size_t b = first_burst; b < last_burst; b++) {
+        uint32_t start = ds.burst_start[b];
+        uint32_t available = ds.burst_start[b + 1] - start;
+        uint8_t n = static_cast<uint8_t>(std::min<uint32_t>(cand.ping_count, available));
+        if (n == 0)
+            continue;
+
+        const TraceRecord *rec = &ds.pings[start];
+        bool aborted = false;
+        for (uint8_t i = 0; i < n; i++) {
+            pings[i] = UsReplayDriver::reevaluate(rec[i], cc);
+            if (pings[i].result == UsResult::ECHO_STUCK || pings[i].result == UsResult::HW_FAULT) {
+                aborted = true;
+                n = i + 1;
+                break;
+            }
+        }
+
+        score.bursts++;
+        score.latency_us += burst_latency_us(rec, n, cand.cfg);
+        if (aborted)
+            continue;
+
+        Reading result = processor.process_compiled(pings, n, cc);
+        if (!is_success(result.result))
+            continue;
+
+        score.successes++;
+        if (result.result == UsResult::OK)
+            score.ok++;
+
+        float ref = ds.reference_cm.empty() ? std::numeric_limits<float>::quiet_NaN() : ds.reference_cm[b];
+        if (!std::isnan(ref)) {
+            score.compared++;
+            score.abs_err_cm += std::fabs(result.cm - ref);
+        }
+    }
+    return score;
+}
+
+std::vector<Score> run_sweep(
+    const std::vector<Dataset> &datasets,
+    const std::vector<Candidate> &candidates,
+    ThreadPool &pool,
+    size_t chunk)
+{
+    if (chunk == 0)
+        chunk = 1;
+
+    struct Job
+    {
+        size_t candidate;
+        const Dataset *ds;
+        size_t first;
+        size_t last;
+    };
+
+    std::vector<Job> jobs;
+    for (size_t c = 0; c < candidates.size(); c++) {
+        for (const Dataset &ds : datasets) {
+            if (ds.recorded_cfg.ping_interval_ms != candidates[c].cfg.ping_interval_ms)
+                continue;
+            for (size_t first = 0; first < ds.bursts(); first += chunk) {
+                jobs.push_back({c, &ds, first, std::min(first + chunk, ds.bursts())});
+            }
+        }
+    }
+
+    // Each job owns its slot, so workers never contend on the results
+    std::vector<Score> partial(jobs.size());
+    for (size_t j = 0; j < jobs.size(); j++) {
+        pool.submit([&, j] {
+            const Job &job = jobs[j];
+            partial[j] = score_range(*job.ds, candidates[job.candidate], job.first, job.last);
+        });
+    }
+    pool.wait();
+
+    std::vector<Score> scores(candidates.size());
+    for (size_t j = 0; j < jobs.size(); j++) {
+        scores[jobs[j].candidate].merge(partial[j]);
+    }
+    return scores;
+}
+
+} // namespace us_sweep
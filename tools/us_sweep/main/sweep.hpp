@@ -0,0 +1,140 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "us_trace.hpp"
+#include "us_types.hpp"
+
+namespace us_sweep {
+
+/**
+ * @brief Bursts recorded with the same ping interval, flattened for scoring.
+ */
+struct Dataset
+{
+    ultrasonic::UsConfig recorded_cfg;             /**< Config of the first trace merged in. */
+    std::vector<ultrasonic::TraceRecord> pings;    /**< All pings, burst after burst. */
+    std::vector<uint32_t> burst_start;             /**< Index of each burst's first ping, plus an end sentinel. */
+    std::vector<float> reference_cm;               /**< Per-burst reference distance, NaN if unknown. */
+
+    size_t bursts() const { return burst_start.empty() ? 0 : burst_start.size() - 1; }
+};
+
+/**
+ * @brief One point of the search space.
+ */
+struct Candidate
+{
+    ultrasonic::UsConfig cfg; /**< Processing config; ping_interval_ms selects the dataset. */
+    uint8_t ping_count;       /**< Pings used from each recorded burst. */
+};
+
+/**
+ * @brief Accumulated score of one candidate.
+ */
+struct Score
+{
+    uint64_t bursts = 0;       /**< Bursts evaluated. */
+    uint64_t successes = 0;    /**< Bursts ending in OK or WEAK_SIGNAL. */
+    uint64_t ok = 0;           /**< Bursts ending in OK. */
+    uint64_t compared = 0;     /**< Successful bursts with a known reference. */
+    double abs_err_cm = 0.0;   /**< Sum of |result - reference| over compared bursts. */
+    double latency_us = 0.0;   /**< Sum of estimated burst durations. */
+
+    void merge(const Score &other);
+
+    double success_rate() const { return bursts ? static_cast<double>(successes) / bursts : 0.0; }
+    double mae_cm() const { return compared ? abs_err_cm / compared : 0.0; }
+    double mean_latency_ms() const { return bursts ? latency_us / bursts / 1000.0 : 0.0; }
+
+    /** @brief Ranking key (lower is better): MAE plus a penalty per failed burst. */
+    double rank_value(double miss_penalty_cm) const { return mae_cm() + miss_penalty_cm * (1.0 - success_rate()); }
+};
+
+/**
+ * @brief Fixed-size pool of worker threads consuming a FIFO of jobs.
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /** @brief Queue a job. */
+    void submit(std::function<void()> job);
+
+    /** @brief Block until every queued job has finished. */
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex mutex_;
+    std::condition_variable job_cv_;
+    std::condition_variable idle_cv_;
+    size_t active_ = 0;
+    bool stopping_ = false;
+};
+
+/**
+ * @brief Append the bursts of a trace file to the dataset matching its ping interval.
+ *
+ * @param path     Trace file written by UsTraceWriter.
+ * @param datasets Datasets, one per distinct recorded ping interval.
+ * @return Number of bursts loaded, or -1 if the file could not be read.
+ */
+long load_trace(const char *path, std::vector<Dataset> &datasets);
+
+/**
+ * @brief Fill Dataset::reference_cm for every burst.
+ *
+ * With @p truth_cm set (not NaN), every burst uses it. Otherwise the
+ * reference is the median of all valid pings of the full burst under the
+ * recorded range limits.
+ */
+void compute_references(Dataset &ds, float truth_cm);
+
+/**
+ * @brief Estimated wall time of the first @p count pings of a burst (us).
+ */
+double burst_latency_us(const ultrasonic::TraceRecord *pings, uint8_t count, const ultrasonic::UsConfig &cfg);
+
+/**
+ * @brief Score one candidate over a range of bursts of a dataset.
+ */
+Score score_range(const Dataset &ds, const Candidate &cand, size_t first_burst, size_t last_burst);
+
+/**
+ * @brief Score every candidate in parallel.
+ *
+ * Work is split into (candidate, burst chunk) jobs so that both wide grids
+ * and huge datasets keep every worker busy.
+ *
+ * @param datasets    Loaded datasets.
+ * @param candidates  Search space.
+ * @param pool        Worker pool.
+ * @param chunk       Bursts per job.
+ * @return One Score per candidate, in candidate order. Candidates whose
+ *         ping interval matches no dataset score zero bursts.
+ */
+std::vector<Score> run_sweep(
+    const std::vector<Dataset> &datasets,
+    const std::vector<Candidate> &candidates,
+    ThreadPool &pool,
+    size_t chunk);
+
+} // namespace us_sweep